@@ -0,0 +1,184 @@
+#include "harness.h"
+
+#include <imageloader.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// Upper bound of the iterations so very fast benchmarks still finish quickly
+#define BENCH_MAX_ITERATIONS 1000000
+
+void bench_init(BenchHarness* harness)
+{
+    memset(harness, 0, sizeof(*harness));
+    harness->min_time = 0.2;
+    harness->log = stdout;
+}
+
+void bench_free(BenchHarness* harness)
+{
+    free(harness->results);
+    harness->results = NULL;
+    harness->num_results = 0;
+    harness->capacity = 0;
+}
+
+#ifdef _WIN32
+
+double bench_now(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+size_t bench_num_processors(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+double bench_now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+size_t bench_num_processors(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (size_t)count : 1;
+}
+
+#endif
+
+bool bench_selected(const BenchHarness* harness, const char* name)
+{
+    return harness->filter == NULL || strstr(name, harness->filter) != NULL;
+}
+
+static bool bench_add_result(BenchHarness* harness, const BenchResult* result)
+{
+    if (harness->num_results == harness->capacity)
+    {
+        size_t capacity = harness->capacity > 0 ? harness->capacity * 2 : 64;
+        BenchResult* results = (BenchResult*)realloc(harness->results, capacity * sizeof(BenchResult));
+        if (results == NULL)
+        {
+            return false;
+        }
+
+        harness->results = results;
+        harness->capacity = capacity;
+    }
+
+    harness->results[harness->num_results++] = *result;
+    return true;
+}
+
+bool bench_run(BenchHarness* harness, const BenchCase* info, BenchFunc func, void* arg)
+{
+    if (!bench_selected(harness, info->name))
+    {
+        return true;
+    }
+
+    // The first iteration warms up caches and the allocator and isn't counted
+    double seconds;
+    if (!func(arg, &seconds))
+    {
+        fprintf(harness->log, "%-56s skipped\n", info->name);
+        return false;
+    }
+
+    BenchResult result;
+    result.info = *info;
+    snprintf(result.name, sizeof(result.name), "%s", info->name);
+    result.info.name = NULL;
+    result.iterations = 0;
+    result.seconds = 0.0;
+
+    while (result.seconds < harness->min_time && result.iterations < BENCH_MAX_ITERATIONS)
+    {
+        if (!func(arg, &seconds))
+        {
+            fprintf(harness->log, "%-56s skipped\n", info->name);
+            return false;
+        }
+
+        result.seconds += seconds;
+        ++result.iterations;
+    }
+
+    double per_iteration = result.seconds / (double)result.iterations;
+    fprintf(harness->log, "%-56s %12.1f us", info->name, per_iteration * 1e6);
+    if (info->bytes > 0.0)
+    {
+        fprintf(harness->log, " %10.1f MB/s", info->bytes / per_iteration / 1e6);
+    }
+    if (info->items > 0.0)
+    {
+        fprintf(harness->log, " %10.1f images/s", info->items / per_iteration);
+    }
+    fprintf(harness->log, "\n");
+
+    return bench_add_result(harness, &result);
+}
+
+void bench_write_json(const BenchHarness* harness, FILE* out)
+{
+    fprintf(out, "{\n");
+    fprintf(out, "  \"context\": {\n");
+    fprintf(out, "    \"library_version\": \"%u.%u.%u\",\n", (unsigned)imgload_version_major(),
+            (unsigned)imgload_version_minor(), (unsigned)imgload_version_patch());
+    fprintf(out, "    \"num_cpus\": %u,\n", (unsigned)bench_num_processors());
+    fprintf(out, "    \"timestamp\": %lld\n", (long long)time(NULL));
+    fprintf(out, "  },\n");
+    fprintf(out, "  \"benchmarks\": [");
+
+    for (size_t i = 0; i < harness->num_results; ++i)
+    {
+        const BenchResult* result = &harness->results[i];
+        double per_iteration = result->seconds / (double)result->iterations;
+
+        // Names only consist of letters, digits and punctuation which doesn't need escaping
+        fprintf(out, "%s\n    {\n", i > 0 ? "," : "");
+        fprintf(out, "      \"name\": \"%s\",\n", result->name);
+        fprintf(out, "      \"group\": \"%s\",\n", result->info.group);
+        fprintf(out, "      \"width\": %u,\n", (unsigned)result->info.width);
+        fprintf(out, "      \"height\": %u,\n", (unsigned)result->info.height);
+        fprintf(out, "      \"threads\": %u,\n", (unsigned)result->info.threads);
+        fprintf(out, "      \"iterations\": %u,\n", (unsigned)result->iterations);
+        fprintf(out, "      \"real_time\": %.3f,\n", per_iteration * 1e9);
+        fprintf(out, "      \"time_unit\": \"ns\"");
+        if (result->info.bytes > 0.0)
+        {
+            fprintf(out, ",\n      \"bytes_per_second\": %.1f", result->info.bytes / per_iteration);
+        }
+        if (result->info.items > 0.0)
+        {
+            fprintf(out, ",\n      \"items_per_second\": %.3f", result->info.items / per_iteration);
+        }
+        fprintf(out, "\n    }");
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+}
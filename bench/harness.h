@@ -0,0 +1,87 @@
+#ifndef IMAGELOADER_BENCH_HARNESS_H
+#define IMAGELOADER_BENCH_HARNESS_H
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define BENCH_NAME_SIZE 96
+
+/**
+ * @brief Runs a single iteration of a benchmark
+ * Setup work like creating the image can be done inside the function, only the time reported in seconds_out counts.
+ * @param arg The argument passed to bench_run
+ * @param seconds_out The time of the measured part
+ * @return false if the iteration failed, the benchmark is skipped then
+ */
+typedef bool (*BenchFunc)(void* arg, double* seconds_out);
+
+/**
+ * @brief Parameters of a benchmark which end up in the report
+ */
+typedef struct
+{
+    const char* group; //!< probe, decode, convert, flip, decompress or kernel, has to be a string literal
+    const char* name; //!< Unique name, used for filtering
+
+    size_t width;
+    size_t height;
+    size_t threads;
+
+    double bytes; //!< Bytes processed by one iteration, 0 if throughput doesn't make sense
+    double items; //!< Images processed by one iteration
+} BenchCase;
+
+typedef struct
+{
+    BenchCase info;
+    char name[BENCH_NAME_SIZE]; //!< Copy of the name, info.name isn't valid anymore
+
+    size_t iterations;
+    double seconds; //!< Measured time of all iterations
+} BenchResult;
+
+typedef struct
+{
+    double min_time; //!< Minimum measured time of every benchmark in seconds
+    const char* filter; //!< Only benchmarks containing this in their name are run, NULL runs all
+
+    FILE* log; //!< Human readable results
+
+    BenchResult* results;
+    size_t num_results;
+    size_t capacity;
+} BenchHarness;
+
+void bench_init(BenchHarness* harness);
+
+void bench_free(BenchHarness* harness);
+
+/**
+ * @brief Gets a monotonic time in seconds
+ */
+double bench_now(void);
+
+/**
+ * @brief Gets the number of processors
+ */
+size_t bench_num_processors(void);
+
+/**
+ * @brief Checks if the benchmark should run at all, setting up expensive benchmarks can be skipped if not
+ */
+bool bench_selected(const BenchHarness* harness, const char* name);
+
+/**
+ * @brief Runs the function until the minimum time is reached and records the result
+ * @return false if the benchmark was skipped because an iteration failed
+ */
+bool bench_run(BenchHarness* harness, const BenchCase* info, BenchFunc func, void* arg);
+
+/**
+ * @brief Writes all results in the JSON format of Google Benchmark so existing tooling can read them
+ */
+void bench_write_json(const BenchHarness* harness, FILE* out);
+
+#endif //IMAGELOADER_BENCH_HARNESS_H
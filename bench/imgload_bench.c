@@ -0,0 +1,1025 @@
+#include "harness.h"
+#include "synthetic.h"
+
+#include <imageloader.h>
+
+#if BENCH_KERNELS
+#include "dxt_simd.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_THREAD_STEPS 16
+#define BENCH_MAX_INPUTS 32
+
+// Every thread of a decode benchmark gets this many images
+#define BENCH_IMAGES_PER_THREAD 4
+
+static const size_t SYNTH_SIZES[] = { 256, 1024, 2048 };
+
+typedef struct
+{
+    BenchHarness harness;
+
+    ImgloadContextFlags flags; //!< Added to the flags of every context
+    size_t max_size;
+
+    size_t threads[BENCH_MAX_THREAD_STEPS];
+    size_t num_threads;
+} Bench;
+
+/**
+ * @brief An encoded file decoded by the plugins
+ */
+typedef struct
+{
+    char name[64];
+    SynthBuffer file;
+
+    ImgloadImageInfo info;
+} BenchInput;
+
+typedef struct
+{
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+} MemoryStream;
+
+static size_t IMGLOAD_CALLBACK memory_read(void* ud, uint8_t* buf, size_t size)
+{
+    MemoryStream* stream = (MemoryStream*)ud;
+    if (size > stream->size - stream->pos)
+    {
+        size = stream->size - stream->pos;
+    }
+    memcpy(buf, stream->data + stream->pos, size);
+    stream->pos += size;
+
+    return size;
+}
+
+static int64_t IMGLOAD_CALLBACK memory_seek(void* ud, int64_t offset, int whence)
+{
+    MemoryStream* stream = (MemoryStream*)ud;
+
+    int64_t base = whence == SEEK_SET ? 0 : whence == SEEK_CUR ? (int64_t)stream->pos : (int64_t)stream->size;
+    int64_t pos = base + offset;
+    if (pos < 0 || pos > (int64_t)stream->size)
+    {
+        return -1;
+    }
+    stream->pos = (size_t)pos;
+
+    return pos;
+}
+
+static ImgloadIO memory_io(void)
+{
+    ImgloadIO io;
+    io.read = memory_read;
+    io.seek = memory_seek;
+    return io;
+}
+
+static void* IMGLOAD_CALLBACK bench_realloc(void* ud, void* mem, size_t size)
+{
+    (void)ud;
+    return realloc(mem, size);
+}
+
+static void IMGLOAD_CALLBACK bench_free_mem(void* ud, void* mem)
+{
+    (void)ud;
+    free(mem);
+}
+
+static ImgloadContext bench_context(const Bench* bench, ImgloadContextFlags flags, SynthImage* synth)
+{
+    ImgloadMemoryAllocator allocator;
+    allocator.realloc = bench_realloc;
+    allocator.free = bench_free_mem;
+
+    ImgloadContext ctx;
+    if (imgload_context_init(&ctx, bench->flags | flags, &allocator, NULL) != IMGLOAD_ERR_NO_ERROR)
+    {
+        return NULL;
+    }
+    if (synth != NULL && imgload_context_add_plugin(ctx, synth_plugin_loader, synth) != IMGLOAD_ERR_NO_ERROR)
+    {
+        imgload_context_free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+static size_t format_bpp(ImgloadFormat format)
+{
+    switch (format)
+    {
+    case IMGLOAD_FORMAT_R8G8B8:
+        return 3;
+    case IMGLOAD_FORMAT_GRAY8:
+        return 1;
+    default:
+        return 4;
+    }
+}
+
+static const char* format_name(ImgloadFormat format)
+{
+    switch (format)
+    {
+    case IMGLOAD_FORMAT_R8G8B8A8:
+        return "rgba8";
+    case IMGLOAD_FORMAT_B8G8R8A8:
+        return "bgra8";
+    case IMGLOAD_FORMAT_R8G8B8:
+        return "rgb8";
+    case IMGLOAD_FORMAT_GRAY8:
+        return "gray8";
+    default:
+        return "unknown";
+    }
+}
+
+static const char* compression_name(ImgloadCompression compression)
+{
+    switch (compression)
+    {
+    case IMGLOAD_COMPRESSION_DXT1:
+        return "bc1";
+    case IMGLOAD_COMPRESSION_DXT5:
+        return "bc3";
+    case IMGLOAD_COMPRESSION_BC4:
+        return "bc4";
+    case IMGLOAD_COMPRESSION_BC5:
+        return "bc5";
+    case IMGLOAD_COMPRESSION_BC6H_UF16:
+        return "bc6h";
+    case IMGLOAD_COMPRESSION_BC7:
+        return "bc7";
+    default:
+        return "unknown";
+    }
+}
+
+static bool read_file(const char* path, SynthBuffer* out)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    bool result = true;
+    uint8_t chunk[65536];
+    size_t read;
+    while (result && (read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        size_t capacity = out->size + read;
+        uint8_t* data = (uint8_t*)realloc(out->data, capacity);
+        if (data == NULL)
+        {
+            result = false;
+            break;
+        }
+        memcpy(data + out->size, chunk, read);
+        out->data = data;
+        out->size += read;
+        out->capacity = capacity;
+    }
+
+    fclose(file);
+    return result && out->size > 0;
+}
+
+/**
+ * @brief Keeps an input if the plugins of this build can read it
+ */
+static void add_input(const Bench* bench, BenchInput* inputs, size_t* num_inputs, const char* name, SynthBuffer* file)
+{
+    ImgloadContext ctx = bench_context(bench, 0, NULL);
+    if (ctx == NULL)
+    {
+        synth_buffer_free(file);
+        return;
+    }
+
+    BenchInput* input = &inputs[*num_inputs];
+    MemoryStream stream = { file->data, file->size, 0 };
+    ImgloadIO io = memory_io();
+
+    if (*num_inputs < BENCH_MAX_INPUTS
+        && imgload_image_probe_info(ctx, &io, &stream, &input->info) == IMGLOAD_ERR_NO_ERROR)
+    {
+        snprintf(input->name, sizeof(input->name), "%s", name);
+        input->file = *file;
+        ++*num_inputs;
+    }
+    else
+    {
+        fprintf(bench->harness.log, "%-56s no plugin\n", name);
+        synth_buffer_free(file);
+    }
+
+    imgload_context_free(ctx);
+}
+
+static size_t create_inputs(const Bench* bench, BenchInput* inputs)
+{
+    size_t num_inputs = 0;
+
+    static const char* const FILES[][2] = {
+        { "png/test1.png", "file/test1.png" },
+        { "stb_image/jpeg420exif.jpg", "file/jpeg420exif.jpg" },
+        { "stb_image/FLAG_B24.TGA", "file/FLAG_B24.tga" },
+        { "ddsimg/Col_Viper_Mk7e_Th11.dds", "file/Col_Viper_Mk7e_Th11.dds" },
+    };
+    for (size_t i = 0; i < sizeof(FILES) / sizeof(FILES[0]); ++i)
+    {
+        char path[512];
+        snprintf(path, sizeof(path), "%s%s", BENCH_DATA_PATH, FILES[i][0]);
+
+        SynthBuffer file;
+        memset(&file, 0, sizeof(file));
+        if (read_file(path, &file))
+        {
+            add_input(bench, inputs, &num_inputs, FILES[i][1], &file);
+        }
+        else
+        {
+            fprintf(bench->harness.log, "%-56s missing\n", path);
+            synth_buffer_free(&file);
+        }
+    }
+
+    static const ImgloadCompression DDS_COMPRESSIONS[] = {
+        IMGLOAD_COMPRESSION_DXT1, IMGLOAD_COMPRESSION_DXT5, IMGLOAD_COMPRESSION_BC7,
+    };
+
+    for (size_t i = 0; i < sizeof(SYNTH_SIZES) / sizeof(SYNTH_SIZES[0]); ++i)
+    {
+        size_t size = SYNTH_SIZES[i];
+        if (size > bench->max_size)
+        {
+            continue;
+        }
+
+        uint8_t* pixels = synth_pixels(size, size, 4);
+        if (pixels == NULL)
+        {
+            continue;
+        }
+
+        char name[64];
+        SynthBuffer file;
+
+        memset(&file, 0, sizeof(file));
+        snprintf(name, sizeof(name), "synth/png/%u", (unsigned)size);
+        if (synth_encode_png(pixels, size, size, 4, &file))
+        {
+            add_input(bench, inputs, &num_inputs, name, &file);
+        }
+        else
+        {
+            synth_buffer_free(&file);
+        }
+
+        memset(&file, 0, sizeof(file));
+        snprintf(name, sizeof(name), "synth/tga/%u", (unsigned)size);
+        if (synth_encode_tga(pixels, size, size, 4, &file))
+        {
+            add_input(bench, inputs, &num_inputs, name, &file);
+        }
+        else
+        {
+            synth_buffer_free(&file);
+        }
+
+        for (size_t j = 0; j < sizeof(DDS_COMPRESSIONS) / sizeof(DDS_COMPRESSIONS[0]); ++j)
+        {
+            memset(&file, 0, sizeof(file));
+            snprintf(name, sizeof(name), "synth/dds_%s/%u", compression_name(DDS_COMPRESSIONS[j]), (unsigned)size);
+            if (synth_encode_dds(size, size, DDS_COMPRESSIONS[j], &file))
+            {
+                add_input(bench, inputs, &num_inputs, name, &file);
+            }
+            else
+            {
+                synth_buffer_free(&file);
+            }
+        }
+
+        free(pixels);
+    }
+
+    return num_inputs;
+}
+
+typedef struct
+{
+    ImgloadContext ctx;
+    const BenchInput* input;
+} ProbeArgs;
+
+static bool probe_init_iteration(void* arg, double* seconds_out)
+{
+    ProbeArgs* args = (ProbeArgs*)arg;
+
+    double start = bench_now();
+    ImgloadImage img;
+    if (imgload_image_init_from_memory(args->ctx, &img, args->input->file.data, args->input->file.size)
+        != IMGLOAD_ERR_NO_ERROR)
+    {
+        return false;
+    }
+    imgload_image_free(img);
+    *seconds_out = bench_now() - start;
+
+    return true;
+}
+
+static bool probe_info_iteration(void* arg, double* seconds_out)
+{
+    ProbeArgs* args = (ProbeArgs*)arg;
+    MemoryStream stream = { args->input->file.data, args->input->file.size, 0 };
+    ImgloadIO io = memory_io();
+
+    double start = bench_now();
+    ImgloadImageInfo info;
+    if (imgload_image_probe_info(args->ctx, &io, &stream, &info) != IMGLOAD_ERR_NO_ERROR)
+    {
+        return false;
+    }
+    *seconds_out = bench_now() - start;
+
+    return true;
+}
+
+static void bench_probe(Bench* bench, const BenchInput* inputs, size_t num_inputs)
+{
+    ImgloadContext ctx = bench_context(bench, 0, NULL);
+    if (ctx == NULL)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < num_inputs; ++i)
+    {
+        ProbeArgs args = { ctx, &inputs[i] };
+        char name[BENCH_NAME_SIZE];
+
+        BenchCase info;
+        memset(&info, 0, sizeof(info));
+        info.group = "probe";
+        info.name = name;
+        info.width = inputs[i].info.width;
+        info.height = inputs[i].info.height;
+        info.threads = 1;
+        info.items = 1.0;
+
+        snprintf(name, sizeof(name), "probe/init/%s", inputs[i].name);
+        bench_run(&bench->harness, &info, probe_init_iteration, &args);
+
+        snprintf(name, sizeof(name), "probe/info/%s", inputs[i].name);
+        bench_run(&bench->harness, &info, probe_info_iteration, &args);
+    }
+
+    imgload_context_free(ctx);
+}
+
+typedef struct
+{
+    ImgloadContext ctx;
+    const BenchInput* input;
+    size_t threads;
+    size_t count;
+
+    ImgloadIO* ios;
+    MemoryStream* streams;
+    void** uds;
+    ImgloadImage* images;
+} DecodeArgs;
+
+static bool decode_iteration(void* arg, double* seconds_out)
+{
+    DecodeArgs* args = (DecodeArgs*)arg;
+
+    for (size_t i = 0; i < args->count; ++i)
+    {
+        args->streams[i].data = args->input->file.data;
+        args->streams[i].size = args->input->file.size;
+        args->streams[i].pos = 0;
+        args->ios[i] = memory_io();
+        args->uds[i] = &args->streams[i];
+    }
+
+    ImgloadBatchOptions options;
+    memset(&options, 0, sizeof(options));
+    options.num_threads = args->threads;
+
+    double start = bench_now();
+    ImgloadErrorCode err = imgload_batch_load(args->ctx, args->ios, args->uds, args->count, args->images, NULL,
+                                              &options);
+    *seconds_out = bench_now() - start;
+
+    for (size_t i = 0; i < args->count; ++i)
+    {
+        if (args->images[i] != NULL)
+        {
+            imgload_image_free(args->images[i]);
+        }
+    }
+
+    return err == IMGLOAD_ERR_NO_ERROR;
+}
+
+static void bench_decode(Bench* bench, const BenchInput* inputs, size_t num_inputs)
+{
+    ImgloadContext ctx = bench_context(bench, 0, NULL);
+    if (ctx == NULL)
+    {
+        return;
+    }
+
+    size_t max_count = bench->threads[bench->num_threads - 1] * BENCH_IMAGES_PER_THREAD;
+    DecodeArgs args;
+    args.ctx = ctx;
+    args.ios = (ImgloadIO*)malloc(max_count * sizeof(ImgloadIO));
+    args.streams = (MemoryStream*)malloc(max_count * sizeof(MemoryStream));
+    args.uds = (void**)malloc(max_count * sizeof(void*));
+    args.images = (ImgloadImage*)malloc(max_count * sizeof(ImgloadImage));
+
+    for (size_t i = 0; args.ios != NULL && args.streams != NULL && args.uds != NULL && args.images != NULL
+         && i < num_inputs; ++i)
+    {
+        const ImgloadImageInfo* image = &inputs[i].info;
+
+        // Compressed images are only loaded, the decompression has its own benchmarks
+        double bytes = image->compression == IMGLOAD_COMPRESSION_NONE
+            ? (double)(image->width * image->height * format_bpp(image->format))
+            : (double)inputs[i].file.size;
+
+        for (size_t j = 0; j < bench->num_threads; ++j)
+        {
+            char name[BENCH_NAME_SIZE];
+            snprintf(name, sizeof(name), "decode/%s/t%u", inputs[i].name, (unsigned)bench->threads[j]);
+
+            args.input = &inputs[i];
+            args.threads = bench->threads[j];
+            args.count = bench->threads[j] * BENCH_IMAGES_PER_THREAD;
+
+            BenchCase info;
+            info.group = "decode";
+            info.name = name;
+            info.width = image->width;
+            info.height = image->height;
+            info.threads = args.threads;
+            info.bytes = bytes * (double)args.count;
+            info.items = (double)args.count;
+
+            bench_run(&bench->harness, &info, decode_iteration, &args);
+        }
+    }
+
+    free(args.ios);
+    free(args.streams);
+    free(args.uds);
+    free(args.images);
+    imgload_context_free(ctx);
+}
+
+typedef struct
+{
+    ImgloadContext ctx;
+    ImgloadFormat destination;
+} ConvertArgs;
+
+static bool convert_iteration(void* arg, double* seconds_out)
+{
+    ConvertArgs* args = (ConvertArgs*)arg;
+
+    ImgloadImage img;
+    if (imgload_image_init_from_memory(args->ctx, &img, SYNTH_FILE, sizeof(SYNTH_FILE)) != IMGLOAD_ERR_NO_ERROR)
+    {
+        return false;
+    }
+
+    ImgloadErrorCode err = imgload_image_read_data(img);
+    if (err == IMGLOAD_ERR_NO_ERROR)
+    {
+        // Only the conversion of the loaded data is measured
+        double start = bench_now();
+        err = imgload_image_transform_data(img, args->destination, imgload_transform_alpha(0xFF));
+        *seconds_out = bench_now() - start;
+    }
+
+    imgload_image_free(img);
+    return err == IMGLOAD_ERR_NO_ERROR;
+}
+
+static void bench_convert(Bench* bench)
+{
+    static const ImgloadFormat FORMATS[] = {
+        IMGLOAD_FORMAT_R8G8B8A8, IMGLOAD_FORMAT_B8G8R8A8, IMGLOAD_FORMAT_R8G8B8, IMGLOAD_FORMAT_GRAY8,
+    };
+    const size_t num_formats = sizeof(FORMATS) / sizeof(FORMATS[0]);
+
+    for (size_t s = 0; s < sizeof(SYNTH_SIZES) / sizeof(SYNTH_SIZES[0]); ++s)
+    {
+        size_t size = SYNTH_SIZES[s];
+        if (size > bench->max_size || !bench_selected(&bench->harness, "convert/"))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < num_formats; ++i)
+        {
+            SynthImage synth;
+            synth.width = size;
+            synth.height = size;
+            synth.format = FORMATS[i];
+            synth.compression = IMGLOAD_COMPRESSION_NONE;
+            synth.data_size = size * size * format_bpp(FORMATS[i]);
+
+            uint8_t* pixels = synth_pixels(size, size, format_bpp(FORMATS[i]));
+            ImgloadContext ctx = pixels != NULL ? bench_context(bench, IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS, &synth) : NULL;
+            synth.data = pixels;
+
+            for (size_t j = 0; ctx != NULL && j < num_formats; ++j)
+            {
+                if (i == j)
+                {
+                    continue;
+                }
+
+                char name[BENCH_NAME_SIZE];
+                snprintf(name, sizeof(name), "convert/%s-%s/%u", format_name(FORMATS[i]), format_name(FORMATS[j]),
+                         (unsigned)size);
+
+                ConvertArgs args = { ctx, FORMATS[j] };
+
+                BenchCase info;
+                info.group = "convert";
+                info.name = name;
+                info.width = size;
+                info.height = size;
+                info.threads = 1;
+                info.bytes = (double)(size * size * format_bpp(FORMATS[j]));
+                info.items = 1.0;
+
+                bench_run(&bench->harness, &info, convert_iteration, &args);
+            }
+
+            if (ctx != NULL)
+            {
+                imgload_context_free(ctx);
+            }
+            free(pixels);
+        }
+    }
+}
+
+static bool read_iteration(void* arg, double* seconds_out)
+{
+    ImgloadContext ctx = (ImgloadContext)arg;
+
+    ImgloadImage img;
+    if (imgload_image_init_from_memory(ctx, &img, SYNTH_FILE, sizeof(SYNTH_FILE)) != IMGLOAD_ERR_NO_ERROR)
+    {
+        return false;
+    }
+
+    double start = bench_now();
+    ImgloadErrorCode err = imgload_image_read_data(img);
+    *seconds_out = bench_now() - start;
+
+    imgload_image_free(img);
+    return err == IMGLOAD_ERR_NO_ERROR;
+}
+
+static void bench_flip(Bench* bench)
+{
+    for (size_t s = 0; s < sizeof(SYNTH_SIZES) / sizeof(SYNTH_SIZES[0]); ++s)
+    {
+        size_t size = SYNTH_SIZES[s];
+        if (size > bench->max_size || !bench_selected(&bench->harness, "flip/"))
+        {
+            continue;
+        }
+
+        SynthImage synth;
+        synth.width = size;
+        synth.height = size;
+        synth.format = IMGLOAD_FORMAT_R8G8B8A8;
+        synth.compression = IMGLOAD_COMPRESSION_NONE;
+        synth.data_size = size * size * 4;
+        synth.data = synth_pixels(size, size, 4);
+        if (synth.data == NULL)
+        {
+            continue;
+        }
+
+        // Storing the pixels of the plugin copies them, with flipping the rows are reversed while copying
+        static const char* const MODES[] = { "none", "vertical" };
+        for (size_t i = 0; i < 2; ++i)
+        {
+            ImgloadContextFlags flags = IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS | (i == 1 ? IMGLOAD_CONTEXT_FLIP_IMAGES : 0);
+            ImgloadContext ctx = bench_context(bench, flags, &synth);
+            if (ctx == NULL)
+            {
+                continue;
+            }
+
+            char name[BENCH_NAME_SIZE];
+            snprintf(name, sizeof(name), "flip/%s/%u", MODES[i], (unsigned)size);
+
+            BenchCase info;
+            info.group = "flip";
+            info.name = name;
+            info.width = size;
+            info.height = size;
+            info.threads = 1;
+            info.bytes = (double)synth.data_size;
+            info.items = 1.0;
+
+            bench_run(&bench->harness, &info, read_iteration, ctx);
+
+            imgload_context_free(ctx);
+        }
+
+        free((void*)synth.data);
+    }
+}
+
+typedef struct
+{
+    ImgloadContext ctx;
+    size_t threads;
+} DecompressArgs;
+
+static bool decompress_iteration(void* arg, double* seconds_out)
+{
+    DecompressArgs* args = (DecompressArgs*)arg;
+
+    ImgloadImage img;
+    if (imgload_image_init_from_memory(args->ctx, &img, SYNTH_FILE, sizeof(SYNTH_FILE)) != IMGLOAD_ERR_NO_ERROR)
+    {
+        return false;
+    }
+
+    ImgloadErrorCode err = imgload_image_read_data(img);
+    if (err == IMGLOAD_ERR_NO_ERROR)
+    {
+        double start = bench_now();
+        err = imgload_image_decompress_all(img, args->threads);
+        *seconds_out = bench_now() - start;
+    }
+
+    imgload_image_free(img);
+    return err == IMGLOAD_ERR_NO_ERROR;
+}
+
+static void bench_decompress(Bench* bench)
+{
+    static const ImgloadCompression COMPRESSIONS[] = {
+        IMGLOAD_COMPRESSION_DXT1, IMGLOAD_COMPRESSION_DXT5, IMGLOAD_COMPRESSION_BC4,
+        IMGLOAD_COMPRESSION_BC5, IMGLOAD_COMPRESSION_BC6H_UF16, IMGLOAD_COMPRESSION_BC7,
+    };
+
+    for (size_t s = 0; s < sizeof(SYNTH_SIZES) / sizeof(SYNTH_SIZES[0]); ++s)
+    {
+        size_t size = SYNTH_SIZES[s];
+        if (size > bench->max_size || !bench_selected(&bench->harness, "decompress/"))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < sizeof(COMPRESSIONS) / sizeof(COMPRESSIONS[0]); ++i)
+        {
+            SynthImage synth;
+            synth.width = size;
+            synth.height = size;
+            synth.format = IMGLOAD_FORMAT_R8G8B8A8;
+            synth.compression = COMPRESSIONS[i];
+            synth.data = synth_blocks(size, size, COMPRESSIONS[i], &synth.data_size);
+            if (synth.data == NULL)
+            {
+                continue;
+            }
+
+            ImgloadContext ctx = bench_context(bench, IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS, &synth);
+            for (size_t j = 0; ctx != NULL && j < bench->num_threads; ++j)
+            {
+                char name[BENCH_NAME_SIZE];
+                snprintf(name, sizeof(name), "decompress/%s/%u/t%u", compression_name(COMPRESSIONS[i]),
+                         (unsigned)size, (unsigned)bench->threads[j]);
+
+                DecompressArgs args = { ctx, bench->threads[j] };
+
+                BenchCase info;
+                info.group = "decompress";
+                info.name = name;
+                info.width = size;
+                info.height = size;
+                info.threads = args.threads;
+                info.bytes = (double)(size * size * 4);
+                info.items = 1.0;
+
+                bench_run(&bench->harness, &info, decompress_iteration, &args);
+            }
+
+            if (ctx != NULL)
+            {
+                imgload_context_free(ctx);
+            }
+            free((void*)synth.data);
+        }
+    }
+}
+
+#if BENCH_KERNELS
+
+typedef struct
+{
+    DxtRowDecoder decoder;
+    const uint8_t* blocks;
+    size_t block_size;
+    size_t blocks_x;
+    size_t blocks_y;
+    uint8_t* pixels;
+} KernelArgs;
+
+static bool kernel_iteration(void* arg, double* seconds_out)
+{
+    KernelArgs* args = (KernelArgs*)arg;
+    ptrdiff_t stride = (ptrdiff_t)(args->blocks_x * 4 * 4);
+
+    double start = bench_now();
+    for (size_t y = 0; y < args->blocks_y; ++y)
+    {
+        args->decoder(args->blocks + y * args->blocks_x * args->block_size, args->blocks_x,
+                      args->pixels + y * 4 * (size_t)stride, stride, 4, false);
+    }
+    *seconds_out = bench_now() - start;
+    return true;
+}
+
+typedef struct
+{
+    ImgloadCompression compression;
+    size_t block_size;
+    const char* isa;
+    CpuFeatures required;
+    DxtRowDecoder decoder;
+} KernelCase;
+
+/**
+ * @brief Times the DXT row kernels of every instruction set against the scalar ones
+ * The decompress benchmarks only see the kernel the library picks, so a SIMD kernel which got slower than the scalar
+ * one doesn't show up there. The scalar kernel of a compression is listed first and every kernel after it is compared
+ * to it. Timings depend on the machine so the speed is only reported, the decoded pixels have to match exactly.
+ * @return false if a SIMD kernel decodes different pixels than the scalar kernel of the same compression
+ */
+static bool bench_kernels(Bench* bench)
+{
+    static const KernelCase KERNELS[] = {
+        { IMGLOAD_COMPRESSION_DXT1, 8, "scalar", 0, dxt_decode_dxt1_scalar },
+#if DXT_HAVE_X86_KERNELS
+        { IMGLOAD_COMPRESSION_DXT1, 8, "ssse3", CPU_FEATURE_SSSE3, dxt_decode_dxt1_ssse3 },
+        { IMGLOAD_COMPRESSION_DXT1, 8, "avx2", CPU_FEATURE_AVX2, dxt_decode_dxt1_avx2 },
+#endif
+        { IMGLOAD_COMPRESSION_DXT5, 16, "scalar", 0, dxt_decode_dxt5_scalar },
+#if DXT_HAVE_X86_KERNELS
+        { IMGLOAD_COMPRESSION_DXT5, 16, "ssse3", CPU_FEATURE_SSSE3, dxt_decode_dxt5_ssse3 },
+        { IMGLOAD_COMPRESSION_DXT5, 16, "avx2", CPU_FEATURE_AVX2, dxt_decode_dxt5_avx2 },
+#endif
+        { IMGLOAD_COMPRESSION_BC4, 8, "scalar", 0, dxt_decode_bc4_scalar },
+#if DXT_HAVE_X86_KERNELS
+        { IMGLOAD_COMPRESSION_BC4, 8, "ssse3", CPU_FEATURE_SSSE3, dxt_decode_bc4_ssse3 },
+        { IMGLOAD_COMPRESSION_BC4, 8, "avx2", CPU_FEATURE_AVX2, dxt_decode_bc4_avx2 },
+#endif
+        { IMGLOAD_COMPRESSION_BC5, 16, "scalar", 0, dxt_decode_bc5_scalar },
+#if DXT_HAVE_X86_KERNELS
+        { IMGLOAD_COMPRESSION_BC5, 16, "ssse3", CPU_FEATURE_SSSE3, dxt_decode_bc5_ssse3 },
+        { IMGLOAD_COMPRESSION_BC5, 16, "avx2", CPU_FEATURE_AVX2, dxt_decode_bc5_avx2 },
+#endif
+    };
+
+    // Small enough to stay in the cache, the kernels are measured and not the memory bandwidth
+    static const size_t SIZE = 256;
+
+    if (!bench_selected(&bench->harness, "kernel/"))
+    {
+        return true;
+    }
+
+    bool ok = true;
+    CpuFeatures features = cpu_features();
+    uint8_t* pixels = (uint8_t*)malloc(SIZE * SIZE * 4);
+    uint8_t* expected = (uint8_t*)malloc(SIZE * SIZE * 4);
+    uint8_t* blocks = NULL;
+    double scalar_time = 0.0;
+
+    for (size_t i = 0; pixels != NULL && expected != NULL && i < sizeof(KERNELS) / sizeof(KERNELS[0]); ++i)
+    {
+        const KernelCase* kernel = &KERNELS[i];
+        if (kernel->required == 0)
+        {
+            free(blocks);
+            size_t size;
+            blocks = synth_blocks(SIZE, SIZE, kernel->compression, &size);
+            scalar_time = 0.0;
+        }
+        if (blocks == NULL || (features & kernel->required) != kernel->required)
+        {
+            continue;
+        }
+
+        char name[BENCH_NAME_SIZE];
+        snprintf(name, sizeof(name), "kernel/%s/%s", compression_name(kernel->compression), kernel->isa);
+
+        KernelArgs args = { kernel->decoder, blocks, kernel->block_size, SIZE / 4, SIZE / 4, pixels };
+
+        // The scalar kernel decodes the reference pixels which the other kernels are checked against
+        double seconds;
+        memset(pixels, 0, SIZE * SIZE * 4);
+        kernel_iteration(&args, &seconds);
+        if (kernel->required == 0)
+        {
+            memcpy(expected, pixels, SIZE * SIZE * 4);
+        }
+        else if (memcmp(expected, pixels, SIZE * SIZE * 4) != 0)
+        {
+            fprintf(bench->harness.log, "%s decodes different pixels than the scalar kernel!\n", name);
+            ok = false;
+        }
+
+        BenchCase info;
+        info.group = "kernel";
+        info.name = name;
+        info.width = SIZE;
+        info.height = SIZE;
+        info.threads = 1;
+        info.bytes = (double)(SIZE * SIZE * 4);
+        info.items = 1.0;
+
+        size_t num_results = bench->harness.num_results;
+        if (!bench_run(&bench->harness, &info, kernel_iteration, &args) || bench->harness.num_results == num_results)
+        {
+            continue;
+        }
+
+        const BenchResult* result = &bench->harness.results[num_results];
+        if (result->iterations == 0)
+        {
+            continue;
+        }
+
+        double time = result->seconds / (double)result->iterations;
+        if (kernel->required == 0)
+        {
+            scalar_time = time;
+        }
+        else if (scalar_time > 0.0)
+        {
+            fprintf(bench->harness.log, "%s runs at %.2fx the speed of the scalar kernel\n", name, scalar_time / time);
+        }
+    }
+
+    free(blocks);
+    free(expected);
+    free(pixels);
+    return ok;
+}
+
+#endif
+
+static void usage(void)
+{
+    printf("Usage: imgload_bench [options]\n"
+           "  --filter <text>      Only run benchmarks whose name contains the text\n"
+           "  --min-time <s>       Minimum measured time of every benchmark (default 0.2)\n"
+           "  --max-size <n>       Largest synthetic image size (default 2048)\n"
+           "  --max-threads <n>    Largest thread count (default: number of processors)\n"
+           "  --json <path>        Write the results as JSON, - writes to stdout\n"
+           "  --arena              Create contexts with IMGLOAD_CONTEXT_IMAGE_ARENA\n"
+           "  --pool               Create contexts with IMGLOAD_CONTEXT_BUFFER_POOL\n");
+}
+
+int main(int argc, char** argv)
+{
+    Bench bench;
+    memset(&bench, 0, sizeof(bench));
+    bench_init(&bench.harness);
+    bench.max_size = 2048;
+
+    size_t max_threads = bench_num_processors();
+    const char* json_path = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && has_value)
+        {
+            bench.harness.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && has_value)
+        {
+            bench.harness.min_time = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-size") == 0 && has_value)
+        {
+            bench.max_size = (size_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--max-threads") == 0 && has_value)
+        {
+            max_threads = (size_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--json") == 0 && has_value)
+        {
+            json_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--arena") == 0)
+        {
+            bench.flags |= IMGLOAD_CONTEXT_IMAGE_ARENA;
+        }
+        else if (strcmp(argv[i], "--pool") == 0)
+        {
+            bench.flags |= IMGLOAD_CONTEXT_BUFFER_POOL;
+        }
+        else
+        {
+            usage();
+            return strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    // Powers of two up to the limit, the limit itself is always included
+    if (max_threads == 0)
+    {
+        max_threads = 1;
+    }
+    for (size_t threads = 1; threads < max_threads && bench.num_threads < BENCH_MAX_THREAD_STEPS - 1; threads *= 2)
+    {
+        bench.threads[bench.num_threads++] = threads;
+    }
+    bench.threads[bench.num_threads++] = max_threads;
+
+    bool json_stdout = json_path != NULL && strcmp(json_path, "-") == 0;
+    if (json_stdout)
+    {
+        bench.harness.log = stderr;
+    }
+
+    BenchInput* inputs = (BenchInput*)calloc(BENCH_MAX_INPUTS, sizeof(BenchInput));
+    if (inputs == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    size_t num_inputs = create_inputs(&bench, inputs);
+
+    bench_probe(&bench, inputs, num_inputs);
+    bench_decode(&bench, inputs, num_inputs);
+    bench_convert(&bench);
+    bench_flip(&bench);
+    bench_decompress(&bench);
+
+    int result = EXIT_SUCCESS;
+#if BENCH_KERNELS
+    if (!bench_kernels(&bench))
+    {
+        result = EXIT_FAILURE;
+    }
+#endif
+    if (json_path != NULL)
+    {
+        FILE* out = json_stdout ? stdout : fopen(json_path, "w");
+        if (out != NULL)
+        {
+            bench_write_json(&bench.harness, out);
+            if (!json_stdout)
+            {
+                fclose(out);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "Failed to open %s!\n", json_path);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    for (size_t i = 0; i < num_inputs; ++i)
+    {
+        synth_buffer_free(&inputs[i].file);
+    }
+    free(inputs);
+    bench_free(&bench.harness);
+
+    return result;
+}
@@ -0,0 +1,258 @@
+#include "synthetic.h"
+
+#include <imageloader_plugin.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#define DDS_HEADER_SIZE 124
+#define DDS_DX10_HEADER_SIZE 20
+
+#define DDSD_REQUIRED 0x1007 // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+#define DDPF_FOURCC 0x4
+#define DDSCAPS_TEXTURE 0x1000
+#define DDS_DIMENSION_TEXTURE2D 3
+
+const uint8_t SYNTH_FILE[8] = { 'S', 'Y', 'N', 'T', 'H', 'I', 'M', 'G' };
+
+void synth_buffer_free(SynthBuffer* buffer)
+{
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+    buffer->failed = false;
+}
+
+static bool synth_buffer_append(SynthBuffer* buffer, const void* data, size_t size)
+{
+    if (buffer->capacity - buffer->size < size)
+    {
+        size_t capacity = buffer->capacity > 0 ? buffer->capacity : 4096;
+        while (capacity - buffer->size < size)
+        {
+            capacity *= 2;
+        }
+
+        uint8_t* new_data = (uint8_t*)realloc(buffer->data, capacity);
+        if (new_data == NULL)
+        {
+            return false;
+        }
+        buffer->data = new_data;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    return true;
+}
+
+static uint32_t synth_random(uint32_t* state)
+{
+    // xorshift32, the benchmarks only need reproducible noise
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+uint8_t* synth_pixels(size_t width, size_t height, size_t components)
+{
+    uint8_t* pixels = (uint8_t*)malloc(width * height * components);
+    if (pixels == NULL)
+    {
+        return NULL;
+    }
+
+    uint32_t state = 0x12345678;
+    for (size_t y = 0; y < height; ++y)
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            uint8_t* pixel = pixels + (y * width + x) * components;
+            uint32_t noise = synth_random(&state);
+
+            for (size_t c = 0; c < components; ++c)
+            {
+                size_t gradient = c % 2 == 0 ? x * 255 / width : y * 255 / height;
+                pixel[c] = (uint8_t)(gradient + ((noise >> (c * 8)) & 0x0F));
+            }
+        }
+    }
+
+    return pixels;
+}
+
+static size_t synth_block_bytes(ImgloadCompression compression)
+{
+    switch (compression)
+    {
+    case IMGLOAD_COMPRESSION_DXT1:
+    case IMGLOAD_COMPRESSION_BC4:
+    case IMGLOAD_COMPRESSION_BC4_SNORM:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
+uint8_t* synth_blocks(size_t width, size_t height, ImgloadCompression compression, size_t* size_out)
+{
+    size_t size = ((width + 3) / 4) * ((height + 3) / 4) * synth_block_bytes(compression);
+    uint8_t* blocks = (uint8_t*)malloc(size);
+    if (blocks == NULL)
+    {
+        return NULL;
+    }
+
+    uint32_t state = 0x9E3779B9;
+    for (size_t i = 0; i < size; i += 4)
+    {
+        uint32_t value = synth_random(&state);
+        memcpy(blocks + i, &value, 4);
+    }
+
+    *size_out = size;
+    return blocks;
+}
+
+static void synth_write_func(void* context, void* data, int size)
+{
+    SynthBuffer* buffer = (SynthBuffer*)context;
+    if (!synth_buffer_append(buffer, data, (size_t)size))
+    {
+        // The encoders can't handle errors of the write function
+        buffer->failed = true;
+    }
+}
+
+bool synth_encode_png(const uint8_t* pixels, size_t width, size_t height, size_t components, SynthBuffer* out)
+{
+    return stbi_write_png_to_func(synth_write_func, out, (int)width, (int)height, (int)components, pixels,
+                                  (int)(width * components)) != 0 && !out->failed;
+}
+
+bool synth_encode_tga(const uint8_t* pixels, size_t width, size_t height, size_t components, SynthBuffer* out)
+{
+    return stbi_write_tga_to_func(synth_write_func, out, (int)width, (int)height, (int)components, pixels) != 0
+        && !out->failed;
+}
+
+static void synth_write_u32(uint8_t* dst, uint32_t value)
+{
+    dst[0] = (uint8_t)value;
+    dst[1] = (uint8_t)(value >> 8);
+    dst[2] = (uint8_t)(value >> 16);
+    dst[3] = (uint8_t)(value >> 24);
+}
+
+bool synth_encode_dds(size_t width, size_t height, ImgloadCompression compression, SynthBuffer* out)
+{
+    uint32_t dxgi_format;
+    switch (compression)
+    {
+    case IMGLOAD_COMPRESSION_DXT1:
+        dxgi_format = 71; // DXGI_FORMAT_BC1_UNORM
+        break;
+    case IMGLOAD_COMPRESSION_DXT5:
+        dxgi_format = 77; // DXGI_FORMAT_BC3_UNORM
+        break;
+    case IMGLOAD_COMPRESSION_BC7:
+        dxgi_format = 98; // DXGI_FORMAT_BC7_UNORM
+        break;
+    default:
+        return false;
+    }
+
+    uint8_t header[4 + DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, "DDS ", 4);
+
+    uint8_t* dds = header + 4;
+    synth_write_u32(dds + 0, DDS_HEADER_SIZE);
+    synth_write_u32(dds + 4, DDSD_REQUIRED);
+    synth_write_u32(dds + 8, (uint32_t)height);
+    synth_write_u32(dds + 12, (uint32_t)width);
+    synth_write_u32(dds + 72, 32); // Size of the pixel format
+    synth_write_u32(dds + 76, DDPF_FOURCC);
+    memcpy(dds + 80, "DX10", 4);
+    synth_write_u32(dds + 104, DDSCAPS_TEXTURE);
+
+    uint8_t* dx10 = dds + DDS_HEADER_SIZE;
+    synth_write_u32(dx10 + 0, dxgi_format);
+    synth_write_u32(dx10 + 4, DDS_DIMENSION_TEXTURE2D);
+    synth_write_u32(dx10 + 12, 1); // Array size
+
+    size_t size;
+    uint8_t* blocks = synth_blocks(width, height, compression, &size);
+    if (blocks == NULL)
+    {
+        return false;
+    }
+
+    bool result = synth_buffer_append(out, header, sizeof(header)) && synth_buffer_append(out, blocks, size);
+    free(blocks);
+
+    return result;
+}
+
+static ImgloadErrorCode IMGLOAD_CALLBACK synth_init_image(ImgloadPlugin plugin, ImgloadImage img)
+{
+    SynthImage* image = (SynthImage*)imgload_plugin_get_data(plugin);
+
+    imgload_plugin_image_set_data_type(img, image->format, image->compression);
+    imgload_plugin_image_set_num_frames(img, 1);
+    imgload_plugin_image_set_num_mipmaps(img, 0, 1);
+
+    uint32_t width = (uint32_t)image->width;
+    uint32_t height = (uint32_t)image->height;
+    uint32_t one = 1;
+    imgload_plugin_image_set_property(img, 0, IMGLOAD_PROPERTY_WIDTH, IMGLOAD_PROPERTY_TYPE_UINT32, &width);
+    imgload_plugin_image_set_property(img, 0, IMGLOAD_PROPERTY_HEIGHT, IMGLOAD_PROPERTY_TYPE_UINT32, &height);
+    imgload_plugin_image_set_property(img, 0, IMGLOAD_PROPERTY_DEPTH, IMGLOAD_PROPERTY_TYPE_UINT32, &one);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static ImgloadErrorCode IMGLOAD_CALLBACK synth_read_data(ImgloadPlugin plugin, ImgloadImage img)
+{
+    SynthImage* image = (SynthImage*)imgload_plugin_get_data(plugin);
+
+    ImgloadImageData data;
+    data.width = image->width;
+    data.height = image->height;
+    data.depth = 1;
+    data.stride = image->compression == IMGLOAD_COMPRESSION_NONE ? image->data_size / image->height : 0;
+    data.data_size = image->data_size;
+    data.data = (void*)image->data;
+
+    // The data is copied like a plugin decoding into a temporary buffer would hand it over
+    if (image->compression != IMGLOAD_COMPRESSION_NONE)
+    {
+        return imgload_plugin_image_set_compressed_data(img, 0, 0, &data, 0);
+    }
+    return imgload_plugin_image_set_image_data(img, 0, 0, &data, 0);
+}
+
+ImgloadErrorCode IMGLOAD_CALLBACK synth_plugin_loader(ImgloadPlugin plugin, void* parameter)
+{
+    imgload_plugin_set_info(plugin, "synthetic", "Synthetic images", "Plugin providing generated images for benchmarks");
+    imgload_plugin_set_data(plugin, parameter);
+
+    ImgloadErrorCode err = imgload_plugin_register_signature(plugin, SYNTH_FILE, sizeof(SYNTH_FILE));
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
+    }
+
+    imgload_plugin_callback_init_image(plugin, synth_init_image);
+    imgload_plugin_callback_read_data(plugin, synth_read_data);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
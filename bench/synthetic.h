@@ -0,0 +1,71 @@
+#ifndef IMAGELOADER_BENCH_SYNTHETIC_H
+#define IMAGELOADER_BENCH_SYNTHETIC_H
+#pragma once
+
+#include <imageloader.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A growable block of memory holding an encoded file
+ */
+typedef struct
+{
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+    bool failed; //!< Appending failed, the contents are incomplete
+} SynthBuffer;
+
+void synth_buffer_free(SynthBuffer* buffer);
+
+/**
+ * @brief Generates pixels with smooth gradients and some noise so encoders don't compress them too well
+ * @return The pixels allocated with malloc
+ */
+uint8_t* synth_pixels(size_t width, size_t height, size_t components);
+
+/**
+ * @brief Generates random blocks of a block compression format
+ * @return The blocks allocated with malloc
+ */
+uint8_t* synth_blocks(size_t width, size_t height, ImgloadCompression compression, size_t* size_out);
+
+bool synth_encode_png(const uint8_t* pixels, size_t width, size_t height, size_t components, SynthBuffer* out);
+
+bool synth_encode_tga(const uint8_t* pixels, size_t width, size_t height, size_t components, SynthBuffer* out);
+
+/**
+ * @brief Writes a DDS file with the DX10 header, only BC1, BC3 and BC7 are supported
+ */
+bool synth_encode_dds(size_t width, size_t height, ImgloadCompression compression, SynthBuffer* out);
+
+/**
+ * @brief The image provided by the synthetic plugin, can be changed between images
+ */
+typedef struct
+{
+    size_t width;
+    size_t height;
+
+    ImgloadFormat format;
+    ImgloadCompression compression;
+
+    const uint8_t* data; //!< Pixels in format or blocks of compression, copied into every image
+    size_t data_size;
+} SynthImage;
+
+/**
+ * @brief Signature of the files loaded by the synthetic plugin, the rest of the file is ignored
+ */
+extern const uint8_t SYNTH_FILE[8];
+
+/**
+ * @brief Plugin which creates images from raw pixels or blocks without decoding anything
+ * @param parameter The SynthImage describing the images
+ */
+ImgloadErrorCode IMGLOAD_CALLBACK synth_plugin_loader(ImgloadPlugin plugin, void* parameter);
+
+#endif //IMAGELOADER_BENCH_SYNTHETIC_H
@@ -61,13 +61,14 @@ namespace
 namespace imgload
 {
 
-    Context::Context(std::unique_ptr<MemoryAllocator>&& allocator) : m_ctx(nullptr), m_allocator(std::move(allocator))
+    Context::Context(std::unique_ptr<MemoryAllocator>&& allocator, ImgloadContextFlags flags) : m_ctx(nullptr),
+                                                                                               m_allocator(std::move(allocator))
     {
         ImgloadMemoryAllocator alloc;
         alloc.realloc = class_realloc;
         alloc.free = class_free;
 
-        auto err = imgload_context_init(&m_ctx, 0, &alloc, m_allocator.get());
+        auto err = imgload_context_init(&m_ctx, flags, &alloc, m_allocator.get());
 
         if (err != IMGLOAD_ERR_NO_ERROR)
         {
@@ -115,6 +116,57 @@ namespace imgload
         m_logger = std::move(logger);
     }
 
+    void Context::setIOBufferSize(size_t size)
+    {
+        if (!m_ctx)
+        {
+            throw std::runtime_error("No context allocated!");
+        }
+
+        auto err = imgload_context_set_io_buffer_size(m_ctx, size);
+
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            throw Exception(err);
+        }
+    }
+
+    ImgloadStats Context::getStats() const
+    {
+        if (!m_ctx)
+        {
+            throw std::runtime_error("No context allocated!");
+        }
+
+        ImgloadStats stats;
+        auto err = imgload_context_get_stats(m_ctx, &stats);
+
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            throw Exception(err);
+        }
+
+        return stats;
+    }
+
+    ImgloadStats Context::getPluginStats(const char* pluginId) const
+    {
+        if (!m_ctx)
+        {
+            throw std::runtime_error("No context allocated!");
+        }
+
+        ImgloadStats stats;
+        auto err = imgload_context_get_plugin_stats(m_ctx, pluginId, &stats);
+
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            throw Exception(err);
+        }
+
+        return stats;
+    }
+
     Image Context::loadImage(std::unique_ptr<IOHandler>&& io)
     {
         ImgloadIO img_io;
@@ -131,4 +183,28 @@ namespace imgload
         // Pass io to the Image instance so it's kept alive for as long as the Image exists
         return Image(image, std::move(io));
     }
+
+    Image Context::loadImageFromMemory(const void* data, size_t size)
+    {
+        ImgloadImage image;
+        auto err = imgload_image_init_from_memory(m_ctx, &image, data, size);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            throw Exception(err);
+        }
+
+        return Image(image, nullptr);
+    }
+
+    Image Context::loadImageFromFile(const char* path)
+    {
+        ImgloadImage image;
+        auto err = imgload_image_init_from_file(m_ctx, &image, path);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            throw Exception(err);
+        }
+
+        return Image(image, nullptr);
+    }
 }
\ No newline at end of file
@@ -53,7 +53,7 @@ namespace imgload
         std::unique_ptr<Logger> m_logger;
 
     public:
-        explicit Context(std::unique_ptr<MemoryAllocator>&& allocator);
+        explicit Context(std::unique_ptr<MemoryAllocator>&& allocator, ImgloadContextFlags flags = 0);
 
         Context(Context&& other);
 
@@ -69,7 +69,20 @@ namespace imgload
 
         void setLogger(std::unique_ptr<Logger>&& logger);
 
+        void setIOBufferSize(size_t size);
+
+        /**
+         * @brief Gets the statistics of all freed images, requires IMGLOAD_CONTEXT_COLLECT_STATS
+         */
+        ImgloadStats getStats() const;
+
+        ImgloadStats getPluginStats(const char* pluginId) const;
+
         Image loadImage(std::unique_ptr<IOHandler>&& io);
+
+        Image loadImageFromMemory(const void* data, size_t size);
+
+        Image loadImageFromFile(const char* path);
     };
 }
 
@@ -110,6 +110,20 @@ imgload::Compression imgload::Image::getCompression() const
             return Compression::DXT4;
         case IMGLOAD_COMPRESSION_DXT5:
             return Compression::DXT5;
+        case IMGLOAD_COMPRESSION_BC4:
+            return Compression::BC4;
+        case IMGLOAD_COMPRESSION_BC4_SNORM:
+            return Compression::BC4_SNORM;
+        case IMGLOAD_COMPRESSION_BC5:
+            return Compression::BC5;
+        case IMGLOAD_COMPRESSION_BC5_SNORM:
+            return Compression::BC5_SNORM;
+        case IMGLOAD_COMPRESSION_BC6H_UF16:
+            return Compression::BC6H_UF16;
+        case IMGLOAD_COMPRESSION_BC6H_SF16:
+            return Compression::BC6H_SF16;
+        case IMGLOAD_COMPRESSION_BC7:
+            return Compression::BC7;
         default:
             throw std::runtime_error(
                     "Unknown compression format, C++ API probably incompatible with imgloader version!");
@@ -141,6 +155,39 @@ void imgload::Image::readData()
     }
 }
 
+void imgload::Image::readMipmaps(size_t subimage, size_t firstMipmap, size_t numMipmaps)
+{
+    auto err = imgload_image_read_mipmaps(m_image, subimage, firstMipmap, numMipmaps);
+
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        throw Exception(err);
+    }
+}
+
+void imgload::Image::decompressAll(size_t numThreads)
+{
+    auto err = imgload_image_decompress_all(m_image, numThreads);
+
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        throw Exception(err);
+    }
+}
+
+ImgloadStats imgload::Image::getStats() const
+{
+    ImgloadStats stats;
+    auto err = imgload_image_get_stats(m_image, &stats);
+
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        throw Exception(err);
+    }
+
+    return stats;
+}
+
 imgload::SubImage::SubImage(ImgloadImage image, size_t i) : m_image(image), m_index(i)
 {
 }
@@ -220,6 +267,34 @@ ImgloadImageData imgload::SubImage::getImageData(size_t mipmap)
     return data;
 }
 
+void imgload::SubImage::readImageData(size_t mipmap, void* dst, size_t dstStride)
+{
+    if (mipmap >= numMipmaps())
+    {
+        throw std::runtime_error("Mipmap out of range!");
+    }
+
+    auto err = imgload_image_data_into(m_image, m_index, mipmap, dst, dstStride);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        throw Exception(err);
+    }
+}
+
+void imgload::SubImage::readRows(size_t mipmap, size_t firstRow, size_t numRows, void* dst, size_t dstStride)
+{
+    if (mipmap >= numMipmaps())
+    {
+        throw std::runtime_error("Mipmap out of range!");
+    }
+
+    auto err = imgload_image_read_rows(m_image, m_index, mipmap, firstRow, numRows, dst, dstStride);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        throw Exception(err);
+    }
+}
+
 void Image::convertFormat(DataFormat requested, uint64_t param)
 {
     auto err = imgload_image_transform_data(m_image, imgloadFormat(requested), param);
@@ -24,6 +24,13 @@ namespace imgload
         DXT3,
         DXT4,
         DXT5,
+        BC4,
+        BC4_SNORM,
+        BC5,
+        BC5_SNORM,
+        BC6H_UF16,
+        BC6H_SF16,
+        BC7,
     };
 
     enum class Property
@@ -78,6 +85,10 @@ namespace imgload
 
         ImgloadImageData getImageData(size_t mipmap);
 
+        void readImageData(size_t mipmap, void* dst, size_t dstStride);
+
+        void readRows(size_t mipmap, size_t firstRow, size_t numRows, void* dst, size_t dstStride);
+
         friend class Image;
     };
 
@@ -159,6 +170,15 @@ namespace imgload
 
         void readData();
 
+        void readMipmaps(size_t subimage, size_t firstMipmap, size_t numMipmaps);
+
+        void decompressAll(size_t numThreads = 0);
+
+        /**
+         * @brief Gets the statistics of the image, requires IMGLOAD_CONTEXT_COLLECT_STATS
+         */
+        ImgloadStats getStats() const;
+
         friend class Context;
     };
 }
@@ -98,16 +98,46 @@ enum
 };
 typedef uint32_t ImgloadLogLevel;
 
+/**
+ * @brief Messages below this level are discarded at compile time
+ * Can be defined before including this header, the library itself is configured with the CMake variable
+ * IMGLOADER_MIN_LOG_LEVEL. Messages which pass this check are still filtered by imgload_context_set_log_level.
+ */
+#ifndef IMGLOAD_MIN_LOG_LEVEL
+#define IMGLOAD_MIN_LOG_LEVEL IMGLOAD_LOG_DEBUG
+#endif
+
 enum
 {
     IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS = 1 << 0,
     IMGLOAD_CONTEXT_FLIP_IMAGES = 1 << 1,
+    /**
+     * Images are only loaded to get their compressed data, e.g. for uploading it to the GPU. Plugins keep the blocks
+     * in a single allocation or reference the mapped file instead of handing over a copy of every mipmap.
+     */
+    IMGLOAD_CONTEXT_COMPRESSED_PASSTHROUGH = 1 << 2,
+    /**
+     * The metadata of every image (frames, mipmaps, properties and the state of the plugins) is allocated from an
+     * arena which is freed at once with the image. Pixel data still uses the allocator of the context.
+     */
+    IMGLOAD_CONTEXT_IMAGE_ARENA = 1 << 3,
+    /**
+     * Large pixel buffers of freed images are kept in a pool and reused by images of a similar size. The pool is shared
+     * by all threads using the context, see imgload_context_set_buffer_pool_limit.
+     */
+    IMGLOAD_CONTEXT_BUFFER_POOL = 1 << 4,
+    /**
+     * Every image records how much data it read and where the time was spent, see imgload_image_get_stats. The
+     * numbers are added to the context when the image is freed.
+     */
+    IMGLOAD_CONTEXT_COLLECT_STATS = 1 << 5,
 };
 typedef uint32_t ImgloadContextFlags;
 
 /**
  * @brief Custom memory allocation functions
- * Should be used if a custom memory allocator should be used in the library.
+ * Should be used if a custom memory allocator should be used in the library. If a context is used from multiple threads
+ * the functions will be called concurrently and have to be thread safe.
  */
 typedef struct
 {
@@ -128,6 +158,13 @@ typedef struct
     void (IMGLOAD_CALLBACK* free)(void* ud, void* mem);
 } ImgloadMemoryAllocator;
 
+/**
+ * @brief The context of the library which holds the registered plugins and the settings
+ *
+ * A context may be shared by multiple threads: images can be created and loaded concurrently while plugins are added
+ * and the log callback, log level or IO buffer size are changed. A single image must only be used by one thread at a
+ * time. imgload_context_free must not be called while any other function uses the context.
+ */
 typedef struct ImgloadContextImpl* ImgloadContext;
 
 typedef struct ImgloadPluginImpl* ImgloadPlugin;
@@ -140,13 +177,90 @@ typedef ImgloadErrorCode(IMGLOAD_CALLBACK* ImgloadLogHandler)(void* ud, ImgloadL
 ImgloadErrorCode IMGLOAD_API imgload_context_init(ImgloadContext* ctx_ptr, ImgloadContextFlags flags,
                                                   ImgloadMemoryAllocator* allocator, void* alloc_ud);
 
+/**
+ * @brief Adds a plugin to the context
+ * The plugin is used for images created after this call returned. Images which are created concurrently may or may not
+ * see the plugin.
+ * @param ctx The context
+ * @param loader_func The loader which initializes the plugin
+ * @param plugin_param The parameter passed to the loader
+ * @return The error code
+ */
 ImgloadErrorCode IMGLOAD_API imgload_context_add_plugin(ImgloadContext ctx, ImgloadPluginLoader loader_func,
                                                         void* plugin_param);
 
+/**
+ * @brief Sets the function which receives log messages
+ * The handler may be called from every thread which uses the context so it has to be thread safe. It must not change
+ * the log callback of the context itself.
+ * @param ctx The context
+ * @param handler The log handler
+ * @param ud The userdata passed to the handler
+ * @return The error code
+ */
 ImgloadErrorCode IMGLOAD_API imgload_context_set_log_callback(ImgloadContext ctx, ImgloadLogHandler handler, void* ud);
 
 ImgloadErrorCode IMGLOAD_API imgload_context_set_log_level(ImgloadContext ctx, ImgloadLogLevel level);
 
+/**
+ * @brief Sets the size of the read buffer used for images loaded using imgload_image_init
+ * With a buffer, small reads of plugins are served from memory and the IO functions are only called for large reads
+ * which fill the buffer. Seeks within the buffered range don't call the IO functions either. The setting applies to
+ * images created after this call. Images loaded from memory or files are never buffered.
+ * @param ctx The context
+ * @param size The buffer size in bytes, 0 disables buffering (the default)
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_context_set_io_buffer_size(ImgloadContext ctx, size_t size);
+
+/**
+ * @brief Sets how much memory the buffer pool keeps for reuse
+ * Only has an effect if the context was created with IMGLOAD_CONTEXT_BUFFER_POOL. Buffers which are freed while the
+ * pool is full go back to the allocator, lowering the limit frees cached buffers right away.
+ * @param ctx The context
+ * @param size The limit in bytes, 0 disables caching (the default is 64 MiB)
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_context_set_buffer_pool_limit(ImgloadContext ctx, size_t size);
+
+/**
+ * @brief Statistics about loading images, collected if the context has IMGLOAD_CONTEXT_COLLECT_STATS set
+ * The times don't overlap, e.g. converting the pixels while the plugin reads the image counts as conversion time.
+ */
+typedef struct
+{
+    uint64_t images; //!< The number of images the statistics were collected from
+
+    uint64_t bytes_read; //!< Bytes returned by the read functions or read from the memory of the image
+    uint64_t read_calls; //!< The number of calls to the read function of ImgloadIO
+    uint64_t seek_calls; //!< The number of calls to the seek function of ImgloadIO
+
+    uint64_t probe_ns; //!< Finding the plugin, including the probe functions of the plugins
+    uint64_t init_ns; //!< The init_image function of the plugin
+    uint64_t read_ns; //!< Reading the image data by the plugin
+    uint64_t decompress_ns; //!< Decompressing block compressed data
+    uint64_t convert_ns; //!< Changing the data format, flipping at the same time is included
+    uint64_t flip_ns; //!< Flipping images which don't need to be converted
+
+    uint64_t peak_bytes; //!< The most memory the context had allocated at once, only set for the context
+} ImgloadStats;
+
+/**
+ * @brief Gets the statistics of all images which have been freed
+ * @return IMGLOAD_ERR_NO_DATA if the context doesn't collect statistics
+ */
+ImgloadErrorCode IMGLOAD_API imgload_context_get_stats(ImgloadContext ctx, ImgloadStats* stats_out);
+
+/**
+ * @brief Gets the statistics of the freed images loaded by one plugin
+ * probe_ns is the time spent in the probe functions of the plugin for all images, including those it didn't load.
+ * @param plugin_id The id the plugin has set with imgload_plugin_set_info
+ * @return IMGLOAD_ERR_NO_DATA if the context doesn't collect statistics, IMGLOAD_ERR_OUT_OF_RANGE if there is no
+ * plugin with the id
+ */
+ImgloadErrorCode IMGLOAD_API imgload_context_get_plugin_stats(ImgloadContext ctx, const char* plugin_id,
+                                                              ImgloadStats* stats_out);
+
 ImgloadErrorCode IMGLOAD_API imgload_context_free(ImgloadContext ctx);
 
 
@@ -176,6 +290,52 @@ typedef struct
 
 typedef struct ImgloadImageImpl* ImgloadImage;
 
+/**
+ * @brief A stage of loading an image, passed to the trace handlers
+ */
+typedef struct
+{
+    const char* name; //!< The name of the stage, e.g. read_image, stays valid as long as the library is loaded
+    const char* plugin; //!< The id of the plugin handling the stage, NULL if no plugin is involved yet
+    ImgloadImage image;
+} ImgloadTraceEvent;
+
+typedef void (IMGLOAD_CALLBACK* ImgloadTraceHandler)(void* ud, const ImgloadTraceEvent* event);
+
+/**
+ * @brief Sets the functions called when a stage of loading an image begins and ends
+ * Stages nest and always end on the thread they began on. The handlers are called from every thread which uses the
+ * context so they have to be thread safe and must not change the trace callbacks of the context. Changing the
+ * callbacks while images are loaded may split a begin and end pair between the old and the new handlers.
+ * @param ctx The context
+ * @param begin Called when a stage begins, NULL together with end disables tracing
+ * @param end Called when a stage ends
+ * @param ud The userdata passed to the handlers
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_context_set_trace_callbacks(ImgloadContext ctx, ImgloadTraceHandler begin,
+                                                                 ImgloadTraceHandler end, void* ud);
+
+typedef struct ImgloadTraceWriterImpl* ImgloadTraceWriter;
+
+/**
+ * @brief Writes the stages of all images loaded by the context to a file in the Chrome trace event format
+ * The file can be opened with chrome://tracing or Perfetto. The writer replaces the trace callbacks of the context
+ * until it is closed, which has to happen before the context is freed.
+ * @param ctx The context
+ * @param path The file to write
+ * @param writer_out The writer
+ * @return IMGLOAD_ERR_IO_ERROR if the file can't be created
+ */
+ImgloadErrorCode IMGLOAD_API imgload_trace_writer_open(ImgloadContext ctx, const char* path,
+                                                       ImgloadTraceWriter* writer_out);
+
+/**
+ * @brief Removes the trace callbacks from the context and completes the file
+ * Images must not be loaded by other threads while the writer is closed.
+ */
+ImgloadErrorCode IMGLOAD_API imgload_trace_writer_close(ImgloadTraceWriter writer);
+
 enum
 {
     IMGLOAD_PROPERTY_WIDTH = 0,
@@ -218,11 +378,71 @@ enum
     IMGLOAD_COMPRESSION_DXT3 = 3,
     IMGLOAD_COMPRESSION_DXT4 = 4,
     IMGLOAD_COMPRESSION_DXT5 = 5,
+    // The library decodes the following formats to RGBA like Direct3D does: BC4 fills red, BC5 red and green and both
+    // leave alpha opaque. Signed values are mapped from [-1, 1] to [0, 255], BC6H values are clamped to [0, 1].
+    IMGLOAD_COMPRESSION_BC4 = 6,
+    IMGLOAD_COMPRESSION_BC4_SNORM = 7,
+    IMGLOAD_COMPRESSION_BC5 = 8,
+    IMGLOAD_COMPRESSION_BC5_SNORM = 9,
+    IMGLOAD_COMPRESSION_BC6H_UF16 = 10,
+    IMGLOAD_COMPRESSION_BC6H_SF16 = 11,
+    IMGLOAD_COMPRESSION_BC7 = 12,
 };
 typedef uint32_t ImgloadCompression;
 
 ImgloadErrorCode IMGLOAD_API imgload_image_init(ImgloadContext ctx, ImgloadImage* image, ImgloadIO* io, void* io_ud);
 
+/**
+ * @brief Initializes an image which is read from a memory buffer
+ * Plugins may decode directly from the buffer without copying it first.
+ * @param ctx The context to use
+ * @param image The pointer the image will be written to
+ * @param data The image file contents, must stay valid until the image is freed
+ * @param size The size of the buffer in bytes
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_init_from_memory(ImgloadContext ctx, ImgloadImage* image,
+                                                            const void* data, size_t size);
+
+/**
+ * @brief Initializes an image by memory-mapping the given file
+ * The mapping is kept until the image is freed.
+ * @param ctx The context to use
+ * @param image The pointer the image will be written to
+ * @param path The path of the file
+ * @return The error code, IMGLOAD_ERR_IO_ERROR if the file could not be mapped
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_init_from_file(ImgloadContext ctx, ImgloadImage* image, const char* path);
+
+/**
+ * @brief The metadata of an image file
+ */
+typedef struct
+{
+    size_t width; //!< The size of the first subimage
+    size_t height;
+    size_t depth;
+
+    size_t subimages;
+    size_t mipmaps; //!< The number of mipmaps of the first subimage
+
+    ImgloadFormat format; //!< The format the plugin provides the data in
+    ImgloadCompression compression;
+} ImgloadImageInfo;
+
+/**
+ * @brief Reads the metadata of an image file without creating an image
+ * Plugins which support it only parse the file header and don't allocate any memory. For the other plugins the image
+ * is initialized and freed again.
+ * @param ctx The context to use
+ * @param io The IO functions
+ * @param io_ud The userdata passed to the IO functions
+ * @param info_out The metadata of the image
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_probe_info(ImgloadContext ctx, ImgloadIO* io, void* io_ud,
+                                                      ImgloadImageInfo* info_out);
+
 size_t IMGLOAD_API imgload_image_num_subimages(ImgloadImage img);
 
 size_t IMGLOAD_API imgload_image_num_mipmaps(ImgloadImage img, size_t subimage);
@@ -241,6 +461,20 @@ ImgloadErrorCode IMGLOAD_API imgload_image_transform_data(ImgloadImage img, Imgl
 
 ImgloadErrorCode IMGLOAD_API imgload_image_read_data(ImgloadImage img);
 
+/**
+ * @brief Reads the data of a range of mipmaps of one subimage
+ * Plugins which support it seek to the requested mipmaps and only read those, e.g. for streaming the small mipmaps of
+ * a texture before the large ones. Otherwise the whole image is read like imgload_image_read_data does. Mipmaps which
+ * already have data are not read again.
+ * @param img The image
+ * @param subimage The subimage
+ * @param first_mipmap The first mipmap to read
+ * @param n_mipmaps The number of mipmaps to read
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_read_mipmaps(ImgloadImage img, size_t subimage, size_t first_mipmap,
+                                                        size_t n_mipmaps);
+
 typedef struct
 {
     size_t width;
@@ -258,8 +492,234 @@ ImgloadErrorCode IMGLOAD_API imgload_image_compressed_data(ImgloadImage img, siz
 ImgloadErrorCode IMGLOAD_API imgload_image_data(ImgloadImage img, size_t subimage, size_t mipmap,
                                                 ImgloadImageData* data);
 
+/**
+ * @brief Decompresses all mipmaps of all subimages using multiple threads
+ * Reads the compressed data if that has not been done yet. Block compressed formats are split into tiles of block rows
+ * which are decoded in parallel so large single mipmaps are decoded in parallel as well. Formats the library can't
+ * decode itself are decompressed one mipmap at a time by the plugin. Afterwards imgload_image_data returns the data of
+ * every mipmap without decompressing. Does nothing for images which are not compressed.
+ * @param img The image
+ * @param num_threads The number of threads including the calling thread, 0 uses one thread per processor
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_decompress_all(ImgloadImage img, size_t num_threads);
+
+/**
+ * @brief Decodes the image data of a mipmap directly into a caller provided buffer
+ * Flipping and format conversion are applied while writing to @p dst. If the data has not been loaded yet, it is
+ * decoded into @p dst and not kept by the image, so imgload_image_data will not return it afterwards. Data that is
+ * already loaded is copied. The buffer has to hold depth * height rows of width pixels in the format returned by
+ * imgload_image_data_format.
+ * @param img The image
+ * @param subimage The subimage
+ * @param mipmap The mipmap
+ * @param dst The buffer the first row is written to
+ * @param dst_stride The distance between the start of two rows in dst in bytes
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_data_into(ImgloadImage img, size_t subimage, size_t mipmap, void* dst,
+                                                     size_t dst_stride);
+
+/**
+ * @brief Decodes a range of rows of an image into a caller provided buffer
+ * If the plugin supports it, the rows are decoded directly into @p dst without holding the whole image in memory. For
+ * that rows should be requested in ascending order. Otherwise (or if IMGLOAD_CONTEXT_FLIP_IMAGES is set) the whole
+ * image is decoded and the requested rows are copied. The rows of all slices of a 3D image are numbered
+ * consecutively. The data is written in the format returned by imgload_image_data_format.
+ * @param img The image
+ * @param subimage The subimage
+ * @param mipmap The mipmap
+ * @param first_row The index of the first row to read
+ * @param n_rows The number of rows to read
+ * @param dst The buffer the first row is written to
+ * @param dst_stride The distance between the start of two rows in dst in bytes
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_read_rows(ImgloadImage img, size_t subimage, size_t mipmap,
+                                                     size_t first_row, size_t n_rows, void* dst, size_t dst_stride);
+
+/**
+ * @brief Gets the statistics collected since the image was created
+ * @return IMGLOAD_ERR_NO_DATA if the context doesn't collect statistics
+ */
+ImgloadErrorCode IMGLOAD_API imgload_image_get_stats(ImgloadImage img, ImgloadStats* stats_out);
+
 ImgloadErrorCode IMGLOAD_API imgload_image_free(ImgloadImage image);
 
+
+enum
+{
+    IMGLOAD_BATCH_HEADER_ONLY = 1 << 0, //!< Only initialize the images, don't call imgload_image_read_data
+};
+typedef uint32_t ImgloadBatchFlags;
+
+typedef void (IMGLOAD_CALLBACK* ImgloadBatchTaskFunc)(void* task_data);
+
+/**
+ * @brief Hands a task of a batch load to an external job system
+ * The task has to be run exactly once on a thread other than the one calling imgload_batch_load. It may run after
+ * imgload_batch_load returned but must be run before the context is freed.
+ * @param ud The userdata from ImgloadBatchOptions
+ * @param task The function to run
+ * @param task_data The argument for the function
+ */
+typedef void (IMGLOAD_CALLBACK* ImgloadBatchSubmitFunc)(void* ud, ImgloadBatchTaskFunc task, void* task_data);
+
+/**
+ * @brief Options for imgload_batch_load
+ */
+typedef struct
+{
+    /**
+     * The number of threads which load images including the calling thread, 0 uses one thread per processor. The
+     * number is limited to the number of images.
+     */
+    size_t num_threads;
+
+    ImgloadBatchFlags flags;
+
+    /**
+     * If set, num_threads - 1 tasks are submitted using this function instead of starting threads
+     */
+    ImgloadBatchSubmitFunc submit;
+    void* submit_ud;
+} ImgloadBatchOptions;
+
+/**
+ * @brief Initializes many images in parallel and reads their data
+ * Every image is initialized using imgload_image_init and then loaded using imgload_image_read_data. The images are
+ * distributed between the threads which steal work from each other when they run out so slow files don't hold up the
+ * batch. The calling thread takes part in loading and the function returns once every image has been processed.
+ * @param ctx The context
+ * @param ios The IO functions of every image
+ * @param uds The userdata of every image or @c NULL to pass @c NULL to all IO functions
+ * @param count The number of images
+ * @param images Receives the images, an entry is @c NULL if loading the image failed
+ * @param errors Receives the error code of every image, may be @c NULL
+ * @param options The options, @c NULL for the defaults
+ * @return IMGLOAD_ERR_NO_ERROR if all images were loaded, the error of the first image which failed otherwise
+ */
+ImgloadErrorCode IMGLOAD_API imgload_batch_load(ImgloadContext ctx, ImgloadIO* ios, void** uds, size_t count,
+                                                ImgloadImage* images, ImgloadErrorCode* errors,
+                                                const ImgloadBatchOptions* options);
+
+/**
+ * @brief An image which is loaded asynchronously
+ */
+typedef struct ImgloadAsyncLoadImpl* ImgloadAsyncLoad;
+
+/**
+ * @brief IO callbacks which complete reads asynchronously
+ */
+typedef struct
+{
+    /**
+     * @brief Starts reading a range of the file
+     * The read is finished by calling imgload_async_complete from any thread, this may also happen before this function
+     * returns. A load only has one read in flight at a time.
+     * @param ud The userdata passed to imgload_async_load
+     * @param load The load the read belongs to
+     * @param offset The offset in the file
+     * @param buf The buffer receiving the data, valid until the read is completed
+     * @param size The number of bytes to read, fewer bytes may only be read at the end of the file
+     */
+    void (IMGLOAD_CALLBACK* read)(void* ud, ImgloadAsyncLoad load, uint64_t offset, uint8_t* buf, size_t size);
+
+    /**
+     * @brief Called once after the last read of a load was completed, may be @c NULL
+     * @param ud The userdata passed to imgload_async_load
+     */
+    void (IMGLOAD_CALLBACK* close)(void* ud);
+} ImgloadAsyncIO;
+
+/**
+ * @brief Receives the result of an asynchronous load
+ * @param ud The userdata from ImgloadAsyncOptions
+ * @param img The image which belongs to the caller now, @c NULL if loading failed
+ * @param err The error code
+ */
+typedef void (IMGLOAD_CALLBACK* ImgloadAsyncDoneFunc)(void* ud, ImgloadImage img, ImgloadErrorCode err);
+
+/**
+ * @brief Options for imgload_async_load
+ */
+typedef struct
+{
+    /**
+     * The size of the file if it is known, the file is then read with a single request. If it is 0 the file is read
+     * in growing chunks until a read returns fewer bytes than requested.
+     */
+    uint64_t size;
+
+    ImgloadBatchFlags flags; //!< IMGLOAD_BATCH_HEADER_ONLY only initializes the image
+
+    /**
+     * If set the image is decoded in a task submitted with this function, otherwise it is decoded on the thread which
+     * completes the last read
+     */
+    ImgloadBatchSubmitFunc submit;
+    void* submit_ud;
+
+    ImgloadAsyncDoneFunc done; //!< Required
+    void* done_ud;
+} ImgloadAsyncOptions;
+
+/**
+ * @brief Starts loading an image using asynchronous IO
+ * The file is read into memory using the read callback without blocking the calling thread. Once the last read is
+ * completed the image is decoded like imgload_batch_load does and passed to the done function. The context must not be
+ * freed before every load is done.
+ * @param ctx The context
+ * @param io The IO callbacks, copied by the function
+ * @param io_ud The userdata passed to the IO callbacks
+ * @param options The options
+ * @return The error code, if it's not IMGLOAD_ERR_NO_ERROR no callback is called
+ */
+ImgloadErrorCode IMGLOAD_API imgload_async_load(ImgloadContext ctx, const ImgloadAsyncIO* io, void* io_ud,
+                                                const ImgloadAsyncOptions* options);
+
+/**
+ * @brief Completes the read which is in flight for a load
+ * Without a submit function the image is decoded inside this function after the last read.
+ * @param load The load
+ * @param bytes_read The number of bytes written to the buffer
+ * @param err IMGLOAD_ERR_NO_ERROR or the error of the read which fails the load
+ */
+void IMGLOAD_API imgload_async_complete(ImgloadAsyncLoad load, size_t bytes_read, ImgloadErrorCode err);
+
+/**
+ * @brief Asynchronous IO for local files using a pool of threads doing blocking reads
+ */
+typedef struct ImgloadAsyncFileReaderImpl* ImgloadAsyncFileReader;
+
+/**
+ * @brief Starts the threads of a file reader
+ * @param ctx The context
+ * @param num_threads The number of reading threads, 0 uses one thread per processor
+ * @param reader_out Receives the reader
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_async_file_reader_init(ImgloadContext ctx, size_t num_threads,
+                                                            ImgloadAsyncFileReader* reader_out);
+
+/**
+ * @brief Loads a file asynchronously using imgload_async_load
+ * If the size in the options is 0 it is determined from the file.
+ * @param reader The reader
+ * @param path The path of the file
+ * @param options The options
+ * @return The error code, IMGLOAD_ERR_IO_ERROR if the file could not be opened
+ */
+ImgloadErrorCode IMGLOAD_API imgload_async_file_reader_load(ImgloadAsyncFileReader reader, const char* path,
+                                                            const ImgloadAsyncOptions* options);
+
+/**
+ * @brief Stops the threads of a file reader, every load of the reader has to be done
+ * @param reader The reader
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_async_file_reader_free(ImgloadAsyncFileReader reader);
+
 #ifdef __cplusplus
 }
 #endif
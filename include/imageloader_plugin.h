@@ -12,38 +12,184 @@ extern "C"
 void* IMGLOAD_API imgload_plugin_realloc(ImgloadPlugin plugin, void* ptr, size_t size);
 void IMGLOAD_API imgload_plugin_free(ImgloadPlugin plugin, void* ptr);
 
+/**
+ * @brief Allocates zero initialized memory for the metadata of an image
+ * If the context has IMGLOAD_CONTEXT_IMAGE_ARENA set the memory comes from the arena of the image. It must not be
+ * passed to imgload_plugin_realloc or handed over as image data.
+ * @param img The image
+ * @param size The size in bytes
+ * @return The memory or @c NULL if allocation failed
+ */
+void* IMGLOAD_API imgload_plugin_image_alloc(ImgloadImage img, size_t size);
+
+/**
+ * @brief Frees memory of imgload_plugin_image_alloc
+ * Arena memory is only reused if it was the last allocation of the image, everything else is released with the image.
+ * @param img The image
+ * @param ptr The memory, may be @c NULL
+ */
+void IMGLOAD_API imgload_plugin_image_dealloc(ImgloadImage img, void* ptr);
+
+/**
+ * @brief Logs a message prefixed with the id of the plugin
+ * The format string is only evaluated if the level passes the log level of the context and a handler is set.
+ * @param plugin The plugin
+ * @param level The level of the message
+ * @param format The printf format string
+ */
 void IMGLOAD_API imgload_plugin_log(ImgloadPlugin plugin, ImgloadLogLevel level, const char* format, ...);
 
+/**
+ * @brief Logs a message unless the level is below IMGLOAD_MIN_LOG_LEVEL
+ * With a constant level the call and its arguments are removed entirely by the compiler if the level is filtered.
+ */
+#define IMGLOAD_PLUGIN_LOG(plugin, level, ...) \
+    do \
+    { \
+        if ((level) >= IMGLOAD_MIN_LOG_LEVEL) \
+        { \
+            imgload_plugin_log(plugin, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
 void IMGLOAD_API imgload_plugin_set_data(ImgloadPlugin plugin, void* data);
 void* IMGLOAD_API imgload_plugin_get_data(ImgloadPlugin plugin);
 
 void IMGLOAD_API imgload_plugin_set_info(ImgloadPlugin plugin, const char* id, const char* name, const char* description);
 
+/**
+ * @brief Registers a magic value the files supported by this plugin start with
+ * Images with a matching signature are passed directly to this plugin without probing other plugins. If multiple
+ * signatures match, the longest one wins. A plugin which registers signatures but has no probe function is only used
+ * for files matching one of its signatures. This may only be called from the plugin loader function.
+ * @param plugin The plugin
+ * @param signature The bytes at the start of the file
+ * @param size The number of bytes, at most IMGLOAD_PLUGIN_HEADER_SIZE
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_plugin_register_signature(ImgloadPlugin plugin, const uint8_t* signature, size_t size);
+
+
+/**
+ * @brief The maximum number of bytes of the file start that are passed to a header probe function
+ */
+#define IMGLOAD_PLUGIN_HEADER_SIZE 256
+
+/**
+ * @brief Possible return values of a header probe function
+ */
+enum
+{
+    IMGLOAD_PROBE_NO = 0, //!< The plugin can't handle the image
+    IMGLOAD_PROBE_YES = 1, //!< The plugin can handle the image
+    IMGLOAD_PROBE_UNKNOWN = 2, //!< The header is not enough to decide, the stream probe function should be used
+};
+typedef int ImgloadProbeResult;
 
 typedef void(IMGLOAD_CALLBACK *ImgloadPluginDeinitFunc)(ImgloadPlugin plugin);
 
 typedef int(IMGLOAD_CALLBACK *ImgloadPluginProbeFunc)(ImgloadPlugin plugin, ImgloadImage img);
 
+/**
+ * @brief Probes an image using only the first bytes of the file
+ * The header is read once and shared between all plugins. If the plugin accepts the image then its init function is
+ * called with the stream positioned at the start of the file.
+ * @param plugin The plugin
+ * @param header The first bytes of the file
+ * @param size The number of valid bytes in header, at most IMGLOAD_PLUGIN_HEADER_SIZE
+ * @return One of the IMGLOAD_PROBE_* values
+ */
+typedef ImgloadProbeResult(IMGLOAD_CALLBACK *ImgloadPluginProbeHeaderFunc)(ImgloadPlugin plugin, const uint8_t* header,
+                                                                          size_t size);
+
 typedef ImgloadErrorCode(IMGLOAD_CALLBACK *ImgloadPluginImageFunc)(ImgloadPlugin plugin, ImgloadImage img);
 
+/**
+ * @brief Reads the metadata of an image from its header
+ * The image is not initialized and the stream is positioned at the start of the file. Only the read, seek, map and size
+ * functions may be used on the image.
+ * @param plugin The plugin
+ * @param img The image
+ * @param info_out The metadata of the image
+ * @return The error code, IMGLOAD_ERR_NO_DATA if the image has to be initialized to get the metadata
+ */
+typedef ImgloadErrorCode(IMGLOAD_CALLBACK *ImgloadPluginImageInfoFunc)(ImgloadPlugin plugin, ImgloadImage img,
+                                                                       ImgloadImageInfo* info_out);
+
 typedef ImgloadErrorCode(IMGLOAD_CALLBACK *ImgloadPluginDecompressData)(ImgloadPlugin plugin, ImgloadImage img, size_t subimage, size_t mipmap);
 
+/**
+ * @brief Decodes a range of rows directly into a caller provided buffer
+ * Rows are written in the format set with imgload_plugin_image_set_data_type and the rows of all slices are numbered
+ * consecutively. A plugin may require that rows are requested in ascending order.
+ * @param plugin The plugin
+ * @param img The image
+ * @param subimage The subimage
+ * @param mipmap The mipmap
+ * @param first_row The first row to decode
+ * @param n_rows The number of rows to decode
+ * @param dst The buffer the first row is written to
+ * @param dst_stride The distance between the start of two rows in dst in bytes
+ * @return The error code, IMGLOAD_ERR_NO_DATA if the rows can't be streamed and the whole image should be decoded
+ */
+typedef ImgloadErrorCode(IMGLOAD_CALLBACK *ImgloadPluginReadRowsFunc)(ImgloadPlugin plugin, ImgloadImage img,
+                                                                      size_t subimage, size_t mipmap, size_t first_row,
+                                                                      size_t n_rows, uint8_t* dst, size_t dst_stride);
+
+/**
+ * @brief Reads the data of a range of mipmaps of one subimage
+ * @param plugin The plugin
+ * @param img The image
+ * @param subimage The subimage
+ * @param first_mipmap The first mipmap to read
+ * @param n_mipmaps The number of mipmaps to read
+ * @return The error code, IMGLOAD_ERR_NO_DATA if the plugin can't read single mipmaps of this image
+ */
+typedef ImgloadErrorCode(IMGLOAD_CALLBACK *ImgloadPluginReadMipmapsFunc)(ImgloadPlugin plugin, ImgloadImage img,
+                                                                         size_t subimage, size_t first_mipmap,
+                                                                         size_t n_mipmaps);
 
 void IMGLOAD_API imgload_plugin_callback_deinit(ImgloadPlugin plugin, ImgloadPluginDeinitFunc func);
 
 void IMGLOAD_API imgload_plugin_callback_probe(ImgloadPlugin plugin, ImgloadPluginProbeFunc func);
 
+void IMGLOAD_API imgload_plugin_callback_probe_header(ImgloadPlugin plugin, ImgloadPluginProbeHeaderFunc func);
+
 void IMGLOAD_API imgload_plugin_callback_init_image(ImgloadPlugin plugin, ImgloadPluginImageFunc func);
 
 void IMGLOAD_API imgload_plugin_callback_deinit_image(ImgloadPlugin plugin, ImgloadPluginImageFunc func);
 
+void IMGLOAD_API imgload_plugin_callback_image_info(ImgloadPlugin plugin, ImgloadPluginImageInfoFunc func);
+
 void IMGLOAD_API imgload_plugin_callback_read_data(ImgloadPlugin plugin, ImgloadPluginImageFunc func);
 
+void IMGLOAD_API imgload_plugin_callback_read_rows(ImgloadPlugin plugin, ImgloadPluginReadRowsFunc func);
+
+void IMGLOAD_API imgload_plugin_callback_read_mipmaps(ImgloadPlugin plugin, ImgloadPluginReadMipmapsFunc func);
+
 void IMGLOAD_API imgload_plugin_callback_decompress_data(ImgloadPlugin plugin, ImgloadPluginDecompressData func);
 
 size_t IMGLOAD_API imgload_plugin_image_read(ImgloadImage img, uint8_t* buf, size_t size);
 int64_t IMGLOAD_API imgload_plugin_image_seek(ImgloadImage img, int64_t offset, int whence);
 
+/**
+ * @brief Gets direct access to a range of the image file
+ * This only works if the image was created from memory or a file, for normal streams @c NULL is returned and the
+ * plugin has to use imgload_plugin_image_read instead. The current read position is not changed.
+ * @param img The image
+ * @param offset The offset of the range from the beginning of the file
+ * @param size The size of the range
+ * @return A pointer to the data which is valid until the image is freed or @c NULL if not possible
+ */
+const uint8_t* IMGLOAD_API imgload_plugin_image_map(ImgloadImage img, uint64_t offset, size_t size);
+
+/**
+ * @brief Determines the total size of the image file
+ * @param img The image
+ * @return The size in bytes or a negative value if unknown
+ */
+int64_t IMGLOAD_API imgload_plugin_image_size(ImgloadImage img);
+
 void IMGLOAD_API imgload_plugin_image_set_data(ImgloadImage img, void* data);
 void* IMGLOAD_API imgload_plugin_image_get_data(ImgloadImage img);
 
@@ -62,6 +208,26 @@ ImgloadErrorCode IMGLOAD_API imgload_plugin_image_set_compressed_data(ImgloadIma
 ImgloadErrorCode IMGLOAD_API imgload_plugin_image_set_image_data(ImgloadImage img, size_t subimage, size_t mipmap,
     ImgloadImageData* data, int transfer_ownership);
 
+/**
+ * @brief Sets compressed data without copying it
+ * The memory stays owned by the plugin and has to be valid until the deinit_image callback of the image was called.
+ * Memory returned by imgload_plugin_image_map can be referenced as well.
+ * @param img The image
+ * @param subimage The subimage
+ * @param mipmap The mipmap
+ * @param data The compressed data
+ * @return The error code
+ */
+ImgloadErrorCode IMGLOAD_API imgload_plugin_image_reference_compressed_data(ImgloadImage img, size_t subimage,
+    size_t mipmap, ImgloadImageData* data);
+
+/**
+ * @brief Checks if the image is loaded with IMGLOAD_CONTEXT_COMPRESSED_PASSTHROUGH
+ * @param img The image
+ * @return Non-zero if the compressed data should be referenced instead of copied
+ */
+int IMGLOAD_API imgload_plugin_image_compressed_passthrough(ImgloadImage img);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,508 @@
+#include <imageloader.h>
+
+#include "context.h"
+#include "image.h"
+#include "log.h"
+#include "memory.h"
+#include "thread.h"
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+// Size of the first read of a file with unknown size, every further read doubles the buffer
+#define ASYNC_INITIAL_CHUNK_SIZE (64 * 1024)
+
+/**
+ * @brief The state of an asynchronous load
+ * The reads of a load are strictly sequential. The thread which completes a read continues the load, unless the read
+ * completed while the read function was still running. Then the thread which called the read function continues so
+ * synchronous IO doesn't recurse for every chunk.
+ */
+struct ImgloadAsyncLoadImpl
+{
+    ImgloadContext ctx;
+
+    ImgloadAsyncIO io;
+    void* io_ud;
+    ImgloadAsyncOptions options;
+
+    uint8_t* data;
+    size_t size; //!< The number of bytes read so far
+    size_t capacity;
+
+    size_t requested; //!< The size of the read in flight
+    bool end_of_file;
+    ImgloadErrorCode err;
+
+    ThreadMutex lock;
+    bool issuing; //!< The read function is running
+    bool completed_early; //!< The read was completed before the read function returned
+};
+
+static void async_free(ImgloadAsyncLoad load)
+{
+    ImgloadContext ctx = load->ctx;
+
+    thread_mutex_destroy(&load->lock);
+    mem_free(ctx, load->data);
+    mem_free(ctx, load);
+}
+
+static void async_decode(ImgloadAsyncLoad load)
+{
+    ImgloadContext ctx = load->ctx;
+    ImgloadAsyncOptions options = load->options;
+    ImgloadErrorCode err = load->err;
+    ImgloadImage img = NULL;
+
+    if (err == IMGLOAD_ERR_NO_ERROR)
+    {
+        // The image owns the data from now on
+        uint8_t* data = load->data;
+        load->data = NULL;
+
+        err = image_init_from_owned_memory(ctx, &img, data, load->size);
+
+        if (err == IMGLOAD_ERR_NO_ERROR && !(options.flags & IMGLOAD_BATCH_HEADER_ONLY))
+        {
+            err = imgload_image_read_data(img);
+            if (err != IMGLOAD_ERR_NO_ERROR)
+            {
+                imgload_image_free(img);
+            }
+        }
+
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            img = NULL;
+        }
+    }
+
+    async_free(load);
+
+    options.done(options.done_ud, img, err);
+}
+
+static void IMGLOAD_CALLBACK async_decode_task(void* task_data)
+{
+    async_decode((ImgloadAsyncLoad)task_data);
+}
+
+static void async_finish(ImgloadAsyncLoad load)
+{
+    if (load->io.close != NULL)
+    {
+        load->io.close(load->io_ud);
+    }
+
+    if (load->err == IMGLOAD_ERR_NO_ERROR && load->options.submit != NULL)
+    {
+        load->options.submit(load->options.submit_ud, async_decode_task, load);
+        return;
+    }
+
+    async_decode(load);
+}
+
+/**
+ * @brief Determines the size of the next read and makes room for it
+ * @return @c false if there is nothing left to read
+ */
+static bool async_prepare_read(ImgloadAsyncLoad load)
+{
+    if (load->err != IMGLOAD_ERR_NO_ERROR || load->end_of_file)
+    {
+        return false;
+    }
+
+    if (load->size == load->capacity)
+    {
+        if (load->options.size != 0)
+        {
+            // Files of known size are read completely, there is no need to check for more data
+            return false;
+        }
+
+        if (load->capacity > SIZE_MAX / 2)
+        {
+            load->err = IMGLOAD_ERR_OUT_OF_MEMORY;
+            return false;
+        }
+
+        size_t capacity = load->capacity * 2;
+        uint8_t* data = (uint8_t*)mem_realloc(load->ctx, load->data, capacity);
+        if (data == NULL)
+        {
+            load->err = IMGLOAD_ERR_OUT_OF_MEMORY;
+            return false;
+        }
+
+        load->data = data;
+        load->capacity = capacity;
+    }
+
+    load->requested = load->capacity - load->size;
+    return true;
+}
+
+static void async_run(ImgloadAsyncLoad load)
+{
+    while (async_prepare_read(load))
+    {
+        thread_mutex_lock(&load->lock);
+        load->issuing = true;
+        load->completed_early = false;
+        thread_mutex_unlock(&load->lock);
+
+        load->io.read(load->io_ud, load, (uint64_t)load->size, load->data + load->size, load->requested);
+
+        thread_mutex_lock(&load->lock);
+        load->issuing = false;
+        bool completed = load->completed_early;
+        thread_mutex_unlock(&load->lock);
+
+        if (!completed)
+        {
+            // The completing thread continues, the load may already be freed
+            return;
+        }
+    }
+
+    async_finish(load);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_async_load(ImgloadContext ctx, const ImgloadAsyncIO* io, void* io_ud,
+                                                const ImgloadAsyncOptions* options)
+{
+    assert(ctx != NULL);
+    assert(io != NULL && io->read != NULL);
+    assert(options != NULL && options->done != NULL);
+
+    if (options->size > SIZE_MAX)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    ImgloadAsyncLoad load = (ImgloadAsyncLoad)mem_reallocz(ctx, NULL, sizeof(struct ImgloadAsyncLoadImpl));
+    if (load == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    load->ctx = ctx;
+    load->io = *io;
+    load->io_ud = io_ud;
+    load->options = *options;
+
+    // Allocated up front so the load can't fail before the first read because of memory
+    load->capacity = options->size != 0 ? (size_t)options->size : ASYNC_INITIAL_CHUNK_SIZE;
+    load->data = (uint8_t*)mem_realloc(ctx, NULL, load->capacity);
+    if (load->data == NULL)
+    {
+        mem_free(ctx, load);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    if (!thread_mutex_init(&load->lock))
+    {
+        mem_free(ctx, load->data);
+        mem_free(ctx, load);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    async_run(load);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+void IMGLOAD_API imgload_async_complete(ImgloadAsyncLoad load, size_t bytes_read, ImgloadErrorCode err)
+{
+    assert(load != NULL);
+    assert(bytes_read <= load->requested);
+
+    thread_mutex_lock(&load->lock);
+
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        load->err = err;
+    }
+    else
+    {
+        load->size += bytes_read;
+        load->end_of_file = bytes_read < load->requested;
+    }
+
+    bool issuing = load->issuing;
+    load->completed_early = issuing;
+
+    thread_mutex_unlock(&load->lock);
+
+    if (!issuing)
+    {
+        async_run(load);
+    }
+}
+
+/**
+ * @brief A file opened by an asynchronous file reader together with its read in flight
+ */
+typedef struct AsyncFile
+{
+    ImgloadAsyncFileReader reader;
+    FILE* file;
+    uint64_t position;
+
+    struct AsyncFile* next; //!< The next file in the queue of the reader
+
+    ImgloadAsyncLoad load;
+    uint64_t offset;
+    uint8_t* buf;
+    size_t size;
+} AsyncFile;
+
+struct ImgloadAsyncFileReaderImpl
+{
+    ImgloadContext ctx;
+
+    ThreadMutex lock;
+    ThreadCondition queued; //!< Signaled when a read is queued or the reader stops
+
+    // Files with a read which has not been started yet
+    AsyncFile* first;
+    AsyncFile* last;
+    bool stopping;
+
+    Thread* threads;
+    size_t num_threads;
+};
+
+static ImgloadErrorCode async_file_read_blocking(AsyncFile* file, size_t* read_out)
+{
+    *read_out = 0;
+
+    if (file->offset != file->position)
+    {
+        if (file->offset > LONG_MAX || fseek(file->file, (long)file->offset, SEEK_SET) != 0)
+        {
+            return IMGLOAD_ERR_IO_ERROR;
+        }
+        file->position = file->offset;
+    }
+
+    size_t read = fread(file->buf, 1, file->size, file->file);
+    file->position += read;
+
+    if (read < file->size && ferror(file->file))
+    {
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    *read_out = read;
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static void async_reader_thread(void* arg)
+{
+    ImgloadAsyncFileReader reader = (ImgloadAsyncFileReader)arg;
+
+    for (;;)
+    {
+        thread_mutex_lock(&reader->lock);
+        while (reader->first == NULL && !reader->stopping)
+        {
+            thread_condition_wait(&reader->queued, &reader->lock);
+        }
+
+        AsyncFile* file = reader->first;
+        if (file == NULL)
+        {
+            thread_mutex_unlock(&reader->lock);
+            return;
+        }
+
+        reader->first = file->next;
+        if (reader->first == NULL)
+        {
+            reader->last = NULL;
+        }
+        thread_mutex_unlock(&reader->lock);
+
+        size_t read;
+        ImgloadErrorCode err = async_file_read_blocking(file, &read);
+
+        // May decode the image and close the file
+        imgload_async_complete(file->load, read, err);
+    }
+}
+
+static void IMGLOAD_CALLBACK async_file_read(void* ud, ImgloadAsyncLoad load, uint64_t offset, uint8_t* buf,
+                                             size_t size)
+{
+    AsyncFile* file = (AsyncFile*)ud;
+    ImgloadAsyncFileReader reader = file->reader;
+
+    file->load = load;
+    file->offset = offset;
+    file->buf = buf;
+    file->size = size;
+    file->next = NULL;
+
+    thread_mutex_lock(&reader->lock);
+    if (reader->last != NULL)
+    {
+        reader->last->next = file;
+    }
+    else
+    {
+        reader->first = file;
+    }
+    reader->last = file;
+    thread_condition_broadcast(&reader->queued);
+    thread_mutex_unlock(&reader->lock);
+}
+
+static void IMGLOAD_CALLBACK async_file_close(void* ud)
+{
+    AsyncFile* file = (AsyncFile*)ud;
+
+    fclose(file->file);
+    mem_free(file->reader->ctx, file);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_async_file_reader_init(ImgloadContext ctx, size_t num_threads,
+                                                            ImgloadAsyncFileReader* reader_out)
+{
+    assert(ctx != NULL);
+    assert(reader_out != NULL);
+
+    if (num_threads == 0)
+    {
+        num_threads = thread_hardware_concurrency();
+    }
+
+    ImgloadAsyncFileReader reader = (ImgloadAsyncFileReader)mem_reallocz(ctx, NULL,
+                                                                         sizeof(struct ImgloadAsyncFileReaderImpl));
+    if (reader == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    reader->ctx = ctx;
+
+    reader->threads = (Thread*)mem_realloc(ctx, NULL, num_threads * sizeof(Thread));
+    if (reader->threads == NULL)
+    {
+        mem_free(ctx, reader);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    if (!thread_mutex_init(&reader->lock))
+    {
+        mem_free(ctx, reader->threads);
+        mem_free(ctx, reader);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    if (!thread_condition_init(&reader->queued))
+    {
+        thread_mutex_destroy(&reader->lock);
+        mem_free(ctx, reader->threads);
+        mem_free(ctx, reader);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    // Work with fewer threads if some can't be started
+    while (reader->num_threads < num_threads
+           && thread_create(&reader->threads[reader->num_threads], async_reader_thread, reader))
+    {
+        ++reader->num_threads;
+    }
+
+    if (reader->num_threads == 0)
+    {
+        imgload_async_file_reader_free(reader);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    *reader_out = reader;
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_async_file_reader_load(ImgloadAsyncFileReader reader, const char* path,
+                                                            const ImgloadAsyncOptions* options)
+{
+    assert(reader != NULL);
+    assert(path != NULL);
+    assert(options != NULL);
+
+    ImgloadContext ctx = reader->ctx;
+
+    AsyncFile* file = (AsyncFile*)mem_reallocz(ctx, NULL, sizeof(AsyncFile));
+    if (file == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    file->reader = reader;
+
+    file->file = fopen(path, "rb");
+    if (file->file == NULL)
+    {
+        print_to_log(ctx, IMGLOAD_LOG_ERROR, "Failed to open file '%s'!\n", path);
+        mem_free(ctx, file);
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    ImgloadAsyncOptions file_options = *options;
+    if (file_options.size == 0 && fseek(file->file, 0, SEEK_END) == 0)
+    {
+        // Reading in chunks still works if the size can't be determined
+        long size = ftell(file->file);
+        if (size > 0 && fseek(file->file, 0, SEEK_SET) == 0)
+        {
+            file_options.size = (uint64_t)size;
+        }
+        else
+        {
+            rewind(file->file);
+        }
+    }
+
+    ImgloadAsyncIO io;
+    io.read = async_file_read;
+    io.close = async_file_close;
+
+    ImgloadErrorCode err = imgload_async_load(ctx, &io, file, &file_options);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        fclose(file->file);
+        mem_free(ctx, file);
+    }
+
+    return err;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_async_file_reader_free(ImgloadAsyncFileReader reader)
+{
+    assert(reader != NULL);
+
+    ImgloadContext ctx = reader->ctx;
+
+    thread_mutex_lock(&reader->lock);
+    assert(reader->first == NULL);
+    reader->stopping = true;
+    thread_condition_broadcast(&reader->queued);
+    thread_mutex_unlock(&reader->lock);
+
+    for (size_t i = 0; i < reader->num_threads; ++i)
+    {
+        thread_join(&reader->threads[i]);
+    }
+
+    thread_condition_destroy(&reader->queued);
+    thread_mutex_destroy(&reader->lock);
+
+    mem_free(ctx, reader->threads);
+    mem_free(ctx, reader);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
@@ -0,0 +1,354 @@
+#include <imageloader.h>
+
+#include "context.h"
+#include "memory.h"
+#include "thread.h"
+
+#include <assert.h>
+#include <string.h>
+
+/**
+ * @brief The range of images a worker has not started yet
+ * The owner takes images from the front, other workers steal from the back.
+ */
+typedef struct
+{
+    ThreadMutex lock;
+
+    size_t begin;
+    size_t end;
+} BatchQueue;
+
+/**
+ * @brief The shared state of a batch load
+ * Submitted tasks may start after imgload_batch_load returned so the state is reference counted. Tasks which start
+ * after the batch has been closed only release their reference and never touch the caller's arrays.
+ */
+typedef struct
+{
+    ImgloadContext ctx;
+
+    ImgloadIO* ios;
+    void** uds;
+    ImgloadImage* images;
+    ImgloadErrorCode* errors; //!< Owned by the batch, copied to the caller when done
+    ImgloadBatchFlags flags;
+
+    BatchQueue* queues;
+    size_t num_queues;
+
+    ThreadMutex lock;
+    ThreadCondition finished; //!< Signaled when the last active worker is done
+
+    size_t next_queue; //!< Queue of the next task which starts
+    size_t active; //!< Number of workers which are currently loading images
+    size_t refs;
+    bool closed;
+} Batch;
+
+static void batch_free(Batch* batch)
+{
+    ImgloadContext ctx = batch->ctx;
+
+    for (size_t i = 0; i < batch->num_queues; ++i)
+    {
+        thread_mutex_destroy(&batch->queues[i].lock);
+    }
+    thread_condition_destroy(&batch->finished);
+    thread_mutex_destroy(&batch->lock);
+
+    mem_free(ctx, batch->queues);
+    mem_free(ctx, batch->errors);
+    mem_free(ctx, batch);
+}
+
+static Batch* batch_alloc(ImgloadContext ctx, size_t count, size_t num_queues)
+{
+    Batch* batch = (Batch*)mem_reallocz(ctx, NULL, sizeof(Batch));
+    if (batch == NULL)
+    {
+        return NULL;
+    }
+    batch->ctx = ctx;
+
+    batch->errors = (ImgloadErrorCode*)mem_reallocz(ctx, NULL, count * sizeof(ImgloadErrorCode));
+    batch->queues = (BatchQueue*)mem_reallocz(ctx, NULL, num_queues * sizeof(BatchQueue));
+    if (batch->errors == NULL || batch->queues == NULL)
+    {
+        mem_free(ctx, batch->errors);
+        mem_free(ctx, batch->queues);
+        mem_free(ctx, batch);
+        return NULL;
+    }
+
+    if (!thread_mutex_init(&batch->lock))
+    {
+        mem_free(ctx, batch->errors);
+        mem_free(ctx, batch->queues);
+        mem_free(ctx, batch);
+        return NULL;
+    }
+    if (!thread_condition_init(&batch->finished))
+    {
+        thread_mutex_destroy(&batch->lock);
+        mem_free(ctx, batch->errors);
+        mem_free(ctx, batch->queues);
+        mem_free(ctx, batch);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < num_queues; ++i)
+    {
+        if (!thread_mutex_init(&batch->queues[i].lock))
+        {
+            batch_free(batch);
+            return NULL;
+        }
+
+        // Only initialized queues are destroyed by batch_free
+        batch->num_queues = i + 1;
+
+        // Split the images evenly, the queues start out in file order so neighbouring files are loaded together
+        batch->queues[i].begin = i * count / num_queues;
+        batch->queues[i].end = (i + 1) * count / num_queues;
+    }
+
+    return batch;
+}
+
+/**
+ * @brief Gets the next image a worker should load
+ * @return @c false if there are no images left in any queue
+ */
+static bool batch_take(Batch* batch, size_t queue_index, size_t* index)
+{
+    BatchQueue* own = &batch->queues[queue_index];
+
+    thread_mutex_lock(&own->lock);
+    if (own->begin < own->end)
+    {
+        *index = own->begin++;
+        thread_mutex_unlock(&own->lock);
+        return true;
+    }
+    thread_mutex_unlock(&own->lock);
+
+    // Steal half of the remaining images of another worker so stealing is rare
+    for (size_t i = 1; i < batch->num_queues; ++i)
+    {
+        BatchQueue* victim = &batch->queues[(queue_index + i) % batch->num_queues];
+
+        thread_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->begin;
+        if (remaining == 0)
+        {
+            thread_mutex_unlock(&victim->lock);
+            continue;
+        }
+
+        size_t stolen = (remaining + 1) / 2;
+        size_t first = victim->end - stolen;
+        victim->end = first;
+        thread_mutex_unlock(&victim->lock);
+
+        // The own queue is empty so other workers can't take anything from it in the meantime
+        thread_mutex_lock(&own->lock);
+        own->begin = first + 1;
+        own->end = first + stolen;
+        thread_mutex_unlock(&own->lock);
+
+        *index = first;
+        return true;
+    }
+
+    return false;
+}
+
+static void batch_load_image(Batch* batch, size_t index)
+{
+    ImgloadImage img = NULL;
+    void* ud = batch->uds != NULL ? batch->uds[index] : NULL;
+
+    ImgloadErrorCode err = imgload_image_init(batch->ctx, &img, &batch->ios[index], ud);
+
+    if (err == IMGLOAD_ERR_NO_ERROR && !(batch->flags & IMGLOAD_BATCH_HEADER_ONLY))
+    {
+        err = imgload_image_read_data(img);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            imgload_image_free(img);
+        }
+    }
+
+    batch->images[index] = err == IMGLOAD_ERR_NO_ERROR ? img : NULL;
+    batch->errors[index] = err;
+}
+
+static void batch_work(Batch* batch, size_t queue_index)
+{
+    size_t index;
+    while (batch_take(batch, queue_index, &index))
+    {
+        batch_load_image(batch, index);
+    }
+}
+
+static void batch_release(Batch* batch)
+{
+    thread_mutex_lock(&batch->lock);
+    bool last = --batch->refs == 0;
+    thread_mutex_unlock(&batch->lock);
+
+    if (last)
+    {
+        batch_free(batch);
+    }
+}
+
+static void IMGLOAD_CALLBACK batch_task(void* task_data)
+{
+    Batch* batch = (Batch*)task_data;
+
+    thread_mutex_lock(&batch->lock);
+    bool run = !batch->closed;
+    size_t queue_index = 0;
+    if (run)
+    {
+        queue_index = batch->next_queue++ % batch->num_queues;
+        ++batch->active;
+    }
+    thread_mutex_unlock(&batch->lock);
+
+    if (run)
+    {
+        batch_work(batch, queue_index);
+
+        thread_mutex_lock(&batch->lock);
+        if (--batch->active == 0)
+        {
+            thread_condition_broadcast(&batch->finished);
+        }
+        thread_mutex_unlock(&batch->lock);
+    }
+
+    batch_release(batch);
+}
+
+static void batch_thread(void* arg)
+{
+    batch_task(arg);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_batch_load(ImgloadContext ctx, ImgloadIO* ios, void** uds, size_t count,
+                                                ImgloadImage* images, ImgloadErrorCode* errors,
+                                                const ImgloadBatchOptions* options)
+{
+    assert(ctx != NULL);
+    assert(ios != NULL || count == 0);
+    assert(images != NULL || count == 0);
+
+    if (count == 0)
+    {
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadBatchOptions default_options;
+    memset(&default_options, 0, sizeof(default_options));
+    if (options == NULL)
+    {
+        options = &default_options;
+    }
+
+    size_t num_threads = options->num_threads != 0 ? options->num_threads : thread_hardware_concurrency();
+    if (num_threads > count)
+    {
+        num_threads = count;
+    }
+
+    Batch* batch = batch_alloc(ctx, count, num_threads);
+    if (batch == NULL)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            images[i] = NULL;
+            if (errors != NULL)
+            {
+                errors[i] = IMGLOAD_ERR_OUT_OF_MEMORY;
+            }
+        }
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    batch->ios = ios;
+    batch->uds = uds;
+    batch->images = images;
+    batch->flags = options->flags;
+
+    // The calling thread works on the first queue
+    batch->next_queue = 1;
+    batch->active = 1;
+    batch->refs = num_threads;
+
+    Thread* threads = NULL;
+    size_t num_started = 0;
+    if (options->submit != NULL)
+    {
+        for (size_t i = 1; i < num_threads; ++i)
+        {
+            options->submit(options->submit_ud, batch_task, batch);
+        }
+    }
+    else if (num_threads > 1)
+    {
+        threads = (Thread*)mem_realloc(ctx, NULL, (num_threads - 1) * sizeof(Thread));
+
+        for (size_t i = 0; threads != NULL && i < num_threads - 1; ++i)
+        {
+            if (!thread_create(&threads[num_started], batch_thread, batch))
+            {
+                break;
+            }
+            ++num_started;
+        }
+
+        // The queues of threads which could not be started are stolen by the others
+        thread_mutex_lock(&batch->lock);
+        batch->refs -= (num_threads - 1) - num_started;
+        thread_mutex_unlock(&batch->lock);
+    }
+
+    batch_work(batch, 0);
+
+    // Wait for images which are still loaded by other workers, tasks that did not start yet will not start loading
+    thread_mutex_lock(&batch->lock);
+    batch->closed = true;
+    --batch->active;
+    while (batch->active > 0)
+    {
+        thread_condition_wait(&batch->finished, &batch->lock);
+    }
+    thread_mutex_unlock(&batch->lock);
+
+    for (size_t i = 0; i < num_started; ++i)
+    {
+        thread_join(&threads[i]);
+    }
+    mem_free(ctx, threads);
+
+    ImgloadErrorCode result = IMGLOAD_ERR_NO_ERROR;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (result == IMGLOAD_ERR_NO_ERROR)
+        {
+            result = batch->errors[i];
+        }
+        if (errors != NULL)
+        {
+            errors[i] = batch->errors[i];
+        }
+    }
+
+    batch_release(batch);
+
+    return result;
+}
@@ -0,0 +1,656 @@
+#include "bptc.h"
+
+#include <string.h>
+
+#define BPTC_BLOCK_DIM 4
+#define BPTC_BLOCK_PIXELS 16
+
+/**
+ * The subset of every pixel of the partitions with two subsets, one bit per pixel
+ */
+static const uint16_t PARTITIONS_2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+/**
+ * The subset of every pixel of the partitions with three subsets, two bits per pixel
+ */
+static const uint32_t PARTITIONS_3[64] = {
+    0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050, 0x5555A0A0, 0x5A5A5050,
+    0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090, 0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250,
+    0xA5945040, 0x0A425054, 0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+    0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414, 0x50A4A450, 0x6A5A0200,
+    0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424, 0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50,
+    0x500AA550, 0xAAAA4444, 0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+    0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580, 0xAA141414, 0x96960000,
+    0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000, 0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254,
+};
+
+// The pixels whose index has one bit less, the anchor of the first subset is always pixel 0
+static const uint8_t ANCHORS_2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+static const uint8_t ANCHORS_3_SECOND[64] = {
+     3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+     3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+     8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+     3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+};
+
+static const uint8_t ANCHORS_3_THIRD[64] = {
+    15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+    15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+    15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+    15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+};
+
+static const uint8_t WEIGHTS_2[4] = { 0, 21, 43, 64 };
+static const uint8_t WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint8_t WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static const uint8_t* index_weights(unsigned int bits)
+{
+    switch (bits)
+    {
+    case 2:
+        return WEIGHTS_2;
+    case 3:
+        return WEIGHTS_3;
+    default:
+        return WEIGHTS_4;
+    }
+}
+
+/**
+ * @brief Reads the fields of a block, starting with the lowest bit of the first byte
+ */
+typedef struct
+{
+    uint64_t low;
+    uint64_t high;
+    unsigned int pos;
+} BitReader;
+
+static void bits_init(BitReader* reader, const uint8_t* block)
+{
+    reader->low = 0;
+    reader->high = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        reader->low |= (uint64_t)block[i] << (8 * i);
+        reader->high |= (uint64_t)block[8 + i] << (8 * i);
+    }
+    reader->pos = 0;
+}
+
+static uint32_t bits_read(BitReader* reader, unsigned int count)
+{
+    uint64_t value;
+    if (reader->pos >= 64)
+    {
+        value = reader->high >> (reader->pos - 64);
+    }
+    else if (reader->pos + count <= 64)
+    {
+        value = reader->low >> reader->pos;
+    }
+    else
+    {
+        value = (reader->low >> reader->pos) | (reader->high << (64 - reader->pos));
+    }
+    reader->pos += count;
+
+    return (uint32_t)(value & ((1u << count) - 1));
+}
+
+static uint8_t partition_subset(unsigned int subsets, unsigned int partition, unsigned int pixel)
+{
+    switch (subsets)
+    {
+    case 2:
+        return (uint8_t)((PARTITIONS_2[partition] >> pixel) & 1);
+    case 3:
+        return (uint8_t)((PARTITIONS_3[partition] >> (2 * pixel)) & 3);
+    default:
+        return 0;
+    }
+}
+
+static bool is_anchor(unsigned int subsets, unsigned int partition, unsigned int pixel)
+{
+    switch (subsets)
+    {
+    case 2:
+        return pixel == 0 || pixel == ANCHORS_2[partition];
+    case 3:
+        return pixel == 0 || pixel == ANCHORS_3_SECOND[partition] || pixel == ANCHORS_3_THIRD[partition];
+    default:
+        return pixel == 0;
+    }
+}
+
+static int interpolate(int e0, int e1, unsigned int weight)
+{
+    return ((64 - (int)weight) * e0 + (int)weight * e1 + 32) >> 6;
+}
+
+static void store_block(const uint8_t* pixels, uint8_t* dst, ptrdiff_t dst_stride, size_t rows, bool bgra)
+{
+    for (size_t y = 0; y < rows; ++y)
+    {
+        uint8_t* row = dst + (ptrdiff_t)y * dst_stride;
+        for (size_t x = 0; x < BPTC_BLOCK_DIM; ++x)
+        {
+            const uint8_t* pixel = pixels + (y * BPTC_BLOCK_DIM + x) * 4;
+
+            row[x * 4] = pixel[bgra ? 2 : 0];
+            row[x * 4 + 1] = pixel[1];
+            row[x * 4 + 2] = pixel[bgra ? 0 : 2];
+            row[x * 4 + 3] = pixel[3];
+        }
+    }
+}
+
+typedef struct
+{
+    uint8_t subsets;
+    uint8_t partition_bits;
+    uint8_t rotation_bits;
+    uint8_t index_selection_bits;
+    uint8_t color_bits;
+    uint8_t alpha_bits; //!< 0 if the mode has no alpha
+    uint8_t endpoint_pbits; //!< Every endpoint has its own p-bit
+    uint8_t shared_pbits; //!< Both endpoints of a subset share their p-bit
+    uint8_t index_bits;
+    uint8_t index2_bits; //!< 0 if the mode has only one set of indices
+} Bc7Mode;
+
+static const Bc7Mode BC7_MODES[8] = {
+    { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+    { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+    { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+    { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+    { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+    { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+    { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+    { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+};
+
+static uint8_t bc7_expand(uint32_t value, unsigned int bits)
+{
+    value <<= 8 - bits;
+    return (uint8_t)(value | (value >> bits));
+}
+
+static void bc7_decode_block(const uint8_t* block, uint8_t pixels[BPTC_BLOCK_PIXELS][4])
+{
+    // The mode is the number of zero bits before the first set bit
+    unsigned int mode = 0;
+    while (mode < 8 && !(block[0] & (1 << mode)))
+    {
+        ++mode;
+    }
+
+    if (mode == 8)
+    {
+        // Reserved, decoded as transparent black
+        memset(pixels, 0, BPTC_BLOCK_PIXELS * 4);
+        return;
+    }
+
+    const Bc7Mode* info = &BC7_MODES[mode];
+
+    BitReader bits;
+    bits_init(&bits, block);
+    bits.pos = mode + 1;
+
+    unsigned int partition = bits_read(&bits, info->partition_bits);
+    unsigned int rotation = bits_read(&bits, info->rotation_bits);
+    unsigned int index_selection = bits_read(&bits, info->index_selection_bits);
+
+    unsigned int num_endpoints = info->subsets * 2u;
+    uint32_t endpoints[6][4];
+
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        for (unsigned int e = 0; e < num_endpoints; ++e)
+        {
+            endpoints[e][c] = bits_read(&bits, info->color_bits);
+        }
+    }
+    for (unsigned int e = 0; e < num_endpoints; ++e)
+    {
+        endpoints[e][3] = bits_read(&bits, info->alpha_bits);
+    }
+
+    uint32_t pbits[6] = { 0, 0, 0, 0, 0, 0 };
+    bool has_pbits = info->endpoint_pbits || info->shared_pbits;
+    if (info->endpoint_pbits)
+    {
+        for (unsigned int e = 0; e < num_endpoints; ++e)
+        {
+            pbits[e] = bits_read(&bits, 1);
+        }
+    }
+    else if (info->shared_pbits)
+    {
+        for (unsigned int s = 0; s < info->subsets; ++s)
+        {
+            pbits[2 * s] = pbits[2 * s + 1] = bits_read(&bits, 1);
+        }
+    }
+
+    uint8_t colors[6][4];
+    for (unsigned int e = 0; e < num_endpoints; ++e)
+    {
+        for (unsigned int c = 0; c < 4; ++c)
+        {
+            unsigned int channel_bits = c < 3 ? info->color_bits : info->alpha_bits;
+            if (channel_bits == 0)
+            {
+                colors[e][c] = 255;
+                continue;
+            }
+
+            uint32_t value = endpoints[e][c];
+            if (has_pbits)
+            {
+                value = (value << 1) | pbits[e];
+                ++channel_bits;
+            }
+            colors[e][c] = bc7_expand(value, channel_bits);
+        }
+    }
+
+    uint8_t indices[BPTC_BLOCK_PIXELS];
+    uint8_t indices2[BPTC_BLOCK_PIXELS];
+    for (unsigned int i = 0; i < BPTC_BLOCK_PIXELS; ++i)
+    {
+        indices[i] = (uint8_t)bits_read(&bits, info->index_bits - (is_anchor(info->subsets, partition, i) ? 1 : 0));
+    }
+    if (info->index2_bits != 0)
+    {
+        for (unsigned int i = 0; i < BPTC_BLOCK_PIXELS; ++i)
+        {
+            indices2[i] = (uint8_t)bits_read(&bits, info->index2_bits - (i == 0 ? 1 : 0));
+        }
+    }
+
+    const uint8_t* weights = index_weights(info->index_bits);
+    const uint8_t* weights2 = index_weights(info->index2_bits);
+
+    for (unsigned int i = 0; i < BPTC_BLOCK_PIXELS; ++i)
+    {
+        unsigned int subset = partition_subset(info->subsets, partition, i);
+        const uint8_t* e0 = colors[2 * subset];
+        const uint8_t* e1 = colors[2 * subset + 1];
+
+        unsigned int color_weight = weights[indices[i]];
+        unsigned int alpha_weight = color_weight;
+        if (info->index2_bits != 0)
+        {
+            // The index selection bit swaps the indices used for color and alpha
+            color_weight = index_selection ? weights2[indices2[i]] : weights[indices[i]];
+            alpha_weight = index_selection ? weights[indices[i]] : weights2[indices2[i]];
+        }
+
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            pixels[i][c] = (uint8_t)interpolate(e0[c], e1[c], color_weight);
+        }
+        pixels[i][3] = (uint8_t)interpolate(e0[3], e1[3], alpha_weight);
+
+        if (rotation != 0)
+        {
+            // Swap alpha with red, green or blue
+            uint8_t alpha = pixels[i][3];
+            pixels[i][3] = pixels[i][rotation - 1];
+            pixels[i][rotation - 1] = alpha;
+        }
+    }
+}
+
+void bptc_decode_bc7(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                     bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        uint8_t pixels[BPTC_BLOCK_PIXELS][4];
+        bc7_decode_block(src + i * 16, pixels);
+
+        store_block(pixels[0], dst + i * BPTC_BLOCK_DIM * 4, dst_stride, rows, bgra);
+    }
+}
+
+/**
+ * @brief Bits of an endpoint value stored in the header of a BC6H block
+ */
+typedef struct
+{
+    uint8_t value; //!< 3 * endpoint + channel
+    uint8_t shift;
+    uint8_t bits;
+} Bc6hField;
+
+typedef struct
+{
+    bool transformed; //!< Endpoints after the first one are stored as deltas
+    uint8_t regions;
+    uint8_t endpoint_bits;
+    uint8_t delta_bits[3];
+
+    Bc6hField fields[24]; //!< In the order they are stored, unused fields have no bits
+} Bc6hMode;
+
+// Endpoints 0 and 1 belong to the first region, 2 and 3 to the second one
+#define R(e, shift, bits) { 3 * (e), shift, bits }
+#define G(e, shift, bits) { 3 * (e) + 1, shift, bits }
+#define B(e, shift, bits) { 3 * (e) + 2, shift, bits }
+
+static const Bc6hMode BC6H_MODES[14] = {
+    { true, 2, 10, { 5, 5, 5 }, {
+        G(2, 4, 1), B(2, 4, 1), B(3, 4, 1), R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 5), G(3, 4, 1), G(2, 0, 4),
+        G(1, 0, 5), B(3, 0, 1), G(3, 0, 4), B(1, 0, 5), B(3, 1, 1), B(2, 0, 4), R(2, 0, 5), B(3, 2, 1), R(3, 0, 5),
+        B(3, 3, 1) } },
+    { true, 2, 7, { 6, 6, 6 }, {
+        G(2, 5, 1), G(3, 4, 1), G(3, 5, 1), R(0, 0, 7), B(3, 0, 1), B(3, 1, 1), B(2, 4, 1), G(0, 0, 7), B(2, 5, 1),
+        B(3, 2, 1), G(2, 4, 1), B(0, 0, 7), B(3, 3, 1), B(3, 5, 1), B(3, 4, 1), R(1, 0, 6), G(2, 0, 4), G(1, 0, 6),
+        G(3, 0, 4), B(1, 0, 6), B(2, 0, 4), R(2, 0, 6), R(3, 0, 6) } },
+    { true, 2, 11, { 5, 4, 4 }, {
+        R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 5), R(0, 10, 1), G(2, 0, 4), G(1, 0, 4), G(0, 10, 1),
+        B(3, 0, 1), G(3, 0, 4), B(1, 0, 4), B(0, 10, 1), B(3, 1, 1), B(2, 0, 4), R(2, 0, 5), B(3, 2, 1), R(3, 0, 5),
+        B(3, 3, 1) } },
+    { true, 2, 11, { 4, 5, 4 }, {
+        R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 4), R(0, 10, 1), G(3, 4, 1), G(2, 0, 4), G(1, 0, 5),
+        G(0, 10, 1), G(3, 0, 4), B(1, 0, 4), B(0, 10, 1), B(3, 1, 1), B(2, 0, 4), R(2, 0, 4), B(3, 0, 1), B(3, 2, 1),
+        R(3, 0, 4), G(2, 4, 1), B(3, 3, 1) } },
+    { true, 2, 11, { 4, 4, 5 }, {
+        R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 4), R(0, 10, 1), B(2, 4, 1), G(2, 0, 4), G(1, 0, 4),
+        G(0, 10, 1), B(3, 0, 1), G(3, 0, 4), B(1, 0, 5), B(0, 10, 1), B(2, 0, 4), R(2, 0, 4), B(3, 1, 1), B(3, 2, 1),
+        R(3, 0, 4), B(3, 4, 1), B(3, 3, 1) } },
+    { true, 2, 9, { 5, 5, 5 }, {
+        R(0, 0, 9), B(2, 4, 1), G(0, 0, 9), G(2, 4, 1), B(0, 0, 9), B(3, 4, 1), R(1, 0, 5), G(3, 4, 1), G(2, 0, 4),
+        G(1, 0, 5), B(3, 0, 1), G(3, 0, 4), B(1, 0, 5), B(3, 1, 1), B(2, 0, 4), R(2, 0, 5), B(3, 2, 1), R(3, 0, 5),
+        B(3, 3, 1) } },
+    { true, 2, 8, { 6, 5, 5 }, {
+        R(0, 0, 8), G(3, 4, 1), B(2, 4, 1), G(0, 0, 8), B(3, 2, 1), G(2, 4, 1), B(0, 0, 8), B(3, 3, 1), B(3, 4, 1),
+        R(1, 0, 6), G(2, 0, 4), G(1, 0, 5), B(3, 0, 1), G(3, 0, 4), B(1, 0, 5), B(3, 1, 1), B(2, 0, 4), R(2, 0, 6),
+        R(3, 0, 6) } },
+    { true, 2, 8, { 5, 6, 5 }, {
+        R(0, 0, 8), B(3, 0, 1), B(2, 4, 1), G(0, 0, 8), G(2, 5, 1), G(2, 4, 1), B(0, 0, 8), G(3, 5, 1), B(3, 4, 1),
+        R(1, 0, 5), G(3, 4, 1), G(2, 0, 4), G(1, 0, 6), G(3, 0, 4), B(1, 0, 5), B(3, 1, 1), B(2, 0, 4), R(2, 0, 5),
+        B(3, 2, 1), R(3, 0, 5), B(3, 3, 1) } },
+    { true, 2, 8, { 5, 5, 6 }, {
+        R(0, 0, 8), B(3, 1, 1), B(2, 4, 1), G(0, 0, 8), B(2, 5, 1), G(2, 4, 1), B(0, 0, 8), B(3, 5, 1), B(3, 4, 1),
+        R(1, 0, 5), G(3, 4, 1), G(2, 0, 4), G(1, 0, 5), B(3, 0, 1), G(3, 0, 4), B(1, 0, 6), B(2, 0, 4), R(2, 0, 5),
+        B(3, 2, 1), R(3, 0, 5), B(3, 3, 1) } },
+    { false, 2, 6, { 6, 6, 6 }, {
+        R(0, 0, 6), G(3, 4, 1), B(3, 0, 1), B(3, 1, 1), B(2, 4, 1), G(0, 0, 6), G(2, 5, 1), B(2, 5, 1), B(3, 2, 1),
+        G(2, 4, 1), B(0, 0, 6), G(3, 5, 1), B(3, 3, 1), B(3, 5, 1), B(3, 4, 1), R(1, 0, 6), G(2, 0, 4), G(1, 0, 6),
+        G(3, 0, 4), B(1, 0, 6), B(2, 0, 4), R(2, 0, 6), R(3, 0, 6) } },
+    { false, 1, 10, { 10, 10, 10 }, {
+        R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 10), G(1, 0, 10), B(1, 0, 10) } },
+    { true, 1, 11, { 9, 9, 9 }, {
+        R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 9), R(0, 10, 1), G(1, 0, 9), G(0, 10, 1), B(1, 0, 9),
+        B(0, 10, 1) } },
+    // The high bits of the first endpoint are stored in reverse order
+    { true, 1, 12, { 8, 8, 8 }, {
+        R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 8), R(0, 11, 1), R(0, 10, 1), G(1, 0, 8), G(0, 11, 1),
+        G(0, 10, 1), B(1, 0, 8), B(0, 11, 1), B(0, 10, 1) } },
+    { true, 1, 16, { 4, 4, 4 }, {
+        R(0, 0, 10), G(0, 0, 10), B(0, 0, 10), R(1, 0, 4), R(0, 15, 1), R(0, 14, 1), R(0, 13, 1), R(0, 12, 1),
+        R(0, 11, 1), R(0, 10, 1), G(1, 0, 4), G(0, 15, 1), G(0, 14, 1), G(0, 13, 1), G(0, 12, 1), G(0, 11, 1),
+        G(0, 10, 1), B(1, 0, 4), B(0, 15, 1), B(0, 14, 1), B(0, 13, 1), B(0, 12, 1), B(0, 11, 1), B(0, 10, 1) } },
+};
+
+#undef R
+#undef G
+#undef B
+
+/**
+ * @brief Gets the mode of a BC6H block from its first five bits, -1 for reserved modes
+ */
+static int bc6h_mode(uint32_t bits)
+{
+    // Modes with a two bit mode field
+    if ((bits & 0x2) == 0)
+    {
+        return (int)(bits & 0x1);
+    }
+
+    switch (bits)
+    {
+    case 0x02:
+        return 2;
+    case 0x06:
+        return 3;
+    case 0x0A:
+        return 4;
+    case 0x0E:
+        return 5;
+    case 0x12:
+        return 6;
+    case 0x16:
+        return 7;
+    case 0x1A:
+        return 8;
+    case 0x1E:
+        return 9;
+    case 0x03:
+        return 10;
+    case 0x07:
+        return 11;
+    case 0x0B:
+        return 12;
+    case 0x0F:
+        return 13;
+    default:
+        return -1;
+    }
+}
+
+static int32_t sign_extend(uint32_t value, unsigned int bits)
+{
+    uint32_t sign = 1u << (bits - 1);
+    value &= (sign << 1) - 1;
+
+    return (int32_t)(value ^ sign) - (int32_t)sign;
+}
+
+/**
+ * @brief Scales an endpoint to 16 bits
+ */
+static int32_t bc6h_unquantize(int32_t value, unsigned int bits, bool is_signed)
+{
+    if (!is_signed)
+    {
+        if (bits >= 15 || value == 0)
+        {
+            return value;
+        }
+        if (value == (1 << bits) - 1)
+        {
+            return 0xFFFF;
+        }
+        return ((value << 15) + 0x4000) >> (bits - 1);
+    }
+
+    if (bits >= 16)
+    {
+        return value;
+    }
+
+    bool negative = value < 0;
+    if (negative)
+    {
+        value = -value;
+    }
+
+    int32_t result;
+    if (value == 0)
+    {
+        result = 0;
+    }
+    else if (value >= (1 << (bits - 1)) - 1)
+    {
+        result = 0x7FFF;
+    }
+    else
+    {
+        result = ((value << 15) + 0x4000) >> (bits - 1);
+    }
+
+    return negative ? -result : result;
+}
+
+/**
+ * @brief Converts an interpolated value to the bits of a half float
+ */
+static uint16_t bc6h_to_half(int32_t value, bool is_signed)
+{
+    if (!is_signed)
+    {
+        return (uint16_t)((value * 31) >> 6);
+    }
+    if (value < 0)
+    {
+        return (uint16_t)(0x8000 | ((-value * 31) >> 5));
+    }
+    return (uint16_t)((value * 31) >> 5);
+}
+
+static uint8_t half_to_unorm8(uint16_t half)
+{
+    uint32_t exponent = (half >> 10) & 0x1F;
+    if (half & 0x8000)
+    {
+        return 0;
+    }
+    if (exponent >= 15)
+    {
+        return 255;
+    }
+
+    // The value is mantissa / 2^shift, the result is rounded to nearest
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t shift = 24;
+    if (exponent != 0)
+    {
+        mantissa |= 0x400;
+        shift = 25 - exponent;
+    }
+
+    return (uint8_t)((mantissa * 255 + (1u << (shift - 1))) >> shift);
+}
+
+static void bc6h_decode_block(const uint8_t* block, bool is_signed, uint8_t pixels[BPTC_BLOCK_PIXELS][4])
+{
+    BitReader bits;
+    bits_init(&bits, block);
+
+    int mode_index = bc6h_mode(block[0] & 0x1F);
+    if (mode_index < 0)
+    {
+        // Reserved, decoded as black
+        for (unsigned int i = 0; i < BPTC_BLOCK_PIXELS; ++i)
+        {
+            pixels[i][0] = pixels[i][1] = pixels[i][2] = 0;
+            pixels[i][3] = 255;
+        }
+        return;
+    }
+
+    const Bc6hMode* mode = &BC6H_MODES[mode_index];
+    bits.pos = mode_index < 2 ? 2 : 5;
+
+    uint32_t raw[4][3];
+    memset(raw, 0, sizeof(raw));
+    for (unsigned int i = 0; i < sizeof(mode->fields) / sizeof(mode->fields[0]) && mode->fields[i].bits != 0; ++i)
+    {
+        const Bc6hField* field = &mode->fields[i];
+        raw[field->value / 3][field->value % 3] |= bits_read(&bits, field->bits) << field->shift;
+    }
+
+    unsigned int partition = mode->regions == 2 ? bits_read(&bits, 5) : 0;
+    unsigned int num_endpoints = mode->regions * 2u;
+
+    int32_t endpoints[4][3];
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+        uint32_t mask = (1u << mode->endpoint_bits) - 1;
+
+        endpoints[0][c] = is_signed ? sign_extend(raw[0][c], mode->endpoint_bits) : (int32_t)raw[0][c];
+
+        for (unsigned int e = 1; e < num_endpoints; ++e)
+        {
+            int32_t value = (int32_t)raw[e][c];
+            if (mode->transformed || is_signed)
+            {
+                value = sign_extend(raw[e][c], mode->delta_bits[c]);
+            }
+            if (mode->transformed)
+            {
+                // Deltas are relative to the first endpoint and wrap around
+                uint32_t sum = ((uint32_t)endpoints[0][c] + (uint32_t)value) & mask;
+                value = is_signed ? sign_extend(sum, mode->endpoint_bits) : (int32_t)sum;
+            }
+            endpoints[e][c] = value;
+        }
+
+        for (unsigned int e = 0; e < num_endpoints; ++e)
+        {
+            endpoints[e][c] = bc6h_unquantize(endpoints[e][c], mode->endpoint_bits, is_signed);
+        }
+    }
+
+    unsigned int index_bits = mode->regions == 2 ? 3 : 4;
+    const uint8_t* weights = index_weights(index_bits);
+
+    for (unsigned int i = 0; i < BPTC_BLOCK_PIXELS; ++i)
+    {
+        unsigned int index = bits_read(&bits, index_bits - (is_anchor(mode->regions, partition, i) ? 1 : 0));
+        unsigned int region = partition_subset(mode->regions, partition, i);
+
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            int32_t value = interpolate(endpoints[2 * region][c], endpoints[2 * region + 1][c], weights[index]);
+            pixels[i][c] = half_to_unorm8(bc6h_to_half(value, is_signed));
+        }
+        pixels[i][3] = 255;
+    }
+}
+
+static void bc6h_decode(const uint8_t* src, size_t num_blocks, bool is_signed, uint8_t* dst, ptrdiff_t dst_stride,
+                        size_t rows, bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        uint8_t pixels[BPTC_BLOCK_PIXELS][4];
+        bc6h_decode_block(src + i * 16, is_signed, pixels);
+
+        store_block(pixels[0], dst + i * BPTC_BLOCK_DIM * 4, dst_stride, rows, bgra);
+    }
+}
+
+void bptc_decode_bc6h_uf16(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra)
+{
+    bc6h_decode(src, num_blocks, false, dst, dst_stride, rows, bgra);
+}
+
+void bptc_decode_bc6h_sf16(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra)
+{
+    bc6h_decode(src, num_blocks, true, dst, dst_stride, rows, bgra);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Decoders of the BPTC formats BC6H and BC7 with the signature of DxtRowDecoder. Every block selects a mode with its
+// own bit layout so the blocks are decoded one pixel at a time.
+
+/**
+ * @brief Decodes unsigned BC6H blocks, the half float colors are clamped to [0, 1]
+ */
+void bptc_decode_bc6h_uf16(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra);
+
+/**
+ * @brief Decodes signed BC6H blocks, the half float colors are clamped to [0, 1]
+ */
+void bptc_decode_bc6h_sf16(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra);
+
+/**
+ * @brief Decodes BC7 blocks
+ */
+void bptc_decode_bc7(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                     bool bgra);
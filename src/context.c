@@ -19,6 +19,15 @@
 #include "plugin_stb_image.h"
 #endif
 
+/**
+ * @brief Frees the memory of the context itself
+ * The context isn't allocated with mem_realloc so it doesn't have the header for tracking memory statistics.
+ */
+static void context_dealloc(ImgloadContext ctx)
+{
+    ctx->mem.allocator.free(ctx->mem.ud, ctx);
+}
+
 static int register_default_plugins(ImgloadContext ctx)
 {
 #if IMGLOADER_WITH_LIBDDSIMG
@@ -66,6 +75,43 @@ ImgloadErrorCode IMGLOAD_API imgload_context_init(ImgloadContext* ctx_ptr, Imglo
 
     ctx->log.minLevel = IMGLOAD_LOG_ERROR;
 
+    if (!thread_rwlock_init(&ctx->plugin_lock))
+    {
+        context_dealloc(ctx);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    if (!thread_rwlock_init(&ctx->log.lock))
+    {
+        thread_rwlock_destroy(&ctx->plugin_lock);
+        context_dealloc(ctx);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    if (!thread_rwlock_init(&ctx->trace.lock))
+    {
+        thread_rwlock_destroy(&ctx->log.lock);
+        thread_rwlock_destroy(&ctx->plugin_lock);
+        context_dealloc(ctx);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    if (!mem_pool_init(&ctx->pool, (flags & IMGLOAD_CONTEXT_BUFFER_POOL) != 0))
+    {
+        thread_rwlock_destroy(&ctx->trace.lock);
+        thread_rwlock_destroy(&ctx->log.lock);
+        thread_rwlock_destroy(&ctx->plugin_lock);
+        context_dealloc(ctx);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    if ((flags & IMGLOAD_CONTEXT_COLLECT_STATS) && !thread_mutex_init(&ctx->stats.lock))
+    {
+        mem_pool_destroy(ctx, &ctx->pool);
+        thread_rwlock_destroy(&ctx->trace.lock);
+        thread_rwlock_destroy(&ctx->log.lock);
+        thread_rwlock_destroy(&ctx->plugin_lock);
+        context_dealloc(ctx);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    ctx->stats.enabled = (flags & IMGLOAD_CONTEXT_COLLECT_STATS) != 0;
+
     if (!(flags & IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS))
     {
         if (!register_default_plugins(ctx))
@@ -80,6 +126,47 @@ ImgloadErrorCode IMGLOAD_API imgload_context_init(ImgloadContext* ctx_ptr, Imglo
     return IMGLOAD_ERR_NO_ERROR;
 }
 
+static void register_signatures(ImgloadContext ctx, ImgloadPlugin plugin)
+{
+    for (size_t i = 0; i < plugin->signatures.count; ++i)
+    {
+        PluginSignature* signature = &plugin->signatures.list[i];
+
+        // Keep the bucket sorted by length, signatures of the same length stay in registration order
+        PluginSignature** insert_pos = &ctx->signatures[signature->bytes[0]];
+        while (*insert_pos != NULL && (*insert_pos)->size >= signature->size)
+        {
+            insert_pos = &(*insert_pos)->next;
+        }
+
+        signature->next = *insert_pos;
+        *insert_pos = signature;
+    }
+}
+
+ImgloadPlugin context_match_signature(ImgloadContext ctx, const uint8_t* header, size_t size)
+{
+    assert(ctx != NULL);
+
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    PluginSignature* current = ctx->signatures[header[0]];
+    while (current != NULL)
+    {
+        if (current->size <= size && memcmp(current->bytes, header, current->size) == 0)
+        {
+            return current->plugin;
+        }
+
+        current = current->next;
+    }
+
+    return NULL;
+}
+
 ImgloadErrorCode IMGLOAD_API imgload_context_add_plugin(ImgloadContext ctx, ImgloadPluginLoader loader_func, void* plugin_param)
 {
     assert(ctx != NULL);
@@ -87,6 +174,7 @@ ImgloadErrorCode IMGLOAD_API imgload_context_add_plugin(ImgloadContext ctx, Imgl
 
     ImgloadPlugin plugin;
     
+    // The loader runs without the lock so images can still be loaded while a plugin initializes
     ImgloadErrorCode err = plugin_init(ctx, loader_func, plugin_param, &plugin);
 
     if (err != IMGLOAD_ERR_NO_ERROR)
@@ -94,6 +182,8 @@ ImgloadErrorCode IMGLOAD_API imgload_context_add_plugin(ImgloadContext ctx, Imgl
         return err;
     }
 
+    thread_rwlock_write_lock(&ctx->plugin_lock);
+
     if (ctx->plugins.head == NULL)
     {
         // Initialize the list with the first plugin
@@ -109,6 +199,10 @@ ImgloadErrorCode IMGLOAD_API imgload_context_add_plugin(ImgloadContext ctx, Imgl
         ctx->plugins.tail = plugin;
     }
 
+    register_signatures(ctx, plugin);
+
+    thread_rwlock_write_unlock(&ctx->plugin_lock);
+
     return IMGLOAD_ERR_NO_ERROR;
 }
 
@@ -117,9 +211,13 @@ ImgloadErrorCode IMGLOAD_API imgload_context_set_log_callback(ImgloadContext ctx
     assert(ctx != NULL);
     assert(handler != NULL);
 
+    thread_rwlock_write_lock(&ctx->log.lock);
+
     ctx->log.handler = handler;
     ctx->log.ud = ud;
 
+    thread_rwlock_write_unlock(&ctx->log.lock);
+
     return IMGLOAD_ERR_NO_ERROR;
 }
 
@@ -127,11 +225,98 @@ ImgloadErrorCode IMGLOAD_API imgload_context_set_log_level(ImgloadContext ctx, I
 {
     assert(ctx != NULL);
 
-    ctx->log.minLevel = level;
+    thread_atomic_store_u32(&ctx->log.minLevel, level);
 
     return IMGLOAD_ERR_NO_ERROR;
 }
 
+ImgloadErrorCode IMGLOAD_API imgload_context_set_trace_callbacks(ImgloadContext ctx, ImgloadTraceHandler begin,
+                                                                 ImgloadTraceHandler end, void* ud)
+{
+    assert(ctx != NULL);
+    assert((begin == NULL) == (end == NULL));
+
+    thread_rwlock_write_lock(&ctx->trace.lock);
+
+    ctx->trace.begin = begin;
+    ctx->trace.end = end;
+    ctx->trace.ud = ud;
+    thread_atomic_store_u32(&ctx->trace.enabled, begin != NULL);
+
+    thread_rwlock_write_unlock(&ctx->trace.lock);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_context_set_io_buffer_size(ImgloadContext ctx, size_t size)
+{
+    assert(ctx != NULL);
+
+    thread_atomic_store_size(&ctx->io_buffer_size, size);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_context_set_buffer_pool_limit(ImgloadContext ctx, size_t size)
+{
+    assert(ctx != NULL);
+
+    mem_pool_set_limit(ctx, &ctx->pool, size);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_context_get_stats(ImgloadContext ctx, ImgloadStats* stats_out)
+{
+    assert(ctx != NULL);
+    assert(stats_out != NULL);
+
+    if (!ctx->stats.enabled)
+    {
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    thread_mutex_lock(&ctx->stats.lock);
+    *stats_out = ctx->stats.totals;
+    thread_mutex_unlock(&ctx->stats.lock);
+
+    stats_out->peak_bytes = thread_atomic_load_size(&ctx->stats.peak);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_context_get_plugin_stats(ImgloadContext ctx, const char* plugin_id,
+                                                              ImgloadStats* stats_out)
+{
+    assert(ctx != NULL);
+    assert(plugin_id != NULL);
+    assert(stats_out != NULL);
+
+    if (!ctx->stats.enabled)
+    {
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    ImgloadErrorCode err = IMGLOAD_ERR_OUT_OF_RANGE;
+
+    thread_rwlock_read_lock(&ctx->plugin_lock);
+    for (ImgloadPlugin plugin = ctx->plugins.head; plugin != NULL; plugin = plugin->next)
+    {
+        if (plugin->info.id != NULL && strcmp(plugin->info.id, plugin_id) == 0)
+        {
+            thread_mutex_lock(&ctx->stats.lock);
+            *stats_out = plugin->stats;
+            thread_mutex_unlock(&ctx->stats.lock);
+
+            err = IMGLOAD_ERR_NO_ERROR;
+            break;
+        }
+    }
+    thread_rwlock_read_unlock(&ctx->plugin_lock);
+
+    return err;
+}
+
 ImgloadErrorCode IMGLOAD_API imgload_context_free(ImgloadContext ctx)
 {
     assert(ctx != NULL);
@@ -147,7 +332,19 @@ ImgloadErrorCode IMGLOAD_API imgload_context_free(ImgloadContext ctx)
     ctx->plugins.tail = NULL;
     ctx->plugins.head = NULL;
 
-    mem_free(ctx, ctx);
+    // Plugins may give back buffers while they are freed so the pool goes last
+    mem_pool_destroy(ctx, &ctx->pool);
+
+    if (ctx->stats.enabled)
+    {
+        thread_mutex_destroy(&ctx->stats.lock);
+    }
+
+    thread_rwlock_destroy(&ctx->trace.lock);
+    thread_rwlock_destroy(&ctx->log.lock);
+    thread_rwlock_destroy(&ctx->plugin_lock);
+
+    context_dealloc(ctx);
 
     return IMGLOAD_ERR_NO_ERROR;
 }
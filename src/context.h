@@ -4,7 +4,9 @@
 
 #include <imageloader.h>
 
+#include "memory.h"
 #include "plugin.h"
+#include "thread.h"
 
 struct ImgloadContextImpl
 {
@@ -16,19 +18,66 @@ struct ImgloadContextImpl
 
     ImgloadContextFlags flags;
 
+    /**
+     * Protects the plugin list and the signature table. Images take the read lock while looking for their plugin, adding
+     * a plugin takes the write lock. Plugins are only removed when the context is freed.
+     */
+    ThreadRWLock plugin_lock;
+
     struct
     {
         ImgloadPlugin head;
         ImgloadPlugin tail;
     } plugins;
 
+    /**
+     * Jump table indexed by the first byte of a file. Every bucket is sorted by signature length so the longest
+     * matching signature is found first.
+     */
+    PluginSignature* signatures[256];
+
+    MemPool pool; //!< Cache of pixel buffers, only enabled with IMGLOAD_CONTEXT_BUFFER_POOL
+
+    struct
+    {
+        bool enabled; //!< Set if the context has IMGLOAD_CONTEXT_COLLECT_STATS, never changes
+
+        ThreadMutex lock; //!< Protects the totals and the statistics of the plugins
+        ImgloadStats totals; //!< The sum of all freed images
+
+        // Memory allocated through mem_realloc, tracked using a header in front of every allocation
+        volatile size_t allocated;
+        volatile size_t peak;
+    } stats;
+
+    volatile size_t io_buffer_size; //!< Size of the read buffer of stream images, 0 if reads are not buffered
+
     struct
     {
+        ThreadRWLock lock; //!< Protects the handler, it is called with the read lock held
+
         ImgloadLogHandler handler;
         void* ud;
 
-        ImgloadLogLevel minLevel;
+        volatile ImgloadLogLevel minLevel; //!< Accessed atomically so the level can be checked without the lock
     } log;
+
+    struct
+    {
+        ThreadRWLock lock; //!< Protects the handlers, they are called with the read lock held
+
+        ImgloadTraceHandler begin;
+        ImgloadTraceHandler end;
+        void* ud;
+
+        volatile uint32_t enabled; //!< Set while handlers are registered, checked without the lock
+    } trace;
 };
 
+/**
+ * @brief Finds the plugin which has registered a signature matching the given file header
+ * @return The plugin or @c NULL if no signature matches
+ */
+ImgloadPlugin context_match_signature(ImgloadContext ctx, const uint8_t* header, size_t size);
+
 #endif //IMAGELOADER_CONTEXT_H
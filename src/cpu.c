@@ -0,0 +1,100 @@
+#include "cpu.h"
+
+#include <stdbool.h>
+
+#if IMGLOAD_ARCH_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if IMGLOAD_ARCH_X86
+
+static void query_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    regs[0] = (uint32_t)info[0];
+    regs[1] = (uint32_t)info[1];
+    regs[2] = (uint32_t)info[2];
+    regs[3] = (uint32_t)info[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t query_xcr0(void)
+{
+#if defined(_MSC_VER)
+    return (uint64_t)_xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+static CpuFeatures detect_features(void)
+{
+    CpuFeatures features = 0;
+    uint32_t regs[4];
+
+    query_cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+
+    if (max_leaf < 1)
+    {
+        return features;
+    }
+
+    query_cpuid(1, 0, regs);
+    if (regs[3] & (1u << 26))
+    {
+        features |= CPU_FEATURE_SSE2;
+    }
+    if (regs[2] & (1u << 9))
+    {
+        features |= CPU_FEATURE_SSSE3;
+    }
+
+    // AVX state has to be enabled by the OS before AVX2 can be used
+    bool os_avx = (regs[2] & (1u << 27)) && (regs[2] & (1u << 28)) && (query_xcr0() & 0x6) == 0x6;
+
+    if (os_avx && max_leaf >= 7)
+    {
+        query_cpuid(7, 0, regs);
+        if (regs[1] & (1u << 5))
+        {
+            features |= CPU_FEATURE_AVX2;
+        }
+    }
+
+    return features;
+}
+
+#else
+
+static CpuFeatures detect_features(void)
+{
+    return 0;
+}
+
+#endif
+
+CpuFeatures cpu_features(void)
+{
+    // Concurrent first calls compute the same value so the race is harmless
+    static volatile bool detected = false;
+    static volatile CpuFeatures features = 0;
+
+    if (!detected)
+    {
+        features = detect_features();
+        detected = true;
+    }
+
+    return features;
+}
@@ -0,0 +1,48 @@
+#ifndef IMAGELOADER_CPU_H
+#define IMAGELOADER_CPU_H
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define IMGLOAD_ARCH_X86 1
+#else
+#define IMGLOAD_ARCH_X86 0
+#endif
+
+enum
+{
+    CPU_FEATURE_SSE2 = 1 << 0,
+    CPU_FEATURE_SSSE3 = 1 << 1,
+    CPU_FEATURE_AVX2 = 1 << 2,
+};
+typedef uint32_t CpuFeatures;
+
+// GCC and Clang only allow intrinsics of instruction sets which are enabled for the function using them
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+
+// Helpers shared by kernels of different instruction sets have to be inlined into their callers. A call from an AVX2
+// function into a non-inlined SSE function runs legacy SSE instructions with dirty upper YMM halves, which is very slow.
+#if defined(__GNUC__) || defined(__clang__)
+#define FORCE_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define FORCE_INLINE __forceinline
+#else
+#define FORCE_INLINE inline
+#endif
+
+/**
+ * @brief Determines the instruction set extensions which can be used on the current machine
+ * The result is only computed once.
+ */
+CpuFeatures cpu_features(void);
+
+#endif //IMAGELOADER_CPU_H
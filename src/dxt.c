@@ -0,0 +1,481 @@
+#include "dxt.h"
+#include "dxt_simd.h"
+#include "bptc.h"
+
+#include <string.h>
+
+#define DXT_BLOCK_DIM 4
+
+static uint16_t read_u16(const uint8_t* src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+static uint32_t read_u32(const uint8_t* src)
+{
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+static void expand_565(uint16_t color, bool bgra, uint8_t* pixel)
+{
+    uint8_t r = (uint8_t)((color >> 11) & 0x1F);
+    uint8_t g = (uint8_t)((color >> 5) & 0x3F);
+    uint8_t b = (uint8_t)(color & 0x1F);
+
+    pixel[bgra ? 2 : 0] = (uint8_t)((r << 3) | (r >> 2));
+    pixel[1] = (uint8_t)((g << 2) | (g >> 4));
+    pixel[bgra ? 0 : 2] = (uint8_t)((b << 3) | (b >> 2));
+    pixel[3] = 255;
+}
+
+/**
+ * @brief Builds the four colors of a color block
+ * @param allow_transparent DXT1 blocks with color0 <= color1 use three colors and transparent black, the color blocks
+ * of the other formats always use four colors
+ */
+static void color_palette(const uint8_t* block, bool allow_transparent, bool bgra, uint8_t palette[4][4])
+{
+    uint16_t c0 = read_u16(block);
+    uint16_t c1 = read_u16(block + 2);
+
+    expand_565(c0, bgra, palette[0]);
+    expand_565(c1, bgra, palette[1]);
+
+    if (c0 > c1 || !allow_transparent)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            palette[2][i] = (uint8_t)((2 * palette[0][i] + palette[1][i]) / 3);
+            palette[3][i] = (uint8_t)((palette[0][i] + 2 * palette[1][i]) / 3);
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 255;
+    }
+    else
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            palette[2][i] = (uint8_t)((palette[0][i] + palette[1][i]) / 2);
+            palette[3][i] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+}
+
+/**
+ * @brief Writes the colors of a color block, the alpha channel is only written for DXT1 blocks
+ */
+static void decode_color_block(const uint8_t* block, bool dxt1, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                               bool bgra)
+{
+    uint8_t palette[4][4];
+    color_palette(block, dxt1, bgra, palette);
+
+    uint32_t indices = read_u32(block + 4);
+    size_t channels = dxt1 ? 4 : 3;
+
+    for (size_t y = 0; y < rows; ++y)
+    {
+        uint8_t* row = dst + (ptrdiff_t)y * dst_stride;
+        for (size_t x = 0; x < DXT_BLOCK_DIM; ++x)
+        {
+            const uint8_t* color = palette[(indices >> (2 * (y * DXT_BLOCK_DIM + x))) & 0x3];
+            memcpy(row + x * 4, color, channels);
+        }
+    }
+}
+
+/**
+ * @brief Writes the explicit 4 bit alpha values of a DXT2/3 block
+ */
+static void decode_explicit_alpha(const uint8_t* block, uint8_t* dst, ptrdiff_t dst_stride, size_t rows)
+{
+    for (size_t y = 0; y < rows; ++y)
+    {
+        uint16_t alpha = read_u16(block + 2 * y);
+        uint8_t* row = dst + (ptrdiff_t)y * dst_stride;
+
+        for (size_t x = 0; x < DXT_BLOCK_DIM; ++x)
+        {
+            row[x * 4 + 3] = (uint8_t)(((alpha >> (4 * x)) & 0xF) * 17);
+        }
+    }
+}
+
+/**
+ * @brief Builds the eight values of a DXT4/5 alpha block or an unsigned BC4/5 channel block
+ */
+static void interpolated_palette(const uint8_t* block, uint8_t palette[8])
+{
+    palette[0] = block[0];
+    palette[1] = block[1];
+
+    if (palette[0] > palette[1])
+    {
+        for (int i = 1; i < 7; ++i)
+        {
+            palette[i + 1] = (uint8_t)(((7 - i) * palette[0] + i * palette[1]) / 7);
+        }
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+        {
+            palette[i + 1] = (uint8_t)(((5 - i) * palette[0] + i * palette[1]) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+/**
+ * @brief Builds the eight values of a signed BC4/5 channel block, mapped from [-1, 1] to [0, 255]
+ */
+static void signed_palette(const uint8_t* block, uint8_t palette[8])
+{
+    // -128 and -127 both represent -1
+    int v0 = (int8_t)block[0] < -127 ? -127 : (int8_t)block[0];
+    int v1 = (int8_t)block[1] < -127 ? -127 : (int8_t)block[1];
+
+    int values[8];
+    values[0] = v0;
+    values[1] = v1;
+
+    if (v0 > v1)
+    {
+        for (int i = 1; i < 7; ++i)
+        {
+            values[i + 1] = ((7 - i) * v0 + i * v1) / 7;
+        }
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+        {
+            values[i + 1] = ((5 - i) * v0 + i * v1) / 5;
+        }
+        values[6] = -127;
+        values[7] = 127;
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        palette[i] = (uint8_t)(((values[i] + 127) * 255 + 127) / 254);
+    }
+}
+
+/**
+ * @brief Writes the values selected by the 3 bit indices of an interpolated block to one channel of the pixels
+ * @param dst The channel of the first pixel
+ */
+static void decode_indexed_channel(const uint8_t* block, const uint8_t palette[8], uint8_t* dst, ptrdiff_t dst_stride,
+                                   size_t rows)
+{
+    // 16 indices of 3 bits each
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        indices |= (uint64_t)block[2 + i] << (8 * i);
+    }
+
+    for (size_t y = 0; y < rows; ++y)
+    {
+        uint8_t* row = dst + (ptrdiff_t)y * dst_stride;
+        for (size_t x = 0; x < DXT_BLOCK_DIM; ++x)
+        {
+            row[x * 4] = palette[(indices >> (3 * (y * DXT_BLOCK_DIM + x))) & 0x7];
+        }
+    }
+}
+
+/**
+ * @brief Writes the interpolated alpha values of a DXT4/5 block
+ */
+static void decode_interpolated_alpha(const uint8_t* block, uint8_t* dst, ptrdiff_t dst_stride, size_t rows)
+{
+    uint8_t palette[8];
+    interpolated_palette(block, palette);
+
+    decode_indexed_channel(block, palette, dst + 3, dst_stride, rows);
+}
+
+/**
+ * @brief Decodes BC4 and BC5 blocks, which store red and optionally green like the alpha of DXT5
+ */
+static void decode_channel_blocks(const uint8_t* src, size_t num_blocks, size_t channels, bool snorm, uint8_t* dst,
+                                  ptrdiff_t dst_stride, size_t rows, bool bgra)
+{
+    // Red and green
+    const size_t offsets[2] = { bgra ? 2 : 0, 1 };
+
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        uint8_t* block_dst = dst + i * DXT_BLOCK_DIM * 4;
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            uint8_t* row = block_dst + (ptrdiff_t)y * dst_stride;
+            for (size_t x = 0; x < DXT_BLOCK_DIM; ++x)
+            {
+                row[x * 4] = 0;
+                row[x * 4 + 1] = 0;
+                row[x * 4 + 2] = 0;
+                row[x * 4 + 3] = 255;
+            }
+        }
+
+        for (size_t c = 0; c < channels; ++c)
+        {
+            const uint8_t* block = src + (i * channels + c) * 8;
+
+            uint8_t palette[8];
+            if (snorm)
+            {
+                signed_palette(block, palette);
+            }
+            else
+            {
+                interpolated_palette(block, palette);
+            }
+
+            decode_indexed_channel(block, palette, block_dst + offsets[c], dst_stride, rows);
+        }
+    }
+}
+
+void dxt_decode_dxt1_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                            bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        decode_color_block(src + i * 8, true, dst + i * DXT_BLOCK_DIM * 4, dst_stride, rows, bgra);
+    }
+}
+
+void dxt_decode_dxt3_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                            bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        uint8_t* block_dst = dst + i * DXT_BLOCK_DIM * 4;
+
+        decode_color_block(src + i * 16 + 8, false, block_dst, dst_stride, rows, bgra);
+        decode_explicit_alpha(src + i * 16, block_dst, dst_stride, rows);
+    }
+}
+
+void dxt_decode_dxt5_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                            bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        uint8_t* block_dst = dst + i * DXT_BLOCK_DIM * 4;
+
+        decode_color_block(src + i * 16 + 8, false, block_dst, dst_stride, rows, bgra);
+        decode_interpolated_alpha(src + i * 16, block_dst, dst_stride, rows);
+    }
+}
+
+void dxt_decode_bc4_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra)
+{
+    decode_channel_blocks(src, num_blocks, 1, false, dst, dst_stride, rows, bgra);
+}
+
+void dxt_decode_bc4_snorm_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                 size_t rows, bool bgra)
+{
+    decode_channel_blocks(src, num_blocks, 1, true, dst, dst_stride, rows, bgra);
+}
+
+void dxt_decode_bc5_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra)
+{
+    decode_channel_blocks(src, num_blocks, 2, false, dst, dst_stride, rows, bgra);
+}
+
+void dxt_decode_bc5_snorm_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                 size_t rows, bool bgra)
+{
+    decode_channel_blocks(src, num_blocks, 2, true, dst, dst_stride, rows, bgra);
+}
+
+DxtRowDecoder dxt_row_decoder(ImgloadCompression compression)
+{
+#if DXT_HAVE_X86_KERNELS
+    CpuFeatures features = cpu_features();
+#endif
+
+    // Premultiplied alpha (DXT2 and DXT4) is returned as stored
+    switch (compression)
+    {
+    case IMGLOAD_COMPRESSION_DXT1:
+#if DXT_HAVE_X86_KERNELS
+        if (features & CPU_FEATURE_AVX2)
+        {
+            return dxt_decode_dxt1_avx2;
+        }
+        if (features & CPU_FEATURE_SSSE3)
+        {
+            return dxt_decode_dxt1_ssse3;
+        }
+#endif
+        return dxt_decode_dxt1_scalar;
+    case IMGLOAD_COMPRESSION_DXT2:
+    case IMGLOAD_COMPRESSION_DXT3:
+#if DXT_HAVE_X86_KERNELS
+        if (features & CPU_FEATURE_AVX2)
+        {
+            return dxt_decode_dxt3_avx2;
+        }
+        if (features & CPU_FEATURE_SSSE3)
+        {
+            return dxt_decode_dxt3_ssse3;
+        }
+#endif
+        return dxt_decode_dxt3_scalar;
+    case IMGLOAD_COMPRESSION_DXT4:
+    case IMGLOAD_COMPRESSION_DXT5:
+#if DXT_HAVE_X86_KERNELS
+        if (features & CPU_FEATURE_AVX2)
+        {
+            return dxt_decode_dxt5_avx2;
+        }
+        if (features & CPU_FEATURE_SSSE3)
+        {
+            return dxt_decode_dxt5_ssse3;
+        }
+#endif
+        return dxt_decode_dxt5_scalar;
+    case IMGLOAD_COMPRESSION_BC4:
+#if DXT_HAVE_X86_KERNELS
+        if (features & CPU_FEATURE_AVX2)
+        {
+            return dxt_decode_bc4_avx2;
+        }
+        if (features & CPU_FEATURE_SSSE3)
+        {
+            return dxt_decode_bc4_ssse3;
+        }
+#endif
+        return dxt_decode_bc4_scalar;
+    case IMGLOAD_COMPRESSION_BC4_SNORM:
+        return dxt_decode_bc4_snorm_scalar;
+    case IMGLOAD_COMPRESSION_BC5:
+#if DXT_HAVE_X86_KERNELS
+        if (features & CPU_FEATURE_AVX2)
+        {
+            return dxt_decode_bc5_avx2;
+        }
+        if (features & CPU_FEATURE_SSSE3)
+        {
+            return dxt_decode_bc5_ssse3;
+        }
+#endif
+        return dxt_decode_bc5_scalar;
+    case IMGLOAD_COMPRESSION_BC5_SNORM:
+        return dxt_decode_bc5_snorm_scalar;
+    case IMGLOAD_COMPRESSION_BC6H_UF16:
+        return bptc_decode_bc6h_uf16;
+    case IMGLOAD_COMPRESSION_BC6H_SF16:
+        return bptc_decode_bc6h_sf16;
+    case IMGLOAD_COMPRESSION_BC7:
+        return bptc_decode_bc7;
+    default:
+        return NULL;
+    }
+}
+
+size_t dxt_block_bytes(ImgloadCompression compression)
+{
+    switch (compression)
+    {
+    case IMGLOAD_COMPRESSION_DXT1:
+    case IMGLOAD_COMPRESSION_BC4:
+    case IMGLOAD_COMPRESSION_BC4_SNORM:
+        return 8;
+    case IMGLOAD_COMPRESSION_DXT2:
+    case IMGLOAD_COMPRESSION_DXT3:
+    case IMGLOAD_COMPRESSION_DXT4:
+    case IMGLOAD_COMPRESSION_DXT5:
+    case IMGLOAD_COMPRESSION_BC5:
+    case IMGLOAD_COMPRESSION_BC5_SNORM:
+    case IMGLOAD_COMPRESSION_BC6H_UF16:
+    case IMGLOAD_COMPRESSION_BC6H_SF16:
+    case IMGLOAD_COMPRESSION_BC7:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+static size_t blocks_per_row(const ImgloadImageData* compressed)
+{
+    return (compressed->width + DXT_BLOCK_DIM - 1) / DXT_BLOCK_DIM;
+}
+
+static size_t block_rows_per_slice(const ImgloadImageData* compressed)
+{
+    return (compressed->height + DXT_BLOCK_DIM - 1) / DXT_BLOCK_DIM;
+}
+
+size_t dxt_block_rows(const ImgloadImageData* compressed)
+{
+    return compressed->depth * block_rows_per_slice(compressed);
+}
+
+bool dxt_validate(ImgloadCompression compression, const ImgloadImageData* compressed)
+{
+    size_t block_bytes = dxt_block_bytes(compression);
+    if (block_bytes == 0 || compressed->data == NULL)
+    {
+        return false;
+    }
+
+    return compressed->data_size >= dxt_block_rows(compressed) * blocks_per_row(compressed) * block_bytes;
+}
+
+void dxt_decode_block_rows(DxtRowDecoder decoder, ImgloadCompression compression, const ImgloadImageData* compressed,
+                           size_t first_block_row, size_t num_block_rows, uint8_t* dst, size_t dst_stride, bool flip,
+                           bool bgra)
+{
+    size_t block_bytes = dxt_block_bytes(compression);
+    size_t row_blocks = blocks_per_row(compressed);
+    size_t slice_block_rows = block_rows_per_slice(compressed);
+
+    // Blocks which lie completely inside the image are decoded directly into the destination
+    size_t full_blocks = compressed->width / DXT_BLOCK_DIM;
+    size_t edge_pixels = compressed->width % DXT_BLOCK_DIM;
+
+    // Flipped images are written bottom up starting at the last row of the slice
+    ptrdiff_t row_step = flip ? -(ptrdiff_t)dst_stride : (ptrdiff_t)dst_stride;
+
+    const uint8_t* src = (const uint8_t*)compressed->data;
+
+    for (size_t block_row = first_block_row; block_row < first_block_row + num_block_rows; ++block_row)
+    {
+        size_t slice = block_row / slice_block_rows;
+        size_t y = (block_row % slice_block_rows) * DXT_BLOCK_DIM;
+        size_t rows = compressed->height - y < DXT_BLOCK_DIM ? compressed->height - y : DXT_BLOCK_DIM;
+
+        size_t dst_y = flip ? compressed->height - y - 1 : y;
+
+        const uint8_t* row_src = src + block_row * row_blocks * block_bytes;
+        uint8_t* row_dst = dst + (slice * compressed->height + dst_y) * dst_stride;
+
+        decoder(row_src, full_blocks, row_dst, row_step, rows, bgra);
+
+        if (edge_pixels != 0)
+        {
+            uint8_t block[DXT_BLOCK_DIM * DXT_BLOCK_DIM * 4];
+            decoder(row_src + full_blocks * block_bytes, 1, block, DXT_BLOCK_DIM * 4, rows, bgra);
+
+            for (size_t i = 0; i < rows; ++i)
+            {
+                memcpy(row_dst + (ptrdiff_t)i * row_step + full_blocks * DXT_BLOCK_DIM * 4,
+                       block + i * DXT_BLOCK_DIM * 4, edge_pixels * 4);
+            }
+        }
+    }
+}
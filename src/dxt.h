@@ -0,0 +1,57 @@
+#pragma once
+
+#include <imageloader.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Decodes a row of blocks into RGBA or BGRA pixels
+ * Writes 4 * num_blocks pixels to each of the first @p rows rows of @p dst.
+ * @param src The first block
+ * @param num_blocks The number of blocks in the row
+ * @param dst The first pixel of the top row
+ * @param dst_stride The distance between the start of two rows in bytes, negative for writing the rows bottom up
+ * @param rows The number of rows to write, between 1 and 4
+ * @param bgra Write the pixels in BGRA order instead of RGBA
+ */
+typedef void (*DxtRowDecoder)(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                              bool bgra);
+
+/**
+ * @brief Gets the fastest row decoder of a block compression format supported by the current CPU
+ * @return The decoder or @c NULL if the compression can't be decoded by the library
+ */
+DxtRowDecoder dxt_row_decoder(ImgloadCompression compression);
+
+/**
+ * @brief Gets the number of bytes of a compressed 4x4 block, 0 if the compression is not block based
+ */
+size_t dxt_block_bytes(ImgloadCompression compression);
+
+/**
+ * @brief Gets the number of block rows of a compressed mipmap, counting the block rows of all slices
+ */
+size_t dxt_block_rows(const ImgloadImageData* compressed);
+
+/**
+ * @brief Checks that the compressed data holds all blocks of the mipmap
+ */
+bool dxt_validate(ImgloadCompression compression, const ImgloadImageData* compressed);
+
+/**
+ * @brief Decodes a range of block rows of a mipmap into RGBA or BGRA pixels
+ * Block rows are numbered consecutively across the slices of a 3D image. Different ranges may be decoded concurrently.
+ * @param decoder The decoder returned by dxt_row_decoder
+ * @param compression The compression of the data
+ * @param compressed The compressed mipmap, has to pass dxt_validate
+ * @param first_block_row The first block row to decode
+ * @param num_block_rows The number of block rows to decode
+ * @param dst The first row of the decoded image which has depth * height rows
+ * @param dst_stride The distance between the start of two rows in dst in bytes
+ * @param flip Flip every slice vertically
+ * @param bgra Write the pixels in BGRA order instead of RGBA
+ */
+void dxt_decode_block_rows(DxtRowDecoder decoder, ImgloadCompression compression, const ImgloadImageData* compressed,
+                           size_t first_block_row, size_t num_block_rows, uint8_t* dst, size_t dst_stride, bool flip,
+                           bool bgra);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "dxt.h"
+#include "cpu.h"
+#include "project.h"
+
+#if IMGLOADER_WITH_SIMD && IMGLOAD_ARCH_X86
+#define DXT_HAVE_X86_KERNELS 1
+#else
+#define DXT_HAVE_X86_KERNELS 0
+#endif
+
+#if DXT_HAVE_X86_KERNELS
+
+// SSSE3 kernels
+void dxt_decode_dxt1_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra);
+void dxt_decode_dxt3_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra);
+void dxt_decode_dxt5_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra);
+void dxt_decode_bc4_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                          bool bgra);
+void dxt_decode_bc5_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                          bool bgra);
+
+// AVX2 kernels, these decode two blocks at once
+void dxt_decode_dxt1_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                          bool bgra);
+void dxt_decode_dxt3_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                          bool bgra);
+void dxt_decode_dxt5_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                          bool bgra);
+void dxt_decode_bc4_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                         bool bgra);
+void dxt_decode_bc5_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                         bool bgra);
+
+#endif
+
+// Scalar kernels, used if the CPU lacks the required instruction set extensions
+void dxt_decode_dxt1_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                            bool bgra);
+void dxt_decode_dxt3_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                            bool bgra);
+void dxt_decode_dxt5_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                            bool bgra);
+void dxt_decode_bc4_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra);
+void dxt_decode_bc5_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride, size_t rows,
+                           bool bgra);
+
+// Signed BC4/5 is only decoded by scalar kernels
+void dxt_decode_bc4_snorm_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                 size_t rows, bool bgra);
+void dxt_decode_bc5_snorm_scalar(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                 size_t rows, bool bgra);
@@ -0,0 +1,418 @@
+#include "dxt_simd.h"
+
+#if DXT_HAVE_X86_KERNELS
+
+#include <immintrin.h>
+
+// Shuffle control for one row of a color block, pixel k copies the palette entry selected by bits 2k and 2k + 1
+#define PIXEL_MASK(b, k) (uint8_t)((((b) >> (2 * (k))) & 3) * 4), (uint8_t)((((b) >> (2 * (k))) & 3) * 4 + 1), \
+                         (uint8_t)((((b) >> (2 * (k))) & 3) * 4 + 2), (uint8_t)((((b) >> (2 * (k))) & 3) * 4 + 3)
+#define ROW_MASK(b) { PIXEL_MASK(b, 0), PIXEL_MASK(b, 1), PIXEL_MASK(b, 2), PIXEL_MASK(b, 3) }
+#define ROW_MASKS4(b) ROW_MASK(b), ROW_MASK((b) + 1), ROW_MASK((b) + 2), ROW_MASK((b) + 3)
+#define ROW_MASKS16(b) ROW_MASKS4(b), ROW_MASKS4((b) + 4), ROW_MASKS4((b) + 8), ROW_MASKS4((b) + 12)
+#define ROW_MASKS64(b) ROW_MASKS16(b), ROW_MASKS16((b) + 16), ROW_MASKS16((b) + 32), ROW_MASKS16((b) + 48)
+
+/**
+ * Indexed by the index byte of a row. A lookup is cheaper than computing the shuffle control from the indices.
+ */
+static const uint8_t COLOR_ROW_MASKS[256][16] = {
+    ROW_MASKS64(0), ROW_MASKS64(64), ROW_MASKS64(128), ROW_MASKS64(192)
+};
+
+// Byte value which makes pshufb write a zero
+#define Z 0x80
+
+// Shuffle control which moves value 4y + x of a block to channel c of pixel x
+#define CHANNEL_BYTE(c, i, v) ((c) == (i) ? (v) : Z)
+#define CHANNEL_PIXEL(c, v) CHANNEL_BYTE(c, 0, v), CHANNEL_BYTE(c, 1, v), CHANNEL_BYTE(c, 2, v), CHANNEL_BYTE(c, 3, v)
+#define CHANNEL_ROW(c, y) { CHANNEL_PIXEL(c, 4 * (y)), CHANNEL_PIXEL(c, 4 * (y) + 1), CHANNEL_PIXEL(c, 4 * (y) + 2), \
+                            CHANNEL_PIXEL(c, 4 * (y) + 3) }
+#define CHANNEL_ROWS(c) { CHANNEL_ROW(c, 0), CHANNEL_ROW(c, 1), CHANNEL_ROW(c, 2), CHANNEL_ROW(c, 3) }
+
+/**
+ * Moves the values of one row from the 16 values of a block to one channel of the row, indexed by channel and row
+ */
+static const uint8_t CHANNEL_ROW_MASKS[4][4][16] = {
+    CHANNEL_ROWS(0), CHANNEL_ROWS(1), CHANNEL_ROWS(2), CHANNEL_ROWS(3)
+};
+
+static uint16_t read_u16(const uint8_t* src)
+{
+    return (uint16_t)(src[0] | (src[1] << 8));
+}
+
+/**
+ * @brief Computes the four colors of a color block, every color takes 4 bytes
+ */
+static FORCE_INLINE TARGET_SSE2 __m128i color_palette(const uint8_t* block, bool allow_transparent, bool bgra)
+{
+    uint16_t c0 = read_u16(block);
+    uint16_t c1 = read_u16(block + 2);
+
+    __m128i colors = _mm_setr_epi16((short)c0, (short)c0, (short)c0, 0, (short)c1, (short)c1, (short)c1, 0);
+
+    // Move every channel to the top bits of its lane, red is already there
+    __m128i shift = bgra ? _mm_setr_epi16(2048, 32, 1, 0, 2048, 32, 1, 0)
+                         : _mm_setr_epi16(1, 32, 2048, 0, 1, 32, 2048, 0);
+    __m128i top = _mm_mullo_epi16(colors, shift);
+    top = _mm_and_si128(top, _mm_setr_epi16((short)0xF800, (short)0xFC00, (short)0xF800, 0,
+                                            (short)0xF800, (short)0xFC00, (short)0xF800, 0));
+
+    // Multiplying by 8.25 and 4.0625 replicates the top bits of 5 and 6 bit values into the low bits
+    __m128i expanded = _mm_mulhi_epu16(top, _mm_setr_epi16(0x108, 0x104, 0x108, 0, 0x108, 0x104, 0x108, 0));
+    expanded = _mm_or_si128(expanded, _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255));
+
+    __m128i swapped = _mm_shuffle_epi32(expanded, _MM_SHUFFLE(1, 0, 3, 2));
+    __m128i mixed;
+
+    if (c0 > c1 || !allow_transparent)
+    {
+        // (2 * c0 + c1) / 3 and (c0 + 2 * c1) / 3, x / 3 == (x * 0xAAAB) >> 17 for all 16 bit values
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(expanded, expanded), swapped);
+        mixed = _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16((short)0xAAAB)), 1);
+    }
+    else
+    {
+        // (c0 + c1) / 2 and transparent black
+        mixed = _mm_srli_epi16(_mm_add_epi16(expanded, swapped), 1);
+        mixed = _mm_and_si128(mixed, _mm_setr_epi16(-1, -1, -1, -1, 0, 0, 0, 0));
+    }
+
+    return _mm_packus_epi16(expanded, mixed);
+}
+
+static FORCE_INLINE TARGET_SSSE3 __m128i color_row(__m128i palette, uint8_t indices)
+{
+    return _mm_shuffle_epi8(palette, _mm_loadu_si128((const __m128i*) COLOR_ROW_MASKS[indices]));
+}
+
+/**
+ * @brief Gets the 16 alpha values of a DXT2/3 block
+ */
+static FORCE_INLINE TARGET_SSE2 __m128i explicit_alpha(const uint8_t* block)
+{
+    __m128i nibble_mask = _mm_set1_epi8(0x0F);
+
+    __m128i packed = _mm_loadl_epi64((const __m128i*) block);
+    __m128i low = _mm_and_si128(packed, nibble_mask);
+    __m128i high = _mm_and_si128(_mm_srli_epi16(packed, 4), nibble_mask);
+
+    // The first pixel is stored in the low nibble, every value is multiplied by 17 to get the 8 bit value
+    __m128i alpha = _mm_unpacklo_epi8(low, high);
+    return _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+}
+
+/**
+ * @brief Gets the 16 values of a DXT4/5 alpha block or an unsigned BC4/5 channel block
+ */
+static FORCE_INLINE TARGET_SSSE3 __m128i interpolated_values(const uint8_t* block)
+{
+    __m128i a0 = _mm_set1_epi16(block[0]);
+    __m128i a1 = _mm_set1_epi16(block[1]);
+    __m128i palette;
+
+    if (block[0] > block[1])
+    {
+        // Six interpolated values, x / 7 == (x * 9363) >> 16 for x <= 7 * 255
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a0, _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1)),
+                                    _mm_mullo_epi16(a1, _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6)));
+        palette = _mm_mulhi_epu16(sum, _mm_set1_epi16(9363));
+    }
+    else
+    {
+        // Four interpolated values, 0 and 255, x / 5 == (x * 13108) >> 16 for x <= 5 * 255
+        __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a0, _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0)),
+                                    _mm_mullo_epi16(a1, _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0)));
+        palette = _mm_mulhi_epu16(sum, _mm_set1_epi16(13108));
+        palette = _mm_or_si128(palette, _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+    }
+    palette = _mm_packus_epi16(palette, palette);
+
+    // The 3 bit indices of a row take 12 bits
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        bits |= (uint64_t)block[2 + i] << (8 * i);
+    }
+
+    short r0 = (short)(bits & 0xFFF);
+    short r1 = (short)((bits >> 12) & 0xFFF);
+    short r2 = (short)((bits >> 24) & 0xFFF);
+    short r3 = (short)((bits >> 36) & 0xFFF);
+
+    // Move the index of every pixel to the top 3 bits of its lane
+    __m128i shift = _mm_setr_epi16(8192, 1024, 128, 16, 8192, 1024, 128, 16);
+    __m128i rows01 = _mm_srli_epi16(_mm_mullo_epi16(_mm_setr_epi16(r0, r0, r0, r0, r1, r1, r1, r1), shift), 13);
+    __m128i rows23 = _mm_srli_epi16(_mm_mullo_epi16(_mm_setr_epi16(r2, r2, r2, r2, r3, r3, r3, r3), shift), 13);
+
+    return _mm_shuffle_epi8(palette, _mm_packus_epi16(rows01, rows23));
+}
+
+static FORCE_INLINE TARGET_SSSE3 __m128i channel_row(__m128i values, size_t channel, size_t y)
+{
+    return _mm_shuffle_epi8(values, _mm_loadu_si128((const __m128i*) CHANNEL_ROW_MASKS[channel][y]));
+}
+
+/**
+ * @brief Replaces the alpha channel of a row of colors with the alpha values of row @p y of the block
+ */
+static FORCE_INLINE TARGET_SSSE3 __m128i with_alpha(__m128i colors, __m128i alpha, size_t y)
+{
+    return _mm_or_si128(_mm_and_si128(colors, _mm_set1_epi32(0x00FFFFFF)), channel_row(alpha, 3, y));
+}
+
+TARGET_SSSE3 void dxt_decode_dxt1_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                        size_t rows, bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        const uint8_t* block = src + i * 8;
+        uint8_t* block_dst = dst + i * 16;
+
+        __m128i palette = color_palette(block, true, bgra);
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            _mm_storeu_si128((__m128i*) (block_dst + (ptrdiff_t) y * dst_stride), color_row(palette, block[4 + y]));
+        }
+    }
+}
+
+TARGET_SSSE3 void dxt_decode_dxt3_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                        size_t rows, bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        const uint8_t* block = src + i * 16;
+        uint8_t* block_dst = dst + i * 16;
+
+        __m128i palette = color_palette(block + 8, false, bgra);
+        __m128i alpha = explicit_alpha(block);
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m128i row = with_alpha(color_row(palette, block[12 + y]), alpha, y);
+            _mm_storeu_si128((__m128i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+}
+
+TARGET_SSSE3 void dxt_decode_dxt5_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                        size_t rows, bool bgra)
+{
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        const uint8_t* block = src + i * 16;
+        uint8_t* block_dst = dst + i * 16;
+
+        __m128i palette = color_palette(block + 8, false, bgra);
+        __m128i alpha = interpolated_values(block);
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m128i row = with_alpha(color_row(palette, block[12 + y]), alpha, y);
+            _mm_storeu_si128((__m128i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+}
+
+TARGET_SSSE3 void dxt_decode_bc4_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                       size_t rows, bool bgra)
+{
+    size_t red = bgra ? 2 : 0;
+    __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        __m128i values = interpolated_values(src + i * 8);
+        uint8_t* block_dst = dst + i * 16;
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m128i row = _mm_or_si128(channel_row(values, red, y), opaque);
+            _mm_storeu_si128((__m128i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+}
+
+TARGET_SSSE3 void dxt_decode_bc5_ssse3(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                       size_t rows, bool bgra)
+{
+    size_t red = bgra ? 2 : 0;
+    __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        __m128i red_values = interpolated_values(src + i * 16);
+        __m128i green_values = interpolated_values(src + i * 16 + 8);
+        uint8_t* block_dst = dst + i * 16;
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m128i row = _mm_or_si128(_mm_or_si128(channel_row(red_values, red, y), channel_row(green_values, 1, y)),
+                                       opaque);
+            _mm_storeu_si128((__m128i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+}
+
+static TARGET_AVX2 __m256i combine(__m128i low, __m128i high)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+}
+
+/**
+ * @brief Looks up a row of two neighbouring blocks, the result are 8 consecutive pixels
+ */
+static TARGET_AVX2 __m256i color_row2(__m256i palettes, uint8_t indices0, uint8_t indices1)
+{
+    __m256i mask = combine(_mm_loadu_si128((const __m128i*) COLOR_ROW_MASKS[indices0]),
+                           _mm_loadu_si128((const __m128i*) COLOR_ROW_MASKS[indices1]));
+
+    return _mm256_shuffle_epi8(palettes, mask);
+}
+
+static TARGET_AVX2 __m256i channel_row2(__m256i values, size_t channel, size_t y)
+{
+    __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*) CHANNEL_ROW_MASKS[channel][y]));
+
+    return _mm256_shuffle_epi8(values, mask);
+}
+
+static TARGET_AVX2 __m256i with_alpha2(__m256i colors, __m256i alpha, size_t y)
+{
+    return _mm256_or_si256(_mm256_and_si256(colors, _mm256_set1_epi32(0x00FFFFFF)), channel_row2(alpha, 3, y));
+}
+
+TARGET_AVX2 void dxt_decode_dxt1_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                      size_t rows, bool bgra)
+{
+    size_t i = 0;
+    for (; i + 2 <= num_blocks; i += 2)
+    {
+        const uint8_t* block0 = src + i * 8;
+        const uint8_t* block1 = block0 + 8;
+        uint8_t* block_dst = dst + i * 16;
+
+        __m256i palettes = combine(color_palette(block0, true, bgra), color_palette(block1, true, bgra));
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m256i row = color_row2(palettes, block0[4 + y], block1[4 + y]);
+            _mm256_storeu_si256((__m256i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+
+    if (i < num_blocks)
+    {
+        dxt_decode_dxt1_ssse3(src + i * 8, num_blocks - i, dst + i * 16, dst_stride, rows, bgra);
+    }
+}
+
+TARGET_AVX2 void dxt_decode_dxt3_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                      size_t rows, bool bgra)
+{
+    size_t i = 0;
+    for (; i + 2 <= num_blocks; i += 2)
+    {
+        const uint8_t* block0 = src + i * 16;
+        const uint8_t* block1 = block0 + 16;
+        uint8_t* block_dst = dst + i * 16;
+
+        __m256i palettes = combine(color_palette(block0 + 8, false, bgra), color_palette(block1 + 8, false, bgra));
+        __m256i alpha = combine(explicit_alpha(block0), explicit_alpha(block1));
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m256i row = with_alpha2(color_row2(palettes, block0[12 + y], block1[12 + y]), alpha, y);
+            _mm256_storeu_si256((__m256i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+
+    if (i < num_blocks)
+    {
+        dxt_decode_dxt3_ssse3(src + i * 16, num_blocks - i, dst + i * 16, dst_stride, rows, bgra);
+    }
+}
+
+TARGET_AVX2 void dxt_decode_dxt5_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                      size_t rows, bool bgra)
+{
+    size_t i = 0;
+    for (; i + 2 <= num_blocks; i += 2)
+    {
+        const uint8_t* block0 = src + i * 16;
+        const uint8_t* block1 = block0 + 16;
+        uint8_t* block_dst = dst + i * 16;
+
+        __m256i palettes = combine(color_palette(block0 + 8, false, bgra), color_palette(block1 + 8, false, bgra));
+        __m256i alpha = combine(interpolated_values(block0), interpolated_values(block1));
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m256i row = with_alpha2(color_row2(palettes, block0[12 + y], block1[12 + y]), alpha, y);
+            _mm256_storeu_si256((__m256i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+
+    if (i < num_blocks)
+    {
+        dxt_decode_dxt5_ssse3(src + i * 16, num_blocks - i, dst + i * 16, dst_stride, rows, bgra);
+    }
+}
+
+TARGET_AVX2 void dxt_decode_bc4_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                     size_t rows, bool bgra)
+{
+    size_t red = bgra ? 2 : 0;
+    __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+
+    size_t i = 0;
+    for (; i + 2 <= num_blocks; i += 2)
+    {
+        __m256i values = combine(interpolated_values(src + i * 8), interpolated_values(src + i * 8 + 8));
+        uint8_t* block_dst = dst + i * 16;
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m256i row = _mm256_or_si256(channel_row2(values, red, y), opaque);
+            _mm256_storeu_si256((__m256i*) (block_dst + (ptrdiff_t) y * dst_stride), row);
+        }
+    }
+
+    if (i < num_blocks)
+    {
+        dxt_decode_bc4_ssse3(src + i * 8, num_blocks - i, dst + i * 16, dst_stride, rows, bgra);
+    }
+}
+
+TARGET_AVX2 void dxt_decode_bc5_avx2(const uint8_t* src, size_t num_blocks, uint8_t* dst, ptrdiff_t dst_stride,
+                                     size_t rows, bool bgra)
+{
+    size_t red = bgra ? 2 : 0;
+    __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+
+    size_t i = 0;
+    for (; i + 2 <= num_blocks; i += 2)
+    {
+        const uint8_t* block0 = src + i * 16;
+        const uint8_t* block1 = block0 + 16;
+        uint8_t* block_dst = dst + i * 16;
+
+        __m256i red_values = combine(interpolated_values(block0), interpolated_values(block1));
+        __m256i green_values = combine(interpolated_values(block0 + 8), interpolated_values(block1 + 8));
+
+        for (size_t y = 0; y < rows; ++y)
+        {
+            __m256i row = _mm256_or_si256(channel_row2(red_values, red, y), channel_row2(green_values, 1, y));
+            _mm256_storeu_si256((__m256i*) (block_dst + (ptrdiff_t) y * dst_stride), _mm256_or_si256(row, opaque));
+        }
+    }
+
+    if (i < num_blocks)
+    {
+        dxt_decode_bc5_ssse3(src + i * 16, num_blocks - i, dst + i * 16, dst_stride, rows, bgra);
+    }
+}
+
+#endif
@@ -2,10 +2,12 @@
 //
 
 #include "format.h"
+#include "format_simd.h"
 #include "memory.h"
 #include "packed.h"
 
 #include <assert.h>
+#include <string.h>
 
 PACK(struct color_rgba
 {
@@ -43,135 +45,285 @@ size_t format_bpp(ImgloadFormat format)
     }
 }
 
-static void convert_rgba_bgra(ImgloadImageData* img_data)
+void format_init_params(FormatParams* params, uint64_t param)
 {
+    // For conversions adding an alpha channel the parameter is the alpha value
+    params->alpha = (uint8_t)param;
 
-    size_t slice_size = img_data->height * img_data->stride;
+    uint32_t r_ratio = 2126;
+    uint32_t g_ratio = 7152;
+    uint32_t b_ratio = 722;
 
-    uint8_t* data_begin = (uint8_t*) img_data->data;
-
-    for (size_t d = 0; d < img_data->depth; ++d)
+    if (param != 0)
     {
-        for (size_t y = 0; y < img_data->height; ++y)
+        // See imgload_transform_rgb, use bytes 4, 3, and 2 for r, g, and b
+        uint32_t r_param = (uint32_t)((param & 0xFF000000) >> 24);
+        uint32_t g_param = (uint32_t)((param & 0x00FF0000) >> 16);
+        uint32_t b_param = (uint32_t)((param & 0x0000FF00) >> 8);
+
+        if (r_param + g_param + b_param != 0)
         {
-            uint8_t* line_begin = data_begin + d * slice_size + y * img_data->stride;
+            r_ratio = r_param;
+            g_ratio = g_param;
+            b_ratio = b_param;
+        }
+    }
 
-            color_rgba_t* colors = (color_rgba_t*) line_begin;
+    // Compute the weights once in fixed point, rounding errors are added to green so the weights sum up exactly
+    uint32_t sum = r_ratio + g_ratio + b_ratio;
+    uint32_t one = 1u << FORMAT_LUMINANCE_SHIFT;
 
-            for (size_t x = 0; x < img_data->width; ++x)
-            {
-                color_rgba_t c = colors[x];
+    uint32_t r_weight = (r_ratio * one + sum / 2) / sum;
+    uint32_t b_weight = (b_ratio * one + sum / 2) / sum;
+    if (r_weight + b_weight > one)
+    {
+        b_weight = one - r_weight;
+    }
 
-                color_rgba_t* dest_color = colors + x;
+    params->luminance_weights[0] = (uint16_t)r_weight;
+    params->luminance_weights[1] = (uint16_t)(one - r_weight - b_weight);
+    params->luminance_weights[2] = (uint16_t)b_weight;
+}
 
-                // Switch r and b, the rest stays the same
-                dest_color->r = c.b;
-                dest_color->b = c.r;
-            }
-        }
+static uint8_t luminance(const FormatParams* params, uint8_t r, uint8_t g, uint8_t b)
+{
+    uint32_t sum = r * (uint32_t)params->luminance_weights[0] + g * (uint32_t)params->luminance_weights[1]
+        + b * (uint32_t)params->luminance_weights[2];
+
+    return (uint8_t)(sum >> FORMAT_LUMINANCE_SHIFT);
+}
+
+void format_swap_rb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    (void)params;
+
+    const color_rgba_t* input = (const color_rgba_t*)src;
+    color_rgba_t* output = (color_rgba_t*)dst;
+
+    for (size_t x = 0; x < width; ++x)
+    {
+        // Read the complete color first since this may be done in-place
+        color_rgba_t c = input[x];
+
+        output[x].r = c.b;
+        output[x].g = c.g;
+        output[x].b = c.r;
+        output[x].a = c.a;
     }
 }
 
-typedef void (* ConverterFunction)(ImgloadImage img, void* input_ptr, void* output_ptr);
+void format_rgba_to_rgb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    (void)params;
+
+    const color_rgba_t* input = (const color_rgba_t*)src;
+    color_rgb_t* output = (color_rgb_t*)dst;
+
+    for (size_t x = 0; x < width; ++x)
+    {
+        output[x].r = input[x].r;
+        output[x].g = input[x].g;
+        output[x].b = input[x].b;
+    }
+}
 
-static void convert_generic(ImgloadImage img, ImgloadImageData* input, ImgloadFormat input_fmt,
-                            ImgloadImageData* output,
-                            ImgloadFormat output_fmt, ConverterFunction converter)
+void format_bgra_to_rgb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
 {
-    size_t input_slice_size = input->height * input->stride;
-    size_t output_slice_size = output->height * output->stride;
+    (void)params;
 
-    uint8_t* input_begin = (uint8_t*) input->data;
-    uint8_t* output_begin = (uint8_t*) output->data;
+    const color_rgba_t* input = (const color_rgba_t*)src;
+    color_rgb_t* output = (color_rgb_t*)dst;
 
-    size_t input_bpp = format_bpp(input_fmt);
-    size_t output_bpp = format_bpp(output_fmt);
+    for (size_t x = 0; x < width; ++x)
+    {
+        output[x].r = input[x].b;
+        output[x].g = input[x].g;
+        output[x].b = input[x].r;
+    }
+}
 
-    for (size_t d = 0; d < input->depth; ++d)
+void format_rgba_to_gray_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    const color_rgba_t* input = (const color_rgba_t*)src;
+
+    for (size_t x = 0; x < width; ++x)
     {
-        for (size_t y = 0; y < input->height; ++y)
-        {
-            uint8_t* input_line_begin = input_begin + d * input_slice_size + y * input->stride;
-            uint8_t* output_line_begin = output_begin + d * output_slice_size + y * output->stride;
+        dst[x] = luminance(params, input[x].r, input[x].g, input[x].b);
+    }
+}
 
-            for (size_t x = 0; x < input->width; ++x)
-            {
-                uint8_t* input_ptr = input_line_begin + x * input_bpp;
-                uint8_t* output_ptr = output_line_begin + x * output_bpp;
+void format_bgra_to_gray_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    const color_rgba_t* input = (const color_rgba_t*)src;
 
-                converter(img, input_ptr, output_ptr);
-            }
-        }
+    for (size_t x = 0; x < width; ++x)
+    {
+        dst[x] = luminance(params, input[x].b, input[x].g, input[x].r);
     }
 }
 
-static void rgb_to_rgba(ImgloadImage img, void* input_ptr, void* output_ptr)
+void format_rgb_to_rgba_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
 {
-    color_rgb_t* input_color = (color_rgb_t*) input_ptr;
-    color_rgba_t* output_color = (color_rgba_t*) output_ptr;
+    const color_rgb_t* input = (const color_rgb_t*)src;
+    color_rgba_t* output = (color_rgba_t*)dst;
 
-    output_color->r = input_color->r;
-    output_color->g = input_color->g;
-    output_color->b = input_color->b;
-    output_color->a = (uint8_t) img->conv.param; // The parameter is the alpha value
+    for (size_t x = 0; x < width; ++x)
+    {
+        output[x].r = input[x].r;
+        output[x].g = input[x].g;
+        output[x].b = input[x].b;
+        output[x].a = params->alpha;
+    }
 }
 
-static void rgba_to_rgb(ImgloadImage img, void* input_ptr, void* output_ptr)
+void format_rgb_to_bgra_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
 {
-    color_rgba_t* input_color = (color_rgba_t*) input_ptr;
-    color_rgb_t* output_color = (color_rgb_t*) output_ptr;
+    const color_rgb_t* input = (const color_rgb_t*)src;
+    color_rgba_t* output = (color_rgba_t*)dst;
 
-    output_color->r = input_color->r;
-    output_color->g = input_color->g;
-    output_color->b = input_color->b;
+    for (size_t x = 0; x < width; ++x)
+    {
+        output[x].r = input[x].b;
+        output[x].g = input[x].g;
+        output[x].b = input[x].r;
+        output[x].a = params->alpha;
+    }
 }
 
-static void rgb_to_luminance(ImgloadImage img, void* input_ptr, void* output_ptr)
+void format_rgb_to_gray_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
 {
-    float r_factor = 0.2126f;
-    float g_factor = 0.7152f;
-    float b_factor = 0.0722f;
+    const color_rgb_t* input = (const color_rgb_t*)src;
 
-    if (img->conv.param != 0)
+    for (size_t x = 0; x < width; ++x)
     {
-        uint64_t param = img->conv.param;
-        // See imgload_transform_rgb, use bytes 4, 3, and 2 for r, g, and b
-        uint64_t r_ratio = (param & 0xFF000000) >> 24;
-        uint64_t g_ratio = (param & 0x00FF0000) >> 16;
-        uint64_t b_ratio = (param & 0x0000FF00) >> 8;
+        dst[x] = luminance(params, input[x].r, input[x].g, input[x].b);
+    }
+}
+
+void format_gray_to_rgba_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    color_rgba_t* output = (color_rgba_t*)dst;
 
-        uint64_t sum = r_ratio + g_ratio + b_ratio;
+    for (size_t x = 0; x < width; ++x)
+    {
+        output[x].r = src[x];
+        output[x].g = src[x];
+        output[x].b = src[x];
+        output[x].a = params->alpha;
+    }
+}
+
+void format_gray_to_rgb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    (void)params;
+
+    color_rgb_t* output = (color_rgb_t*)dst;
 
-        r_factor = (float)r_ratio / sum;
-        g_factor = (float)g_ratio / sum;
-        b_factor = (float)b_ratio / sum;
+    for (size_t x = 0; x < width; ++x)
+    {
+        output[x].r = src[x];
+        output[x].g = src[x];
+        output[x].b = src[x];
     }
+}
+
+/**
+ * @brief A converter for every combination of formats, the first index is the source format
+ */
+typedef struct
+{
+    FormatRowConverter converters[4][4];
+} ConverterTable;
+
+static void select_scalar(ConverterTable* table)
+{
+    memset(table, 0, sizeof(*table));
+
+    table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_B8G8R8A8] = format_swap_rb_scalar;
+    table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_R8G8B8] = format_rgba_to_rgb_scalar;
+    table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_GRAY8] = format_rgba_to_gray_scalar;
+
+    table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_R8G8B8A8] = format_swap_rb_scalar;
+    table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_R8G8B8] = format_bgra_to_rgb_scalar;
+    table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_GRAY8] = format_bgra_to_gray_scalar;
 
-    color_rgb_t* input_color = (color_rgb_t*) input_ptr;
-    uint8_t* output_color = (uint8_t*) output_ptr;
+    table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_R8G8B8A8] = format_rgb_to_rgba_scalar;
+    table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_B8G8R8A8] = format_rgb_to_bgra_scalar;
+    table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_GRAY8] = format_rgb_to_gray_scalar;
 
-    *output_color = (uint8_t) (input_color->r * r_factor + input_color->g * g_factor + input_color->b * b_factor);
+    // Gray values are the same for RGBA and BGRA
+    table->converters[IMGLOAD_FORMAT_GRAY8][IMGLOAD_FORMAT_R8G8B8A8] = format_gray_to_rgba_scalar;
+    table->converters[IMGLOAD_FORMAT_GRAY8][IMGLOAD_FORMAT_B8G8R8A8] = format_gray_to_rgba_scalar;
+    table->converters[IMGLOAD_FORMAT_GRAY8][IMGLOAD_FORMAT_R8G8B8] = format_gray_to_rgb_scalar;
 }
 
-static void luminance_to_rgba(ImgloadImage img, void* input_ptr, void* output_ptr)
+#if FORMAT_HAVE_X86_KERNELS
+static void select_x86(ConverterTable* table, CpuFeatures features)
 {
-    uint8_t* input_color = (uint8_t*) input_ptr;
-    color_rgba_t* output_color = (color_rgba_t*) output_ptr;
+    if (features & CPU_FEATURE_SSE2)
+    {
+        table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_B8G8R8A8] = format_swap_rb_sse2;
+        table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_R8G8B8A8] = format_swap_rb_sse2;
+
+        table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_GRAY8] = format_rgba_to_gray_sse2;
+        table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_GRAY8] = format_bgra_to_gray_sse2;
+
+        table->converters[IMGLOAD_FORMAT_GRAY8][IMGLOAD_FORMAT_R8G8B8A8] = format_gray_to_rgba_sse2;
+        table->converters[IMGLOAD_FORMAT_GRAY8][IMGLOAD_FORMAT_B8G8R8A8] = format_gray_to_rgba_sse2;
+    }
+
+    if (features & CPU_FEATURE_SSSE3)
+    {
+        table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_B8G8R8A8] = format_swap_rb_ssse3;
+        table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_R8G8B8A8] = format_swap_rb_ssse3;
+
+        table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_R8G8B8] = format_rgba_to_rgb_ssse3;
+        table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_R8G8B8] = format_bgra_to_rgb_ssse3;
+
+        table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_R8G8B8A8] = format_rgb_to_rgba_ssse3;
+        table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_B8G8R8A8] = format_rgb_to_bgra_ssse3;
+        table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_GRAY8] = format_rgb_to_gray_ssse3;
 
-    output_color->r = *input_color;
-    output_color->g = *input_color;
-    output_color->b = *input_color;
-    output_color->a = (uint8_t) img->conv.param; // The parameter is the alpha value
+        table->converters[IMGLOAD_FORMAT_GRAY8][IMGLOAD_FORMAT_R8G8B8] = format_gray_to_rgb_ssse3;
+    }
+
+    if (features & CPU_FEATURE_AVX2)
+    {
+        table->converters[IMGLOAD_FORMAT_R8G8B8A8][IMGLOAD_FORMAT_B8G8R8A8] = format_swap_rb_avx2;
+        table->converters[IMGLOAD_FORMAT_B8G8R8A8][IMGLOAD_FORMAT_R8G8B8A8] = format_swap_rb_avx2;
+
+        table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_R8G8B8A8] = format_rgb_to_rgba_avx2;
+        table->converters[IMGLOAD_FORMAT_R8G8B8][IMGLOAD_FORMAT_B8G8R8A8] = format_rgb_to_bgra_avx2;
+    }
 }
+#endif
 
-static void luminance_to_rgb(ImgloadImage img, void* input_ptr, void* output_ptr)
+FormatRowConverter format_row_converter(ImgloadFormat from, ImgloadFormat to)
 {
-    uint8_t* input_color = (uint8_t*) input_ptr;
-    color_rgb_t* output_color = (color_rgb_t*) output_ptr;
+    if (from > IMGLOAD_FORMAT_GRAY8 || to > IMGLOAD_FORMAT_GRAY8)
+    {
+        return NULL;
+    }
+
+    // The table is built once like the CPU features. Concurrent first calls build the same table and it is only
+    // copied after it is complete, so the race is harmless
+    static volatile bool built = false;
+    static ConverterTable table;
+
+    if (!built)
+    {
+        ConverterTable selected;
+        select_scalar(&selected);
+
+#if FORMAT_HAVE_X86_KERNELS
+        select_x86(&selected, cpu_features());
+#endif
 
-    output_color->r = *input_color;
-    output_color->g = *input_color;
-    output_color->b = *input_color;
+        table = selected;
+        built = true;
+    }
+
+    return table.converters[from][to];
 }
 
 ImgloadErrorCode format_change(ImgloadImage img, ImgloadFormat current, ImgloadImageData* data,
@@ -191,6 +343,15 @@ ImgloadErrorCode format_change(ImgloadImage img, ImgloadFormat current, ImgloadI
         return IMGLOAD_ERR_NO_ERROR;
     }
 
+    FormatRowConverter converter = format_row_converter(current, destination);
+    if (converter == NULL)
+    {
+        return IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
+    }
+
+    FormatParams params;
+    format_init_params(&params, img->conv.param);
+
     // When both formats use the same amount of memory then the conversion can happen in-place
     bool in_place = format_bpp(current) == format_bpp(destination);
 
@@ -208,7 +369,7 @@ ImgloadErrorCode format_change(ImgloadImage img, ImgloadFormat current, ImgloadI
     {
         size_t converted_stride = data->width * format_bpp(destination);
         size_t converted_size = data->depth * data->height * converted_stride;
-        uint8_t* converted_data = mem_realloc(img->context, NULL, converted_size);
+        uint8_t* converted_data = mem_pixels_realloc(img->context, NULL, converted_size);
 
         if (converted_data == NULL)
         {
@@ -220,97 +381,23 @@ ImgloadErrorCode format_change(ImgloadImage img, ImgloadFormat current, ImgloadI
         converted_out->data = converted_data;
     }
 
-    ImgloadErrorCode err = IMGLOAD_ERR_NO_ERROR;
+    const uint8_t* input_begin = (const uint8_t*) data->data;
+    uint8_t* output_begin = (uint8_t*) converted_out->data;
 
-    // A giant switch-case for handling all possible combinations, if you have a better solution, let me know...
-    switch(current)
+    // Slices are stored directly after each other so all rows can be processed in one loop
+    size_t rows = data->depth * data->height;
+    for (size_t y = 0; y < rows; ++y)
     {
-        case IMGLOAD_FORMAT_R8G8B8A8:
-            switch(destination)
-            {
-                case IMGLOAD_FORMAT_B8G8R8A8:
-                    convert_rgba_bgra(converted_out);
-                    break;
-                case IMGLOAD_FORMAT_R8G8B8:
-                    convert_generic(img, data, IMGLOAD_FORMAT_R8G8B8A8, converted_out, IMGLOAD_FORMAT_R8G8B8, rgba_to_rgb);
-                    break;
-                case IMGLOAD_FORMAT_GRAY8:
-                    // We can use rgb_to_luminance because the alpha value is ignored, we just need to set the right source format
-                    convert_generic(img, data, IMGLOAD_FORMAT_R8G8B8A8, converted_out, IMGLOAD_FORMAT_GRAY8, rgb_to_luminance);
-                    break;
-                default:
-                    err = IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
-                    break;
-            }
-            break;
-        case IMGLOAD_FORMAT_B8G8R8A8:
-            switch(destination)
-            {
-                case IMGLOAD_FORMAT_R8G8B8A8:
-                    convert_rgba_bgra(converted_out);
-                    break;
-                case IMGLOAD_FORMAT_R8G8B8:
-                    convert_rgba_bgra(data);
-                    convert_generic(img, data, IMGLOAD_FORMAT_R8G8B8A8, converted_out, IMGLOAD_FORMAT_R8G8B8, rgba_to_rgb);
-                    break;
-                case IMGLOAD_FORMAT_GRAY8:
-                    convert_rgba_bgra(data);
-                    // We can use rgb_to_luminance because the alpha value is ignored, we just need to set the right source format
-                    convert_generic(img, data, IMGLOAD_FORMAT_R8G8B8A8, converted_out, IMGLOAD_FORMAT_GRAY8, rgb_to_luminance);
-                    break;
-                default:
-                    err = IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
-                    break;
-            }
-            break;
-        case IMGLOAD_FORMAT_R8G8B8:
-            switch(destination)
-            {
-                case IMGLOAD_FORMAT_R8G8B8A8:
-                    convert_generic(img, data, IMGLOAD_FORMAT_R8G8B8, converted_out, IMGLOAD_FORMAT_R8G8B8A8, rgb_to_rgba);
-                    break;
-                case IMGLOAD_FORMAT_B8G8R8A8:
-                    convert_generic(img, data, IMGLOAD_FORMAT_R8G8B8, converted_out, IMGLOAD_FORMAT_R8G8B8A8, rgb_to_rgba);
-                    convert_rgba_bgra(converted_out);
-                    break;
-                case IMGLOAD_FORMAT_GRAY8:
-                    convert_generic(img, data, IMGLOAD_FORMAT_R8G8B8, converted_out, IMGLOAD_FORMAT_GRAY8, rgb_to_luminance);
-                    break;
-                default:
-                    err = IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
-                    break;
-            }
-            break;
-        case IMGLOAD_FORMAT_GRAY8:
-            switch(destination)
-            {
-                case IMGLOAD_FORMAT_R8G8B8A8:
-                    convert_generic(img, data, IMGLOAD_FORMAT_GRAY8, converted_out, IMGLOAD_FORMAT_R8G8B8A8, luminance_to_rgba);
-                    break;
-                case IMGLOAD_FORMAT_B8G8R8A8:
-                    convert_rgba_bgra(data);
-                    convert_generic(img, data, IMGLOAD_FORMAT_GRAY8, converted_out, IMGLOAD_FORMAT_R8G8B8A8, luminance_to_rgba);
-                    break;
-                case IMGLOAD_FORMAT_R8G8B8:
-                    convert_generic(img, data, IMGLOAD_FORMAT_GRAY8, converted_out, IMGLOAD_FORMAT_R8G8B8A8, luminance_to_rgb);
-                    break;
-                default:
-                    err = IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
-                    break;
-            }
-            break;
-        default:
-            err = IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
-            break;
+        converter(input_begin + y * data->stride, output_begin + y * converted_out->stride, data->width, &params);
     }
 
     if (!in_place)
     {
         // Free the original data
-        mem_free(img->context, data->data);
+        mem_pixels_free(img->context, data->data);
     }
 
-    return err;
+    return IMGLOAD_ERR_NO_ERROR;
 }
 
 uint64_t IMGLOAD_API imgload_transform_alpha(uint8_t alpha)
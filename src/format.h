@@ -2,6 +2,36 @@
 
 #include "image.h"
 
+/**
+ * @brief Precomputed parameters of a format conversion
+ */
+typedef struct
+{
+    uint8_t alpha; //!< The alpha value used when converting to a format with an alpha channel
+
+    /**
+     * Fixed point weights of the red, green and blue channels used for converting to luminance. The weights add up to
+     * (1 << FORMAT_LUMINANCE_SHIFT).
+     */
+    uint16_t luminance_weights[3];
+} FormatParams;
+
+#define FORMAT_LUMINANCE_SHIFT 14
+
+/**
+ * @brief Converts one row of pixels
+ * Converters between formats with the same number of bytes per pixel may be called with src == dst.
+ */
+typedef void (*FormatRowConverter)(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+
 ImgloadErrorCode format_change(ImgloadImage img, ImgloadFormat current, ImgloadImageData* data, ImgloadImageData* converted_out);
 
 size_t format_bpp(ImgloadFormat format);
+
+void format_init_params(FormatParams* params, uint64_t param);
+
+/**
+ * @brief Gets the fastest row converter for the given formats supported by the current CPU
+ * @return The converter or @c NULL if the conversion is not supported
+ */
+FormatRowConverter format_row_converter(ImgloadFormat from, ImgloadFormat to);
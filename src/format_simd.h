@@ -0,0 +1,47 @@
+#pragma once
+
+#include "format.h"
+#include "cpu.h"
+#include "project.h"
+
+#if IMGLOADER_WITH_SIMD && IMGLOAD_ARCH_X86
+#define FORMAT_HAVE_X86_KERNELS 1
+#else
+#define FORMAT_HAVE_X86_KERNELS 0
+#endif
+
+#if FORMAT_HAVE_X86_KERNELS
+
+// SSE2 kernels
+void format_swap_rb_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_gray_to_rgba_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgba_to_gray_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_bgra_to_gray_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+
+// SSSE3 kernels
+void format_swap_rb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgba_to_rgb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_bgra_to_rgb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_rgba_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_bgra_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_gray_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_gray_to_rgb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+
+// AVX2 kernels
+void format_swap_rb_avx2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_rgba_avx2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_bgra_avx2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+
+#endif
+
+// Scalar kernels, also used by the SIMD kernels for the pixels at the end of a row
+void format_swap_rb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgba_to_rgb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_bgra_to_rgb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgba_to_gray_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_bgra_to_gray_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_rgba_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_bgra_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_rgb_to_gray_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_gray_to_rgba_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
+void format_gray_to_rgb_scalar(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params);
@@ -0,0 +1,333 @@
+//
+//
+
+#include "format_simd.h"
+
+#if FORMAT_HAVE_X86_KERNELS
+
+#include <immintrin.h>
+
+// Byte value which makes pshufb write a zero
+#define Z -1
+
+static TARGET_SSE2 __m128i alpha_mask(const FormatParams* params)
+{
+    return _mm_set1_epi32((int)((uint32_t)params->alpha << 24));
+}
+
+static TARGET_SSE2 __m128i luminance_weights(uint16_t first, uint16_t second, uint16_t third)
+{
+    return _mm_setr_epi16((short)first, (short)second, (short)third, 0, (short)first, (short)second, (short)third, 0);
+}
+
+/**
+ * @brief Computes the luminance of four 4 byte pixels, the result is stored in the lowest byte of every 32-bit lane
+ */
+static TARGET_SSE2 __m128i luminance4(__m128i pixels, __m128i weights)
+{
+    __m128i zero = _mm_setzero_si128();
+
+    // Every 32-bit lane contains one partial sum of a pixel, the next lane contains the rest
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+
+    __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+
+    __m128i sum = _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+
+    return _mm_srli_epi32(sum, FORMAT_LUMINANCE_SHIFT);
+}
+
+/**
+ * @brief Computes the luminance of 16 pixels with 4 bytes each and stores the result
+ */
+static TARGET_SSE2 void store_luminance16(uint8_t* dst, __m128i p0, __m128i p1, __m128i p2, __m128i p3, __m128i weights)
+{
+    __m128i lo = _mm_packs_epi32(luminance4(p0, weights), luminance4(p1, weights));
+    __m128i hi = _mm_packs_epi32(luminance4(p2, weights), luminance4(p3, weights));
+
+    _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+}
+
+static TARGET_SSE2 void four_bytes_to_gray_sse2(const uint8_t* src, uint8_t* dst, size_t width, __m128i weights)
+{
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        const uint8_t* in = src + x * 4;
+
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(in + 0));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(in + 16));
+        __m128i p2 = _mm_loadu_si128((const __m128i*)(in + 32));
+        __m128i p3 = _mm_loadu_si128((const __m128i*)(in + 48));
+
+        store_luminance16(dst + x, p0, p1, p2, p3, weights);
+    }
+}
+
+TARGET_SSE2 void format_swap_rb_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i ga_mask = _mm_set1_epi32((int)0xFF00FF00);
+
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + x * 4));
+
+        // Red and blue are the low bytes of the two 16-bit words of a pixel
+        __m128i ga = _mm_and_si128(pixels, ga_mask);
+        __m128i rb = _mm_andnot_si128(ga_mask, pixels);
+        rb = _mm_shufflelo_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+        rb = _mm_shufflehi_epi16(rb, _MM_SHUFFLE(2, 3, 0, 1));
+
+        _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_or_si128(ga, rb));
+    }
+
+    format_swap_rb_scalar(src + x * 4, dst + x * 4, width - x, params);
+}
+
+TARGET_SSE2 void format_gray_to_rgba_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i alpha = _mm_set1_epi8((char)params->alpha);
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i gray = _mm_loadu_si128((const __m128i*)(src + x));
+        uint8_t* out = dst + x * 4;
+
+        __m128i gg_lo = _mm_unpacklo_epi8(gray, gray);
+        __m128i gg_hi = _mm_unpackhi_epi8(gray, gray);
+        __m128i ga_lo = _mm_unpacklo_epi8(gray, alpha);
+        __m128i ga_hi = _mm_unpackhi_epi8(gray, alpha);
+
+        _mm_storeu_si128((__m128i*)(out + 0), _mm_unpacklo_epi16(gg_lo, ga_lo));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_unpackhi_epi16(gg_lo, ga_lo));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_unpacklo_epi16(gg_hi, ga_hi));
+        _mm_storeu_si128((__m128i*)(out + 48), _mm_unpackhi_epi16(gg_hi, ga_hi));
+    }
+
+    format_gray_to_rgba_scalar(src + x, dst + x * 4, width - x, params);
+}
+
+TARGET_SSE2 void format_rgba_to_gray_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    const uint16_t* w = params->luminance_weights;
+    four_bytes_to_gray_sse2(src, dst, width, luminance_weights(w[0], w[1], w[2]));
+
+    size_t x = width - width % 16;
+    format_rgba_to_gray_scalar(src + x * 4, dst + x, width - x, params);
+}
+
+TARGET_SSE2 void format_bgra_to_gray_sse2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    const uint16_t* w = params->luminance_weights;
+    four_bytes_to_gray_sse2(src, dst, width, luminance_weights(w[2], w[1], w[0]));
+
+    size_t x = width - width % 16;
+    format_bgra_to_gray_scalar(src + x * 4, dst + x, width - x, params);
+}
+
+TARGET_SSSE3 void format_swap_rb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(src + x * 4));
+        _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_shuffle_epi8(pixels, shuffle));
+    }
+
+    format_swap_rb_scalar(src + x * 4, dst + x * 4, width - x, params);
+}
+
+/**
+ * @brief Drops the fourth byte of 16 pixels, @p shuffle packs four pixels into the low 12 bytes
+ */
+static TARGET_SSSE3 size_t four_to_three_bytes_ssse3(const uint8_t* src, uint8_t* dst, size_t width, __m128i shuffle)
+{
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        const uint8_t* in = src + x * 4;
+        uint8_t* out = dst + x * 3;
+
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 0)), shuffle);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 16)), shuffle);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 32)), shuffle);
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(in + 48)), shuffle);
+
+        _mm_storeu_si128((__m128i*)(out + 0), _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    }
+
+    return x;
+}
+
+TARGET_SSSE3 void format_rgba_to_rgb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, Z, Z, Z, Z);
+    size_t x = four_to_three_bytes_ssse3(src, dst, width, shuffle);
+
+    format_rgba_to_rgb_scalar(src + x * 4, dst + x * 3, width - x, params);
+}
+
+TARGET_SSSE3 void format_bgra_to_rgb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, Z, Z, Z, Z);
+    size_t x = four_to_three_bytes_ssse3(src, dst, width, shuffle);
+
+    format_bgra_to_rgb_scalar(src + x * 4, dst + x * 3, width - x, params);
+}
+
+/**
+ * @brief Loads 16 pixels with 3 bytes each and expands them to 4 bytes using @p shuffle
+ */
+static TARGET_SSSE3 void load_three_bytes16(const uint8_t* in, __m128i shuffle, __m128i out[4])
+{
+    __m128i in0 = _mm_loadu_si128((const __m128i*)(in + 0));
+    __m128i in1 = _mm_loadu_si128((const __m128i*)(in + 16));
+    __m128i in2 = _mm_loadu_si128((const __m128i*)(in + 32));
+
+    out[0] = _mm_shuffle_epi8(in0, shuffle);
+    out[1] = _mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), shuffle);
+    out[2] = _mm_shuffle_epi8(_mm_alignr_epi8(in2, in1, 8), shuffle);
+    out[3] = _mm_shuffle_epi8(_mm_srli_si128(in2, 4), shuffle);
+}
+
+static TARGET_SSSE3 size_t three_to_four_bytes_ssse3(const uint8_t* src, uint8_t* dst, size_t width, __m128i shuffle,
+                                                    __m128i alpha)
+{
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i pixels[4];
+        load_three_bytes16(src + x * 3, shuffle, pixels);
+
+        uint8_t* out = dst + x * 4;
+        _mm_storeu_si128((__m128i*)(out + 0), _mm_or_si128(pixels[0], alpha));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_or_si128(pixels[1], alpha));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_or_si128(pixels[2], alpha));
+        _mm_storeu_si128((__m128i*)(out + 48), _mm_or_si128(pixels[3], alpha));
+    }
+
+    return x;
+}
+
+TARGET_SSSE3 void format_rgb_to_rgba_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i shuffle = _mm_setr_epi8(0, 1, 2, Z, 3, 4, 5, Z, 6, 7, 8, Z, 9, 10, 11, Z);
+    size_t x = three_to_four_bytes_ssse3(src, dst, width, shuffle, alpha_mask(params));
+
+    format_rgb_to_rgba_scalar(src + x * 3, dst + x * 4, width - x, params);
+}
+
+TARGET_SSSE3 void format_rgb_to_bgra_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i shuffle = _mm_setr_epi8(2, 1, 0, Z, 5, 4, 3, Z, 8, 7, 6, Z, 11, 10, 9, Z);
+    size_t x = three_to_four_bytes_ssse3(src, dst, width, shuffle, alpha_mask(params));
+
+    format_rgb_to_bgra_scalar(src + x * 3, dst + x * 4, width - x, params);
+}
+
+TARGET_SSSE3 void format_rgb_to_gray_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i shuffle = _mm_setr_epi8(0, 1, 2, Z, 3, 4, 5, Z, 6, 7, 8, Z, 9, 10, 11, Z);
+
+    const uint16_t* w = params->luminance_weights;
+    __m128i weights = luminance_weights(w[0], w[1], w[2]);
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i pixels[4];
+        load_three_bytes16(src + x * 3, shuffle, pixels);
+
+        store_luminance16(dst + x, pixels[0], pixels[1], pixels[2], pixels[3], weights);
+    }
+
+    format_rgb_to_gray_scalar(src + x * 3, dst + x, width - x, params);
+}
+
+TARGET_SSSE3 void format_gray_to_rgb_ssse3(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m128i shuffle0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    __m128i shuffle1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    __m128i shuffle2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+    size_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        __m128i gray = _mm_loadu_si128((const __m128i*)(src + x));
+        uint8_t* out = dst + x * 3;
+
+        _mm_storeu_si128((__m128i*)(out + 0), _mm_shuffle_epi8(gray, shuffle0));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_shuffle_epi8(gray, shuffle1));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_shuffle_epi8(gray, shuffle2));
+    }
+
+    format_gray_to_rgb_scalar(src + x, dst + x * 3, width - x, params);
+}
+
+TARGET_AVX2 void format_swap_rb_avx2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                       2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+        __m256i pixels = _mm256_loadu_si256((const __m256i*)(src + x * 4));
+        _mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_shuffle_epi8(pixels, shuffle));
+    }
+
+    format_swap_rb_scalar(src + x * 4, dst + x * 4, width - x, params);
+}
+
+static TARGET_AVX2 size_t three_to_four_bytes_avx2(const uint8_t* src, uint8_t* dst, size_t width, __m256i shuffle,
+                                                   __m256i alpha)
+{
+    size_t x = 0;
+
+    // Each lane loads 16 bytes but only uses 12 of them so the last load needs 4 more bytes of input
+    for (; x + 10 <= width; x += 8)
+    {
+        const uint8_t* in = src + x * 3;
+
+        __m128i lo = _mm_loadu_si128((const __m128i*)(in + 0));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(in + 12));
+        __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        pixels = _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha);
+        _mm256_storeu_si256((__m256i*)(dst + x * 4), pixels);
+    }
+
+    return x;
+}
+
+TARGET_AVX2 void format_rgb_to_rgba_avx2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m256i shuffle = _mm256_setr_epi8(0, 1, 2, Z, 3, 4, 5, Z, 6, 7, 8, Z, 9, 10, 11, Z,
+                                       0, 1, 2, Z, 3, 4, 5, Z, 6, 7, 8, Z, 9, 10, 11, Z);
+    __m256i alpha = _mm256_set1_epi32((int)((uint32_t)params->alpha << 24));
+
+    size_t x = three_to_four_bytes_avx2(src, dst, width, shuffle, alpha);
+
+    format_rgb_to_rgba_scalar(src + x * 3, dst + x * 4, width - x, params);
+}
+
+TARGET_AVX2 void format_rgb_to_bgra_avx2(const uint8_t* src, uint8_t* dst, size_t width, const FormatParams* params)
+{
+    __m256i shuffle = _mm256_setr_epi8(2, 1, 0, Z, 5, 4, 3, Z, 8, 7, 6, Z, 11, 10, 9, Z,
+                                       2, 1, 0, Z, 5, 4, 3, Z, 8, 7, 6, Z, 11, 10, 9, Z);
+    __m256i alpha = _mm256_set1_epi32((int)((uint32_t)params->alpha << 24));
+
+    size_t x = three_to_four_bytes_avx2(src, dst, width, shuffle, alpha);
+
+    format_rgb_to_bgra_scalar(src + x * 3, dst + x * 4, width - x, params);
+}
+
+#endif
@@ -4,6 +4,9 @@
 #include "context.h"
 #include "log.h"
 #include "format.h"
+#include "dxt.h"
+#include "thread.h"
+#include "trace.h"
 
 #include <string.h>
 #include <assert.h>
@@ -20,55 +23,523 @@ static bool validate_image(ImgloadImage img)
     return true;
 }
 
+static ImgloadImage image_alloc(ImgloadContext ctx)
+{
+    ImgloadImage img;
+    if (ctx->flags & IMGLOAD_CONTEXT_IMAGE_ARENA)
+    {
+        MemArena arena;
+        mem_arena_init(&arena);
+
+        img = (ImgloadImage)mem_arena_alloc(ctx, &arena, sizeof(struct ImgloadImageImpl));
+        if (img == NULL)
+        {
+            return NULL;
+        }
+        img->use_arena = true;
+        img->arena = arena;
+    }
+    else
+    {
+        img = (ImgloadImage)mem_reallocz(ctx, NULL, sizeof(struct ImgloadImageImpl));
+        if (img == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    img->context = ctx;
+    img->collect_stats = ctx->stats.enabled;
+
+    return img;
+}
+
+static void image_dealloc(ImgloadImage img)
+{
+    if (img->use_arena)
+    {
+        // The image is stored in the arena so the arena has to be copied out first
+        MemArena arena = img->arena;
+        mem_arena_release(img->context, &arena);
+    }
+    else
+    {
+        mem_free(img->context, img);
+    }
+}
+
+void* image_mem_alloc(ImgloadImage img, size_t size)
+{
+    if (img->use_arena)
+    {
+        return mem_arena_alloc(img->context, &img->arena, size);
+    }
+    return mem_reallocz(img->context, NULL, size);
+}
+
+void image_mem_free(ImgloadImage img, void* ptr)
+{
+    if (img->use_arena)
+    {
+        mem_arena_free(img->context, &img->arena, ptr);
+    }
+    else if (ptr != NULL)
+    {
+        mem_free(img->context, ptr);
+    }
+}
+
+char* image_mem_strdup(ImgloadImage img, const char* str)
+{
+    if (img->use_arena)
+    {
+        return mem_arena_strdup(img->context, &img->arena, str);
+    }
+    return mem_strdup(img->context, str);
+}
+
+/**
+ * @brief A stage of loading an image which is measured and traced
+ */
+typedef struct
+{
+    const char* name;
+    ImgloadPlugin plugin;
+    StatsPhase previous;
+} ImageStage;
+
+/**
+ * @brief Starts a stage, the time is charged to the given statistics phase until the stage ends or another one begins
+ * @param plugin The plugin handling the stage for the trace handlers
+ */
+static ImageStage image_plugin_stage_begin(ImgloadImage img, ImgloadPlugin plugin, StatsPhase phase, const char* name)
+{
+    ImageStage stage;
+    stage.name = name;
+    stage.plugin = plugin;
+    stage.previous = STATS_PHASE_NONE;
+
+    if (trace_enabled(img->context))
+    {
+        trace_event(img->context, true, name, plugin, img);
+    }
+    if (img->collect_stats)
+    {
+        stage.previous = stats_enter(&img->stats, phase);
+    }
+
+    return stage;
+}
+
+static ImageStage image_stage_begin(ImgloadImage img, StatsPhase phase, const char* name)
+{
+    return image_plugin_stage_begin(img, img->plugin, phase, name);
+}
+
+static void image_stage_end(ImgloadImage img, ImageStage stage)
+{
+    if (img->collect_stats)
+    {
+        stats_leave(&img->stats, stage.previous);
+    }
+    if (trace_enabled(img->context))
+    {
+        trace_event(img->context, false, stage.name, stage.plugin, img);
+    }
+}
+
+/**
+ * @brief Adds the statistics of an image which is freed to its context and plugin
+ */
+static void image_stats_merge(ImgloadImage img)
+{
+    ImgloadContext ctx = img->context;
+
+    ImgloadStats* values = &img->stats.values;
+    values->images = 1;
+
+    thread_mutex_lock(&ctx->stats.lock);
+
+    stats_add(&ctx->stats.totals, values);
+    if (img->plugin != NULL)
+    {
+        // The plugin only gets the time of its own probe functions
+        uint64_t probe_ns = values->probe_ns;
+        values->probe_ns = 0;
+        stats_add(&img->plugin->stats, values);
+        values->probe_ns = probe_ns;
+    }
+
+    thread_mutex_unlock(&ctx->stats.lock);
+}
+
+static size_t image_io_callback_read(ImgloadImage img, uint8_t* buf, size_t size)
+{
+    size_t read = img->io.funcs.read(img->io.ud, buf, size);
+
+    if (img->collect_stats)
+    {
+        img->stats.values.bytes_read += read;
+        ++img->stats.values.read_calls;
+    }
+
+    return read;
+}
+
+static int64_t image_io_callback_seek(ImgloadImage img, int64_t offset, int whence)
+{
+    if (img->collect_stats)
+    {
+        ++img->stats.values.seek_calls;
+    }
+
+    return img->io.funcs.seek(img->io.ud, offset, whence);
+}
+
+static ImgloadErrorCode image_init_plugin(ImgloadImage img, ImgloadPlugin plugin)
+{
+    ImageStage stage = image_plugin_stage_begin(img, plugin, STATS_PHASE_INIT, "init_image");
+    ImgloadErrorCode err = plugin->funcs.init_image(plugin, img);
+    image_stage_end(img, stage);
+
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
+    }
+    if (!validate_image(img))
+    {
+        // The plugin may have allocated state for the image already
+        if (plugin->funcs.deinit_image != NULL)
+        {
+            plugin->funcs.deinit_image(plugin, img);
+        }
+        return IMGLOAD_ERR_PLUGIN_ERROR;
+    }
+    img->plugin = plugin;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static ImgloadPlugin image_probe_plugins(ImgloadImage img, const uint8_t* header, size_t header_size, bool* needs_rewind)
+{
+    ImgloadPlugin current = img->context->plugins.head;
+    while (current != NULL)
+    {
+        if (plugin_signature_only(current))
+        {
+            // None of the signatures of this plugin matched so it can't handle the image
+            current = current->next;
+            continue;
+        }
+
+        ImgloadProbeResult result = IMGLOAD_PROBE_UNKNOWN;
+        uint64_t probe_start = img->collect_stats ? stats_now_ns() : 0;
+        ImageStage stage = image_plugin_stage_begin(img, current, STATS_PHASE_PROBE, "probe_plugin");
+
+        if (current->funcs.probe_header != NULL)
+        {
+            result = current->funcs.probe_header(current, header, header_size);
+        }
+
+        if (result == IMGLOAD_PROBE_UNKNOWN && current->funcs.probe != NULL)
+        {
+            if (*needs_rewind)
+            {
+                image_io_seek(img, 0, SEEK_SET);
+            }
+
+            result = current->funcs.probe(current, img) ? IMGLOAD_PROBE_YES : IMGLOAD_PROBE_NO;
+
+            // Stream probes expect the init function to continue where the probe function stopped
+            *needs_rewind = result != IMGLOAD_PROBE_YES;
+        }
+
+        image_stage_end(img, stage);
+
+        if (img->collect_stats)
+        {
+            uint64_t probe_ns = stats_now_ns() - probe_start;
+
+            thread_mutex_lock(&img->context->stats.lock);
+            current->stats.probe_ns += probe_ns;
+            thread_mutex_unlock(&img->context->stats.lock);
+        }
+
+        if (result == IMGLOAD_PROBE_YES)
+        {
+            return current;
+        }
+
+        current = current->next;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Finds the plugin which can handle the image
+ * @return The plugin or @c NULL if the format is not supported. The stream is positioned where the plugin expects it.
+ */
+static ImgloadPlugin image_select_plugin(ImgloadImage img)
+{
+    ImageStage stage = image_stage_begin(img, STATS_PHASE_PROBE, "probe");
+
+    // The header is read once and then shared by all plugins which can probe using only the header
+    uint8_t header_buffer[IMGLOAD_PLUGIN_HEADER_SIZE];
+    const uint8_t* header;
+    size_t header_size;
+
+    // Tracks if the stream needs to be rewound before it can be used by the next plugin
+    bool needs_rewind;
+
+    if (img->io.in_memory)
+    {
+        header_size = img->io.memory_size < sizeof(header_buffer) ? img->io.memory_size : sizeof(header_buffer);
+        header = img->io.memory;
+        needs_rewind = false;
+    }
+    else
+    {
+        header_size = image_io_read(img, header_buffer, sizeof(header_buffer));
+        header = header_buffer;
+        needs_rewind = header_size != 0;
+    }
+
+    // Plugins may be added concurrently, the found plugin stays valid since plugins are only removed with the context
+    thread_rwlock_read_lock(&img->context->plugin_lock);
+
+    // Signatures identify the plugin directly, probing is only needed if none of them matches
+    ImgloadPlugin plugin = context_match_signature(img->context, header, header_size);
+    if (plugin == NULL)
+    {
+        plugin = image_probe_plugins(img, header, header_size, &needs_rewind);
+    }
+
+    thread_rwlock_read_unlock(&img->context->plugin_lock);
+
+    if (plugin != NULL && needs_rewind)
+    {
+        image_io_seek(img, 0, SEEK_SET);
+    }
+
+    image_stage_end(img, stage);
+
+    return plugin;
+}
+
+static ImgloadErrorCode image_find_plugin(ImgloadImage img, ImgloadImage* image)
+{
+    ImgloadPlugin plugin = image_select_plugin(img);
+    if (plugin == NULL)
+    {
+        // Unsupported format
+        imgload_image_free(img);
+        return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    }
+
+    // Found the right plugin, now initialize the plugin for this image
+    ImgloadErrorCode err = image_init_plugin(img, plugin);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        imgload_image_free(img);
+        return err;
+    }
+
+    *image = img;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
 ImgloadErrorCode IMGLOAD_API imgload_image_init(ImgloadContext ctx, ImgloadImage* image, ImgloadIO* io,
                                                    void* io_ud)
 {
     assert(ctx != NULL);
     assert(image != NULL);
+    assert(io != NULL);
 
-    ImgloadImage img = mem_reallocz(ctx, NULL, sizeof(struct ImgloadImageImpl));
+    ImgloadImage img = image_alloc(ctx);
     if (img == NULL)
     {
         return IMGLOAD_ERR_OUT_OF_MEMORY;
     }
 
-    img->context = ctx;
-
     img->io.funcs = *io;
     img->io.ud = io_ud;
 
-    ImgloadPlugin current = img->context->plugins.head;
-    while (current != NULL)
+    size_t buffer_size = thread_atomic_load_size(&ctx->io_buffer_size);
+    if (buffer_size > 0)
     {
-        if (current->funcs.probe(current, img))
-        {
-            // Found the right plugin, now initialize the plugin for this image
-            ImgloadErrorCode err = current->funcs.init_image(current, img);
+        // The buffer tracks the stream position itself so it has to know where the stream starts
+        int64_t start = image_io_callback_seek(img, 0, SEEK_CUR);
 
-            if (err != IMGLOAD_ERR_NO_ERROR)
-            {
-                imgload_image_free(img);
-                return err;
-            }
-            if (!validate_image(img))
+        if (start >= 0)
+        {
+            img->io.buffer = (uint8_t*) mem_realloc(ctx, NULL, buffer_size);
+            if (img->io.buffer == NULL)
             {
                 imgload_image_free(img);
-                return IMGLOAD_ERR_PLUGIN_ERROR;
+                return IMGLOAD_ERR_OUT_OF_MEMORY;
             }
-            img->plugin = current;
 
-            *image = img;
+            img->io.buffer_capacity = buffer_size;
+            img->io.buffer_offset = start;
+        }
+    }
 
-            return IMGLOAD_ERR_NO_ERROR;
+    return image_find_plugin(img, image);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_init_from_memory(ImgloadContext ctx, ImgloadImage* image,
+                                                               const void* data, size_t size)
+{
+    assert(ctx != NULL);
+    assert(image != NULL);
+    assert(data != NULL || size == 0);
+
+    ImgloadImage img = image_alloc(ctx);
+    if (img == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    img->io.in_memory = true;
+    img->io.memory = (const uint8_t*)data;
+    img->io.memory_size = size;
+
+    return image_find_plugin(img, image);
+}
+
+ImgloadErrorCode image_init_from_owned_memory(ImgloadContext ctx, ImgloadImage* image, uint8_t* data, size_t size)
+{
+    assert(ctx != NULL);
+    assert(image != NULL);
+
+    ImgloadImage img = image_alloc(ctx);
+    if (img == NULL)
+    {
+        mem_free(ctx, data);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    img->io.in_memory = true;
+    img->io.memory = data;
+    img->io.memory_size = size;
+    img->io.owned_memory = data;
+
+    return image_find_plugin(img, image);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_init_from_file(ImgloadContext ctx, ImgloadImage* image, const char* path)
+{
+    assert(ctx != NULL);
+    assert(image != NULL);
+    assert(path != NULL);
+
+    ImgloadImage img = image_alloc(ctx);
+    if (img == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    ImgloadErrorCode err = mapping_open(&img->io.mapping, path);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        print_to_log(ctx, IMGLOAD_LOG_ERROR, "Failed to map file '%s'!\n", path);
+        image_dealloc(img);
+        return err;
+    }
+
+    img->io.in_memory = true;
+    img->io.memory = img->io.mapping.data;
+    img->io.memory_size = img->io.mapping.size;
+
+    return image_find_plugin(img, image);
+}
+
+/**
+ * @brief Gets the metadata of an initialized image
+ */
+static void image_get_info(ImgloadImage img, ImgloadImageInfo* info_out)
+{
+    ImgloadImageInfo info;
+    info.subimages = img->n_frames;
+    info.mipmaps = img->n_frames > 0 ? img->frames[0].n_mipmaps : 0;
+    info.format = img->plugin_data_format;
+    info.compression = img->compression;
+    info.width = 0;
+    info.height = 0;
+    info.depth = 1;
+
+    uint32_t value;
+    if (img->n_frames > 0)
+    {
+        if (imgload_image_get_property(img, 0, IMGLOAD_PROPERTY_WIDTH, IMGLOAD_PROPERTY_TYPE_UINT32, &value)
+            == IMGLOAD_ERR_NO_ERROR)
+        {
+            info.width = value;
+        }
+        if (imgload_image_get_property(img, 0, IMGLOAD_PROPERTY_HEIGHT, IMGLOAD_PROPERTY_TYPE_UINT32, &value)
+            == IMGLOAD_ERR_NO_ERROR)
+        {
+            info.height = value;
+        }
+        if (imgload_image_get_property(img, 0, IMGLOAD_PROPERTY_DEPTH, IMGLOAD_PROPERTY_TYPE_UINT32, &value)
+            == IMGLOAD_ERR_NO_ERROR)
+        {
+            info.depth = value;
         }
+    }
 
-        image_io_seek(img, 0, SEEK_SET);
-        current = current->next;
+    *info_out = info;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_probe_info(ImgloadContext ctx, ImgloadIO* io, void* io_ud,
+                                                      ImgloadImageInfo* info_out)
+{
+    assert(ctx != NULL);
+    assert(io != NULL);
+    assert(info_out != NULL);
+
+    // The image only provides the unbuffered stream to the plugin so it can live on the stack
+    struct ImgloadImageImpl probe;
+    memset(&probe, 0, sizeof(probe));
+    probe.context = ctx;
+    probe.io.funcs = *io;
+    probe.io.ud = io_ud;
+
+    int64_t start = io->seek(io_ud, 0, SEEK_CUR);
+
+    ImgloadPlugin plugin = image_select_plugin(&probe);
+    if (plugin == NULL)
+    {
+        return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    }
+
+    if (plugin->funcs.image_info != NULL)
+    {
+        ImgloadErrorCode err = plugin->funcs.image_info(plugin, &probe, info_out);
+        if (err != IMGLOAD_ERR_NO_DATA)
+        {
+            return err;
+        }
+    }
+
+    // The plugin needs the complete image to know its metadata
+    if (start < 0 || io->seek(io_ud, start, SEEK_SET) != start)
+    {
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    ImgloadImage img;
+    ImgloadErrorCode err = imgload_image_init(ctx, &img, io, io_ud);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
     }
 
-    // Unsupported format
-    mem_free(ctx, img);
-    return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    image_get_info(img, info_out);
+
+    return imgload_image_free(img);
 }
 
 size_t IMGLOAD_API imgload_image_num_subimages(ImgloadImage img)
@@ -149,6 +620,8 @@ ImgloadErrorCode IMGLOAD_API imgload_image_transform_data(ImgloadImage img, Imgl
     img->conv.requested = requested;
     img->conv.param = param;
 
+    ImageStage stage = image_stage_begin(img, STATS_PHASE_CONVERT, "transform_data");
+
     // Transform all currently loaded data
     for (size_t i = 0; i < img->n_frames; ++i)
     {
@@ -166,6 +639,7 @@ ImgloadErrorCode IMGLOAD_API imgload_image_transform_data(ImgloadImage img, Imgl
                 if (err != IMGLOAD_ERR_NO_ERROR)
                 {
                     // The image format is in an inconsistent state now and should not be used anymore
+                    image_stage_end(img, stage);
                     return err;
                 }
             }
@@ -174,6 +648,8 @@ ImgloadErrorCode IMGLOAD_API imgload_image_transform_data(ImgloadImage img, Imgl
 
     img->data_format = requested;
 
+    image_stage_end(img, stage);
+
     return IMGLOAD_ERR_NO_ERROR;
 }
 
@@ -184,94 +660,789 @@ ImgloadErrorCode IMGLOAD_API imgload_image_read_data(ImgloadImage img)
 
     if (img->plugin->funcs.read_image)
     {
-        return img->plugin->funcs.read_image(img->plugin, img);
+        ImageStage stage = image_stage_begin(img, STATS_PHASE_READ, "read_image");
+        ImgloadErrorCode err = img->plugin->funcs.read_image(img->plugin, img);
+        image_stage_end(img, stage);
+
+        return err;
     }
 
     // No read function => data must have been initialized earlier
     return IMGLOAD_ERR_NO_ERROR;
 }
 
-size_t IMGLOAD_API imgload_image_num_mipmaps(ImgloadImage img, size_t subimage)
+static bool mipmap_has_data(const Mipmap* mip)
 {
-    assert(img != NULL);
-    assert(subimage < img->n_frames);
-
-    return img->frames[subimage].n_mipmaps;
+    return mip->compressed.has_data || mip->raw.has_data;
 }
 
-ImgloadErrorCode IMGLOAD_API imgload_image_compressed_data(ImgloadImage img, size_t subimage, size_t mipmap, ImgloadImageData* data_out)
+ImgloadErrorCode IMGLOAD_API imgload_image_read_mipmaps(ImgloadImage img, size_t subimage, size_t first_mipmap,
+                                                        size_t n_mipmaps)
 {
     assert(img != NULL);
+    assert(img->plugin != NULL);
     assert(subimage < img->n_frames);
-    assert(mipmap < img->frames[subimage].n_mipmaps);
+    assert(first_mipmap + n_mipmaps <= img->frames[subimage].n_mipmaps);
 
-    if (img->compression == IMGLOAD_COMPRESSION_NONE)
+    // Only the range between the first and the last missing mipmap is read
+    const Mipmap* mipmaps = img->frames[subimage].mipmaps;
+    while (n_mipmaps > 0 && mipmap_has_data(&mipmaps[first_mipmap]))
+    {
+        ++first_mipmap;
+        --n_mipmaps;
+    }
+    while (n_mipmaps > 0 && mipmap_has_data(&mipmaps[first_mipmap + n_mipmaps - 1]))
+    {
+        --n_mipmaps;
+    }
+
+    if (n_mipmaps == 0)
+    {
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    if (img->plugin->funcs.read_mipmaps != NULL)
+    {
+        ImageStage stage = image_stage_begin(img, STATS_PHASE_READ, "read_mipmaps");
+        ImgloadErrorCode err = img->plugin->funcs.read_mipmaps(img->plugin, img, subimage, first_mipmap, n_mipmaps);
+        image_stage_end(img, stage);
+        if (err != IMGLOAD_ERR_NO_DATA)
+        {
+            return err;
+        }
+    }
+
+    return imgload_image_read_data(img);
+}
+
+size_t IMGLOAD_API imgload_image_num_mipmaps(ImgloadImage img, size_t subimage)
+{
+    assert(img != NULL);
+    assert(subimage < img->n_frames);
+
+    return img->frames[subimage].n_mipmaps;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_compressed_data(ImgloadImage img, size_t subimage, size_t mipmap, ImgloadImageData* data_out)
+{
+    assert(img != NULL);
+    assert(subimage < img->n_frames);
+    assert(mipmap < img->frames[subimage].n_mipmaps);
+
+    if (img->compression == IMGLOAD_COMPRESSION_NONE)
+    {
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    if (!img->frames[subimage].mipmaps[mipmap].compressed.has_data)
+    {
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    // Everything seems to be alright
+    *data_out = img->frames[subimage].mipmaps[mipmap].compressed.image;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+/**
+ * @brief Checks if the core decoders can write the final format of the image
+ * If not, the pixels are decoded as RGBA and converted afterwards.
+ */
+static bool image_decodes_direct(ImgloadImage img, bool* bgra)
+{
+    ImgloadFormat format = img->conv.do_convert ? img->conv.requested : img->plugin_data_format;
+
+    *bgra = format == IMGLOAD_FORMAT_B8G8R8A8;
+    return format == IMGLOAD_FORMAT_R8G8B8A8 || format == IMGLOAD_FORMAT_B8G8R8A8;
+}
+
+/**
+ * @brief Gets the core decoder for the compressed data of a mipmap
+ * @return @c NULL if the mipmap has to be decompressed by the plugin
+ */
+static DxtRowDecoder image_block_decoder(ImgloadImage img, const Mipmap* mip)
+{
+    // The decoders produce RGBA, other formats are left to the plugin
+    if (img->plugin_data_format != IMGLOAD_FORMAT_R8G8B8A8 || !mip->compressed.has_data
+        || !dxt_validate(img->compression, &mip->compressed.image))
+    {
+        return NULL;
+    }
+
+    return dxt_row_decoder(img->compression);
+}
+
+/**
+ * @brief Stores pixels written by a core decoder
+ * @param direct The pixels are already in the final format and orientation, otherwise they are RGBA
+ */
+static ImgloadErrorCode image_store_decoded(ImgloadImage img, size_t subimage, size_t mipmap, ImgloadImageData* data,
+                                            bool direct)
+{
+    if (!direct)
+    {
+        return image_set_data(img, subimage, mipmap, data, true);
+    }
+
+    Mipmap* mip = &img->frames[subimage].mipmaps[mipmap];
+    mip->raw.image = *data;
+    mip->raw.has_data = true;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+/**
+ * @brief Decodes a compressed mipmap using a core decoder
+ * The blocks are written straight into the final layout, including the memory of imgload_image_data_into.
+ */
+static ImgloadErrorCode image_decompress_blocks(ImgloadImage img, size_t subimage, size_t mipmap,
+                                                DxtRowDecoder decoder)
+{
+    const ImgloadImageData* compressed = &img->frames[subimage].mipmaps[mipmap].compressed.image;
+
+    bool flip = (img->context->flags & IMGLOAD_CONTEXT_FLIP_IMAGES) != 0;
+    bool bgra;
+    bool direct = image_decodes_direct(img, &bgra);
+
+    if (direct && img->sink.active && img->sink.subimage == subimage && img->sink.mipmap == mipmap)
+    {
+        ImageStage stage = image_stage_begin(img, STATS_PHASE_DECOMPRESS, "decompress_blocks");
+        dxt_decode_block_rows(decoder, img->compression, compressed, 0, dxt_block_rows(compressed), img->sink.dst,
+                              img->sink.stride, flip, bgra);
+        image_stage_end(img, stage);
+        img->sink.written = true;
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadImageData data;
+    data.width = compressed->width;
+    data.height = compressed->height;
+    data.depth = compressed->depth;
+    data.stride = data.width * 4;
+    data.data_size = data.stride * data.height * data.depth;
+    data.data = mem_pixels_realloc(img->context, NULL, data.data_size);
+    if (data.data == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    ImageStage stage = image_stage_begin(img, STATS_PHASE_DECOMPRESS, "decompress_blocks");
+    dxt_decode_block_rows(decoder, img->compression, compressed, 0, dxt_block_rows(compressed), (uint8_t*) data.data,
+                          data.stride, direct && flip, bgra);
+    image_stage_end(img, stage);
+
+    return image_store_decoded(img, subimage, mipmap, &data, direct);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_data(ImgloadImage img, size_t subimage, size_t mipmap, ImgloadImageData* data_out)
+{
+    assert(img != NULL);
+    assert(subimage < img->n_frames);
+    assert(mipmap < img->frames[subimage].n_mipmaps);
+
+    if (img->frames[subimage].mipmaps[mipmap].raw.has_data)
+    {
+        // Data is already present
+        *data_out = img->frames[subimage].mipmaps[mipmap].raw.image;
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    // Block compressed data is decoded by the library if possible, otherwise the plugin could do lazy decompression
+    DxtRowDecoder decoder = image_block_decoder(img, &img->frames[subimage].mipmaps[mipmap]);
+    if (decoder != NULL)
+    {
+        ImgloadErrorCode err = image_decompress_blocks(img, subimage, mipmap, decoder);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        *data_out = img->frames[subimage].mipmaps[mipmap].raw.image;
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    if (img->plugin->funcs.decompress_data != NULL)
+    {
+        ImageStage stage = image_stage_begin(img, STATS_PHASE_DECOMPRESS, "decompress_data");
+        ImgloadErrorCode err = img->plugin->funcs.decompress_data(img->plugin, img, subimage, mipmap);
+        image_stage_end(img, stage);
+
+        if (err == IMGLOAD_ERR_NO_ERROR)
+        {
+            if (img->frames[subimage].mipmaps[mipmap].raw.has_data)
+            {
+                // Data has been loaded by plugin
+                *data_out = img->frames[subimage].mipmaps[mipmap].raw.image;
+
+                return IMGLOAD_ERR_NO_ERROR;
+            }
+        }
+        else
+        {
+            return err;
+        }
+    }
+
+    return IMGLOAD_ERR_NO_DATA;
+}
+
+// The number of block rows decoded by one task of imgload_image_decompress_all
+#define DECOMPRESS_TILE_BLOCK_ROWS 16
+
+/**
+ * @brief A mipmap which is decompressed by the library
+ */
+typedef struct
+{
+    size_t subimage;
+    size_t mipmap;
+
+    const ImgloadImageData* compressed;
+    uint8_t* pixels; //!< Allocated with a stride of 4 * width
+
+    size_t first_tile;
+    size_t num_tiles;
+} DecompressJob;
+
+typedef struct
+{
+    ImgloadCompression compression;
+    DxtRowDecoder decoder;
+    bool flip;
+    bool bgra;
+
+    DecompressJob* jobs;
+    size_t num_jobs;
+
+    size_t num_tiles;
+    volatile size_t next_tile;
+} DecompressWork;
+
+static void decompress_worker(void* arg)
+{
+    DecompressWork* work = (DecompressWork*)arg;
+
+    size_t job_index = 0;
+    size_t tile;
+    while ((tile = thread_atomic_fetch_add_size(&work->next_tile, 1)) < work->num_tiles)
+    {
+        // Tiles are handed out in order so the job of the next tile is never before the current one
+        while (tile >= work->jobs[job_index].first_tile + work->jobs[job_index].num_tiles)
+        {
+            ++job_index;
+        }
+
+        DecompressJob* job = &work->jobs[job_index];
+
+        size_t first_row = (tile - job->first_tile) * DECOMPRESS_TILE_BLOCK_ROWS;
+        size_t num_rows = dxt_block_rows(job->compressed) - first_row;
+        if (num_rows > DECOMPRESS_TILE_BLOCK_ROWS)
+        {
+            num_rows = DECOMPRESS_TILE_BLOCK_ROWS;
+        }
+
+        dxt_decode_block_rows(work->decoder, work->compression, job->compressed, first_row, num_rows, job->pixels,
+                              job->compressed->width * 4, work->flip, work->bgra);
+    }
+}
+
+static void decompress_run(ImgloadContext ctx, DecompressWork* work, size_t num_threads)
+{
+    if (num_threads == 0)
+    {
+        num_threads = thread_hardware_concurrency();
+    }
+    if (num_threads > work->num_tiles)
+    {
+        num_threads = work->num_tiles;
+    }
+
+    Thread* threads = NULL;
+    size_t num_started = 0;
+    if (num_threads > 1)
+    {
+        // If threads can't be started the remaining tiles are decoded by the other threads
+        threads = (Thread*) mem_realloc(ctx, NULL, (num_threads - 1) * sizeof(Thread));
+        while (threads != NULL && num_started < num_threads - 1 &&
+               thread_create(&threads[num_started], decompress_worker, work))
+        {
+            ++num_started;
+        }
+    }
+
+    decompress_worker(work);
+
+    for (size_t i = 0; i < num_started; ++i)
+    {
+        thread_join(&threads[i]);
+    }
+    if (threads != NULL)
+    {
+        mem_free(ctx, threads);
+    }
+}
+
+static void decompress_free_jobs(ImgloadContext ctx, DecompressJob* jobs, size_t num_jobs)
+{
+    for (size_t i = 0; i < num_jobs; ++i)
+    {
+        if (jobs[i].pixels != NULL)
+        {
+            mem_pixels_free(ctx, jobs[i].pixels);
+        }
+    }
+    mem_free(ctx, jobs);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_decompress_all(ImgloadImage img, size_t num_threads)
+{
+    assert(img != NULL);
+
+    if (img->compression == IMGLOAD_COMPRESSION_NONE)
+    {
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    // Make sure the compressed data is available
+    size_t max_jobs = 0;
+    bool missing_data = false;
+    for (size_t i = 0; i < img->n_frames; ++i)
+    {
+        for (size_t j = 0; j < img->frames[i].n_mipmaps; ++j)
+        {
+            Mipmap* mip = &img->frames[i].mipmaps[j];
+
+            if (!mip->raw.has_data)
+            {
+                ++max_jobs;
+                missing_data = missing_data || !mip->compressed.has_data;
+            }
+        }
+    }
+
+    if (max_jobs == 0)
+    {
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+    if (missing_data)
+    {
+        ImgloadErrorCode err = imgload_image_read_data(img);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+    }
+
+    DecompressWork work;
+    memset(&work, 0, sizeof(work));
+    work.compression = img->compression;
+
+    // The decoders produce RGBA, other formats are left to the plugin
+    if (img->plugin_data_format == IMGLOAD_FORMAT_R8G8B8A8)
+    {
+        work.decoder = dxt_row_decoder(img->compression);
+    }
+
+    // If the pixels can be decoded in their final layout they are stored without another pass over them
+    bool direct = image_decodes_direct(img, &work.bgra);
+    work.flip = direct && (img->context->flags & IMGLOAD_CONTEXT_FLIP_IMAGES) != 0;
+
+    if (work.decoder != NULL)
+    {
+        work.jobs = (DecompressJob*) mem_reallocz(img->context, NULL, max_jobs * sizeof(DecompressJob));
+        if (work.jobs == NULL)
+        {
+            return IMGLOAD_ERR_OUT_OF_MEMORY;
+        }
+
+        for (size_t i = 0; i < img->n_frames; ++i)
+        {
+            for (size_t j = 0; j < img->frames[i].n_mipmaps; ++j)
+            {
+                Mipmap* mip = &img->frames[i].mipmaps[j];
+                if (mip->raw.has_data || !mip->compressed.has_data || !dxt_validate(img->compression, &mip->compressed.image))
+                {
+                    continue;
+                }
+
+                const ImgloadImageData* compressed = &mip->compressed.image;
+
+                DecompressJob* job = &work.jobs[work.num_jobs++];
+                job->subimage = i;
+                job->mipmap = j;
+                job->compressed = compressed;
+                size_t pixels_size = compressed->width * compressed->height * compressed->depth * 4;
+                job->pixels = (uint8_t*) mem_pixels_realloc(img->context, NULL, pixels_size);
+                if (job->pixels == NULL)
+                {
+                    decompress_free_jobs(img->context, work.jobs, work.num_jobs);
+                    return IMGLOAD_ERR_OUT_OF_MEMORY;
+                }
+
+                job->first_tile = work.num_tiles;
+                job->num_tiles = (dxt_block_rows(compressed) + DECOMPRESS_TILE_BLOCK_ROWS - 1) / DECOMPRESS_TILE_BLOCK_ROWS;
+                work.num_tiles += job->num_tiles;
+            }
+        }
+
+        if (work.num_tiles > 0)
+        {
+            ImageStage stage = image_stage_begin(img, STATS_PHASE_DECOMPRESS, "decompress_all");
+            decompress_run(img->context, &work, num_threads);
+            image_stage_end(img, stage);
+        }
+
+        for (size_t i = 0; i < work.num_jobs; ++i)
+        {
+            DecompressJob* job = &work.jobs[i];
+
+            ImgloadImageData data;
+            data.width = job->compressed->width;
+            data.height = job->compressed->height;
+            data.depth = job->compressed->depth;
+            data.stride = data.width * 4;
+            data.data_size = data.stride * data.height * data.depth;
+            data.data = job->pixels;
+
+            // The image takes ownership of the pixels even if storing them fails
+            job->pixels = NULL;
+
+            ImgloadErrorCode err = image_store_decoded(img, job->subimage, job->mipmap, &data, direct);
+            if (err != IMGLOAD_ERR_NO_ERROR)
+            {
+                decompress_free_jobs(img->context, work.jobs, work.num_jobs);
+                return err;
+            }
+        }
+
+        decompress_free_jobs(img->context, work.jobs, work.num_jobs);
+    }
+
+    // Everything the library could not decode is decompressed by the plugin
+    for (size_t i = 0; i < img->n_frames; ++i)
+    {
+        for (size_t j = 0; j < img->frames[i].n_mipmaps; ++j)
+        {
+            if (img->frames[i].mipmaps[j].raw.has_data)
+            {
+                continue;
+            }
+
+            ImgloadImageData data;
+            ImgloadErrorCode err = imgload_image_data(img, i, j, &data);
+            if (err != IMGLOAD_ERR_NO_ERROR)
+            {
+                return err;
+            }
+        }
+    }
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+// The number of rows that are decoded at once when the streamed rows have to be converted
+#define STREAM_BAND_ROWS 32
+
+/**
+ * @brief Decodes the rows using the read_rows function of the plugin
+ * @return IMGLOAD_ERR_NO_DATA if the rows can't be streamed
+ */
+static ImgloadErrorCode image_plugin_read_rows(ImgloadImage img, size_t subimage, size_t mipmap, size_t first_row,
+                                               size_t n_rows, uint8_t* dst, size_t dst_stride)
+{
+    ImageStage stage = image_stage_begin(img, STATS_PHASE_READ, "read_rows");
+    ImgloadErrorCode err = img->plugin->funcs.read_rows(img->plugin, img, subimage, mipmap, first_row, n_rows, dst,
+                                                        dst_stride);
+    image_stage_end(img, stage);
+
+    return err;
+}
+
+static ImgloadErrorCode image_stream_rows(ImgloadImage img, size_t subimage, size_t mipmap, size_t first_row,
+                                          size_t n_rows, uint8_t* dst, size_t dst_stride)
+{
+    if (!img->conv.do_convert || img->conv.requested == img->plugin_data_format)
+    {
+        return image_plugin_read_rows(img, subimage, mipmap, first_row, n_rows, dst, dst_stride);
+    }
+
+    FormatRowConverter converter = format_row_converter(img->plugin_data_format, img->conv.requested);
+    if (converter == NULL)
+    {
+        return IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
+    }
+
+    // The width is needed for converting the rows
+    uint32_t width;
+    if (imgload_image_get_property(img, subimage, IMGLOAD_PROPERTY_WIDTH, IMGLOAD_PROPERTY_TYPE_UINT32, &width)
+        != IMGLOAD_ERR_NO_ERROR)
+    {
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    width >>= mipmap;
+    if (width == 0)
+    {
+        width = 1;
+    }
+
+    FormatParams params;
+    format_init_params(&params, img->conv.param);
+
+    if (format_bpp(img->plugin_data_format) == format_bpp(img->conv.requested))
+    {
+        // The rows can be converted where they are decoded
+        ImgloadErrorCode err = image_plugin_read_rows(img, subimage, mipmap, first_row, n_rows, dst, dst_stride);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        ImageStage stage = image_stage_begin(img, STATS_PHASE_CONVERT, "convert_rows");
+        for (size_t y = 0; y < n_rows; ++y)
+        {
+            uint8_t* row = dst + y * dst_stride;
+            converter(row, row, width, &params);
+        }
+        image_stage_end(img, stage);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    // Decode a band of rows into a temporary buffer and convert them into the destination
+    size_t band_stride = width * format_bpp(img->plugin_data_format);
+    size_t band_rows = n_rows < STREAM_BAND_ROWS ? n_rows : STREAM_BAND_ROWS;
+
+    uint8_t* band = (uint8_t*) mem_pixels_realloc(img->context, NULL, band_rows * band_stride);
+    if (band == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    ImgloadErrorCode err = IMGLOAD_ERR_NO_ERROR;
+    for (size_t row = 0; row < n_rows; row += band_rows)
+    {
+        size_t rows = n_rows - row < band_rows ? n_rows - row : band_rows;
+
+        err = image_plugin_read_rows(img, subimage, mipmap, first_row + row, rows, band, band_stride);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            break;
+        }
+
+        ImageStage stage = image_stage_begin(img, STATS_PHASE_CONVERT, "convert_rows");
+        for (size_t y = 0; y < rows; ++y)
+        {
+            converter(band + y * band_stride, dst + (row + y) * dst_stride, width, &params);
+        }
+        image_stage_end(img, stage);
+    }
+
+    mem_pixels_free(img->context, band);
+
+    return err;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_read_rows(ImgloadImage img, size_t subimage, size_t mipmap,
+                                                     size_t first_row, size_t n_rows, void* dst, size_t dst_stride)
+{
+    assert(img != NULL);
+    assert(subimage < img->n_frames);
+    assert(mipmap < img->frames[subimage].n_mipmaps);
+    assert(dst != NULL || n_rows == 0);
+
+    Mipmap* mip = &img->frames[subimage].mipmaps[mipmap];
+
+    // Flipped images can't be streamed since the last row would have to be decoded first
+    bool can_stream = img->plugin->funcs.read_rows != NULL && !mip->raw.has_data
+        && !(img->context->flags & IMGLOAD_CONTEXT_FLIP_IMAGES);
+
+    if (can_stream)
+    {
+        ImgloadErrorCode err = image_stream_rows(img, subimage, mipmap, first_row, n_rows, (uint8_t*) dst, dst_stride);
+
+        if (err != IMGLOAD_ERR_NO_DATA)
+        {
+            return err;
+        }
+    }
+
+    // Fall back to decoding the whole image
+    if (!mip->raw.has_data && !mip->compressed.has_data)
+    {
+        ImgloadErrorCode err = imgload_image_read_data(img);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+    }
+
+    ImgloadImageData data;
+    ImgloadErrorCode err = imgload_image_data(img, subimage, mipmap, &data);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
+    }
+
+    if (first_row + n_rows > data.depth * data.height)
+    {
+        return IMGLOAD_ERR_OUT_OF_RANGE;
+    }
+
+    size_t row_size = data.width * format_bpp(img->data_format);
+    for (size_t y = 0; y < n_rows; ++y)
+    {
+        memcpy((uint8_t*) dst + y * dst_stride, (const uint8_t*) data.data + (first_row + y) * data.stride, row_size);
+    }
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+/**
+ * @brief Determines the number of rows of all slices of a mipmap using the properties of the subimage
+ */
+static bool image_mipmap_rows(ImgloadImage img, size_t subimage, size_t mipmap, size_t* rows_out)
+{
+    uint32_t height;
+    if (imgload_image_get_property(img, subimage, IMGLOAD_PROPERTY_HEIGHT, IMGLOAD_PROPERTY_TYPE_UINT32, &height)
+        != IMGLOAD_ERR_NO_ERROR)
     {
-        return IMGLOAD_ERR_NO_DATA;
+        return false;
     }
 
-    if (!img->frames[subimage].mipmaps[mipmap].compressed.has_data)
+    uint32_t depth;
+    if (imgload_image_get_property(img, subimage, IMGLOAD_PROPERTY_DEPTH, IMGLOAD_PROPERTY_TYPE_UINT32, &depth)
+        != IMGLOAD_ERR_NO_ERROR)
     {
-        return IMGLOAD_ERR_NO_DATA;
+        depth = 1;
     }
 
-    // Everything seems to be alright
-    *data_out = img->frames[subimage].mipmaps[mipmap].compressed.image;
+    height >>= mipmap;
+    depth >>= mipmap;
 
-    return IMGLOAD_ERR_NO_ERROR;
+    *rows_out = (size_t)(height > 0 ? height : 1) * (depth > 0 ? depth : 1);
+    return true;
 }
 
-ImgloadErrorCode IMGLOAD_API imgload_image_data(ImgloadImage img, size_t subimage, size_t mipmap, ImgloadImageData* data_out)
+ImgloadErrorCode IMGLOAD_API imgload_image_data_into(ImgloadImage img, size_t subimage, size_t mipmap, void* dst,
+                                                     size_t dst_stride)
 {
     assert(img != NULL);
     assert(subimage < img->n_frames);
     assert(mipmap < img->frames[subimage].n_mipmaps);
+    assert(dst != NULL);
 
-    if (img->frames[subimage].mipmaps[mipmap].raw.has_data)
-    {
-        // Data is already present
-        *data_out = img->frames[subimage].mipmaps[mipmap].raw.image;
-
-        return IMGLOAD_ERR_NO_ERROR;
-    }
+    Mipmap* mip = &img->frames[subimage].mipmaps[mipmap];
 
-    // Raw data is not available but the plugin could do lazy decompression
-    if (img->plugin->funcs.decompress_data != NULL)
+    if (!mip->raw.has_data)
     {
-        ImgloadErrorCode err = img->plugin->funcs.decompress_data(img->plugin, img, subimage, mipmap);
+        bool flip = (img->context->flags & IMGLOAD_CONTEXT_FLIP_IMAGES) != 0;
+        size_t rows;
 
-        if (err == IMGLOAD_ERR_NO_ERROR)
+        if (img->plugin->funcs.read_rows != NULL && !flip && image_mipmap_rows(img, subimage, mipmap, &rows))
         {
-            if (img->frames[subimage].mipmaps[mipmap].raw.has_data)
-            {
-                // Data has been loaded by plugin
-                *data_out = img->frames[subimage].mipmaps[mipmap].raw.image;
+            ImgloadErrorCode err = image_stream_rows(img, subimage, mipmap, 0, rows, (uint8_t*) dst, dst_stride);
 
-                return IMGLOAD_ERR_NO_ERROR;
+            if (err != IMGLOAD_ERR_NO_DATA)
+            {
+                return err;
             }
         }
-        else
+
+        // Let image_set_data write the decoded data directly to the destination
+        img->sink.active = true;
+        img->sink.written = false;
+        img->sink.subimage = subimage;
+        img->sink.mipmap = mipmap;
+        img->sink.dst = (uint8_t*) dst;
+        img->sink.stride = dst_stride;
+
+        ImgloadErrorCode err = IMGLOAD_ERR_NO_ERROR;
+        DxtRowDecoder decoder;
+        if (!mip->compressed.has_data)
+        {
+            err = imgload_image_read_data(img);
+        }
+        else if ((decoder = image_block_decoder(img, mip)) != NULL)
+        {
+            err = image_decompress_blocks(img, subimage, mipmap, decoder);
+        }
+        else if (img->plugin->funcs.decompress_data != NULL)
+        {
+            ImageStage stage = image_stage_begin(img, STATS_PHASE_DECOMPRESS, "decompress_data");
+            err = img->plugin->funcs.decompress_data(img->plugin, img, subimage, mipmap);
+            image_stage_end(img, stage);
+        }
+
+        img->sink.active = false;
+
+        if (err != IMGLOAD_ERR_NO_ERROR)
         {
             return err;
         }
+
+        if (img->sink.written)
+        {
+            return IMGLOAD_ERR_NO_ERROR;
+        }
     }
 
-    return IMGLOAD_ERR_NO_DATA;
+    // The data is stored in the image so it has to be copied
+    ImgloadImageData data;
+    ImgloadErrorCode err = imgload_image_data(img, subimage, mipmap, &data);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
+    }
+
+    size_t row_size = data.width * format_bpp(img->data_format);
+    size_t rows = data.depth * data.height;
+    for (size_t y = 0; y < rows; ++y)
+    {
+        memcpy((uint8_t*) dst + y * dst_stride, (const uint8_t*) data.data + y * data.stride, row_size);
+    }
+
+    return IMGLOAD_ERR_NO_ERROR;
 }
 
 static void free_mipmap_data(ImgloadContext ctx, MipmapData* data)
 {
     // Make sure that memory is allocated and we actually need to free the memory
-    if (data->image.data != NULL)
+    if (data->image.data != NULL && !data->borrowed)
+    {
+        mem_pixels_free(ctx, data->image.data);
+    }
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_image_get_stats(ImgloadImage img, ImgloadStats* stats_out)
+{
+    assert(img != NULL);
+    assert(stats_out != NULL);
+
+    if (!img->collect_stats)
     {
-        mem_free(ctx, data->image.data);
+        return IMGLOAD_ERR_NO_DATA;
     }
+
+    *stats_out = img->stats.values;
+    stats_out->images = 1;
+
+    return IMGLOAD_ERR_NO_ERROR;
 }
 
 ImgloadErrorCode IMGLOAD_API imgload_image_free(ImgloadImage image)
 {
     assert(image != NULL);
 
+    if (image->collect_stats)
+    {
+        image_stats_merge(image);
+    }
+
     if (image->plugin)
     {
         // If there is a plugin registered, deinitialize it when freeing the image
@@ -287,7 +1458,7 @@ ImgloadErrorCode IMGLOAD_API imgload_image_free(ImgloadImage image)
         PropertyValue* val = &frame->properties[i];
         if (val->initialized && val->type == IMGLOAD_PROPERTY_TYPE_STRING)
         {
-            mem_free(image->context, val->value.str);
+            image_mem_free(image, val->value.str);
         }
 
         Mipmap* mipmaps = frame->mipmaps;
@@ -299,29 +1470,234 @@ ImgloadErrorCode IMGLOAD_API imgload_image_free(ImgloadImage image)
                 free_mipmap_data(image->context, &mipmaps[mipmap].raw);
             }
 
-            mem_free(image->context, mipmaps);
+            image_mem_free(image, mipmaps);
         }
     }
 
-    mem_free(image->context, image->frames);
+    image_mem_free(image, image->frames);
+
+    mapping_close(&image->io.mapping);
+
+    if (image->io.owned_memory != NULL)
+    {
+        mem_free(image->context, image->io.owned_memory);
+    }
+
+    if (image->io.buffer != NULL)
+    {
+        mem_free(image->context, image->io.buffer);
+    }
 
-    mem_free(image->context, image);
+    image_dealloc(image);
 
     return IMGLOAD_ERR_NO_ERROR;
 }
 
+static size_t image_io_read_buffered(ImgloadImage img, uint8_t* buf, size_t size)
+{
+    size_t total = 0;
+
+    while (size > 0)
+    {
+        size_t available = img->io.buffer_length - img->io.buffer_pos;
+
+        if (available > 0)
+        {
+            size_t n = size < available ? size : available;
+            memcpy(buf, img->io.buffer + img->io.buffer_pos, n);
+
+            img->io.buffer_pos += n;
+            buf += n;
+            size -= n;
+            total += n;
+            continue;
+        }
+
+        // The buffer is used up, the stream is positioned right after it
+        img->io.buffer_offset += (int64_t)img->io.buffer_length;
+        img->io.buffer_length = 0;
+        img->io.buffer_pos = 0;
+
+        if (size >= img->io.buffer_capacity)
+        {
+            // Large reads go directly to the destination
+            size_t read = image_io_callback_read(img, buf, size);
+            img->io.buffer_offset += (int64_t)read;
+            total += read;
+            break;
+        }
+
+        // Read ahead as much as fits into the buffer
+        size_t read = image_io_callback_read(img, img->io.buffer, img->io.buffer_capacity);
+        if (read == 0)
+        {
+            break;
+        }
+
+        img->io.buffer_length = read;
+    }
+
+    return total;
+}
+
+static int64_t image_io_seek_buffered(ImgloadImage img, int64_t offset, int whence)
+{
+    int64_t position = img->io.buffer_offset + (int64_t)img->io.buffer_pos;
+    int64_t buffer_end = img->io.buffer_offset + (int64_t)img->io.buffer_length;
+
+    int64_t target = whence == SEEK_CUR ? position + offset : offset;
+
+    if (whence != SEEK_END && target >= img->io.buffer_offset && target <= buffer_end)
+    {
+        // The target is buffered so the stream doesn't have to be touched
+        img->io.buffer_pos = (size_t)(target - img->io.buffer_offset);
+        return target;
+    }
+
+    int64_t result = whence == SEEK_END ? image_io_callback_seek(img, offset, SEEK_END)
+                                        : image_io_callback_seek(img, target, SEEK_SET);
+
+    if (result >= 0)
+    {
+        img->io.buffer_offset = result;
+        img->io.buffer_length = 0;
+        img->io.buffer_pos = 0;
+    }
+
+    return result;
+}
+
 size_t IMGLOAD_API image_io_read(ImgloadImage img, uint8_t* buf, size_t size)
 {
     assert(img != NULL);
 
-    return img->io.funcs.read(img->io.ud, buf, size);
+    if (img->io.in_memory)
+    {
+        size_t available = img->io.memory_size - img->io.memory_pos;
+        size_t read = size < available ? size : available;
+
+        if (read > 0)
+        {
+            memcpy(buf, img->io.memory + img->io.memory_pos, read);
+            img->io.memory_pos += read;
+        }
+        if (img->collect_stats)
+        {
+            img->stats.values.bytes_read += read;
+        }
+
+        return read;
+    }
+
+    if (img->io.buffer != NULL)
+    {
+        return image_io_read_buffered(img, buf, size);
+    }
+
+    return image_io_callback_read(img, buf, size);
 }
 
 int64_t IMGLOAD_API image_io_seek(ImgloadImage img, int64_t offset, int whence)
 {
     assert(img != NULL);
 
-    return img->io.funcs.seek(img->io.ud, offset, whence);
+    if (img->io.in_memory)
+    {
+        int64_t base;
+        switch (whence)
+        {
+        case SEEK_CUR:
+            base = (int64_t)img->io.memory_pos;
+            break;
+        case SEEK_END:
+            base = (int64_t)img->io.memory_size;
+            break;
+        default:
+            base = 0;
+            break;
+        }
+
+        int64_t target = base + offset;
+        if (target < 0)
+        {
+            target = 0;
+        }
+        if ((uint64_t)target > (uint64_t)img->io.memory_size)
+        {
+            target = (int64_t)img->io.memory_size;
+        }
+
+        img->io.memory_pos = (size_t)target;
+
+        return target;
+    }
+
+    if (img->io.buffer != NULL)
+    {
+        return image_io_seek_buffered(img, offset, whence);
+    }
+
+    return image_io_callback_seek(img, offset, whence);
+}
+
+const uint8_t* image_io_map(ImgloadImage img, uint64_t offset, size_t size)
+{
+    assert(img != NULL);
+
+    if (!img->io.in_memory || img->io.memory == NULL)
+    {
+        // Streams can't be mapped
+        return NULL;
+    }
+
+    if (offset > (uint64_t)img->io.memory_size || size > img->io.memory_size - (size_t)offset)
+    {
+        return NULL;
+    }
+
+    if (img->collect_stats)
+    {
+        img->stats.values.bytes_read += size;
+    }
+
+    return img->io.memory + offset;
+}
+
+int64_t image_io_size(ImgloadImage img)
+{
+    assert(img != NULL);
+
+    if (img->io.in_memory)
+    {
+        return (int64_t)img->io.memory_size;
+    }
+
+    if (img->io.size_known)
+    {
+        return img->io.size;
+    }
+
+    int64_t end;
+    if (img->io.buffer != NULL)
+    {
+        // The stream is positioned after the buffered bytes, going around the buffer keeps them valid
+        end = image_io_callback_seek(img, 0, SEEK_END);
+        image_io_callback_seek(img, img->io.buffer_offset + (int64_t)img->io.buffer_length, SEEK_SET);
+    }
+    else
+    {
+        int64_t current = image_io_seek(img, 0, SEEK_CUR);
+        end = image_io_seek(img, 0, SEEK_END);
+        image_io_seek(img, current, SEEK_SET);
+    }
+
+    if (end >= 0)
+    {
+        img->io.size_known = true;
+        img->io.size = end;
+    }
+
+    return end;
 }
 
 ImgloadErrorCode image_allocate_frames(ImgloadImage img, size_t num_frames)
@@ -335,7 +1711,17 @@ ImgloadErrorCode image_allocate_frames(ImgloadImage img, size_t num_frames)
         return IMGLOAD_ERR_NO_ERROR;
     }
 
-    ImageFrame* new_frames = (ImageFrame*)mem_reallocz(img->context, img->frames, num_frames * sizeof(*img->frames));
+    ImageFrame* new_frames;
+    if (img->use_arena)
+    {
+        // Like mem_reallocz the frames are cleared, the old frames are either reused or released with the arena
+        mem_arena_free(img->context, &img->arena, img->frames);
+        new_frames = (ImageFrame*)mem_arena_alloc(img->context, &img->arena, num_frames * sizeof(*img->frames));
+    }
+    else
+    {
+        new_frames = (ImageFrame*)mem_reallocz(img->context, img->frames, num_frames * sizeof(*img->frames));
+    }
     if (new_frames == NULL)
     {
         return IMGLOAD_ERR_OUT_OF_MEMORY;
@@ -360,7 +1746,7 @@ ImgloadErrorCode image_allocate_mipmaps(ImgloadImage img, size_t subframe, size_
         return IMGLOAD_ERR_NO_ERROR;
     }
 
-    Mipmap* new_data = (Mipmap*)mem_reallocz(img->context, NULL, mipmaps * sizeof(*frame->mipmaps));
+    Mipmap* new_data = (Mipmap*)image_mem_alloc(img, mipmaps * sizeof(*frame->mipmaps));
     if (new_data == NULL)
     {
         return IMGLOAD_ERR_OUT_OF_MEMORY;
@@ -376,12 +1762,15 @@ ImgloadErrorCode image_set_compressed_data(ImgloadImage img, size_t subframe, si
                                             ImgloadImageData* data, bool transfer_ownership)
 {
     Mipmap* mipmap1 = &img->frames[subframe].mipmaps[mipmap];
+
+    // Data of a mipmap which was read on its own is replaced if the whole image is read later
+    free_mipmap_data(img->context, &mipmap1->compressed);
     mipmap1->compressed.image = *data;
 
     if (!transfer_ownership)
     {
         // Memory wasn't allocated by us so we need to copy it.
-        mipmap1->compressed.image.data = mem_realloc(img->context, NULL, data->data_size);
+        mipmap1->compressed.image.data = mem_pixels_realloc(img->context, NULL, data->data_size);
 
         if (mipmap1->compressed.image.data == NULL)
         {
@@ -392,73 +1781,228 @@ ImgloadErrorCode image_set_compressed_data(ImgloadImage img, size_t subframe, si
     }
 
     mipmap1->compressed.has_data = true;
+    mipmap1->compressed.borrowed = false;
 
     return IMGLOAD_ERR_NO_ERROR;
 }
 
-ImgloadErrorCode image_set_data(ImgloadImage img, size_t subframe, size_t mipmap,
-                                            ImgloadImageData* data, bool transfer_ownership)
+ImgloadErrorCode image_reference_compressed_data(ImgloadImage img, size_t subframe, size_t mipmap,
+                                                 const ImgloadImageData* data)
 {
     Mipmap* mipmap1 = &img->frames[subframe].mipmaps[mipmap];
-    mipmap1->raw.image = *data;
 
-    if (!transfer_ownership)
+    free_mipmap_data(img->context, &mipmap1->compressed);
+    mipmap1->compressed.image = *data;
+    mipmap1->compressed.has_data = true;
+    mipmap1->compressed.borrowed = true;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+/**
+ * @brief Copies or converts one row of pixels, a @c NULL converter copies @p size bytes unchanged
+ */
+static void transfer_row(FormatRowConverter converter, const FormatParams* params, const uint8_t* src, uint8_t* dst,
+                         size_t width, size_t size)
+{
+    if (converter != NULL)
     {
-        // Memory wasn't allocated by us so we need to copy it.
-        mipmap1->raw.image.data = mem_realloc(img->context, NULL, data->data_size);
+        converter(src, dst, width, params);
+    }
+    else if (src != dst)
+    {
+        memcpy(dst, src, size);
+    }
+}
+
+/**
+ * @brief Copies or converts all rows of @p data into another buffer, optionally flipping every slice
+ */
+static void transfer_rows(FormatRowConverter converter, const FormatParams* params, const ImgloadImageData* data,
+                          uint8_t* dst, size_t dst_stride, size_t row_size, bool flip)
+{
+    const uint8_t* src = (const uint8_t*) data->data;
+
+    for (size_t d = 0; d < data->depth; ++d)
+    {
+        const uint8_t* src_slice = src + d * data->height * data->stride;
+        uint8_t* dst_slice = dst + d * data->height * dst_stride;
 
-        if (mipmap1->raw.image.data == NULL)
+        for (size_t y = 0; y < data->height; ++y)
         {
-            return IMGLOAD_ERR_OUT_OF_MEMORY;
-        }
+            size_t dst_y = flip ? data->height - y - 1 : y;
 
-        memcpy(mipmap1->raw.image.data, data->data, data->data_size);
+            transfer_row(converter, params, src_slice + y * data->stride, dst_slice + dst_y * dst_stride,
+                         data->width, row_size);
+        }
     }
-    mipmap1->raw.has_data = true;
+}
 
-    if (img->context->flags & IMGLOAD_CONTEXT_FLIP_IMAGES)
+/**
+ * @brief Frees data passed to image_set_data if we own it but don't keep it
+ */
+static void release_data(ImgloadImage img, ImgloadImageData* data, bool transfer_ownership)
+{
+    if (transfer_ownership)
     {
-        // A buffer for holding one line of the image
-        uint8_t* buffer = (uint8_t*) mem_realloc(img->context, NULL, data->stride);
+        mem_pixels_free(img->context, data->data);
+    }
+}
+
+static ImgloadErrorCode image_store_data(ImgloadImage img, size_t subframe, size_t mipmap,
+                                         ImgloadImageData* data, bool transfer_ownership)
+{
+    Mipmap* mipmap1 = &img->frames[subframe].mipmaps[mipmap];
 
-        if (buffer == NULL)
+    bool flip = (img->context->flags & IMGLOAD_CONTEXT_FLIP_IMAGES) != 0;
+
+    FormatRowConverter converter = NULL;
+    FormatParams params;
+    size_t stride = data->stride;
+    size_t data_size = data->data_size;
+
+    if (img->conv.do_convert && img->conv.requested != img->plugin_data_format)
+    {
+        converter = format_row_converter(img->plugin_data_format, img->conv.requested);
+        if (converter == NULL)
         {
-            print_to_log(img->context, IMGLOAD_LOG_ERROR, "Failed to allocate buffer for flipping image!");
-            return IMGLOAD_ERR_OUT_OF_MEMORY;
+            release_data(img, data, transfer_ownership);
+            return IMGLOAD_ERR_UNSUPPORTED_CONVERSION;
         }
 
-        for (size_t d = 0; d < data->depth; ++d)
+        format_init_params(&params, img->conv.param);
+
+        stride = data->width * format_bpp(img->conv.requested);
+        data_size = data->depth * data->height * stride;
+    }
+
+    if (img->sink.active && img->sink.subimage == subframe && img->sink.mipmap == mipmap)
+    {
+        // The data is written directly to the memory of the caller and not kept by the image
+        size_t row_size = converter != NULL ? stride : data->width * format_bpp(img->plugin_data_format);
+        transfer_rows(converter, &params, data, img->sink.dst, img->sink.stride, row_size, flip);
+
+        img->sink.written = true;
+        release_data(img, data, transfer_ownership);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    if (converter == NULL && !flip && transfer_ownership)
+    {
+        // Nothing to do, just keep the data
+        mipmap1->raw.image = *data;
+        mipmap1->raw.has_data = true;
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    uint8_t* dst;
+
+    // Every row is read and written exactly once. Flipping and converting is done while copying the data into its
+    // final place unless the data is ours and the converted rows fit into the original memory.
+    bool in_place = transfer_ownership && stride == data->stride;
+
+    if (in_place)
+    {
+        dst = (uint8_t*) data->data;
+
+        if (flip)
         {
-            uint8_t* image_data = ((uint8_t*)data->data) + (d * data->height * data->stride);
+            // A buffer for holding one line of the image
+            uint8_t* buffer = (uint8_t*) image_mem_alloc(img, stride);
+
+            if (buffer == NULL)
+            {
+                print_to_log(img->context, IMGLOAD_LOG_ERROR, "Failed to allocate buffer for flipping image!");
+                release_data(img, data, transfer_ownership);
+                return IMGLOAD_ERR_OUT_OF_MEMORY;
+            }
 
-            // Images that have a height that's not divisible by 2 don't need to be handled
-            // specially because the row in the middle of the image doesn't need to be mirrored
-            size_t height_half = data->height / 2;
-            for (size_t y = 0; y < height_half; ++y)
+            for (size_t d = 0; d < data->depth; ++d)
             {
-                uint8_t* top = image_data + y * data->stride;
-                uint8_t* bottom = image_data + (data->height - y - 1) * data->stride;
+                uint8_t* image_data = dst + (d * data->height * stride);
+
+                size_t height_half = data->height / 2;
+                for (size_t y = 0; y < height_half; ++y)
+                {
+                    uint8_t* top = image_data + y * stride;
+                    uint8_t* bottom = image_data + (data->height - y - 1) * stride;
+
+                    transfer_row(converter, &params, top, buffer, data->width, stride);
+                    transfer_row(converter, &params, bottom, top, data->width, stride);
+                    memcpy(bottom, buffer, stride);
+                }
 
-                memcpy(buffer, top, data->stride);
-                memcpy(top, bottom, data->stride);
-                memcpy(bottom, buffer, data->stride);
+                if (data->height % 2 != 0)
+                {
+                    // The row in the middle stays where it is
+                    uint8_t* middle = image_data + height_half * stride;
+                    transfer_row(converter, &params, middle, middle, data->width, stride);
+                }
             }
-        }
 
-        mem_free(img->context, buffer);
+            image_mem_free(img, buffer);
+        }
+        else
+        {
+            size_t rows = data->depth * data->height;
+            for (size_t y = 0; y < rows; ++y)
+            {
+                uint8_t* row = dst + y * stride;
+                transfer_row(converter, &params, row, row, data->width, stride);
+            }
+        }
     }
-
-    if (img->conv.do_convert)
+    else
     {
-        ImgloadImageData converted_data;
-        ImgloadErrorCode err = format_change(img, img->plugin_data_format, &mipmap1->raw.image, &converted_data);
+        dst = (uint8_t*) mem_pixels_realloc(img->context, NULL, data_size);
 
-        if (err != IMGLOAD_ERR_NO_ERROR)
+        if (dst == NULL)
         {
-            return err;
+            release_data(img, data, transfer_ownership);
+            return IMGLOAD_ERR_OUT_OF_MEMORY;
+        }
+
+        if (converter == NULL && !flip)
+        {
+            // Memory wasn't allocated by us so we need to copy it.
+            memcpy(dst, (const uint8_t*) data->data, data_size);
+        }
+        else
+        {
+            transfer_rows(converter, &params, data, dst, stride, stride, flip);
         }
+
+        release_data(img, data, transfer_ownership);
     }
 
+    mipmap1->raw.image.width = data->width;
+    mipmap1->raw.image.height = data->height;
+    mipmap1->raw.image.depth = data->depth;
+    mipmap1->raw.image.stride = stride;
+    mipmap1->raw.image.data_size = data_size;
+    mipmap1->raw.image.data = dst;
+    mipmap1->raw.has_data = true;
+
     return IMGLOAD_ERR_NO_ERROR;
 }
 
+ImgloadErrorCode image_set_data(ImgloadImage img, size_t subframe, size_t mipmap,
+                                            ImgloadImageData* data, bool transfer_ownership)
+{
+    bool convert = img->conv.do_convert && img->conv.requested != img->plugin_data_format;
+    bool flip = (img->context->flags & IMGLOAD_CONTEXT_FLIP_IMAGES) != 0;
+
+    if (!convert && !flip)
+    {
+        // Storing or copying the data counts towards the caller
+        return image_store_data(img, subframe, mipmap, data, transfer_ownership);
+    }
+
+    ImageStage stage = image_stage_begin(img, convert ? STATS_PHASE_CONVERT : STATS_PHASE_FLIP, convert ? "convert" : "flip");
+    ImgloadErrorCode err = image_store_data(img, subframe, mipmap, data, transfer_ownership);
+    image_stage_end(img, stage);
+
+    return err;
+}
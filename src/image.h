@@ -4,6 +4,10 @@
 
 #include <imageloader.h>
 
+#include "mapping.h"
+#include "memory.h"
+#include "stats.h"
+
 #include <stdbool.h>
 
 typedef struct
@@ -25,6 +29,7 @@ typedef struct
 {
     ImgloadImageData image;
     bool has_data;
+    bool borrowed; //!< The memory belongs to the plugin and isn't freed with the image
 } MipmapData;
 
 typedef struct
@@ -45,6 +50,16 @@ struct ImgloadImageImpl
 {
     ImgloadContext context;
 
+    /**
+     * Serves the metadata allocations of the image if the context has IMGLOAD_CONTEXT_IMAGE_ARENA set. The image itself
+     * lives in the first chunk.
+     */
+    bool use_arena;
+    MemArena arena;
+
+    bool collect_stats; //!< Set if the context has IMGLOAD_CONTEXT_COLLECT_STATS
+    StatsRecorder stats;
+
     ImgloadPlugin plugin;
     void* plugin_data;
 
@@ -67,16 +82,74 @@ struct ImgloadImageImpl
     {
         ImgloadIO funcs;
         void* ud;
+
+        // If in_memory is set then the image is read from the memory buffer instead of using the IO functions
+        bool in_memory;
+        const uint8_t* memory;
+        size_t memory_size;
+        size_t memory_pos;
+
+        FileMapping mapping; //!< Only used if the image was created from a file
+        uint8_t* owned_memory; //!< Memory of an asynchronous load which is freed with the image
+
+        // Read buffer in front of the IO functions, NULL if reads are not buffered
+        uint8_t* buffer;
+        size_t buffer_capacity;
+        size_t buffer_length; //!< The number of valid bytes in the buffer
+        size_t buffer_pos; //!< The current read position in the buffer
+        int64_t buffer_offset; //!< The stream position of the first byte in the buffer
+
+        // Streams don't change their size while an image is loaded so the size is only determined once
+        bool size_known;
+        int64_t size;
     } io;
 
+    /**
+     * If active, data set for the given mipmap is written to dst instead of being stored in the image. Used for
+     * decoding directly into memory of the caller.
+     */
+    struct
+    {
+        bool active;
+        bool written;
+        size_t subimage;
+        size_t mipmap;
+
+        uint8_t* dst;
+        size_t stride;
+    } sink;
+
     ImageFrame* frames;
     size_t n_frames;
 };
 
+/**
+ * @brief Allocates zero initialized memory which is used as long as the image
+ * The memory comes from the arena of the image if it has one.
+ */
+void* image_mem_alloc(ImgloadImage img, size_t size);
+
+/**
+ * @brief Frees memory of image_mem_alloc, arena memory is only given back if it was the last allocation
+ */
+void image_mem_free(ImgloadImage img, void* ptr);
+
+char* image_mem_strdup(ImgloadImage img, const char* str);
+
+/**
+ * @brief Initializes an image read from memory allocated with mem_realloc
+ * The image takes ownership of the memory, it is freed even if the initialization fails.
+ */
+ImgloadErrorCode image_init_from_owned_memory(ImgloadContext ctx, ImgloadImage* image, uint8_t* data, size_t size);
+
 size_t IMGLOAD_API image_io_read(ImgloadImage img, uint8_t* buf, size_t size);
 
 int64_t IMGLOAD_API image_io_seek(ImgloadImage img, int64_t offset, int whence);
 
+const uint8_t* image_io_map(ImgloadImage img, uint64_t offset, size_t size);
+
+int64_t image_io_size(ImgloadImage img);
+
 ImgloadErrorCode image_allocate_frames(ImgloadImage img, size_t num_frames);
 
 ImgloadErrorCode image_allocate_mipmaps(ImgloadImage img, size_t subframe, size_t mipmaps);
@@ -84,6 +157,12 @@ ImgloadErrorCode image_allocate_mipmaps(ImgloadImage img, size_t subframe, size_
 ImgloadErrorCode image_set_compressed_data(ImgloadImage img, size_t subframe, size_t mipmap,
                                             ImgloadImageData* data, bool transfer_ownership);
 
+/**
+ * @brief Stores compressed data which stays owned by the plugin
+ */
+ImgloadErrorCode image_reference_compressed_data(ImgloadImage img, size_t subframe, size_t mipmap,
+                                                 const ImgloadImageData* data);
+
 ImgloadErrorCode image_set_data(ImgloadImage img, size_t subframe, size_t mipmap,
                                             ImgloadImageData* data, bool transfer_ownership);
 
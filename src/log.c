@@ -1,4 +1,3 @@
-
 #include <imageloader.h>
 
 #include "log.h"
@@ -7,24 +6,64 @@
 #include <stdio.h>
 #include <stdarg.h>
 
-void print_to_log(ImgloadContext ctx, ImgloadLogLevel level, const char* format, ...)
+void print_to_log_v(ImgloadContext ctx, ImgloadLogLevel level, const char* plugin_id, const char* format, va_list args)
 {
-	if (!ctx->log.handler)
+	if (level < IMGLOAD_MIN_LOG_LEVEL || level < thread_atomic_load_u32(&ctx->log.minLevel))
 	{
 		return;
 	}
 
-	if (level < ctx->log.minLevel)
+	thread_rwlock_read_lock(&ctx->log.lock);
+
+	if (!ctx->log.handler)
 	{
+		thread_rwlock_read_unlock(&ctx->log.lock);
 		return;
 	}
 
 	char buffer[1024];
+	size_t length = 0;
+	size_t available = sizeof(buffer) / sizeof(buffer[0]);
+
+	if (plugin_id != NULL)
+	{
+		// Keep space for the newline
+		--available;
+
+		int ret = snprintf(buffer, available, "[%s] ", plugin_id);
+		if (ret > 0)
+		{
+			length = (size_t)ret < available ? (size_t)ret : available - 1;
+		}
+	}
+
+	int ret = vsnprintf(buffer + length, available - length, format, args);
+	if (ret < 0)
+	{
+		ret = snprintf(buffer + length, available - length, "Failed to evaluate format string '%s'", format);
+	}
+	if (ret > 0)
+	{
+		length += (size_t)ret < available - length ? (size_t)ret : available - length - 1;
+	}
+
+	if (plugin_id != NULL)
+	{
+		buffer[length] = '\n';
+		buffer[length + 1] = '\0';
+	}
+
+	ctx->log.handler(ctx->log.ud, level, buffer);
+
+	thread_rwlock_read_unlock(&ctx->log.lock);
+}
+
+void print_to_log(ImgloadContext ctx, ImgloadLogLevel level, const char* format, ...)
+{
 	va_list args;
 	va_start(args, format);
-	vsnprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), format, args);
 
-	ctx->log.handler(ctx->log.ud, level, buffer);
+	print_to_log_v(ctx, level, NULL, format, args);
 
 	va_end(args);
-}
\ No newline at end of file
+}
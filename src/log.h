@@ -4,6 +4,14 @@
 
 #include <imageloader.h>
 
+#include <stdarg.h>
+
 void print_to_log(ImgloadContext ctx, ImgloadLogLevel level, const char* format, ...);
 
+/**
+ * @brief Formats a message into the log, nothing is formatted if the level is filtered or no handler is set
+ * @param plugin_id If not @c NULL the message is prefixed with the id and ended with a newline
+ */
+void print_to_log_v(ImgloadContext ctx, ImgloadLogLevel level, const char* plugin_id, const char* format, va_list args);
+
 #endif
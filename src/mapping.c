@@ -0,0 +1,155 @@
+#include "mapping.h"
+
+#include <string.h>
+#include <assert.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+ImgloadErrorCode mapping_open(FileMapping* mapping, const char* path)
+{
+    assert(mapping != NULL);
+    assert(path != NULL);
+
+    memset(mapping, 0, sizeof(*mapping));
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || (uint64_t)size.QuadPart > (uint64_t)SIZE_MAX)
+    {
+        CloseHandle(file);
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    if (size.QuadPart == 0)
+    {
+        // Empty files can't be mapped but are still valid (empty) sources
+        CloseHandle(file);
+        mapping->mapped = true;
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    HANDLE map_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (map_handle == NULL)
+    {
+        CloseHandle(file);
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    void* view = MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL)
+    {
+        CloseHandle(map_handle);
+        CloseHandle(file);
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    mapping->mapped = true;
+    mapping->data = (const uint8_t*)view;
+    mapping->size = (size_t)size.QuadPart;
+    mapping->file_handle = file;
+    mapping->mapping_handle = map_handle;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+void mapping_close(FileMapping* mapping)
+{
+    assert(mapping != NULL);
+
+    if (!mapping->mapped)
+    {
+        return;
+    }
+
+    if (mapping->data != NULL)
+    {
+        UnmapViewOfFile((LPCVOID)mapping->data);
+        CloseHandle((HANDLE)mapping->mapping_handle);
+        CloseHandle((HANDLE)mapping->file_handle);
+    }
+
+    memset(mapping, 0, sizeof(*mapping));
+}
+
+#else
+
+ImgloadErrorCode mapping_open(FileMapping* mapping, const char* path)
+{
+    assert(mapping != NULL);
+    assert(path != NULL);
+
+    memset(mapping, 0, sizeof(*mapping));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (uint64_t)info.st_size > (uint64_t)SIZE_MAX)
+    {
+        close(fd);
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    if (info.st_size == 0)
+    {
+        // Empty files can't be mapped but are still valid (empty) sources
+        close(fd);
+        mapping->mapped = true;
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping stays valid after the descriptor has been closed
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    mapping->mapped = true;
+    mapping->data = (const uint8_t*)data;
+    mapping->size = (size_t)info.st_size;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+void mapping_close(FileMapping* mapping)
+{
+    assert(mapping != NULL);
+
+    if (!mapping->mapped)
+    {
+        return;
+    }
+
+    if (mapping->data != NULL)
+    {
+        munmap((void*)mapping->data, mapping->size);
+    }
+
+    memset(mapping, 0, sizeof(*mapping));
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef IMAGELOADER_MAPPING_H
+#define IMAGELOADER_MAPPING_H
+#pragma once
+
+#include <imageloader.h>
+
+#include <stdbool.h>
+
+/**
+ * @brief A read-only memory mapping of a complete file
+ */
+typedef struct
+{
+    bool mapped;
+
+    const uint8_t* data;
+    size_t size;
+
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#endif
+} FileMapping;
+
+ImgloadErrorCode mapping_open(FileMapping* mapping, const char* path);
+
+void mapping_close(FileMapping* mapping);
+
+#endif //IMAGELOADER_MAPPING_H
@@ -2,11 +2,82 @@
 
 #include "context.h"
 #include "memory.h"
+#include <stdint.h>
 #include <string.h>
 
+// Alignment of all arena and pool allocations, enough for every fundamental type
+#define MEM_ALIGNMENT 16
+#define MEM_ARENA_CHUNK_SIZE 4096
+
+// Smaller buffers are not worth caching, the allocator serves them quickly
+#define MEM_POOL_MIN_SIZE (64 * 1024)
+#define MEM_POOL_DEFAULT_LIMIT (64 * 1024 * 1024)
+
+#define MEM_ALIGN(size) (((size) + MEM_ALIGNMENT - 1) & ~(size_t)(MEM_ALIGNMENT - 1))
+
+struct MemArenaChunk
+{
+    MemArenaChunk* next;
+
+    size_t capacity;
+    size_t used;
+    size_t last; //!< Offset of the last allocation, equal to used if it can't be returned anymore
+};
+
+// The chunk header is padded so that the data after it is aligned
+#define MEM_ARENA_HEADER_SIZE MEM_ALIGN(sizeof(MemArenaChunk))
+
+/**
+ * @brief Header in front of every buffer allocated while the pool is enabled
+ */
+typedef struct PoolBuffer
+{
+    size_t capacity;
+    struct PoolBuffer* next; //!< The next cached buffer of the bucket
+} PoolBuffer;
+
+#define MEM_POOL_HEADER_SIZE MEM_ALIGN(sizeof(PoolBuffer))
+
+// Header in front of every allocation while the context collects statistics, it holds the size of the allocation
+#define MEM_STATS_HEADER_SIZE MEM_ALIGN(sizeof(size_t))
+
+static void mem_stats_track(ImgloadContext ctx, size_t freed, size_t allocated)
+{
+    // Unsigned arithmetic wraps around, so adding the difference also works if memory is freed
+    size_t change = allocated - freed;
+    size_t current = thread_atomic_fetch_add_size(&ctx->stats.allocated, change) + change;
+
+    size_t peak = thread_atomic_load_size(&ctx->stats.peak);
+    while (current > peak && !thread_atomic_compare_exchange_size(&ctx->stats.peak, &peak, current))
+    {
+    }
+}
+
 void* mem_realloc(ImgloadContext ctx, void* ptr, size_t size)
 {
-    return ctx->mem.allocator.realloc(ctx->mem.ud, ptr, size);
+    if (!ctx->stats.enabled)
+    {
+        return ctx->mem.allocator.realloc(ctx->mem.ud, ptr, size);
+    }
+
+    if (size > SIZE_MAX - MEM_STATS_HEADER_SIZE)
+    {
+        return NULL;
+    }
+
+    uint8_t* block = ptr != NULL ? (uint8_t*)ptr - MEM_STATS_HEADER_SIZE : NULL;
+    size_t old_size = block != NULL ? *(size_t*)block : 0;
+
+    block = (uint8_t*)ctx->mem.allocator.realloc(ctx->mem.ud, block, MEM_STATS_HEADER_SIZE + size);
+    if (block == NULL)
+    {
+        return NULL;
+    }
+
+    *(size_t*)block = size;
+    mem_stats_track(ctx, old_size, size);
+
+    return block + MEM_STATS_HEADER_SIZE;
 }
 
 void* mem_reallocz(ImgloadContext ctx, void* ptr, size_t size)
@@ -23,6 +94,14 @@ void* mem_reallocz(ImgloadContext ctx, void* ptr, size_t size)
 
 void mem_free(ImgloadContext ctx, void* ptr)
 {
+    if (ctx->stats.enabled && ptr != NULL)
+    {
+        uint8_t* block = (uint8_t*)ptr - MEM_STATS_HEADER_SIZE;
+        mem_stats_track(ctx, *(size_t*)block, 0);
+
+        ptr = block;
+    }
+
     ctx->mem.allocator.free(ctx->mem.ud, ptr);
 }
 
@@ -42,3 +121,296 @@ char* mem_strdup(ImgloadContext ctx, const char* str)
 
     return new_mem;
 }
+
+void mem_arena_init(MemArena* arena)
+{
+    arena->head = NULL;
+}
+
+static uint8_t* arena_chunk_data(MemArenaChunk* chunk)
+{
+    return (uint8_t*)chunk + MEM_ARENA_HEADER_SIZE;
+}
+
+void* mem_arena_alloc(ImgloadContext ctx, MemArena* arena, size_t size)
+{
+    size_t aligned = MEM_ALIGN(size);
+    if (aligned < size)
+    {
+        return NULL;
+    }
+
+    MemArenaChunk* chunk = arena->head;
+    if (chunk == NULL || chunk->capacity - chunk->used < aligned)
+    {
+        size_t capacity = MEM_ARENA_CHUNK_SIZE - MEM_ARENA_HEADER_SIZE;
+        if (aligned > capacity)
+        {
+            capacity = aligned;
+        }
+        if (capacity > SIZE_MAX - MEM_ARENA_HEADER_SIZE)
+        {
+            return NULL;
+        }
+
+        // The rest of the previous chunk is given up, it's only ever a part of a default chunk
+        chunk = (MemArenaChunk*)mem_realloc(ctx, NULL, MEM_ARENA_HEADER_SIZE + capacity);
+        if (chunk == NULL)
+        {
+            return NULL;
+        }
+        chunk->next = arena->head;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        chunk->last = 0;
+
+        arena->head = chunk;
+    }
+
+    uint8_t* data = arena_chunk_data(chunk) + chunk->used;
+    chunk->last = chunk->used;
+    chunk->used += aligned;
+
+    memset(data, 0, size);
+
+    return data;
+}
+
+void mem_arena_free(ImgloadContext ctx, MemArena* arena, void* ptr)
+{
+    MemArenaChunk* chunk = arena->head;
+    if (ptr == NULL || chunk == NULL || chunk->last == chunk->used
+        || (uint8_t*)ptr != arena_chunk_data(chunk) + chunk->last)
+    {
+        return;
+    }
+
+    chunk->used = chunk->last;
+    if (chunk->used == 0 && chunk->next != NULL)
+    {
+        // Temporary buffers too large for a default chunk don't stay around until the arena is released
+        arena->head = chunk->next;
+        mem_free(ctx, chunk);
+    }
+}
+
+char* mem_arena_strdup(ImgloadContext ctx, MemArena* arena, const char* str)
+{
+    size_t len = strlen(str);
+
+    char* new_mem = (char*)mem_arena_alloc(ctx, arena, len + 1);
+    if (new_mem == NULL)
+    {
+        return NULL;
+    }
+    memcpy(new_mem, str, len + 1);
+
+    return new_mem;
+}
+
+void mem_arena_release(ImgloadContext ctx, MemArena* arena)
+{
+    MemArenaChunk* chunk = arena->head;
+    while (chunk != NULL)
+    {
+        // The arena may be stored in the chunk so nothing is accessed after freeing it
+        MemArenaChunk* next = chunk->next;
+        mem_free(ctx, chunk);
+        chunk = next;
+    }
+}
+
+bool mem_pool_init(MemPool* pool, bool enabled)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->enabled = enabled;
+    pool->limit = MEM_POOL_DEFAULT_LIMIT;
+
+    return !enabled || thread_mutex_init(&pool->lock);
+}
+
+static size_t pool_bucket(size_t size)
+{
+    size_t bucket = 0;
+    while (size > 1)
+    {
+        size >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+static PoolBuffer* pool_header(void* ptr)
+{
+    return (PoolBuffer*)((uint8_t*)ptr - MEM_POOL_HEADER_SIZE);
+}
+
+static void* pool_data(PoolBuffer* buffer)
+{
+    return (uint8_t*)buffer + MEM_POOL_HEADER_SIZE;
+}
+
+/**
+ * @brief Frees cached buffers until the cache fits into the limit, the lock has to be held
+ */
+static void pool_trim(ImgloadContext ctx, MemPool* pool)
+{
+    // Large buffers go first, they are the least likely to be requested again
+    for (size_t i = MEM_POOL_BUCKETS; i > 0 && pool->cached > pool->limit; --i)
+    {
+        PoolBuffer* buffer;
+        while (pool->cached > pool->limit && (buffer = (PoolBuffer*)pool->buckets[i - 1]) != NULL)
+        {
+            pool->buckets[i - 1] = buffer->next;
+            pool->cached -= buffer->capacity;
+            mem_free(ctx, buffer);
+        }
+    }
+}
+
+void mem_pool_destroy(ImgloadContext ctx, MemPool* pool)
+{
+    if (!pool->enabled)
+    {
+        return;
+    }
+
+    pool->limit = 0;
+    pool_trim(ctx, pool);
+    thread_mutex_destroy(&pool->lock);
+}
+
+void mem_pool_set_limit(ImgloadContext ctx, MemPool* pool, size_t limit)
+{
+    if (!pool->enabled)
+    {
+        return;
+    }
+
+    thread_mutex_lock(&pool->lock);
+    pool->limit = limit;
+    pool_trim(ctx, pool);
+    thread_mutex_unlock(&pool->lock);
+}
+
+static void* pool_alloc(ImgloadContext ctx, MemPool* pool, size_t size)
+{
+    if (size >= MEM_POOL_MIN_SIZE)
+    {
+        // Every cached buffer of the bucket is at most twice as large as needed
+        size_t bucket = pool_bucket(size);
+
+        thread_mutex_lock(&pool->lock);
+        PoolBuffer** link = (PoolBuffer**)&pool->buckets[bucket];
+        while (*link != NULL && (*link)->capacity < size)
+        {
+            link = &(*link)->next;
+        }
+        PoolBuffer* buffer = *link;
+        if (buffer != NULL)
+        {
+            *link = buffer->next;
+            pool->cached -= buffer->capacity;
+        }
+        thread_mutex_unlock(&pool->lock);
+
+        if (buffer != NULL)
+        {
+            return pool_data(buffer);
+        }
+    }
+
+    if (size > SIZE_MAX - MEM_POOL_HEADER_SIZE)
+    {
+        return NULL;
+    }
+
+    PoolBuffer* buffer = (PoolBuffer*)mem_realloc(ctx, NULL, MEM_POOL_HEADER_SIZE + size);
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    buffer->capacity = size;
+
+    return pool_data(buffer);
+}
+
+void* mem_pixels_realloc(ImgloadContext ctx, void* ptr, size_t size)
+{
+    MemPool* pool = &ctx->pool;
+    if (!pool->enabled)
+    {
+        return mem_realloc(ctx, ptr, size);
+    }
+
+    if (ptr == NULL)
+    {
+        return pool_alloc(ctx, pool, size);
+    }
+
+    PoolBuffer* buffer = pool_header(ptr);
+    if (size <= buffer->capacity)
+    {
+        return ptr;
+    }
+
+    if (buffer->capacity < MEM_POOL_MIN_SIZE && size < MEM_POOL_MIN_SIZE)
+    {
+        // Neither buffer would ever be cached so the allocator can grow it in place
+        PoolBuffer* grown = (PoolBuffer*)mem_realloc(ctx, buffer, MEM_POOL_HEADER_SIZE + size);
+        if (grown == NULL)
+        {
+            return NULL;
+        }
+        grown->capacity = size;
+
+        return pool_data(grown);
+    }
+
+    void* new_ptr = pool_alloc(ctx, pool, size);
+    if (new_ptr == NULL)
+    {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, buffer->capacity);
+    mem_pixels_free(ctx, ptr);
+
+    return new_ptr;
+}
+
+void mem_pixels_free(ImgloadContext ctx, void* ptr)
+{
+    MemPool* pool = &ctx->pool;
+    if (!pool->enabled)
+    {
+        mem_free(ctx, ptr);
+        return;
+    }
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    PoolBuffer* buffer = pool_header(ptr);
+    if (buffer->capacity >= MEM_POOL_MIN_SIZE)
+    {
+        thread_mutex_lock(&pool->lock);
+        bool cached = pool->cached + buffer->capacity <= pool->limit;
+        if (cached)
+        {
+            size_t bucket = pool_bucket(buffer->capacity);
+            buffer->next = (PoolBuffer*)pool->buckets[bucket];
+            pool->buckets[bucket] = buffer;
+            pool->cached += buffer->capacity;
+        }
+        thread_mutex_unlock(&pool->lock);
+
+        if (cached)
+        {
+            return;
+        }
+    }
+
+    mem_free(ctx, buffer);
+}
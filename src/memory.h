@@ -2,6 +2,10 @@
 #define IMAGELOADER_MEMORY_H
 #pragma once
 
+#include "thread.h"
+
+#include <stdbool.h>
+
 void* mem_realloc(ImgloadContext ctx, void* ptr, size_t size);
 
 void* mem_reallocz(ImgloadContext ctx, void* ptr, size_t size);
@@ -10,4 +14,73 @@ void mem_free(ImgloadContext ctx, void* ptr);
 
 char* mem_strdup(ImgloadContext ctx, const char* str);
 
+typedef struct MemArenaChunk MemArenaChunk;
+
+/**
+ * @brief Bump allocator for many small allocations which are all released together
+ * Chunks are requested from the context allocator, the arena isn't thread safe.
+ */
+typedef struct
+{
+    MemArenaChunk* head; //!< The chunk allocations are served from, the other chunks are full
+} MemArena;
+
+void mem_arena_init(MemArena* arena);
+
+/**
+ * @brief Allocates zero initialized memory from the arena
+ * Requests which don't fit into a default chunk get a chunk of their own.
+ */
+void* mem_arena_alloc(ImgloadContext ctx, MemArena* arena, size_t size);
+
+/**
+ * @brief Returns memory to the arena if it was the last allocation, other memory is only released with the arena
+ */
+void mem_arena_free(ImgloadContext ctx, MemArena* arena, void* ptr);
+
+char* mem_arena_strdup(ImgloadContext ctx, MemArena* arena, const char* str);
+
+/**
+ * @brief Frees all chunks of the arena, the arena itself may live in one of them
+ */
+void mem_arena_release(ImgloadContext ctx, MemArena* arena);
+
+// One free list per power of two of the buffer size
+#define MEM_POOL_BUCKETS (sizeof(size_t) * 8)
+
+/**
+ * @brief Cache of large pixel buffers which are reused instead of going back to the allocator
+ * Only used if the context has IMGLOAD_CONTEXT_BUFFER_POOL set. All memory of mem_pixels_realloc then has a small
+ * header with its capacity, so it must only be freed with mem_pixels_free.
+ */
+typedef struct
+{
+    bool enabled;
+
+    ThreadMutex lock; //!< Protects everything below
+    void* buckets[MEM_POOL_BUCKETS];
+    size_t cached; //!< The capacity of all buffers in the buckets
+    size_t limit;
+} MemPool;
+
+bool mem_pool_init(MemPool* pool, bool enabled);
+
+/**
+ * @brief Frees all cached buffers and the pool itself
+ */
+void mem_pool_destroy(ImgloadContext ctx, MemPool* pool);
+
+/**
+ * @brief Sets the maximum size of the cached buffers, buffers above the limit are freed
+ */
+void mem_pool_set_limit(ImgloadContext ctx, MemPool* pool, size_t limit);
+
+/**
+ * @brief Allocates memory for pixels, plugin memory and everything which may be handed over to an image
+ * With a buffer pool large allocations reuse a cached buffer if there is one of a matching size.
+ */
+void* mem_pixels_realloc(ImgloadContext ctx, void* ptr, size_t size);
+
+void mem_pixels_free(ImgloadContext ctx, void* ptr);
+
 #endif //IMAGELOADER_MEMORY_H
@@ -13,7 +13,7 @@ static ImgloadErrorCode validate_plugin(ImgloadPlugin plugin)
         return IMGLOAD_ERR_PLUGIN_INVALID;
     }
 
-    if (plugin->funcs.probe == NULL)
+    if (plugin->funcs.probe == NULL && plugin->funcs.probe_header == NULL && plugin->signatures.count == 0)
     {
         print_to_log(plugin->context, IMGLOAD_LOG_ERROR, "[%s] A plugin has to have a probe function!\n", plugin->info.id);
         return IMGLOAD_ERR_PLUGIN_INVALID;
@@ -27,6 +27,19 @@ static ImgloadErrorCode validate_plugin(ImgloadPlugin plugin)
     return IMGLOAD_ERR_NO_ERROR;
 }
 
+static void free_signatures(ImgloadPlugin plugin)
+{
+    for (size_t i = 0; i < plugin->signatures.count; ++i)
+    {
+        mem_free(plugin->context, plugin->signatures.list[i].bytes);
+    }
+
+    if (plugin->signatures.list != NULL)
+    {
+        mem_free(plugin->context, plugin->signatures.list);
+    }
+}
+
 ImgloadErrorCode plugin_init(ImgloadContext ctx, ImgloadPluginLoader loader, void* param, ImgloadPlugin* plugin_out)
 {
     assert(plugin_out != NULL);
@@ -44,6 +57,7 @@ ImgloadErrorCode plugin_init(ImgloadContext ctx, ImgloadPluginLoader loader, voi
 
     if (err != IMGLOAD_ERR_NO_ERROR)
     {
+        free_signatures(plugin);
         mem_free(ctx, plugin);
         return err;
     }
@@ -68,5 +82,51 @@ void plugin_free(ImgloadPlugin plugin)
         plugin->funcs.deinit(plugin);
     }
 
+    free_signatures(plugin);
+
     mem_free(plugin->context, plugin);
 }
+
+ImgloadErrorCode plugin_add_signature(ImgloadPlugin plugin, const uint8_t* signature, size_t size)
+{
+    assert(plugin != NULL);
+    assert(signature != NULL);
+
+    if (size == 0 || size > IMGLOAD_PLUGIN_HEADER_SIZE)
+    {
+        return IMGLOAD_ERR_OUT_OF_RANGE;
+    }
+
+    uint8_t* bytes = (uint8_t*)mem_realloc(plugin->context, NULL, size);
+    if (bytes == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+    memcpy(bytes, signature, size);
+
+    PluginSignature* new_list = (PluginSignature*)mem_realloc(plugin->context, plugin->signatures.list,
+                                                              (plugin->signatures.count + 1) * sizeof(PluginSignature));
+    if (new_list == NULL)
+    {
+        mem_free(plugin->context, bytes);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    PluginSignature* entry = &new_list[plugin->signatures.count];
+    entry->plugin = plugin;
+    entry->bytes = bytes;
+    entry->size = size;
+    entry->next = NULL;
+
+    plugin->signatures.list = new_list;
+    ++plugin->signatures.count;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+bool plugin_signature_only(ImgloadPlugin plugin)
+{
+    assert(plugin != NULL);
+
+    return plugin->funcs.probe == NULL && plugin->funcs.probe_header == NULL;
+}
@@ -5,6 +5,21 @@
 #include <imageloader.h>
 #include <imageloader_plugin.h>
 
+#include <stdbool.h>
+
+/**
+ * @brief A magic value at the start of a file that identifies the file format of a plugin
+ */
+typedef struct PluginSignature
+{
+    ImgloadPlugin plugin;
+
+    uint8_t* bytes;
+    size_t size;
+
+    struct PluginSignature* next; //!< The next signature in the dispatch table bucket of the context
+} PluginSignature;
+
 struct ImgloadPluginImpl
 {
     struct ImgloadPluginImpl* prev;
@@ -14,6 +29,12 @@ struct ImgloadPluginImpl
 
     void* plugin_data;
 
+    struct
+    {
+        PluginSignature* list;
+        size_t count;
+    } signatures;
+
     struct
     {
         const char* id;
@@ -25,17 +46,30 @@ struct ImgloadPluginImpl
     {
         ImgloadPluginDeinitFunc deinit;
         ImgloadPluginProbeFunc probe;
+        ImgloadPluginProbeHeaderFunc probe_header;
 
         ImgloadPluginImageFunc init_image;
         ImgloadPluginImageFunc deinit_image;
+        ImgloadPluginImageInfoFunc image_info;
 
         ImgloadPluginImageFunc read_image;
+        ImgloadPluginReadRowsFunc read_rows;
+        ImgloadPluginReadMipmapsFunc read_mipmaps;
         ImgloadPluginDecompressData decompress_data;
     } funcs;
+
+    ImgloadStats stats; //!< The statistics of the freed images of the plugin, protected by the stats lock of the context
 };
 
 ImgloadErrorCode plugin_init(ImgloadContext ctx, ImgloadPluginLoader loader, void* param, ImgloadPlugin* plugin_out);
 
 void plugin_free(ImgloadPlugin plugin);
 
+ImgloadErrorCode plugin_add_signature(ImgloadPlugin plugin, const uint8_t* signature, size_t size);
+
+/**
+ * @brief Checks if the plugin can only be selected by its signatures
+ */
+bool plugin_signature_only(ImgloadPlugin plugin);
+
 #endif //IMAGELOADER_PLUGIN_H
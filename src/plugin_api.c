@@ -4,6 +4,7 @@
 
 #include "image.h"
 #include "plugin.h"
+#include "context.h"
 #include "memory.h"
 #include "log.h"
 
@@ -25,36 +26,58 @@ int64_t IMGLOAD_API imgload_plugin_image_seek(ImgloadImage img, int64_t offset,
     return image_io_seek(img, offset, whence);
 }
 
+const uint8_t* IMGLOAD_API imgload_plugin_image_map(ImgloadImage img, uint64_t offset, size_t size)
+{
+    assert(img != NULL);
+
+    return image_io_map(img, offset, size);
+}
+
+int64_t IMGLOAD_API imgload_plugin_image_size(ImgloadImage img)
+{
+    assert(img != NULL);
+
+    return image_io_size(img);
+}
+
 
 void* IMGLOAD_API imgload_plugin_realloc(ImgloadPlugin plugin, void* ptr, size_t size)
 {
     assert(plugin != NULL);
 
-    return mem_realloc(plugin->context, ptr, size);
+    // Plugins hand their pixels over to images so everything comes from the same allocator as the image data
+    return mem_pixels_realloc(plugin->context, ptr, size);
 }
 
 void IMGLOAD_API imgload_plugin_free(ImgloadPlugin plugin, void* ptr)
 {
     assert(plugin != NULL);
 
-    mem_free(plugin->context, ptr);
+    mem_pixels_free(plugin->context, ptr);
+}
+
+void* IMGLOAD_API imgload_plugin_image_alloc(ImgloadImage img, size_t size)
+{
+    assert(img != NULL);
+
+    return image_mem_alloc(img, size);
+}
+
+void IMGLOAD_API imgload_plugin_image_dealloc(ImgloadImage img, void* ptr)
+{
+    assert(img != NULL);
+
+    image_mem_free(img, ptr);
 }
 
 void IMGLOAD_API imgload_plugin_log(ImgloadPlugin plugin, ImgloadLogLevel level, const char* format, ...)
 {
-    char buffer[1024];
+    assert(plugin != NULL);
 
     va_list list;
     va_start(list, format);
 
-    int ret = vsnprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), format, list);
-
-    if (ret < 0)
-    {
-        print_to_log(plugin->context, level, "[%s] Failed to evaluate format string '%s'\n", plugin->info.id, format);
-    }
-
-    print_to_log(plugin->context, level, "[%s] %s\n", plugin->info.id, buffer);
+    print_to_log_v(plugin->context, level, plugin->info.id, format, list);
 
     va_end(list);
 }
@@ -82,6 +105,14 @@ void IMGLOAD_API imgload_plugin_set_info(ImgloadPlugin plugin, const char* id, c
     plugin->info.description = description;
 }
 
+ImgloadErrorCode IMGLOAD_API imgload_plugin_register_signature(ImgloadPlugin plugin, const uint8_t* signature, size_t size)
+{
+    assert(plugin != NULL);
+    assert(signature != NULL);
+
+    return plugin_add_signature(plugin, signature, size);
+}
+
 void IMGLOAD_API imgload_plugin_callback_deinit(ImgloadPlugin plugin, ImgloadPluginDeinitFunc func)
 {
     assert(plugin != NULL);
@@ -98,6 +129,14 @@ void IMGLOAD_API imgload_plugin_callback_probe(ImgloadPlugin plugin, ImgloadPlug
     plugin->funcs.probe = func;
 }
 
+void IMGLOAD_API imgload_plugin_callback_probe_header(ImgloadPlugin plugin, ImgloadPluginProbeHeaderFunc func)
+{
+    assert(plugin != NULL);
+    assert(func != NULL);
+
+    plugin->funcs.probe_header = func;
+}
+
 void IMGLOAD_API imgload_plugin_callback_init_image(ImgloadPlugin plugin, ImgloadPluginImageFunc func)
 {
     assert(plugin != NULL);
@@ -114,6 +153,14 @@ void IMGLOAD_API imgload_plugin_callback_deinit_image(ImgloadPlugin plugin, Imgl
     plugin->funcs.deinit_image = func;
 }
 
+void IMGLOAD_API imgload_plugin_callback_image_info(ImgloadPlugin plugin, ImgloadPluginImageInfoFunc func)
+{
+    assert(plugin != NULL);
+    assert(func != NULL);
+
+    plugin->funcs.image_info = func;
+}
+
 void IMGLOAD_API imgload_plugin_callback_read_data(ImgloadPlugin plugin, ImgloadPluginImageFunc func)
 {
     assert(plugin != NULL);
@@ -122,6 +169,22 @@ void IMGLOAD_API imgload_plugin_callback_read_data(ImgloadPlugin plugin, Imgload
     plugin->funcs.read_image = func;
 }
 
+void IMGLOAD_API imgload_plugin_callback_read_rows(ImgloadPlugin plugin, ImgloadPluginReadRowsFunc func)
+{
+    assert(plugin != NULL);
+    assert(func != NULL);
+
+    plugin->funcs.read_rows = func;
+}
+
+void IMGLOAD_API imgload_plugin_callback_read_mipmaps(ImgloadPlugin plugin, ImgloadPluginReadMipmapsFunc func)
+{
+    assert(plugin != NULL);
+    assert(func != NULL);
+
+    plugin->funcs.read_mipmaps = func;
+}
+
 void IMGLOAD_API imgload_plugin_callback_decompress_data(ImgloadPlugin plugin, ImgloadPluginDecompressData func)
 {
     assert(plugin != NULL);
@@ -193,7 +256,7 @@ ImgloadErrorCode IMGLOAD_API imgload_plugin_image_set_property(ImgloadImage img,
         property->value.double_val = *(double*)val;
         break;
     case IMGLOAD_PROPERTY_TYPE_STRING:
-        property->value.str = mem_strdup(img->context, *(const char**)val);
+        property->value.str = image_mem_strdup(img, *(const char**)val);
         break;
     case IMGLOAD_PROPERTY_TYPE_COMPLEX:
         property->value.complex = *(void**)val;
@@ -220,6 +283,23 @@ ImgloadImageData* data, int transfer_ownership)
     return image_set_compressed_data(img, subimage, mipmap, data, transfer_ownership != 0);
 }
 
+ImgloadErrorCode IMGLOAD_API imgload_plugin_image_reference_compressed_data(ImgloadImage img, size_t subimage,
+    size_t mipmap, ImgloadImageData* data)
+{
+    assert(img != NULL);
+    assert(subimage < img->n_frames);
+    assert(mipmap < img->frames[subimage].n_mipmaps);
+
+    return image_reference_compressed_data(img, subimage, mipmap, data);
+}
+
+int IMGLOAD_API imgload_plugin_image_compressed_passthrough(ImgloadImage img)
+{
+    assert(img != NULL);
+
+    return (img->context->flags & IMGLOAD_CONTEXT_COMPRESSED_PASSTHROUGH) != 0;
+}
+
 ImgloadErrorCode IMGLOAD_API imgload_plugin_image_set_image_data(ImgloadImage img, size_t subimage, size_t mipmap,
     ImgloadImageData* data, int transfer_ownership)
 {
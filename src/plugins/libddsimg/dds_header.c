@@ -0,0 +1,237 @@
+#include "dds_header.h"
+
+#define DDS_MAGIC_SIZE 4
+
+// The limits of Direct3D 11, they also keep the size of all mipmaps far away from overflowing
+#define DDS_MAX_DIMENSION 16384
+#define DDS_MAX_ARRAY_SIZE 2048
+
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_DEPTH 0x800000
+
+#define DDPF_FOURCC 0x4
+
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_CUBEMAP_FACES 0xFC00
+#define DDSCAPS2_VOLUME 0x200000
+
+#define DDS_RESOURCE_MISC_TEXTURECUBE 0x4
+#define DDS_DIMENSION_TEXTURE3D 4
+
+#define FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+// Field offsets in the header following the magic value
+enum
+{
+    HEADER_FLAGS = 4,
+    HEADER_HEIGHT = 8,
+    HEADER_WIDTH = 12,
+    HEADER_DEPTH = 20,
+    HEADER_MIPMAP_COUNT = 24,
+    HEADER_PIXEL_FORMAT_FLAGS = 76,
+    HEADER_FOURCC = 80,
+    HEADER_CAPS2 = 108,
+
+    DX10_FORMAT = 0,
+    DX10_DIMENSION = 4,
+    DX10_MISC_FLAG = 8,
+    DX10_ARRAY_SIZE = 12,
+};
+
+static uint32_t read_u32(const uint8_t* data, size_t offset)
+{
+    return (uint32_t)data[offset] | ((uint32_t)data[offset + 1] << 8) | ((uint32_t)data[offset + 2] << 16)
+        | ((uint32_t)data[offset + 3] << 24);
+}
+
+static ImgloadCompression convert_fourcc(uint32_t fourcc)
+{
+    switch (fourcc)
+    {
+    case FOURCC('D', 'X', 'T', '1'):
+        return IMGLOAD_COMPRESSION_DXT1;
+    case FOURCC('D', 'X', 'T', '2'):
+        return IMGLOAD_COMPRESSION_DXT2;
+    case FOURCC('D', 'X', 'T', '3'):
+        return IMGLOAD_COMPRESSION_DXT3;
+    case FOURCC('D', 'X', 'T', '4'):
+        return IMGLOAD_COMPRESSION_DXT4;
+    case FOURCC('D', 'X', 'T', '5'):
+        return IMGLOAD_COMPRESSION_DXT5;
+    case FOURCC('A', 'T', 'I', '1'):
+    case FOURCC('B', 'C', '4', 'U'):
+        return IMGLOAD_COMPRESSION_BC4;
+    case FOURCC('B', 'C', '4', 'S'):
+        return IMGLOAD_COMPRESSION_BC4_SNORM;
+    case FOURCC('A', 'T', 'I', '2'):
+    case FOURCC('B', 'C', '5', 'U'):
+        return IMGLOAD_COMPRESSION_BC5;
+    case FOURCC('B', 'C', '5', 'S'):
+        return IMGLOAD_COMPRESSION_BC5_SNORM;
+    default:
+        return IMGLOAD_COMPRESSION_NONE;
+    }
+}
+
+static ImgloadCompression convert_dxgi_format(uint32_t format)
+{
+    // The typeless formats are decoded like their UNORM variants, sRGB is left to the application
+    switch (format)
+    {
+    case 70: // DXGI_FORMAT_BC1_TYPELESS
+    case 71: // DXGI_FORMAT_BC1_UNORM
+    case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+        return IMGLOAD_COMPRESSION_DXT1;
+    case 73: // DXGI_FORMAT_BC2_TYPELESS
+    case 74: // DXGI_FORMAT_BC2_UNORM
+    case 75: // DXGI_FORMAT_BC2_UNORM_SRGB
+        return IMGLOAD_COMPRESSION_DXT3;
+    case 76: // DXGI_FORMAT_BC3_TYPELESS
+    case 77: // DXGI_FORMAT_BC3_UNORM
+    case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+        return IMGLOAD_COMPRESSION_DXT5;
+    case 79: // DXGI_FORMAT_BC4_TYPELESS
+    case 80: // DXGI_FORMAT_BC4_UNORM
+        return IMGLOAD_COMPRESSION_BC4;
+    case 81: // DXGI_FORMAT_BC4_SNORM
+        return IMGLOAD_COMPRESSION_BC4_SNORM;
+    case 82: // DXGI_FORMAT_BC5_TYPELESS
+    case 83: // DXGI_FORMAT_BC5_UNORM
+        return IMGLOAD_COMPRESSION_BC5;
+    case 84: // DXGI_FORMAT_BC5_SNORM
+        return IMGLOAD_COMPRESSION_BC5_SNORM;
+    case 94: // DXGI_FORMAT_BC6H_TYPELESS
+    case 95: // DXGI_FORMAT_BC6H_UF16
+        return IMGLOAD_COMPRESSION_BC6H_UF16;
+    case 96: // DXGI_FORMAT_BC6H_SF16
+        return IMGLOAD_COMPRESSION_BC6H_SF16;
+    case 97: // DXGI_FORMAT_BC7_TYPELESS
+    case 98: // DXGI_FORMAT_BC7_UNORM
+    case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+        return IMGLOAD_COMPRESSION_BC7;
+    default:
+        return IMGLOAD_COMPRESSION_NONE;
+    }
+}
+
+static size_t block_bytes(ImgloadCompression compression)
+{
+    switch (compression)
+    {
+    case IMGLOAD_COMPRESSION_DXT1:
+    case IMGLOAD_COMPRESSION_BC4:
+    case IMGLOAD_COMPRESSION_BC4_SNORM:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
+static uint32_t count_bits(uint32_t value)
+{
+    uint32_t count = 0;
+    for (; value != 0; value &= value - 1)
+    {
+        ++count;
+    }
+    return count;
+}
+
+bool dds_header_has_dx10(const uint8_t header[DDS_HEADER_SIZE])
+{
+    return (read_u32(header, HEADER_PIXEL_FORMAT_FLAGS) & DDPF_FOURCC) != 0
+        && read_u32(header, HEADER_FOURCC) == FOURCC('D', 'X', '1', '0');
+}
+
+ImgloadErrorCode dds_header_parse(const uint8_t header[DDS_HEADER_SIZE], const uint8_t* dx10,
+                                  DDSHeaderInfo* info_out)
+{
+    uint32_t flags = read_u32(header, HEADER_FLAGS);
+    uint32_t caps2 = read_u32(header, HEADER_CAPS2);
+
+    DDSHeaderInfo info;
+    info.width = read_u32(header, HEADER_WIDTH);
+    info.height = read_u32(header, HEADER_HEIGHT);
+    info.depth = 1;
+    info.subimages = 1;
+    info.mipmaps = 1;
+
+    if (dx10 != NULL)
+    {
+        info.compression = convert_dxgi_format(read_u32(dx10, DX10_FORMAT));
+        info.data_offset = DDS_MAGIC_SIZE + DDS_HEADER_SIZE + DDS_HEADER_DX10_SIZE;
+
+        if (read_u32(dx10, DX10_DIMENSION) == DDS_DIMENSION_TEXTURE3D)
+        {
+            info.depth = read_u32(header, HEADER_DEPTH);
+        }
+        else
+        {
+            uint32_t faces = (read_u32(dx10, DX10_MISC_FLAG) & DDS_RESOURCE_MISC_TEXTURECUBE) ? 6 : 1;
+            uint32_t array_size = read_u32(dx10, DX10_ARRAY_SIZE);
+            if (array_size == 0 || array_size > DDS_MAX_ARRAY_SIZE)
+            {
+                return IMGLOAD_ERR_FILE_INVALID;
+            }
+            info.subimages = array_size * faces;
+        }
+    }
+    else
+    {
+        if ((read_u32(header, HEADER_PIXEL_FORMAT_FLAGS) & DDPF_FOURCC) == 0)
+        {
+            return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+        }
+        info.compression = convert_fourcc(read_u32(header, HEADER_FOURCC));
+        info.data_offset = DDS_MAGIC_SIZE + DDS_HEADER_SIZE;
+
+        if ((caps2 & DDSCAPS2_VOLUME) && (flags & DDSD_DEPTH))
+        {
+            info.depth = read_u32(header, HEADER_DEPTH);
+        }
+        else if (caps2 & DDSCAPS2_CUBEMAP)
+        {
+            // Legacy cube maps only store the faces which are flagged
+            info.subimages = count_bits(caps2 & DDSCAPS2_CUBEMAP_FACES);
+        }
+    }
+
+    if (info.compression == IMGLOAD_COMPRESSION_NONE)
+    {
+        return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    }
+    info.block_bytes = block_bytes(info.compression);
+
+    if ((flags & DDSD_MIPMAPCOUNT) && read_u32(header, HEADER_MIPMAP_COUNT) > 1)
+    {
+        info.mipmaps = read_u32(header, HEADER_MIPMAP_COUNT);
+    }
+
+    // Every mipmap is at least one pixel large so the chain can't be longer than the bits of the dimensions
+    if (info.width == 0 || info.height == 0 || info.depth == 0 || info.subimages == 0 || info.mipmaps > 32
+        || info.width > DDS_MAX_DIMENSION || info.height > DDS_MAX_DIMENSION || info.depth > DDS_MAX_DIMENSION)
+    {
+        return IMGLOAD_ERR_FILE_INVALID;
+    }
+
+    *info_out = info;
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static size_t mipmap_dimension(uint32_t size, uint32_t mipmap)
+{
+    size >>= mipmap;
+    return size > 0 ? (size_t)size : 1;
+}
+
+void dds_header_mipmap(const DDSHeaderInfo* info, uint32_t mipmap, ImgloadImageData* data_out)
+{
+    data_out->width = mipmap_dimension(info->width, mipmap);
+    data_out->height = mipmap_dimension(info->height, mipmap);
+    data_out->depth = mipmap_dimension(info->depth, mipmap);
+
+    data_out->stride = 0; // stride isn't useful for compressed formats
+    data_out->data_size = ((data_out->width + 3) / 4) * ((data_out->height + 3) / 4) * data_out->depth
+        * info->block_bytes;
+    data_out->data = NULL;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <imageloader.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Parser for the DDS headers of block compressed formats. The plugin reads all block compressed files itself, these
+// are the files with the DX10 extension header and the legacy FourCC codes of DXT1 to DXT5, BC4 and BC5. Only
+// uncompressed files are left to libddsimg.
+
+#define DDS_HEADER_SIZE 124
+#define DDS_HEADER_DX10_SIZE 20
+
+/**
+ * @brief The layout of a block compressed DDS file
+ */
+typedef struct
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+
+    uint32_t subimages; //!< Array elements, every cube map counts as six subimages
+    uint32_t mipmaps;
+
+    ImgloadCompression compression;
+    size_t block_bytes;
+
+    size_t data_offset; //!< Offset of the first block from the beginning of the file
+} DDSHeaderInfo;
+
+/**
+ * @brief Checks if the header is followed by the DX10 extension header
+ * @param header The DDS_HEADER which follows the magic value
+ */
+bool dds_header_has_dx10(const uint8_t header[DDS_HEADER_SIZE]);
+
+/**
+ * @brief Parses the header of a DDS file
+ * @param header The DDS_HEADER which follows the magic value
+ * @param dx10 The extension header or @c NULL if the file has none
+ * @param info_out The layout of the file
+ * @return @c IMGLOAD_ERR_UNSUPPORTED_FORMAT if the file isn't block compressed
+ */
+ImgloadErrorCode dds_header_parse(const uint8_t header[DDS_HEADER_SIZE], const uint8_t* dx10,
+                                  DDSHeaderInfo* info_out);
+
+/**
+ * @brief Computes the dimensions and the size of a mipmap in the file
+ * @param data_out Receives everything except the data pointer
+ */
+void dds_header_mipmap(const DDSHeaderInfo* info, uint32_t mipmap, ImgloadImageData* data_out);
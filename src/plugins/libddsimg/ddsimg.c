@@ -1,10 +1,13 @@
 
 #include "ddsimg.h"
+#include "dds_header.h"
 
 #include <imageloader_plugin.h>
 
 #include <ddsimg/ddsimg.h>
 
+#include <stdio.h>
+
 static void* DDSIMG_CALLBACK plugin_realloc(void* ud, void* mem, size_t size)
 {
     ImgloadPlugin plugin = (ImgloadPlugin)ud;
@@ -52,45 +55,82 @@ static ImgloadErrorCode convert_error(DDSErrorCode err)
 }
 
 
-static void IMGLOAD_CALLBACK plugin_deinit(ImgloadPlugin plugin)
+/**
+ * @brief The plugin data of an image
+ * libddsimg contexts are not thread safe so every image gets its own context. This allows loading images from
+ * different threads using the same imageloader context. Block compressed files are read by the plugin itself and their
+ * blocks are decoded by the imageloader core, libddsimg only reads uncompressed files.
+ */
+typedef struct
+{
+    DDSContext* ctx;
+    DDSImage* image;
+
+    bool native; //!< The file is read without libddsimg
+    DDSHeaderInfo header;
+    uint8_t* blocks; //!< The blocks of all mipmaps of a native image if the file couldn't be mapped
+} DDSPluginImage;
+
+static ImgloadErrorCode dds_image_alloc(ImgloadPlugin plugin, ImgloadImage img, bool native,
+                                        DDSPluginImage** image_out)
 {
-    DDSContext* ctx = (DDSContext*)imgload_plugin_get_data(plugin);
-    if (ddsimg_context_free(&ctx) != DDSIMG_ERR_NO_ERROR)
+    DDSPluginImage* image = (DDSPluginImage*)imgload_plugin_image_alloc(img, sizeof(DDSPluginImage));
+    if (image == NULL)
     {
-        imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to deallocate libddsimg context!");
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
     }
-}
+    image->ctx = NULL;
+    image->image = NULL;
+    image->native = native;
+    image->blocks = NULL;
 
-static int IMGLOAD_CALLBACK plugin_probe(ImgloadPlugin plugin, ImgloadImage img)
-{
-    uint8_t magic[4];
-    if (imgload_plugin_image_read(img, magic, 4) != 4)
+    if (native)
     {
-        return 0;
+        *image_out = image;
+        return IMGLOAD_ERR_NO_ERROR;
     }
 
-    // Check for 'DDS ' magic header
-    if (magic[0] != 'D')
+    DDSMemoryFunctions mem_funcs;
+    mem_funcs.realloc = plugin_realloc;
+    mem_funcs.free = plugin_free;
+
+    DDSErrorCode err = ddsimg_context_alloc(&image->ctx, &mem_funcs, (void*)plugin);
+    if (err != DDSIMG_ERR_NO_ERROR)
     {
-        return 0;
+        imgload_plugin_image_dealloc(img, image);
+        return err == DDSIMG_ERR_OUT_OF_MEMORY ? IMGLOAD_ERR_OUT_OF_MEMORY : IMGLOAD_ERR_PLUGIN_ERROR;
     }
-    if (magic[1] != 'D')
+
+    *image_out = image;
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static ImgloadErrorCode dds_image_free(ImgloadPlugin plugin, ImgloadImage img, DDSPluginImage* image)
+{
+    ImgloadErrorCode result = IMGLOAD_ERR_NO_ERROR;
+
+    if (image->image != NULL && ddsimg_image_free(&image->image) != DDSIMG_ERR_NO_ERROR)
     {
-        return 0;
+        result = IMGLOAD_ERR_PLUGIN_ERROR;
     }
-    if (magic[2] != 'S')
+    if (image->ctx != NULL && ddsimg_context_free(&image->ctx) != DDSIMG_ERR_NO_ERROR)
     {
-        return 0;
+        imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to deallocate libddsimg context!");
+        result = IMGLOAD_ERR_PLUGIN_ERROR;
     }
-    if (magic[3] != ' ')
+
+    if (image->blocks != NULL)
     {
-        return 0;
+        imgload_plugin_free(plugin, image->blocks);
     }
+    imgload_plugin_image_dealloc(img, image);
 
-    // Right header present
-    return 1;
+    return result;
 }
 
+#define DDS_MAGIC_SIZE 4
+static const uint8_t DDS_MAGIC[DDS_MAGIC_SIZE] = { 'D', 'D', 'S', ' ' };
+
 static ImgloadCompression convert_compression(uint32_t dds_comp)
 {
     switch (dds_comp)
@@ -121,19 +161,262 @@ static ImgloadFormat convert_format(uint32_t dds_format)
     }
 }
 
+/**
+ * @brief Reads the header of a block compressed file
+ * @return @c IMGLOAD_ERR_UNSUPPORTED_FORMAT if the file isn't block compressed
+ */
+static ImgloadErrorCode native_read_header(ImgloadImage img, DDSHeaderInfo* info_out)
+{
+    uint8_t header[DDS_HEADER_SIZE];
+    uint8_t dx10[DDS_HEADER_DX10_SIZE];
+
+    imgload_plugin_image_seek(img, DDS_MAGIC_SIZE, SEEK_SET);
+    if (imgload_plugin_image_read(img, header, DDS_HEADER_SIZE) != DDS_HEADER_SIZE)
+    {
+        return IMGLOAD_ERR_FILE_INVALID;
+    }
+
+    bool has_dx10 = dds_header_has_dx10(header);
+    if (has_dx10 && imgload_plugin_image_read(img, dx10, DDS_HEADER_DX10_SIZE) != DDS_HEADER_DX10_SIZE)
+    {
+        return IMGLOAD_ERR_FILE_INVALID;
+    }
+
+    return dds_header_parse(header, has_dx10 ? dx10 : NULL, info_out);
+}
+
+static ImgloadErrorCode native_init_image(ImgloadPlugin plugin, ImgloadImage img, const DDSHeaderInfo* info)
+{
+    DDSPluginImage* image;
+    ImgloadErrorCode err = dds_image_alloc(plugin, img, true, &image);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
+    }
+    image->header = *info;
+
+    err = imgload_plugin_image_set_num_frames(img, (size_t)info->subimages);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to set number of subimages!");
+        dds_image_free(plugin, img, image);
+        return err;
+    }
+
+    // The core decodes the blocks to RGBA
+    imgload_plugin_image_set_data_type(img, IMGLOAD_FORMAT_R8G8B8A8, info->compression);
+
+    uint32_t width = info->width;
+    uint32_t height = info->height;
+    uint32_t depth = info->depth;
+    for (uint32_t i = 0; i < info->subimages; ++i)
+    {
+        imgload_plugin_image_set_property(img, (size_t)i, IMGLOAD_PROPERTY_WIDTH, IMGLOAD_PROPERTY_TYPE_UINT32, &width);
+        imgload_plugin_image_set_property(img, (size_t)i, IMGLOAD_PROPERTY_HEIGHT, IMGLOAD_PROPERTY_TYPE_UINT32, &height);
+        imgload_plugin_image_set_property(img, (size_t)i, IMGLOAD_PROPERTY_DEPTH, IMGLOAD_PROPERTY_TYPE_UINT32, &depth);
+
+        imgload_plugin_image_set_num_mipmaps(img, (size_t)i, (size_t)info->mipmaps);
+    }
+
+    imgload_plugin_image_set_data(img, (void*)image);
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static ImgloadErrorCode native_read_data(ImgloadPlugin plugin, ImgloadImage img, DDSPluginImage* image)
+{
+    const DDSHeaderInfo* info = &image->header;
+    if (image->blocks != NULL)
+    {
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    // Subimages are stored one after another, each with its complete mipmap chain
+    uint64_t chain_size = 0;
+    for (uint32_t j = 0; j < info->mipmaps; ++j)
+    {
+        ImgloadImageData data;
+        dds_header_mipmap(info, j, &data);
+        chain_size += data.data_size;
+    }
+    uint64_t total_size = chain_size * info->subimages;
+
+    int64_t file_size = imgload_plugin_image_size(img);
+    if (file_size >= 0 && info->data_offset + total_size > (uint64_t)file_size)
+    {
+        return IMGLOAD_ERR_FILE_INVALID;
+    }
+    if (total_size > SIZE_MAX)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    // All mipmaps reference either the mapped file or a single allocation, nothing is copied per mipmap
+    const uint8_t* blocks = imgload_plugin_image_map(img, info->data_offset, (size_t)total_size);
+    if (blocks == NULL)
+    {
+        image->blocks = (uint8_t*)imgload_plugin_realloc(plugin, NULL, (size_t)total_size);
+        if (image->blocks == NULL)
+        {
+            return IMGLOAD_ERR_OUT_OF_MEMORY;
+        }
+
+        imgload_plugin_image_seek(img, (int64_t)info->data_offset, SEEK_SET);
+        if (imgload_plugin_image_read(img, image->blocks, (size_t)total_size) != (size_t)total_size)
+        {
+            imgload_plugin_free(plugin, image->blocks);
+            image->blocks = NULL;
+            return IMGLOAD_ERR_FILE_INVALID;
+        }
+        blocks = image->blocks;
+    }
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < info->subimages; ++i)
+    {
+        for (uint32_t j = 0; j < info->mipmaps; ++j)
+        {
+            ImgloadImageData data;
+            dds_header_mipmap(info, j, &data);
+            data.data = (void*)(blocks + offset);
+            offset += data.data_size;
+
+            ImgloadErrorCode err = imgload_plugin_image_reference_compressed_data(img, (size_t)i, (size_t)j, &data);
+            if (err != IMGLOAD_ERR_NO_ERROR)
+            {
+                return err;
+            }
+        }
+    }
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static ImgloadErrorCode IMGLOAD_CALLBACK plugin_read_mipmaps(ImgloadPlugin plugin, ImgloadImage img, size_t subimage,
+                                                           size_t first_mipmap, size_t n_mipmaps)
+{
+    DDSPluginImage* image = (DDSPluginImage*)imgload_plugin_image_get_data(img);
+    if (!image->native)
+    {
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    // The offset of the mipmap follows from the sizes of the mipmap chains and mipmaps in front of it
+    const DDSHeaderInfo* info = &image->header;
+    uint64_t chain_size = 0;
+    uint64_t offset = info->data_offset;
+    for (uint32_t j = 0; j < info->mipmaps; ++j)
+    {
+        ImgloadImageData data;
+        dds_header_mipmap(info, j, &data);
+        chain_size += data.data_size;
+        offset += j < first_mipmap ? data.data_size : 0;
+    }
+    offset += chain_size * subimage;
+
+    int64_t file_size = imgload_plugin_image_size(img);
+    imgload_plugin_image_seek(img, (int64_t)offset, SEEK_SET);
+
+    for (size_t j = first_mipmap; j < first_mipmap + n_mipmaps; ++j)
+    {
+        ImgloadImageData data;
+        dds_header_mipmap(info, (uint32_t)j, &data);
+
+        if (file_size >= 0 && offset + data.data_size > (uint64_t)file_size)
+        {
+            return IMGLOAD_ERR_FILE_INVALID;
+        }
+
+        ImgloadErrorCode err;
+        const uint8_t* mapped = imgload_plugin_image_map(img, offset, data.data_size);
+        if (mapped != NULL)
+        {
+            data.data = (void*)mapped;
+            err = imgload_plugin_image_reference_compressed_data(img, subimage, j, &data);
+        }
+        else
+        {
+            data.data = imgload_plugin_realloc(plugin, NULL, data.data_size);
+            if (data.data == NULL)
+            {
+                return IMGLOAD_ERR_OUT_OF_MEMORY;
+            }
+            if (imgload_plugin_image_read(img, (uint8_t*)data.data, data.data_size) != data.data_size)
+            {
+                imgload_plugin_free(plugin, data.data);
+                return IMGLOAD_ERR_FILE_INVALID;
+            }
+            err = imgload_plugin_image_set_compressed_data(img, subimage, j, &data, 1);
+        }
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        offset += data.data_size;
+    }
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static ImgloadErrorCode IMGLOAD_CALLBACK plugin_image_info(ImgloadPlugin plugin, ImgloadImage img,
+                                                          ImgloadImageInfo* info_out)
+{
+    (void)plugin;
+
+    // Uncompressed files are left to libddsimg which needs a complete image for that
+    DDSHeaderInfo info;
+    ImgloadErrorCode err = native_read_header(img, &info);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err == IMGLOAD_ERR_UNSUPPORTED_FORMAT ? IMGLOAD_ERR_NO_DATA : err;
+    }
+
+    info_out->width = (size_t)info.width;
+    info_out->height = (size_t)info.height;
+    info_out->depth = (size_t)info.depth;
+    info_out->subimages = (size_t)info.subimages;
+    info_out->mipmaps = (size_t)info.mipmaps;
+    info_out->format = IMGLOAD_FORMAT_R8G8B8A8;
+    info_out->compression = info.compression;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
 static ImgloadErrorCode IMGLOAD_CALLBACK plugin_init_image(ImgloadPlugin plugin, ImgloadImage img)
 {
+    DDSHeaderInfo info;
+    ImgloadErrorCode header_err = native_read_header(img, &info);
+    if (header_err == IMGLOAD_ERR_NO_ERROR)
+    {
+        return native_init_image(plugin, img, &info);
+    }
+    if (header_err != IMGLOAD_ERR_UNSUPPORTED_FORMAT)
+    {
+        return header_err;
+    }
+
     DDSIOFunctions io;
     io.read = plugin_img_read;
     io.seek = plugin_img_seek;
 
-    DDSContext* ctx = (DDSContext*)imgload_plugin_get_data(plugin);
+    DDSPluginImage* image;
+    ImgloadErrorCode alloc_err = dds_image_alloc(plugin, img, false, &image);
+    if (alloc_err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return alloc_err;
+    }
 
-    DDSImage* dds_img = NULL;
-    DDSErrorCode err = ddsimg_image_alloc(ctx, &dds_img, &io, img);
+    // libddsimg reads the header from right after the magic value
+    imgload_plugin_image_seek(img, DDS_MAGIC_SIZE, SEEK_SET);
+
+    DDSErrorCode err = ddsimg_image_alloc(image->ctx, &image->image, &io, img);
 
     if (err != DDSIMG_ERR_NO_ERROR)
     {
+        image->image = NULL;
+        dds_image_free(plugin, img, image);
+
         switch (err)
         {
         case DDSIMG_ERR_OUT_OF_MEMORY:
@@ -143,10 +426,12 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_init_image(ImgloadPlugin plugin,
         }
     }
 
+    DDSImage* dds_img = image->image;
+
     err = ddsimg_image_read_header(dds_img);
     if (err != DDSIMG_ERR_NO_ERROR)
     {
-        ddsimg_image_free(&dds_img);
+        dds_image_free(plugin, img, image);
         return IMGLOAD_ERR_PLUGIN_ERROR;
     }
 
@@ -155,14 +440,14 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_init_image(ImgloadPlugin plugin,
     if (err != DDSIMG_ERR_NO_ERROR)
     {
         imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to get number if subimages of DDS image!");
-        ddsimg_image_free(&dds_img);
+        dds_image_free(plugin, img, image);
         return IMGLOAD_ERR_PLUGIN_ERROR;
     }
 
     if (imgload_plugin_image_set_num_frames(img, (size_t)subimages) != IMGLOAD_ERR_NO_ERROR)
     {
         imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to set number of subimages!");
-        ddsimg_image_free(&dds_img);
+        dds_image_free(plugin, img, image);
         return IMGLOAD_ERR_PLUGIN_ERROR;
     }
 
@@ -170,7 +455,7 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_init_image(ImgloadPlugin plugin,
     if (ddsimg_image_get_size(dds_img, &width, &height, &depth) != IMGLOAD_ERR_NO_ERROR)
     {
         imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to get image size!");
-        ddsimg_image_free(&dds_img);
+        dds_image_free(plugin, img, image);
         return IMGLOAD_ERR_PLUGIN_ERROR;
     }
 
@@ -192,14 +477,20 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_init_image(ImgloadPlugin plugin,
         imgload_plugin_image_set_num_mipmaps(img, (size_t)i, (size_t)mipmaps);
     }
 
-    imgload_plugin_image_set_data(img, (void*)dds_img);
+    imgload_plugin_image_set_data(img, (void*)image);
 
     return IMGLOAD_ERR_NO_ERROR;
 }
 
 static ImgloadErrorCode IMGLOAD_CALLBACK plugin_read_data(ImgloadPlugin plugin, ImgloadImage img)
 {
-    DDSImage* dds_img = (DDSImage*)imgload_plugin_image_get_data(img);
+    DDSPluginImage* image = (DDSPluginImage*)imgload_plugin_image_get_data(img);
+    if (image->native)
+    {
+        return native_read_data(plugin, img, image);
+    }
+
+    DDSImage* dds_img = image->image;
 
     DDSErrorCode err = ddsimg_image_read_data(dds_img);
 
@@ -213,7 +504,10 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_read_data(ImgloadPlugin plugin,
         return IMGLOAD_ERR_PLUGIN_ERROR;
     }
 
-    // Reading was successful
+    // Reading was successful. libddsimg keeps its buffers until the image is freed so in passthrough mode they are
+    // referenced instead of copied.
+    int passthrough = imgload_plugin_image_compressed_passthrough(img);
+
     uint32_t subimages, mipmaps;
     ddsimg_image_get_num_subimages(dds_img, &subimages);
     ddsimg_image_get_num_mipmaps(dds_img, &mipmaps);
@@ -236,7 +530,9 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_read_data(ImgloadPlugin plugin,
                 new_data.data_size = data.data_size;
                 new_data.data = data.data;
 
-                ImgloadErrorCode set_err = imgload_plugin_image_set_compressed_data(img, (size_t)i, (size_t)j, &new_data, 0);
+                ImgloadErrorCode set_err = passthrough
+                    ? imgload_plugin_image_reference_compressed_data(img, (size_t)i, (size_t)j, &new_data)
+                    : imgload_plugin_image_set_compressed_data(img, (size_t)i, (size_t)j, &new_data, 0);
 
                 if (set_err != IMGLOAD_ERR_NO_ERROR)
                 {
@@ -251,7 +547,14 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_read_data(ImgloadPlugin plugin,
 
 static ImgloadErrorCode IMGLOAD_CALLBACK plugin_decompress_data(ImgloadPlugin plugin, ImgloadImage img, size_t subimage, size_t mipmap)
 {
-    DDSImage* dds_img = imgload_plugin_image_get_data(img);
+    DDSPluginImage* image = (DDSPluginImage*)imgload_plugin_image_get_data(img);
+    if (image->native)
+    {
+        // The core decodes these formats, it only asks the plugin if the blocks are missing
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    DDSImage* dds_img = image->image;
 
     MipmapData data;
     DDSErrorCode err = ddsimg_image_get_decompressed_data(dds_img, (uint32_t)subimage, (uint32_t)mipmap, &data);
@@ -276,47 +579,29 @@ static ImgloadErrorCode IMGLOAD_CALLBACK plugin_decompress_data(ImgloadPlugin pl
 
 static ImgloadErrorCode IMGLOAD_CALLBACK plugin_deinit_image(ImgloadPlugin plugin, ImgloadImage img)
 {
-    DDSImage* dds_img = imgload_plugin_image_get_data(img);
-
-    if (ddsimg_image_free(&dds_img) != DDSIMG_ERR_NO_ERROR)
-    {
-        return IMGLOAD_ERR_PLUGIN_ERROR;
-    }
+    DDSPluginImage* image = (DDSPluginImage*)imgload_plugin_image_get_data(img);
 
-    return IMGLOAD_ERR_NO_ERROR;
+    return dds_image_free(plugin, img, image);
 }
 
 
 ImgloadErrorCode IMGLOAD_CALLBACK ddsimg_plugin_loader(ImgloadPlugin plugin, void* parameter)
 {
-    DDSContext* ctx;
-    DDSMemoryFunctions mem_funcs;
-    mem_funcs.realloc = plugin_realloc;
-    mem_funcs.free = plugin_free;
-
     imgload_plugin_set_info(plugin, "ddsimg", "libddsimg Plugin", "Parses DDS files using libddsimg");
 
-    DDSErrorCode err = ddsimg_context_alloc(&ctx, &mem_funcs, (void*)plugin);
-
-    if (err != DDSIMG_ERR_NO_ERROR)
+    // DDS files are identified by their magic value, a probe function is not needed
+    ImgloadErrorCode sig_err = imgload_plugin_register_signature(plugin, DDS_MAGIC, DDS_MAGIC_SIZE);
+    if (sig_err != IMGLOAD_ERR_NO_ERROR)
     {
-        if (err == DDSIMG_ERR_OUT_OF_MEMORY)
-        {
-            return IMGLOAD_ERR_OUT_OF_MEMORY;
-        }
-
-        return IMGLOAD_ERR_PLUGIN_ERROR;
+        return sig_err;
     }
 
-    imgload_plugin_set_data(plugin, (void*)ctx);
-
-    imgload_plugin_callback_deinit(plugin, plugin_deinit);
-    imgload_plugin_callback_probe(plugin, plugin_probe);
-
     imgload_plugin_callback_init_image(plugin, plugin_init_image);
+    imgload_plugin_callback_image_info(plugin, plugin_image_info);
     imgload_plugin_callback_deinit_image(plugin, plugin_deinit_image);
 
     imgload_plugin_callback_read_data(plugin, plugin_read_data);
+    imgload_plugin_callback_read_mipmaps(plugin, plugin_read_mipmaps);
     imgload_plugin_callback_decompress_data(plugin, plugin_decompress_data);
 
     return IMGLOAD_ERR_NO_ERROR;
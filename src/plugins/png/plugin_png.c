@@ -6,6 +6,7 @@
 #include <png.h>
 
 #include <inttypes.h>
+#include <string.h>
 
 // Parts of this code are based on this tutorial: http://www.piko3d.net/tutorials/libpng-tutorial-loading-png-files-from-streams/
 
@@ -13,6 +14,9 @@ typedef struct
 {
     png_structp png_ptr;
     png_infop info_ptr;
+
+    int64_t start; //!< The stream position of the file, decoding starts there again if rows are read out of order
+    png_uint_32 next_row; //!< The next row libpng will decode, the height once the whole image has been read
 } PNGPointers;
 
 #define png_error_occured(png_ptr) setjmp(png_jmpbuf(png_ptr)) != 0
@@ -49,7 +53,7 @@ static void png_error_fn(png_structp png_ptr, png_const_charp message)
 {
     ImgloadPlugin plugin = (ImgloadPlugin)png_get_error_ptr(png_ptr);
 
-    imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, message);
+    imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "%s", message);
     
     longjmp(png_jmpbuf(png_ptr), 1);
 }
@@ -58,24 +62,18 @@ static void png_warning_fn(png_structp png_ptr, png_const_charp message)
 {
     ImgloadPlugin plugin = (ImgloadPlugin)png_get_error_ptr(png_ptr);
 
-    imgload_plugin_log(plugin, IMGLOAD_LOG_WARNING, message);
+    IMGLOAD_PLUGIN_LOG(plugin, IMGLOAD_LOG_WARNING, "%s", message);
 }
 
 
 #define PNGSIGSIZE 8
-static int IMGLOAD_CALLBACK png_probe(ImgloadPlugin plugin, ImgloadImage img)
-{
-    png_byte pngsig[PNGSIGSIZE];
-
-    if (imgload_plugin_image_read(img, pngsig, PNGSIGSIZE) != PNGSIGSIZE)
-    {
-        return 0;
-    }
-
-    return png_sig_cmp(pngsig, 0, PNGSIGSIZE) == 0;
-}
+static const uint8_t PNG_SIGNATURE[PNGSIGSIZE] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
 
-static ImgloadErrorCode IMGLOAD_CALLBACK png_init_image(ImgloadPlugin plugin, ImgloadImage img)
+/**
+ * @brief Creates the libpng structures and reads the chunks in front of the image data
+ * The conversions applied to the image data are set up as well.
+ */
+static ImgloadErrorCode png_open(ImgloadPlugin plugin, ImgloadImage img, png_structp* png_out, png_infop* info_out)
 {
     png_structp png_ptr = png_create_read_struct_2(PNG_LIBPNG_VER_STRING, plugin, png_error_fn, png_warning_fn, plugin, png_malloc_fn, png_free_fn);
     if (png_ptr == NULL)
@@ -97,16 +95,11 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_init_image(ImgloadPlugin plugin, Im
         return IMGLOAD_ERR_PLUGIN_ERROR;
     }
 
+    // The stream is positioned at the start of the file so libpng checks the signature itself
     png_set_read_fn(png_ptr, img, png_user_read_data);
 
-    png_set_sig_bytes(png_ptr, PNGSIGSIZE);
-
     png_read_info(png_ptr, png_info);
 
-    // Info has been read
-    png_uint_32 img_width = png_get_image_width(png_ptr, png_info);
-    png_uint_32 img_height = png_get_image_height(png_ptr, png_info);
-
     png_uint_32 bitdepth = png_get_bit_depth(png_ptr, png_info);
     png_uint_32 color_type = png_get_color_type(png_ptr, png_info);
 
@@ -136,9 +129,57 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_init_image(ImgloadPlugin plugin, Im
     // Update the structure so we can use it later
     png_read_update_info(png_ptr, png_info);
 
-    bitdepth = png_get_bit_depth(png_ptr, png_info);
+    *png_out = png_ptr;
+    *info_out = png_info;
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+/**
+ * @brief Starts decoding from the beginning of the file again
+ * libpng can't go back in the stream so the structures are created again.
+ */
+static ImgloadErrorCode png_restart(ImgloadPlugin plugin, ImgloadImage img, PNGPointers* pointers)
+{
+    // The structures are gone if restarting failed before
+    if (pointers->png_ptr == NULL)
+    {
+        return IMGLOAD_ERR_PLUGIN_ERROR;
+    }
+
+    if (imgload_plugin_image_seek(img, pointers->start, SEEK_SET) != pointers->start)
+    {
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    png_destroy_read_struct(&pointers->png_ptr, &pointers->info_ptr, NULL);
+
+    ImgloadErrorCode err = png_open(plugin, img, &pointers->png_ptr, &pointers->info_ptr);
+    if (err == IMGLOAD_ERR_NO_ERROR)
+    {
+        pointers->next_row = 0;
+    }
+    return err;
+}
+
+static ImgloadErrorCode IMGLOAD_CALLBACK png_init_image(ImgloadPlugin plugin, ImgloadImage img)
+{
+    int64_t start = imgload_plugin_image_seek(img, 0, SEEK_CUR);
+
+    png_structp png_ptr;
+    png_infop png_info;
+    ImgloadErrorCode err = png_open(plugin, img, &png_ptr, &png_info);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
+    }
+
+    // Info has been read
+    png_uint_32 img_width = png_get_image_width(png_ptr, png_info);
+    png_uint_32 img_height = png_get_image_height(png_ptr, png_info);
+
+    png_uint_32 bitdepth = png_get_bit_depth(png_ptr, png_info);
     uint32_t channels = png_get_channels(png_ptr, png_info);
-    color_type = png_get_color_type(png_ptr, png_info);
+    png_uint_32 color_type = png_get_color_type(png_ptr, png_info);
 
     if (bitdepth != 8)
     {
@@ -183,7 +224,7 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_init_image(ImgloadPlugin plugin, Im
     uint32_t one = 1;
     imgload_plugin_image_set_property(img, 0, IMGLOAD_PROPERTY_DEPTH, IMGLOAD_PROPERTY_TYPE_UINT32, &one);
 
-    PNGPointers* pointers = (PNGPointers*)imgload_plugin_realloc(plugin, NULL, sizeof(PNGPointers));
+    PNGPointers* pointers = (PNGPointers*)imgload_plugin_image_alloc(img, sizeof(PNGPointers));
     if (pointers == NULL)
     {
         // Currently no other format is supported
@@ -193,6 +234,8 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_init_image(ImgloadPlugin plugin, Im
 
     pointers->png_ptr = png_ptr;
     pointers->info_ptr = png_info;
+    pointers->start = start;
+    pointers->next_row = 0;
 
     imgload_plugin_image_set_data(img, pointers);
     return IMGLOAD_ERR_NO_ERROR;
@@ -202,6 +245,16 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
 {
     PNGPointers* pointers = (PNGPointers*)imgload_plugin_image_get_data(img);
 
+    if (pointers->next_row != 0)
+    {
+        // Rows have already been decoded
+        ImgloadErrorCode err = png_restart(plugin, img, pointers);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+    }
+
     png_structp png_ptr = pointers->png_ptr;
     png_infop png_info = pointers->info_ptr;
 
@@ -210,7 +263,7 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
 
     //Here's one of the pointers we've defined in the error handler section:
     //Array of row pointers. One for every row.
-    png_bytepp rowPtrs = (png_bytepp)imgload_plugin_realloc(plugin, NULL, img_height * sizeof(png_bytep));
+    png_bytepp rowPtrs = (png_bytepp)imgload_plugin_image_alloc(img, img_height * sizeof(png_bytep));
     if (rowPtrs == NULL)
     {
         return IMGLOAD_ERR_OUT_OF_MEMORY;
@@ -224,7 +277,7 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
     png_byte* data = (png_byte*)imgload_plugin_realloc(plugin, NULL, total_size);
     if (data == NULL)
     {
-        imgload_plugin_free(plugin, rowPtrs);
+        imgload_plugin_image_dealloc(img, rowPtrs);
         return IMGLOAD_ERR_OUT_OF_MEMORY;
     }
 
@@ -239,7 +292,7 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
     if (png_error_occured(png_ptr))
     {
         // Something went wrong, PANIC!!!
-        imgload_plugin_free(plugin, rowPtrs);
+        imgload_plugin_image_dealloc(img, rowPtrs);
         imgload_plugin_free(plugin, data);
 
         return IMGLOAD_ERR_PLUGIN_ERROR;
@@ -249,6 +302,7 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
     //Read the imagedata and write it to the adresses pointed to
     //by rowptrs (in other words: our image databuffer)
     png_read_image(png_ptr, rowPtrs);
+    pointers->next_row = img_height;
 
     // Everything should be fine here, now set the data and go home
     ImgloadImageData img_data;
@@ -264,17 +318,165 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
     ImgloadErrorCode err = imgload_plugin_image_set_image_data(img, 0, 0, &img_data, 1);
 
     // The row pointers aren't needed anymore
-    imgload_plugin_free(plugin, rowPtrs);
+    imgload_plugin_image_dealloc(img, rowPtrs);
 
     return err;
 }
 
+static ImgloadErrorCode IMGLOAD_CALLBACK png_stream_rows(ImgloadPlugin plugin, ImgloadImage img, size_t subimage,
+                                                         size_t mipmap, size_t first_row, size_t n_rows, uint8_t* dst,
+                                                         size_t dst_stride)
+{
+    PNGPointers* pointers = (PNGPointers*)imgload_plugin_image_get_data(img);
+
+    if (subimage != 0 || mipmap != 0)
+    {
+        return IMGLOAD_ERR_OUT_OF_RANGE;
+    }
+
+    if (pointers->png_ptr == NULL)
+    {
+        return IMGLOAD_ERR_PLUGIN_ERROR;
+    }
+
+    // Interlaced images need multiple passes over the whole image, they are decoded completely instead
+    if (png_get_interlace_type(pointers->png_ptr, pointers->info_ptr) != PNG_INTERLACE_NONE)
+    {
+        return IMGLOAD_ERR_NO_DATA;
+    }
+
+    if (first_row + n_rows > png_get_image_height(pointers->png_ptr, pointers->info_ptr))
+    {
+        return IMGLOAD_ERR_OUT_OF_RANGE;
+    }
+
+    if (first_row < pointers->next_row)
+    {
+        ImgloadErrorCode err = png_restart(plugin, img, pointers);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+    }
+
+    png_structp png_ptr = pointers->png_ptr;
+
+    if (png_error_occured(png_ptr))
+    {
+        return IMGLOAD_ERR_PLUGIN_ERROR;
+    }
+
+    // Rows before the requested range still have to be decoded but they don't need to be stored
+    while (pointers->next_row < first_row)
+    {
+        png_read_row(png_ptr, NULL, NULL);
+        ++pointers->next_row;
+    }
+
+    for (size_t i = 0; i < n_rows; ++i)
+    {
+        png_read_row(png_ptr, dst + i * dst_stride, NULL);
+        ++pointers->next_row;
+    }
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static png_uint_32 png_read_u32(const uint8_t* data)
+{
+    return (png_uint_32)data[0] << 24 | (png_uint_32)data[1] << 16 | (png_uint_32)data[2] << 8 | data[3];
+}
+
+/**
+ * @brief Reads the metadata from the chunks in front of the image data without libpng
+ */
+static ImgloadErrorCode IMGLOAD_CALLBACK png_image_info(ImgloadPlugin plugin, ImgloadImage img,
+                                                        ImgloadImageInfo* info_out)
+{
+    (void)plugin;
+
+    // The signature is followed by the IHDR chunk: length, type, width, height, bit depth and color type
+    uint8_t header[PNGSIGSIZE + 18];
+    if (imgload_plugin_image_read(img, header, sizeof(header)) != sizeof(header)
+        || memcmp(header + PNGSIGSIZE + 4, "IHDR", 4) != 0)
+    {
+        return IMGLOAD_ERR_FILE_INVALID;
+    }
+
+    png_uint_32 width = png_read_u32(header + PNGSIGSIZE + 8);
+    png_uint_32 height = png_read_u32(header + PNGSIGSIZE + 12);
+    uint8_t bitdepth = header[PNGSIGSIZE + 16];
+    uint8_t color_type = header[PNGSIGSIZE + 17];
+
+    // The init function expands transparency to an alpha channel so the other chunks up to the image data matter
+    int transparency = 0;
+    int64_t chunk_start = PNGSIGSIZE + 8 + (int64_t)png_read_u32(header + PNGSIGSIZE) + 4;
+    if (color_type != PNG_COLOR_TYPE_RGBA && color_type != PNG_COLOR_TYPE_GRAY_ALPHA)
+    {
+        while (1)
+        {
+            uint8_t chunk[8];
+            if (imgload_plugin_image_seek(img, chunk_start, SEEK_SET) != chunk_start
+                || imgload_plugin_image_read(img, chunk, sizeof(chunk)) != sizeof(chunk))
+            {
+                return IMGLOAD_ERR_FILE_INVALID;
+            }
+
+            if (memcmp(chunk + 4, "tRNS", 4) == 0)
+            {
+                transparency = 1;
+                break;
+            }
+            if (memcmp(chunk + 4, "IDAT", 4) == 0 || memcmp(chunk + 4, "IEND", 4) == 0)
+            {
+                break;
+            }
+
+            chunk_start += 8 + (int64_t)png_read_u32(chunk) + 4;
+        }
+    }
+
+    // Same conversions as in png_init_image, 16 bit is stripped and palettes and small gray values are expanded
+    ImgloadFormat format;
+    if (bitdepth != 1 && bitdepth != 2 && bitdepth != 4 && bitdepth != 8 && bitdepth != 16)
+    {
+        return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    }
+    else if (color_type == PNG_COLOR_TYPE_RGBA
+        || (transparency && (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_PALETTE)))
+    {
+        format = IMGLOAD_FORMAT_R8G8B8A8;
+    }
+    else if (color_type == PNG_COLOR_TYPE_RGB || color_type == PNG_COLOR_TYPE_PALETTE)
+    {
+        format = IMGLOAD_FORMAT_R8G8B8;
+    }
+    else if (color_type == PNG_COLOR_TYPE_GRAY && !transparency)
+    {
+        format = IMGLOAD_FORMAT_GRAY8;
+    }
+    else
+    {
+        return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    }
+
+    info_out->width = (size_t)width;
+    info_out->height = (size_t)height;
+    info_out->depth = 1;
+    info_out->subimages = 1;
+    info_out->mipmaps = 1;
+    info_out->format = format;
+    info_out->compression = IMGLOAD_COMPRESSION_NONE;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
 static ImgloadErrorCode IMGLOAD_CALLBACK png_deinit_image(ImgloadPlugin plugin, ImgloadImage img)
 {
     PNGPointers* pointers = (PNGPointers*)imgload_plugin_image_get_data(img);
 
     png_destroy_read_struct(&pointers->png_ptr, &pointers->info_ptr, NULL);
-    imgload_plugin_free(plugin, pointers);
+    imgload_plugin_image_dealloc(img, pointers);
 
     return IMGLOAD_ERR_NO_ERROR;
 }
@@ -283,12 +485,19 @@ ImgloadErrorCode IMGLOAD_CALLBACK png_plugin_loader(ImgloadPlugin plugin, void*
 {
     imgload_plugin_set_info(plugin, "png", "libPNG plugin", "Loads PNG files using libpng");
 
-    imgload_plugin_callback_probe(plugin, png_probe);
+    // The signature is all that is needed for identifying PNG files so no probe function is necessary
+    ImgloadErrorCode err = imgload_plugin_register_signature(plugin, PNG_SIGNATURE, PNGSIGSIZE);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        return err;
+    }
 
     imgload_plugin_callback_init_image(plugin, png_init_image);
     imgload_plugin_callback_deinit_image(plugin, png_deinit_image);
+    imgload_plugin_callback_image_info(plugin, png_image_info);
 
     imgload_plugin_callback_read_data(plugin, png_read_data);
+    imgload_plugin_callback_read_rows(plugin, png_stream_rows);
 
     return IMGLOAD_ERR_NO_ERROR;
 }
\ No newline at end of file
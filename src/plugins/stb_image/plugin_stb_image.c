@@ -8,70 +8,534 @@
 #define STBI_NO_STDIO
 #include "stb_image.h"
 
+#include "stb_allocator.h"
+
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
-static int stb_read(void* user, char* data, int size)
+#if defined(_MSC_VER)
+#define STB_THREAD_LOCAL __declspec(thread)
+#else
+#define STB_THREAD_LOCAL __thread
+#endif
+
+static STB_THREAD_LOCAL ImgloadPlugin current_plugin = NULL;
+
+ImgloadPlugin stb_allocator_set(ImgloadPlugin plugin)
 {
-    ImgloadImage img = (ImgloadImage)user;
-    
-    return (int)imgload_plugin_image_read(img, (uint8_t*)data, (size_t)size);
+    ImgloadPlugin previous = current_plugin;
+    current_plugin = plugin;
+
+    return previous;
 }
 
-static void stb_skip(void* user, int n)
+void* stb_allocator_malloc(size_t size)
 {
-    ImgloadImage img = (ImgloadImage)user;
+    if (current_plugin == NULL)
+    {
+        return malloc(size);
+    }
 
-    imgload_plugin_image_seek(img, (int)n, SEEK_CUR);
+    return imgload_plugin_realloc(current_plugin, NULL, size);
 }
 
-static int stb_eof(void* user)
+void* stb_allocator_realloc(void* ptr, size_t size)
 {
-    ImgloadImage img = (ImgloadImage)user;
+    if (current_plugin == NULL)
+    {
+        return realloc(ptr, size);
+    }
 
-    // Save the current position
-    int64_t curr = imgload_plugin_image_seek(img, 0, SEEK_CUR);
+    return imgload_plugin_realloc(current_plugin, ptr, size);
+}
 
-    int64_t end = imgload_plugin_image_seek(img, 0, SEEK_END);
+void stb_allocator_free(void* ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
 
-    int eof = curr >= end;
+    if (current_plugin == NULL)
+    {
+        free(ptr);
+        return;
+    }
+
+    imgload_plugin_free(current_plugin, ptr);
+}
+
+/**
+ * @brief State for reading an image through the stb_image callbacks
+ * The position is tracked here so that the end of the stream can be detected without seeking on every check.
+ */
+typedef struct
+{
+    ImgloadImage img;
+
+    int64_t position;
+    int64_t size; //!< Negative until it is needed for the first time
 
-    // Restore previous position
-    imgload_plugin_image_seek(img, curr, SEEK_SET);
+    ImgloadPlugin plugin; //!< Set if the stream keeps everything it reads in the buffer
+    uint8_t* buffer; //!< The first position bytes of the stream, owned by the caller afterwards
+    size_t capacity;
+    int failed; //!< The buffer couldn't be grown
+} StbStream;
 
-    return eof;
+static void stb_stream_init(StbStream* stream, ImgloadImage img)
+{
+    stream->img = img;
+    stream->position = 0;
+    stream->size = -1;
+
+    stream->plugin = NULL;
+    stream->buffer = NULL;
+    stream->capacity = 0;
+    stream->failed = 0;
 }
 
-static int IMGLOAD_CALLBACK stb_image_probe(ImgloadPlugin plugin, ImgloadImage img)
+/**
+ * @brief Makes room for the next bytes of a stream which keeps what it reads
+ * @return Where the bytes go or NULL if the buffer couldn't be grown
+ */
+static uint8_t* stb_stream_reserve(StbStream* stream, size_t size)
+{
+    size_t length = (size_t)stream->position;
+    if (length + size > stream->capacity)
+    {
+        size_t capacity = stream->capacity == 0 ? 1024 : stream->capacity;
+        while (capacity < length + size)
+        {
+            capacity *= 2;
+        }
+
+        uint8_t* buffer = NULL;
+        if (capacity <= INT_MAX)
+        {
+            buffer = (uint8_t*)imgload_plugin_realloc(stream->plugin, stream->buffer, capacity);
+        }
+        if (buffer == NULL)
+        {
+            stream->failed = 1;
+            return NULL;
+        }
+
+        stream->buffer = buffer;
+        stream->capacity = capacity;
+    }
+
+    return stream->buffer + length;
+}
+
+static int stb_read(void* user, char* data, int size)
+{
+    StbStream* stream = (StbStream*)user;
+
+    if (stream->plugin == NULL)
+    {
+        size_t read = imgload_plugin_image_read(stream->img, (uint8_t*)data, (size_t)size);
+        stream->position += (int64_t)read;
+
+        return (int)read;
+    }
+
+    uint8_t* kept = stb_stream_reserve(stream, (size_t)size);
+    if (kept == NULL)
+    {
+        return 0;
+    }
+
+    size_t read = imgload_plugin_image_read(stream->img, kept, (size_t)size);
+    memcpy(data, kept, read);
+    stream->position += (int64_t)read;
+
+    return (int)read;
+}
+
+static void stb_skip(void* user, int n)
+{
+    StbStream* stream = (StbStream*)user;
+
+    if (stream->plugin == NULL)
+    {
+        stream->position = imgload_plugin_image_seek(stream->img, (int64_t)n, SEEK_CUR);
+        return;
+    }
+
+    // Skipped bytes are part of the file which is decoded later so they are read like everything else
+    uint8_t* kept = stb_stream_reserve(stream, (size_t)n);
+    if (kept != NULL)
+    {
+        stream->position += (int64_t)imgload_plugin_image_read(stream->img, kept, (size_t)n);
+    }
+}
+
+static int stb_eof(void* user)
+{
+    StbStream* stream = (StbStream*)user;
+
+    if (stream->size < 0)
+    {
+        stream->size = imgload_plugin_image_size(stream->img);
+    }
+
+    return stream->position >= stream->size;
+}
+
+static stbi_io_callbacks stb_callbacks(void)
 {
     stbi_io_callbacks callbacks;
     callbacks.read = stb_read;
     callbacks.skip = stb_skip;
     callbacks.eof = stb_eof;
 
+    return callbacks;
+}
+
+/**
+ * @brief Gets the complete file if the image is backed by memory
+ * @return The file contents or NULL if the image has to be read through the stream functions
+ */
+static const stbi_uc* stb_map_file(ImgloadImage img, int* length_out)
+{
+    // Mapping an empty range is a cheap check if the image supports mapping at all
+    if (imgload_plugin_image_map(img, 0, 0) == NULL)
+    {
+        return NULL;
+    }
+
+    int64_t size = imgload_plugin_image_size(img);
+    if (size <= 0 || size > INT_MAX)
+    {
+        return NULL;
+    }
+
+    *length_out = (int)size;
+    return imgload_plugin_image_map(img, 0, (size_t)size);
+}
+
+/**
+ * @brief Per image state of the plugin
+ * Init only reads the header of a stream and keeps it, the rest of the file is read once when the image is decoded.
+ */
+typedef struct
+{
+    uint8_t* buffer; //!< The bytes read from the stream, owned by the plugin. Only the header until the file is loaded
+    const stbi_uc* file; //!< The complete file, NULL until it is loaded
+    int length; //!< The size of the file or of the header in the buffer
+} StbImage;
+
+/**
+ * @brief Appends the remaining stream to the buffer if the size of the file is unknown
+ */
+static ImgloadErrorCode stb_read_unknown_size(ImgloadPlugin plugin, ImgloadImage img, StbImage* image)
+{
+    size_t length = (size_t)image->length;
+    size_t capacity = length;
+
+    while (1)
+    {
+        if (length == capacity)
+        {
+            size_t new_capacity = capacity < 64 * 1024 ? 64 * 1024 : capacity * 2;
+            if (new_capacity > INT_MAX)
+            {
+                return IMGLOAD_ERR_OUT_OF_MEMORY;
+            }
+
+            uint8_t* new_buffer = (uint8_t*)imgload_plugin_realloc(plugin, image->buffer, new_capacity);
+            if (new_buffer == NULL)
+            {
+                return IMGLOAD_ERR_OUT_OF_MEMORY;
+            }
+
+            image->buffer = new_buffer;
+            capacity = new_capacity;
+        }
+
+        size_t read = imgload_plugin_image_read(img, image->buffer + length, capacity - length);
+        if (read == 0)
+        {
+            break;
+        }
+
+        length += read;
+    }
+
+    image->length = (int)length;
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+/**
+ * @brief Makes the complete file available in memory, either mapped or read from the stream
+ * The header kept by init is reused so every byte of a stream is only read once.
+ */
+static ImgloadErrorCode stb_load_file(ImgloadPlugin plugin, ImgloadImage img, StbImage* image)
+{
+    if (image->buffer == NULL)
+    {
+        image->file = stb_map_file(img, &image->length);
+        if (image->file != NULL)
+        {
+            return IMGLOAD_ERR_NO_ERROR;
+        }
+
+        image->length = 0;
+    }
+
+    size_t kept = (size_t)image->length;
+    imgload_plugin_image_seek(img, (int64_t)kept, SEEK_SET);
+
+    int64_t size = imgload_plugin_image_size(img);
+    if (size > INT_MAX)
+    {
+        return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    }
+
+    if (size < 0)
+    {
+        ImgloadErrorCode err = stb_read_unknown_size(plugin, img, image);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+    }
+    else
+    {
+        // Allocate at least one byte so an empty file doesn't look like an allocation failure
+        size_t total = (size_t)size > kept ? (size_t)size : kept;
+        uint8_t* buffer = (uint8_t*)imgload_plugin_realloc(plugin, image->buffer, total > 0 ? total : 1);
+        if (buffer == NULL)
+        {
+            return IMGLOAD_ERR_OUT_OF_MEMORY;
+        }
+
+        image->buffer = buffer;
+        image->length = (int)(kept + imgload_plugin_image_read(img, buffer + kept, total - kept));
+    }
+
+    image->file = image->buffer;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static void stb_release_file(ImgloadPlugin plugin, StbImage* image)
+{
+    if (image->buffer != NULL)
+    {
+        imgload_plugin_free(plugin, image->buffer);
+    }
+
+    image->buffer = NULL;
+    image->file = NULL;
+    image->length = 0;
+}
+
+static int header_starts_with(const uint8_t* header, size_t size, const char* magic, size_t magic_size)
+{
+    return size >= magic_size && memcmp(header, magic, magic_size) == 0;
+}
+
+/**
+ * @brief Cheap version of the TGA test stb_image does, TGA files have no magic value
+ */
+static int header_maybe_tga(const uint8_t* header, size_t size)
+{
+    if (size < 17)
+    {
+        return 0;
+    }
+
+    uint8_t color_type = header[1];
+    if (color_type > 1)
+    {
+        return 0;
+    }
+
+    uint8_t image_type = header[2];
+    if (image_type != 1 && image_type != 2 && image_type != 3 && image_type != 9 && image_type != 10 && image_type != 11)
+    {
+        return 0;
+    }
+
+    uint32_t width = (uint32_t)header[12] << 8 | header[13];
+    uint32_t height = (uint32_t)header[14] << 8 | header[15];
+    if (width < 1 || height < 1)
+    {
+        return 0;
+    }
+
+    uint8_t bpp = header[16];
+    return bpp == 8 || bpp == 16 || bpp == 24 || bpp == 32;
+}
+
+static ImgloadProbeResult IMGLOAD_CALLBACK stb_image_probe_header(ImgloadPlugin plugin, const uint8_t* header, size_t size)
+{
+    // Formats with a strong magic value are handled by the registered signatures. These formats have weak magic
+    // values so stb_image has to take a closer look
+    if (!header_starts_with(header, size, "BM", 2)
+        && !header_starts_with(header, size, "P5", 2)
+        && !header_starts_with(header, size, "P6", 2)
+        && !header_starts_with(header, size, "\x53\x80\xF6\x34", 4)
+        && !header_maybe_tga(header, size))
+    {
+        return IMGLOAD_PROBE_NO;
+    }
+
+    // The info of these formats is stored at the start of the file so it can usually be read from the header alone
     int width, height, components;
 
-    int ret = stbi_info_from_callbacks(&callbacks, img, &width, &height, &components);
+    ImgloadPlugin previous = stb_allocator_set(plugin);
+    int ret = stbi_info_from_memory(header, (int)size, &width, &height, &components);
+    stb_allocator_set(previous);
+
+    // PNM headers may continue after the header with any amount of whitespace, stb_image then reports no size
+    if (ret && width > 0 && height > 0)
+    {
+        return IMGLOAD_PROBE_YES;
+    }
+
+    // A header shorter than the maximum is the complete file so reading the stream wouldn't help
+    return size < IMGLOAD_PLUGIN_HEADER_SIZE ? IMGLOAD_PROBE_NO : IMGLOAD_PROBE_UNKNOWN;
+}
+
+static int IMGLOAD_CALLBACK stb_image_probe(ImgloadPlugin plugin, ImgloadImage img)
+{
+    int width, height, components;
+
+    // Only reached if the header wasn't enough, read only as much as stb_image needs for the info
+    StbStream stream;
+    stb_stream_init(&stream, img);
+
+    stbi_io_callbacks callbacks = stb_callbacks();
+
+    ImgloadPlugin previous = stb_allocator_set(plugin);
+    int ret = stbi_info_from_callbacks(&callbacks, &stream, &width, &height, &components);
+    stb_allocator_set(previous);
 
     return ret != 0;
 }
 
-static ImgloadErrorCode IMGLOAD_CALLBACK stb_image_init_image(ImgloadPlugin plugin, ImgloadImage img)
+static int stb_convert_format(int components, ImgloadFormat* format_out)
 {
-    stbi_io_callbacks callbacks;
-    callbacks.read = stb_read;
-    callbacks.skip = stb_skip;
-    callbacks.eof = stb_eof;
+    switch(components)
+    {
+    case STBI_grey:
+        *format_out = IMGLOAD_FORMAT_GRAY8;
+        return 1;
+    case STBI_rgb:
+        *format_out = IMGLOAD_FORMAT_R8G8B8;
+        return 1;
+    case STBI_rgb_alpha:
+        *format_out = IMGLOAD_FORMAT_R8G8B8A8;
+        return 1;
+    default:
+        return 0;
+    }
+}
 
+static ImgloadErrorCode IMGLOAD_CALLBACK stb_image_info(ImgloadPlugin plugin, ImgloadImage img,
+                                                        ImgloadImageInfo* info_out)
+{
     int width, height, components;
 
+    // stb_image only reads the header through the stream, the file isn't loaded like for initializing the image. A
+    // stream probe may have left the stream anywhere
     imgload_plugin_image_seek(img, 0, SEEK_SET);
 
-    int ret = stbi_info_from_callbacks(&callbacks, img, &width, &height, &components);
+    StbStream stream;
+    stb_stream_init(&stream, img);
 
-    if (!ret)
+    stbi_io_callbacks callbacks = stb_callbacks();
+
+    ImgloadPlugin previous = stb_allocator_set(plugin);
+    int ret = stbi_info_from_callbacks(&callbacks, &stream, &width, &height, &components);
+    stb_allocator_set(previous);
+
+    ImgloadFormat format;
+    if (!ret || !stb_convert_format(components, &format))
     {
-        return IMGLOAD_ERR_PLUGIN_ERROR;
+        return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+    }
+
+    info_out->width = (size_t)width;
+    info_out->height = (size_t)height;
+    info_out->depth = 1;
+    info_out->subimages = 1;
+    info_out->mipmaps = 1;
+    info_out->format = format;
+    info_out->compression = IMGLOAD_COMPRESSION_NONE;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+/**
+ * @brief Reads the image info without loading the file
+ * Mapped files are parsed in place, streams are only read as far as stb_image needs for the info. The bytes read from
+ * a stream are kept in the buffer of the image for loading the file later.
+ */
+static ImgloadErrorCode stb_read_info(ImgloadPlugin plugin, ImgloadImage img, StbImage* image, int* width,
+                                      int* height, int* components)
+{
+    ImgloadPlugin previous = stb_allocator_set(plugin);
+
+    int ret;
+    image->buffer = NULL;
+    image->file = stb_map_file(img, &image->length);
+    if (image->file != NULL)
+    {
+        ret = stbi_info_from_memory(image->file, image->length, width, height, components);
+    }
+    else
+    {
+        imgload_plugin_image_seek(img, 0, SEEK_SET);
+
+        StbStream stream;
+        stb_stream_init(&stream, img);
+        stream.plugin = plugin;
+
+        stbi_io_callbacks callbacks = stb_callbacks();
+        ret = stbi_info_from_callbacks(&callbacks, &stream, width, height, components);
+
+        image->buffer = stream.buffer;
+        image->length = (int)stream.position;
+
+        if (stream.failed)
+        {
+            stb_allocator_set(previous);
+            return IMGLOAD_ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    stb_allocator_set(previous);
+    return ret ? IMGLOAD_ERR_NO_ERROR : IMGLOAD_ERR_UNSUPPORTED_FORMAT;
+}
+
+static ImgloadErrorCode IMGLOAD_CALLBACK stb_image_init_image(ImgloadPlugin plugin, ImgloadImage img)
+{
+    int width, height, components;
+
+    StbImage* image = (StbImage*)imgload_plugin_image_alloc(img, sizeof(StbImage));
+    if (image == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    // Users which only need the header don't pay for reading the whole file, that is deferred to stb_image_read_data
+    ImgloadErrorCode err = stb_read_info(plugin, img, image, &width, &height, &components);
+    if (err != IMGLOAD_ERR_NO_ERROR)
+    {
+        // The signatures only check for magic values so the format may still be unsupported by stb_image
+        if (err == IMGLOAD_ERR_UNSUPPORTED_FORMAT)
+        {
+            imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to read image info: %s", stbi_failure_reason());
+        }
+
+        stb_release_file(plugin, image);
+        imgload_plugin_image_dealloc(img, image);
+        return err;
     }
 
     imgload_plugin_image_set_num_frames(img, 1);
@@ -88,40 +552,47 @@ static ImgloadErrorCode IMGLOAD_CALLBACK stb_image_init_image(ImgloadPlugin plug
     imgload_plugin_image_set_property(img, 0, IMGLOAD_PROPERTY_DEPTH, IMGLOAD_PROPERTY_TYPE_UINT32, &one);
 
     ImgloadFormat format;
-    switch(components)
+    if (!stb_convert_format(components, &format))
     {
-    case STBI_grey:
-        format = IMGLOAD_FORMAT_GRAY8;
-        break;
-    case STBI_rgb:
-        format = IMGLOAD_FORMAT_R8G8B8;
-        break;
-    case STBI_rgb_alpha:
-        format = IMGLOAD_FORMAT_R8G8B8A8;
-        break;
-    default:
+        stb_release_file(plugin, image);
+        imgload_plugin_image_dealloc(img, image);
         return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
     }
     imgload_plugin_image_set_data_type(img, format, IMGLOAD_COMPRESSION_NONE);
 
+    imgload_plugin_image_set_data(img, image);
+
     return IMGLOAD_ERR_NO_ERROR;
 }
 
-static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, ImgloadImage img)
+static ImgloadErrorCode IMGLOAD_CALLBACK stb_image_read_data(ImgloadPlugin plugin, ImgloadImage img)
 {
-    stbi_io_callbacks callbacks;
-    callbacks.read = stb_read;
-    callbacks.skip = stb_skip;
-    callbacks.eof = stb_eof;
+    int width, height, components;
+    stbi_uc* ret;
 
+    StbImage* image = (StbImage*)imgload_plugin_image_get_data(img);
 
-    imgload_plugin_image_seek(img, 0, SEEK_SET);
+    if (image->file == NULL)
+    {
+        // Streams are only read completely for decoding, the file is also released after an earlier read
+        ImgloadErrorCode err = stb_load_file(plugin, img, image);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+    }
 
-    int width, height, components;
-    stbi_uc* ret = stbi_load_from_callbacks(&callbacks, img, &width, &height, &components, STBI_default);
+    // stb_image allocates the image using the allocator of the plugin so the memory can be handed over without a copy
+    ImgloadPlugin previous = stb_allocator_set(plugin);
+    ret = stbi_load_from_memory(image->file, image->length, &width, &height, &components, STBI_default);
+    stb_allocator_set(previous);
+
+    // The file contents are not needed anymore after decoding
+    stb_release_file(plugin, image);
 
     if (!ret)
     {
+        imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "Failed to decode image: %s", stbi_failure_reason());
         return IMGLOAD_ERR_PLUGIN_ERROR;
     }
 
@@ -138,24 +609,13 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
         bpp = 4;
         break;
     default:
+        imgload_plugin_free(plugin, ret);
         return IMGLOAD_ERR_UNSUPPORTED_FORMAT;
     }
 
     size_t stride = width * bpp;
     size_t total_size = height * stride;
 
-    uint8_t* buffer = (uint8_t*)imgload_plugin_realloc(plugin, NULL, total_size);
-    if (!buffer)
-    {
-        stbi_image_free(ret);
-        return IMGLOAD_ERR_OUT_OF_MEMORY;
-    }
-
-    // Copy data to our buffer
-    memcpy(buffer, ret, total_size);
-
-    stbi_image_free(ret);
-
     ImgloadImageData data;
     data.width = width;
     data.height = height;
@@ -163,19 +623,57 @@ static ImgloadErrorCode IMGLOAD_CALLBACK png_read_data(ImgloadPlugin plugin, Img
 
     data.stride = stride;
     data.data_size = total_size;
-    data.data = buffer;
+    data.data = ret;
 
     return imgload_plugin_image_set_image_data(img, 0, 0, &data, 1);
 }
 
+static ImgloadErrorCode IMGLOAD_CALLBACK stb_image_deinit_image(ImgloadPlugin plugin, ImgloadImage img)
+{
+    StbImage* image = (StbImage*)imgload_plugin_image_get_data(img);
+
+    if (image != NULL)
+    {
+        stb_release_file(plugin, image);
+        imgload_plugin_image_dealloc(img, image);
+    }
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+static const struct
+{
+    const char* bytes;
+    size_t size;
+} STB_SIGNATURES[] = {
+    { "\xFF\xD8\xFF", 3 }, // JPEG
+    { "\x89PNG\r\n\x1A\n", 8 }, // PNG
+    { "GIF87a", 6 },
+    { "GIF89a", 6 },
+    { "8BPS", 4 }, // PSD
+};
+
 ImgloadErrorCode IMGLOAD_CALLBACK stb_image_plugin_loader(ImgloadPlugin plugin, void* parameter)
 {
     imgload_plugin_set_info(plugin, "stb_image", "stb_image Plugin", "Loads images using stb_image");
 
+    for (size_t i = 0; i < sizeof(STB_SIGNATURES) / sizeof(STB_SIGNATURES[0]); ++i)
+    {
+        ImgloadErrorCode err = imgload_plugin_register_signature(plugin, (const uint8_t*)STB_SIGNATURES[i].bytes,
+                                                                 STB_SIGNATURES[i].size);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+    }
+
+    imgload_plugin_callback_probe_header(plugin, stb_image_probe_header);
     imgload_plugin_callback_probe(plugin, stb_image_probe);
     imgload_plugin_callback_init_image(plugin, stb_image_init_image);
+    imgload_plugin_callback_image_info(plugin, stb_image_info);
+    imgload_plugin_callback_deinit_image(plugin, stb_image_deinit_image);
 
-    imgload_plugin_callback_read_data(plugin, png_read_data);
+    imgload_plugin_callback_read_data(plugin, stb_image_read_data);
 
     return IMGLOAD_ERR_NO_ERROR;
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <imageloader.h>
+
+#include <stddef.h>
+
+/**
+ * @brief Sets the plugin whose allocator is used by stb_image on the current thread
+ * stb_image only supports global allocation macros so the plugin has to be set around every call into stb_image.
+ * Memory returned by stb_image can then be handed to imageloader directly.
+ * @param plugin The plugin or @c NULL to use the C allocator
+ * @return The previously set plugin
+ */
+ImgloadPlugin stb_allocator_set(ImgloadPlugin plugin);
+
+void* stb_allocator_malloc(size_t size);
+void* stb_allocator_realloc(void* ptr, size_t size);
+void stb_allocator_free(void* ptr);
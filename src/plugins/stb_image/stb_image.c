@@ -3,5 +3,10 @@
 #define STBI_NO_HDR
 #define STBI_NO_LINEAR
 #define STBI_NO_STDIO
+#include "stb_allocator.h"
+#define STBI_MALLOC(sz) stb_allocator_malloc(sz)
+#define STBI_REALLOC(p, sz) stb_allocator_realloc(p, sz)
+#define STBI_FREE(p) stb_allocator_free(p)
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -0,0 +1,111 @@
+#include "stats.h"
+
+#include <assert.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef _WIN32
+
+uint64_t stats_now_ns(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    // Split the conversion so the multiplication doesn't overflow
+    uint64_t seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+    uint64_t rest = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+
+    return seconds * 1000000000u + rest * 1000000000u / (uint64_t)frequency.QuadPart;
+}
+
+#else
+
+uint64_t stats_now_ns(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return (uint64_t)time.tv_sec * 1000000000u + (uint64_t)time.tv_nsec;
+}
+
+#endif
+
+static void stats_charge(StatsRecorder* recorder, uint64_t now)
+{
+    uint64_t elapsed = now - recorder->phase_start;
+    ImgloadStats* values = &recorder->values;
+
+    switch (recorder->phase)
+    {
+    case STATS_PHASE_PROBE:
+        values->probe_ns += elapsed;
+        break;
+    case STATS_PHASE_INIT:
+        values->init_ns += elapsed;
+        break;
+    case STATS_PHASE_READ:
+        values->read_ns += elapsed;
+        break;
+    case STATS_PHASE_DECOMPRESS:
+        values->decompress_ns += elapsed;
+        break;
+    case STATS_PHASE_CONVERT:
+        values->convert_ns += elapsed;
+        break;
+    case STATS_PHASE_FLIP:
+        values->flip_ns += elapsed;
+        break;
+    default:
+        // Time outside of the library isn't interesting
+        break;
+    }
+
+    recorder->phase_start = now;
+}
+
+StatsPhase stats_enter(StatsRecorder* recorder, StatsPhase phase)
+{
+    assert(recorder != NULL);
+
+    StatsPhase previous = recorder->phase;
+    stats_charge(recorder, stats_now_ns());
+    recorder->phase = phase;
+
+    return previous;
+}
+
+void stats_leave(StatsRecorder* recorder, StatsPhase previous)
+{
+    assert(recorder != NULL);
+
+    stats_charge(recorder, stats_now_ns());
+    recorder->phase = previous;
+}
+
+void stats_add(ImgloadStats* dst, const ImgloadStats* src)
+{
+    dst->images += src->images;
+
+    dst->bytes_read += src->bytes_read;
+    dst->read_calls += src->read_calls;
+    dst->seek_calls += src->seek_calls;
+
+    dst->probe_ns += src->probe_ns;
+    dst->init_ns += src->init_ns;
+    dst->read_ns += src->read_ns;
+    dst->decompress_ns += src->decompress_ns;
+    dst->convert_ns += src->convert_ns;
+    dst->flip_ns += src->flip_ns;
+
+    if (src->peak_bytes > dst->peak_bytes)
+    {
+        dst->peak_bytes = src->peak_bytes;
+    }
+}
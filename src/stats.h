@@ -0,0 +1,54 @@
+#ifndef IMAGELOADER_STATS_H
+#define IMAGELOADER_STATS_H
+#pragma once
+
+#include <imageloader.h>
+
+/**
+ * @brief The part of loading an image the elapsed time is charged to
+ */
+typedef enum
+{
+    STATS_PHASE_NONE,
+    STATS_PHASE_PROBE,
+    STATS_PHASE_INIT,
+    STATS_PHASE_READ,
+    STATS_PHASE_DECOMPRESS,
+    STATS_PHASE_CONVERT,
+    STATS_PHASE_FLIP,
+} StatsPhase;
+
+/**
+ * @brief The statistics of an image together with the phase which is currently measured
+ * Phases nest, entering a phase pauses the current one so every nanosecond is only counted once.
+ */
+typedef struct
+{
+    ImgloadStats values;
+
+    StatsPhase phase;
+    uint64_t phase_start;
+} StatsRecorder;
+
+/**
+ * @brief Gets a monotonic time in nanoseconds
+ */
+uint64_t stats_now_ns(void);
+
+/**
+ * @brief Starts charging the time to another phase
+ * @return The phase which has to be passed to stats_leave
+ */
+StatsPhase stats_enter(StatsRecorder* recorder, StatsPhase phase);
+
+/**
+ * @brief Ends the current phase and continues the one returned by stats_enter
+ */
+void stats_leave(StatsRecorder* recorder, StatsPhase previous);
+
+/**
+ * @brief Adds the counters and times of src to dst, the peak memory is the maximum of both
+ */
+void stats_add(ImgloadStats* dst, const ImgloadStats* src);
+
+#endif //IMAGELOADER_STATS_H
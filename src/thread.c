@@ -0,0 +1,330 @@
+#include "thread.h"
+
+#include <assert.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+static PSRWLOCK get_srwlock(ThreadRWLock* lock)
+{
+    return (PSRWLOCK)&lock->srwlock;
+}
+
+bool thread_rwlock_init(ThreadRWLock* lock)
+{
+    assert(sizeof(lock->srwlock) == sizeof(SRWLOCK));
+
+    InitializeSRWLock(get_srwlock(lock));
+    return true;
+}
+
+void thread_rwlock_destroy(ThreadRWLock* lock)
+{
+    // SRW locks do not need to be destroyed
+    (void)lock;
+}
+
+void thread_rwlock_read_lock(ThreadRWLock* lock)
+{
+    AcquireSRWLockShared(get_srwlock(lock));
+}
+
+void thread_rwlock_read_unlock(ThreadRWLock* lock)
+{
+    ReleaseSRWLockShared(get_srwlock(lock));
+}
+
+void thread_rwlock_write_lock(ThreadRWLock* lock)
+{
+    AcquireSRWLockExclusive(get_srwlock(lock));
+}
+
+void thread_rwlock_write_unlock(ThreadRWLock* lock)
+{
+    ReleaseSRWLockExclusive(get_srwlock(lock));
+}
+
+bool thread_mutex_init(ThreadMutex* mutex)
+{
+    InitializeSRWLock((PSRWLOCK)&mutex->srwlock);
+    return true;
+}
+
+void thread_mutex_destroy(ThreadMutex* mutex)
+{
+    (void)mutex;
+}
+
+void thread_mutex_lock(ThreadMutex* mutex)
+{
+    AcquireSRWLockExclusive((PSRWLOCK)&mutex->srwlock);
+}
+
+void thread_mutex_unlock(ThreadMutex* mutex)
+{
+    ReleaseSRWLockExclusive((PSRWLOCK)&mutex->srwlock);
+}
+
+bool thread_condition_init(ThreadCondition* cond)
+{
+    assert(sizeof(cond->condition) == sizeof(CONDITION_VARIABLE));
+
+    InitializeConditionVariable((PCONDITION_VARIABLE)&cond->condition);
+    return true;
+}
+
+void thread_condition_destroy(ThreadCondition* cond)
+{
+    (void)cond;
+}
+
+void thread_condition_wait(ThreadCondition* cond, ThreadMutex* mutex)
+{
+    SleepConditionVariableSRW((PCONDITION_VARIABLE)&cond->condition, (PSRWLOCK)&mutex->srwlock, INFINITE, 0);
+}
+
+void thread_condition_broadcast(ThreadCondition* cond)
+{
+    WakeAllConditionVariable((PCONDITION_VARIABLE)&cond->condition);
+}
+
+static DWORD WINAPI thread_start(LPVOID param)
+{
+    Thread* thread = (Thread*)param;
+
+    thread->func(thread->arg);
+    return 0;
+}
+
+bool thread_create(Thread* thread, ThreadFunc func, void* arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+
+    thread->handle = CreateThread(NULL, 0, thread_start, thread, 0, NULL);
+
+    return thread->handle != NULL;
+}
+
+void thread_join(Thread* thread)
+{
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+}
+
+size_t thread_hardware_concurrency(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+}
+
+uint64_t thread_current_id(void)
+{
+    return (uint64_t)GetCurrentThreadId();
+}
+
+#else
+
+bool thread_rwlock_init(ThreadRWLock* lock)
+{
+    return pthread_rwlock_init(&lock->rwlock, NULL) == 0;
+}
+
+void thread_rwlock_destroy(ThreadRWLock* lock)
+{
+    pthread_rwlock_destroy(&lock->rwlock);
+}
+
+void thread_rwlock_read_lock(ThreadRWLock* lock)
+{
+    pthread_rwlock_rdlock(&lock->rwlock);
+}
+
+void thread_rwlock_read_unlock(ThreadRWLock* lock)
+{
+    pthread_rwlock_unlock(&lock->rwlock);
+}
+
+void thread_rwlock_write_lock(ThreadRWLock* lock)
+{
+    pthread_rwlock_wrlock(&lock->rwlock);
+}
+
+void thread_rwlock_write_unlock(ThreadRWLock* lock)
+{
+    pthread_rwlock_unlock(&lock->rwlock);
+}
+
+bool thread_mutex_init(ThreadMutex* mutex)
+{
+    return pthread_mutex_init(&mutex->mutex, NULL) == 0;
+}
+
+void thread_mutex_destroy(ThreadMutex* mutex)
+{
+    pthread_mutex_destroy(&mutex->mutex);
+}
+
+void thread_mutex_lock(ThreadMutex* mutex)
+{
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void thread_mutex_unlock(ThreadMutex* mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+bool thread_condition_init(ThreadCondition* cond)
+{
+    return pthread_cond_init(&cond->cond, NULL) == 0;
+}
+
+void thread_condition_destroy(ThreadCondition* cond)
+{
+    pthread_cond_destroy(&cond->cond);
+}
+
+void thread_condition_wait(ThreadCondition* cond, ThreadMutex* mutex)
+{
+    pthread_cond_wait(&cond->cond, &mutex->mutex);
+}
+
+void thread_condition_broadcast(ThreadCondition* cond)
+{
+    pthread_cond_broadcast(&cond->cond);
+}
+
+static void* thread_start(void* param)
+{
+    Thread* thread = (Thread*)param;
+
+    thread->func(thread->arg);
+    return NULL;
+}
+
+bool thread_create(Thread* thread, ThreadFunc func, void* arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+
+    return pthread_create(&thread->thread, NULL, thread_start, thread) == 0;
+}
+
+void thread_join(Thread* thread)
+{
+    pthread_join(thread->thread, NULL);
+}
+
+size_t thread_hardware_concurrency(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (size_t)count : 1;
+}
+
+uint64_t thread_current_id(void)
+{
+    // pthread_t is an integer or a pointer on all supported platforms
+    return (uint64_t)(uintptr_t)pthread_self();
+}
+
+#endif
+
+#if defined(_MSC_VER)
+
+uint32_t thread_atomic_load_u32(const volatile uint32_t* ptr)
+{
+    // Interlocked operations are full barriers
+    return (uint32_t)InterlockedCompareExchange((volatile LONG*)ptr, 0, 0);
+}
+
+void thread_atomic_store_u32(volatile uint32_t* ptr, uint32_t value)
+{
+    InterlockedExchange((volatile LONG*)ptr, (LONG)value);
+}
+
+size_t thread_atomic_load_size(const volatile size_t* ptr)
+{
+#ifdef _WIN64
+    return (size_t)InterlockedCompareExchange64((volatile LONG64*)ptr, 0, 0);
+#else
+    return (size_t)InterlockedCompareExchange((volatile LONG*)ptr, 0, 0);
+#endif
+}
+
+size_t thread_atomic_fetch_add_size(volatile size_t* ptr, size_t value)
+{
+#ifdef _WIN64
+    return (size_t)InterlockedExchangeAdd64((volatile LONG64*)ptr, (LONG64)value);
+#else
+    return (size_t)InterlockedExchangeAdd((volatile LONG*)ptr, (LONG)value);
+#endif
+}
+
+void thread_atomic_store_size(volatile size_t* ptr, size_t value)
+{
+#ifdef _WIN64
+    InterlockedExchange64((volatile LONG64*)ptr, (LONG64)value);
+#else
+    InterlockedExchange((volatile LONG*)ptr, (LONG)value);
+#endif
+}
+
+bool thread_atomic_compare_exchange_size(volatile size_t* ptr, size_t* expected, size_t desired)
+{
+#ifdef _WIN64
+    size_t previous = (size_t)InterlockedCompareExchange64((volatile LONG64*)ptr, (LONG64)desired, (LONG64)*expected);
+#else
+    size_t previous = (size_t)InterlockedCompareExchange((volatile LONG*)ptr, (LONG)desired, (LONG)*expected);
+#endif
+    if (previous == *expected)
+    {
+        return true;
+    }
+
+    *expected = previous;
+    return false;
+}
+
+#else
+
+uint32_t thread_atomic_load_u32(const volatile uint32_t* ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+void thread_atomic_store_u32(volatile uint32_t* ptr, uint32_t value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+size_t thread_atomic_load_size(const volatile size_t* ptr)
+{
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+size_t thread_atomic_fetch_add_size(volatile size_t* ptr, size_t value)
+{
+    return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+void thread_atomic_store_size(volatile size_t* ptr, size_t value)
+{
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+bool thread_atomic_compare_exchange_size(volatile size_t* ptr, size_t* expected, size_t desired)
+{
+    return __atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+#endif
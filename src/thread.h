@@ -0,0 +1,147 @@
+#ifndef IMAGELOADER_THREAD_H
+#define IMAGELOADER_THREAD_H
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+/**
+ * @brief A mutual exclusion lock
+ */
+typedef struct
+{
+#ifdef _WIN32
+    void* srwlock; //!< Storage of a SRWLOCK which is used in exclusive mode
+#else
+    pthread_mutex_t mutex;
+#endif
+} ThreadMutex;
+
+/**
+ * @brief A condition variable which is used together with a ThreadMutex
+ */
+typedef struct
+{
+#ifdef _WIN32
+    void* condition; //!< Storage of a CONDITION_VARIABLE which has the size of a pointer
+#else
+    pthread_cond_t cond;
+#endif
+} ThreadCondition;
+
+typedef void (*ThreadFunc)(void* arg);
+
+/**
+ * @brief A thread created by thread_create
+ */
+typedef struct
+{
+    ThreadFunc func;
+    void* arg;
+
+#ifdef _WIN32
+    void* handle;
+#else
+    pthread_t thread;
+#endif
+} Thread;
+
+/**
+ * @brief A reader-writer lock, any number of readers may hold the lock at the same time
+ */
+typedef struct
+{
+#ifdef _WIN32
+    void* srwlock; //!< Storage of a SRWLOCK which has the size of a pointer
+#else
+    pthread_rwlock_t rwlock;
+#endif
+} ThreadRWLock;
+
+bool thread_rwlock_init(ThreadRWLock* lock);
+
+void thread_rwlock_destroy(ThreadRWLock* lock);
+
+void thread_rwlock_read_lock(ThreadRWLock* lock);
+
+void thread_rwlock_read_unlock(ThreadRWLock* lock);
+
+void thread_rwlock_write_lock(ThreadRWLock* lock);
+
+void thread_rwlock_write_unlock(ThreadRWLock* lock);
+
+bool thread_mutex_init(ThreadMutex* mutex);
+
+void thread_mutex_destroy(ThreadMutex* mutex);
+
+void thread_mutex_lock(ThreadMutex* mutex);
+
+void thread_mutex_unlock(ThreadMutex* mutex);
+
+bool thread_condition_init(ThreadCondition* cond);
+
+void thread_condition_destroy(ThreadCondition* cond);
+
+/**
+ * @brief Releases the mutex and waits until the condition is signaled, the mutex is locked again before returning
+ * Spurious wakeups are possible so the caller has to check its condition in a loop.
+ */
+void thread_condition_wait(ThreadCondition* cond, ThreadMutex* mutex);
+
+void thread_condition_broadcast(ThreadCondition* cond);
+
+/**
+ * @brief Starts a new thread which runs func(arg)
+ * The thread structure is used by the new thread and must stay valid until thread_join returned.
+ * @return @c true if the thread was started
+ */
+bool thread_create(Thread* thread, ThreadFunc func, void* arg);
+
+/**
+ * @brief Waits until the thread has finished and releases its resources
+ */
+void thread_join(Thread* thread);
+
+/**
+ * @brief Gets the number of processors which are available to run threads, at least 1
+ */
+size_t thread_hardware_concurrency(void);
+
+/**
+ * @brief Gets a number identifying the calling thread while it runs
+ */
+uint64_t thread_current_id(void);
+
+/**
+ * @brief Atomically loads a value with acquire semantics
+ */
+uint32_t thread_atomic_load_u32(const volatile uint32_t* ptr);
+
+/**
+ * @brief Atomically stores a value with release semantics
+ */
+void thread_atomic_store_u32(volatile uint32_t* ptr, uint32_t value);
+
+size_t thread_atomic_load_size(const volatile size_t* ptr);
+
+/**
+ * @brief Atomically adds to a value
+ * @return The value before the addition
+ */
+size_t thread_atomic_fetch_add_size(volatile size_t* ptr, size_t value);
+
+void thread_atomic_store_size(volatile size_t* ptr, size_t value);
+
+/**
+ * @brief Atomically replaces the value if it is equal to the expected one
+ * @param expected The expected value, updated with the current value if they aren't equal
+ * @return @c true if the value was replaced
+ */
+bool thread_atomic_compare_exchange_size(volatile size_t* ptr, size_t* expected, size_t desired);
+
+#endif //IMAGELOADER_THREAD_H
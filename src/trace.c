@@ -0,0 +1,161 @@
+#include "trace.h"
+#include "context.h"
+#include "memory.h"
+#include "plugin.h"
+#include "stats.h"
+#include "log.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+struct ImgloadTraceWriterImpl
+{
+    ImgloadContext context;
+
+    ThreadMutex lock; //!< Serializes the events of all threads
+    FILE* file;
+    bool first_event;
+
+    uint64_t start; //!< Timestamps are relative to opening the writer
+};
+
+bool trace_enabled(ImgloadContext ctx)
+{
+    return thread_atomic_load_u32(&ctx->trace.enabled) != 0;
+}
+
+void trace_event(ImgloadContext ctx, bool begin, const char* name, ImgloadPlugin plugin, ImgloadImage img)
+{
+    thread_rwlock_read_lock(&ctx->trace.lock);
+
+    ImgloadTraceHandler handler = begin ? ctx->trace.begin : ctx->trace.end;
+    if (handler != NULL)
+    {
+        ImgloadTraceEvent event;
+        event.name = name;
+        event.plugin = plugin != NULL ? plugin->info.id : NULL;
+        event.image = img;
+
+        handler(ctx->trace.ud, &event);
+    }
+
+    thread_rwlock_read_unlock(&ctx->trace.lock);
+}
+
+/**
+ * @brief Writes a JSON string, plugin ids are not under our control so they are escaped
+ */
+static void trace_write_string(FILE* file, const char* str)
+{
+    fputc('"', file);
+    for (; *str != '\0'; ++str)
+    {
+        unsigned char c = (unsigned char)*str;
+        if (c == '"' || c == '\\')
+        {
+            fputc('\\', file);
+            fputc(c, file);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+static void trace_writer_event(ImgloadTraceWriter writer, char phase, const ImgloadTraceEvent* event)
+{
+    uint64_t time = stats_now_ns() - writer->start;
+    uint64_t thread = thread_current_id();
+
+    thread_mutex_lock(&writer->lock);
+
+    fputs(writer->first_event ? "\n{\"name\":" : ",\n{\"name\":", writer->file);
+    trace_write_string(writer->file, event->name);
+    fputs(",\"cat\":", writer->file);
+    trace_write_string(writer->file, event->plugin != NULL ? event->plugin : "imageloader");
+
+    // Chrome expects microseconds
+    fprintf(writer->file, ",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%llu,\"args\":{\"image\":\"%p\"}}", phase,
+            (unsigned long long)(time / 1000), (unsigned)(time % 1000), (unsigned long long)thread,
+            (void*)event->image);
+    writer->first_event = false;
+
+    thread_mutex_unlock(&writer->lock);
+}
+
+static void IMGLOAD_CALLBACK trace_writer_begin(void* ud, const ImgloadTraceEvent* event)
+{
+    trace_writer_event((ImgloadTraceWriter)ud, 'B', event);
+}
+
+static void IMGLOAD_CALLBACK trace_writer_end(void* ud, const ImgloadTraceEvent* event)
+{
+    trace_writer_event((ImgloadTraceWriter)ud, 'E', event);
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_trace_writer_open(ImgloadContext ctx, const char* path,
+                                                       ImgloadTraceWriter* writer_out)
+{
+    assert(ctx != NULL);
+    assert(path != NULL);
+    assert(writer_out != NULL);
+
+    ImgloadTraceWriter writer = (ImgloadTraceWriter)mem_reallocz(ctx, NULL, sizeof(struct ImgloadTraceWriterImpl));
+    if (writer == NULL)
+    {
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    if (!thread_mutex_init(&writer->lock))
+    {
+        mem_free(ctx, writer);
+        return IMGLOAD_ERR_OUT_OF_MEMORY;
+    }
+
+    writer->file = fopen(path, "w");
+    if (writer->file == NULL)
+    {
+        print_to_log(ctx, IMGLOAD_LOG_ERROR, "Failed to open trace file '%s'!\n", path);
+        thread_mutex_destroy(&writer->lock);
+        mem_free(ctx, writer);
+        return IMGLOAD_ERR_IO_ERROR;
+    }
+
+    writer->context = ctx;
+    writer->first_event = true;
+    writer->start = stats_now_ns();
+
+    fputs("{\"traceEvents\":[", writer->file);
+
+    imgload_context_set_trace_callbacks(ctx, trace_writer_begin, trace_writer_end, writer);
+
+    *writer_out = writer;
+
+    return IMGLOAD_ERR_NO_ERROR;
+}
+
+ImgloadErrorCode IMGLOAD_API imgload_trace_writer_close(ImgloadTraceWriter writer)
+{
+    assert(writer != NULL);
+
+    ImgloadContext ctx = writer->context;
+
+    // Once the callbacks are replaced no handler can be running anymore
+    imgload_context_set_trace_callbacks(ctx, NULL, NULL, NULL);
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", writer->file);
+
+    bool failed = ferror(writer->file) != 0;
+    failed = fclose(writer->file) != 0 || failed;
+
+    thread_mutex_destroy(&writer->lock);
+    mem_free(ctx, writer);
+
+    return failed ? IMGLOAD_ERR_IO_ERROR : IMGLOAD_ERR_NO_ERROR;
+}
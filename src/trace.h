@@ -0,0 +1,21 @@
+#ifndef IMAGELOADER_TRACE_H
+#define IMAGELOADER_TRACE_H
+#pragma once
+
+#include <imageloader.h>
+
+#include <stdbool.h>
+
+/**
+ * @brief Checks if trace handlers are registered, events should only be created if they are
+ */
+bool trace_enabled(ImgloadContext ctx);
+
+/**
+ * @brief Calls the begin or end handler of the context
+ * @param name The name of the stage, has to be a string literal
+ * @param plugin The plugin handling the stage, may be @c NULL
+ */
+void trace_event(ImgloadContext ctx, bool begin, const char* name, ImgloadPlugin plugin, ImgloadImage img);
+
+#endif //IMAGELOADER_TRACE_H
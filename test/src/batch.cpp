@@ -0,0 +1,269 @@
+#include <imageloader.h>
+#include <imageloader_plugin.h>
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // The magic followed by the value of the single pixel of the image
+    const uint8_t BATCH_MAGIC[] = { 'B', 'T', 'C', 'H' };
+
+    struct MemoryFile
+    {
+        std::vector<uint8_t> data;
+        size_t pos;
+    };
+
+    size_t IMGLOAD_CALLBACK memory_read(void* ud, uint8_t* buf, size_t size)
+    {
+        auto file = static_cast<MemoryFile*>(ud);
+
+        size_t available = file->data.size() - file->pos;
+        size_t read = size < available ? size : available;
+        std::memcpy(buf, file->data.data() + file->pos, read);
+        file->pos += read;
+
+        return read;
+    }
+
+    int64_t IMGLOAD_CALLBACK memory_seek(void* ud, int64_t offset, int whence)
+    {
+        auto file = static_cast<MemoryFile*>(ud);
+
+        switch (whence)
+        {
+            case SEEK_SET:
+                file->pos = static_cast<size_t>(offset);
+                break;
+            case SEEK_CUR:
+                file->pos = static_cast<size_t>(file->pos + offset);
+                break;
+            case SEEK_END:
+                file->pos = static_cast<size_t>(file->data.size() + offset);
+                break;
+        }
+
+        return static_cast<int64_t>(file->pos);
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK batch_init_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        uint8_t header[sizeof(BATCH_MAGIC) + 1];
+        if (imgload_plugin_image_read(img, header, sizeof(header)) != sizeof(header))
+        {
+            return IMGLOAD_ERR_FILE_INVALID;
+        }
+
+        imgload_plugin_image_set_data(img, reinterpret_cast<void*>(static_cast<uintptr_t>(header[4])));
+
+        imgload_plugin_image_set_data_type(img, IMGLOAD_FORMAT_GRAY8, IMGLOAD_COMPRESSION_NONE);
+        imgload_plugin_image_set_num_frames(img, 1);
+        imgload_plugin_image_set_num_mipmaps(img, 0, 1);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK batch_read_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        ImgloadImageData image;
+        image.width = 1;
+        image.height = 1;
+        image.depth = 1;
+        image.stride = 1;
+        image.data_size = 1;
+        image.data = imgload_plugin_realloc(plugin, nullptr, 1);
+
+        *static_cast<uint8_t*>(image.data) = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(imgload_plugin_image_get_data(img)));
+
+        return imgload_plugin_image_set_image_data(img, 0, 0, &image, 1);
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK batch_plugin_loader(ImgloadPlugin plugin, void* parameter)
+    {
+        imgload_plugin_set_info(plugin, "batch", "Batch plugin", "Plugin with single pixel images");
+
+        auto err = imgload_plugin_register_signature(plugin, BATCH_MAGIC, sizeof(BATCH_MAGIC));
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        imgload_plugin_callback_init_image(plugin, batch_init_image);
+        imgload_plugin_callback_read_data(plugin, batch_read_image);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+}
+
+class BatchTests : public util::ContextFixture
+{
+protected:
+    std::vector<MemoryFile> files;
+    std::vector<ImgloadIO> ios;
+    std::vector<void*> uds;
+
+    void SetUp()
+    {
+        this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, batch_plugin_loader, nullptr));
+    }
+
+    void makeFiles(size_t count, size_t invalid_every)
+    {
+        files.resize(count);
+        ios.resize(count);
+        uds.resize(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            files[i].data.assign(BATCH_MAGIC, BATCH_MAGIC + sizeof(BATCH_MAGIC));
+            files[i].data.push_back(static_cast<uint8_t>(i));
+            files[i].pos = 0;
+
+            if (invalid_every != 0 && i % invalid_every == invalid_every - 1)
+            {
+                files[i].data[0] = 'X';
+            }
+
+            ios[i].read = memory_read;
+            ios[i].seek = memory_seek;
+            uds[i] = &files[i];
+        }
+    }
+
+    void checkImages(const std::vector<ImgloadImage>& images, const std::vector<ImgloadErrorCode>& errors,
+                     size_t invalid_every)
+    {
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            SCOPED_TRACE(testing::Message() << "image " << i);
+
+            if (invalid_every != 0 && i % invalid_every == invalid_every - 1)
+            {
+                ASSERT_EQ(IMGLOAD_ERR_UNSUPPORTED_FORMAT, errors[i]);
+                ASSERT_EQ(nullptr, images[i]);
+                continue;
+            }
+
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, errors[i]);
+            ASSERT_NE(nullptr, images[i]);
+
+            ImgloadImageData data;
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(images[i], 0, 0, &data));
+            ASSERT_EQ(static_cast<uint8_t>(i), *static_cast<const uint8_t*>(data.data));
+
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(images[i]));
+        }
+    }
+};
+
+TEST_F(BatchTests, load_with_pool)
+{
+    const size_t COUNT = 300;
+    this->makeFiles(COUNT, 7);
+
+    std::vector<ImgloadImage> images(COUNT);
+    std::vector<ImgloadErrorCode> errors(COUNT);
+
+    ImgloadBatchOptions options;
+    std::memset(&options, 0, sizeof(options));
+    options.num_threads = 6;
+
+    ASSERT_EQ(IMGLOAD_ERR_UNSUPPORTED_FORMAT, imgload_batch_load(this->ctx, ios.data(), uds.data(), COUNT,
+                                                                 images.data(), errors.data(), &options));
+
+    this->checkImages(images, errors, 7);
+}
+
+TEST_F(BatchTests, load_default_options)
+{
+    const size_t COUNT = 50;
+    this->makeFiles(COUNT, 0);
+
+    std::vector<ImgloadImage> images(COUNT);
+    std::vector<ImgloadErrorCode> errors(COUNT);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_batch_load(this->ctx, ios.data(), uds.data(), COUNT, images.data(),
+                                                       errors.data(), nullptr));
+
+    this->checkImages(images, errors, 0);
+}
+
+namespace
+{
+    struct JobSystem
+    {
+        std::mutex lock;
+        std::vector<std::function<void()>> jobs;
+    };
+
+    void IMGLOAD_CALLBACK submit_job(void* ud, ImgloadBatchTaskFunc task, void* task_data)
+    {
+        auto jobs = static_cast<JobSystem*>(ud);
+
+        std::lock_guard<std::mutex> guard(jobs->lock);
+        jobs->jobs.push_back([task, task_data]() { task(task_data); });
+    }
+}
+
+TEST_F(BatchTests, load_with_submit_callback)
+{
+    const size_t COUNT = 100;
+    this->makeFiles(COUNT, 0);
+
+    std::vector<ImgloadImage> images(COUNT);
+    std::vector<ImgloadErrorCode> errors(COUNT);
+
+    JobSystem jobs;
+
+    ImgloadBatchOptions options;
+    std::memset(&options, 0, sizeof(options));
+    options.num_threads = 4;
+    options.submit = submit_job;
+    options.submit_ud = &jobs;
+
+    // Run the first task concurrently, the others only after the batch is done which has to be safe as well
+    std::thread runner([&jobs]()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::lock_guard<std::mutex> guard(jobs.lock);
+                if (!jobs.jobs.empty())
+                {
+                    job = jobs.jobs.front();
+                    jobs.jobs.erase(jobs.jobs.begin());
+                }
+            }
+
+            if (job)
+            {
+                job();
+                return;
+            }
+            std::this_thread::yield();
+        }
+    });
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_batch_load(this->ctx, ios.data(), uds.data(), COUNT, images.data(),
+                                                       errors.data(), &options));
+    runner.join();
+
+    ASSERT_EQ(2, jobs.jobs.size());
+    for (auto& job : jobs.jobs)
+    {
+        job();
+    }
+
+    this->checkImages(images, errors, 0);
+}
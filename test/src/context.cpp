@@ -0,0 +1,392 @@
+#include <imageloader.h>
+#include <imageloader_plugin.h>
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const uint8_t TEST_FILE[] = { 'T', 'E', 'S', 'T', 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    struct ProbeCounts
+    {
+        int header_probes;
+        int stream_probes;
+        ImgloadProbeResult header_result;
+    };
+
+    ImgloadProbeResult IMGLOAD_CALLBACK test_probe_header(ImgloadPlugin plugin, const uint8_t* header, size_t size)
+    {
+        auto counts = static_cast<ProbeCounts*>(imgload_plugin_get_data(plugin));
+        ++counts->header_probes;
+
+        if (size < 4 || std::memcmp(header, "TEST", 4) != 0)
+        {
+            return IMGLOAD_PROBE_NO;
+        }
+
+        return counts->header_result;
+    }
+
+    int IMGLOAD_CALLBACK test_probe(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto counts = static_cast<ProbeCounts*>(imgload_plugin_get_data(plugin));
+        ++counts->stream_probes;
+
+        uint8_t magic[4];
+        if (imgload_plugin_image_read(img, magic, 4) != 4)
+        {
+            return 0;
+        }
+
+        return std::memcmp(magic, "TEST", 4) == 0;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK test_init_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto counts = static_cast<ProbeCounts*>(imgload_plugin_get_data(plugin));
+
+        // After a stream probe the stream continues after the magic, otherwise it starts at the beginning
+        int64_t expected = counts->header_result == IMGLOAD_PROBE_YES ? 0 : 4;
+        if (imgload_plugin_image_seek(img, 0, SEEK_CUR) != expected)
+        {
+            return IMGLOAD_ERR_PLUGIN_ERROR;
+        }
+
+        imgload_plugin_image_set_data_type(img, IMGLOAD_FORMAT_GRAY8, IMGLOAD_COMPRESSION_NONE);
+        imgload_plugin_image_set_num_frames(img, 1);
+        imgload_plugin_image_set_num_mipmaps(img, 0, 1);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK test_plugin_loader(ImgloadPlugin plugin, void* parameter)
+    {
+        imgload_plugin_set_info(plugin, "test", "Test plugin", "Plugin for testing the plugin infrastructure");
+        imgload_plugin_set_data(plugin, parameter);
+
+        imgload_plugin_callback_probe_header(plugin, test_probe_header);
+        imgload_plugin_callback_probe(plugin, test_probe);
+        imgload_plugin_callback_init_image(plugin, test_init_image);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+}
+
+class ContextTests : public util::ContextFixture
+{
+};
+
+TEST_F(ContextTests, probe_header)
+{
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+
+    ProbeCounts counts = { 0, 0, IMGLOAD_PROBE_YES };
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, test_plugin_loader, &counts));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, TEST_FILE, sizeof(TEST_FILE)));
+
+    ASSERT_EQ(1, counts.header_probes);
+    ASSERT_EQ(0, counts.stream_probes);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(ContextTests, probe_header_stream_fallback)
+{
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+
+    ProbeCounts counts = { 0, 0, IMGLOAD_PROBE_UNKNOWN };
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, test_plugin_loader, &counts));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, TEST_FILE, sizeof(TEST_FILE)));
+
+    ASSERT_EQ(1, counts.header_probes);
+    ASSERT_EQ(1, counts.stream_probes);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(ContextTests, probe_unsupported)
+{
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+
+    ProbeCounts counts = { 0, 0, IMGLOAD_PROBE_YES };
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, test_plugin_loader, &counts));
+
+    const uint8_t other_file[] = { 'N', 'O', 'P', 'E', 0, 0, 0, 0 };
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_UNSUPPORTED_FORMAT, imgload_image_init_from_memory(this->ctx, &img, other_file, sizeof(other_file)));
+
+    ASSERT_EQ(1, counts.header_probes);
+    ASSERT_EQ(0, counts.stream_probes);
+}
+
+namespace
+{
+    struct SignaturePluginData
+    {
+        const char* signature;
+        int inits;
+    };
+
+    ImgloadErrorCode IMGLOAD_CALLBACK signature_init_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto data = static_cast<SignaturePluginData*>(imgload_plugin_get_data(plugin));
+        ++data->inits;
+
+        imgload_plugin_image_set_data_type(img, IMGLOAD_FORMAT_GRAY8, IMGLOAD_COMPRESSION_NONE);
+        imgload_plugin_image_set_num_frames(img, 1);
+        imgload_plugin_image_set_num_mipmaps(img, 0, 1);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK signature_plugin_loader(ImgloadPlugin plugin, void* parameter)
+    {
+        auto data = static_cast<SignaturePluginData*>(parameter);
+
+        imgload_plugin_set_info(plugin, data->signature, "Signature plugin", "Plugin which only uses a signature");
+        imgload_plugin_set_data(plugin, parameter);
+
+        auto err = imgload_plugin_register_signature(plugin, reinterpret_cast<const uint8_t*>(data->signature),
+                                                     std::strlen(data->signature));
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        imgload_plugin_callback_init_image(plugin, signature_init_image);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+}
+
+TEST_F(ContextTests, signature_dispatch)
+{
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+
+    SignaturePluginData short_sig = { "TE", 0 };
+    SignaturePluginData long_sig = { "TEST", 0 };
+    ProbeCounts counts = { 0, 0, IMGLOAD_PROBE_YES };
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, test_plugin_loader, &counts));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, signature_plugin_loader, &short_sig));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, signature_plugin_loader, &long_sig));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, TEST_FILE, sizeof(TEST_FILE)));
+
+    // The longest signature wins and no probe function has been called
+    ASSERT_EQ(0, short_sig.inits);
+    ASSERT_EQ(1, long_sig.inits);
+    ASSERT_EQ(0, counts.header_probes);
+    ASSERT_EQ(0, counts.stream_probes);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(ContextTests, signature_only_plugin_not_probed)
+{
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+
+    SignaturePluginData sig = { "ABCD", 0 };
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, signature_plugin_loader, &sig));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_UNSUPPORTED_FORMAT, imgload_image_init_from_memory(this->ctx, &img, TEST_FILE, sizeof(TEST_FILE)));
+
+    ASSERT_EQ(0, sig.inits);
+}
+
+namespace
+{
+    struct ConcurrentPluginData
+    {
+        std::atomic<int> inits;
+    };
+
+    ImgloadErrorCode IMGLOAD_CALLBACK concurrent_init_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto data = static_cast<ConcurrentPluginData*>(imgload_plugin_get_data(plugin));
+        ++data->inits;
+
+        // Goes through the log handler while the main thread changes the log level
+        imgload_plugin_log(plugin, IMGLOAD_LOG_DEBUG, "Initializing image");
+
+        uint32_t width = 12;
+        imgload_plugin_image_set_data_type(img, IMGLOAD_FORMAT_GRAY8, IMGLOAD_COMPRESSION_NONE);
+        imgload_plugin_image_set_num_frames(img, 1);
+        imgload_plugin_image_set_num_mipmaps(img, 0, 1);
+        imgload_plugin_image_set_property(img, 0, IMGLOAD_PROPERTY_WIDTH, IMGLOAD_PROPERTY_TYPE_UINT32, &width);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK concurrent_plugin_loader(ImgloadPlugin plugin, void* parameter)
+    {
+        imgload_plugin_set_info(plugin, "concurrent", "Concurrent plugin", "Plugin used by many threads at once");
+        imgload_plugin_set_data(plugin, parameter);
+
+        auto err = imgload_plugin_register_signature(plugin, TEST_FILE, 4);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        imgload_plugin_callback_init_image(plugin, concurrent_init_image);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK counting_logger(void* ud, ImgloadLogLevel, const char*)
+    {
+        ++*static_cast<std::atomic<int>*>(ud);
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+}
+
+TEST_F(ContextTests, concurrent_loads)
+{
+    const int THREADS = 8;
+    const int LOADS_PER_THREAD = 500;
+
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+
+    ConcurrentPluginData plugin_data;
+    plugin_data.inits = 0;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, concurrent_plugin_loader, &plugin_data));
+
+    std::atomic<int> log_messages(0);
+    std::atomic<int> failures(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < THREADS; ++i)
+    {
+        threads.emplace_back([this, &failures]()
+        {
+            for (int j = 0; j < LOADS_PER_THREAD; ++j)
+            {
+                ImgloadImage img;
+                if (imgload_image_init_from_memory(this->ctx, &img, TEST_FILE, sizeof(TEST_FILE)) != IMGLOAD_ERR_NO_ERROR)
+                {
+                    ++failures;
+                    continue;
+                }
+
+                uint32_t width = 0;
+                imgload_image_get_property(img, 0, IMGLOAD_PROPERTY_WIDTH, IMGLOAD_PROPERTY_TYPE_UINT32, &width);
+                if (width != 12)
+                {
+                    ++failures;
+                }
+
+                imgload_image_free(img);
+            }
+        });
+    }
+
+    // Change the context while the other threads are loading images
+    std::vector<SignaturePluginData> other_plugins(16, SignaturePluginData{ "XYZ", 0 });
+    imgload_context_set_log_callback(this->ctx, counting_logger, &log_messages);
+    for (auto& other : other_plugins)
+    {
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, signature_plugin_loader, &other));
+        imgload_context_set_log_level(this->ctx, IMGLOAD_LOG_DEBUG);
+        imgload_context_set_log_level(this->ctx, IMGLOAD_LOG_ERROR);
+    }
+    imgload_context_set_log_level(this->ctx, IMGLOAD_LOG_DEBUG);
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(0, failures.load());
+    ASSERT_EQ(THREADS * LOADS_PER_THREAD, plugin_data.inits.load());
+
+    for (auto& other : other_plugins)
+    {
+        ASSERT_EQ(0, other.inits);
+    }
+
+    // Messages are only logged at the debug level
+    ASSERT_GE(THREADS * LOADS_PER_THREAD, log_messages.load());
+}
+
+namespace
+{
+    ImgloadErrorCode IMGLOAD_CALLBACK logging_init_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        std::string long_text(2000, 'x');
+
+        imgload_plugin_log(plugin, IMGLOAD_LOG_DEBUG, "Filtered %d", 1);
+        IMGLOAD_PLUGIN_LOG(plugin, IMGLOAD_LOG_WARNING, "Image has %d frames", 1);
+        imgload_plugin_log(plugin, IMGLOAD_LOG_ERROR, "%s", long_text.c_str());
+
+        imgload_plugin_image_set_data_type(img, IMGLOAD_FORMAT_GRAY8, IMGLOAD_COMPRESSION_NONE);
+        imgload_plugin_image_set_num_frames(img, 1);
+        imgload_plugin_image_set_num_mipmaps(img, 0, 1);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK logging_plugin_loader(ImgloadPlugin plugin, void* parameter)
+    {
+        imgload_plugin_set_info(plugin, "logging", "Logging plugin", "Plugin which logs while loading");
+
+        auto err = imgload_plugin_register_signature(plugin, TEST_FILE, 4);
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        imgload_plugin_callback_init_image(plugin, logging_init_image);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK collecting_logger(void* ud, ImgloadLogLevel, const char* text)
+    {
+        static_cast<std::vector<std::string>*>(ud)->push_back(text);
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+}
+
+TEST_F(ContextTests, plugin_log)
+{
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, logging_plugin_loader, nullptr));
+
+    std::vector<std::string> messages;
+    imgload_context_set_log_callback(this->ctx, collecting_logger, &messages);
+    imgload_context_set_log_level(this->ctx, IMGLOAD_LOG_WARNING);
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, TEST_FILE, sizeof(TEST_FILE)));
+    imgload_image_free(img);
+
+    // The warning is removed at compile time if IMGLOAD_MIN_LOG_LEVEL is above it
+    bool warning_enabled = IMGLOAD_LOG_WARNING >= IMGLOAD_MIN_LOG_LEVEL;
+    ASSERT_EQ(warning_enabled ? 2u : 1u, messages.size());
+    if (warning_enabled)
+    {
+        ASSERT_EQ("[logging] Image has 1 frames\n", messages[0]);
+    }
+
+    // Truncated messages keep the prefix and the newline
+    ASSERT_EQ(1023u, messages.back().size());
+    ASSERT_EQ(0u, messages.back().find("[logging] xxx"));
+    ASSERT_EQ('\n', messages.back().back());
+}
@@ -5,7 +5,159 @@
 
 #include "util.h"
 
+#include <array>
 #include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const uint32_t DDSD_DEFAULT = 0x1 | 0x2 | 0x4 | 0x1000;
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    const uint32_t DDSD_DEPTH = 0x800000;
+
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    const uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+    const uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+    const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+    const uint32_t DDS_DIMENSION_TEXTURE3D = 4;
+
+    void put_u32(std::vector<uint8_t>& file, size_t offset, uint32_t value)
+    {
+        for (size_t i = 0; i < 4; ++i)
+        {
+            file[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    /**
+     * @brief Parameters of a DDS file created by make_dds
+     */
+    struct DDSParams
+    {
+        uint32_t width = 4;
+        uint32_t height = 4;
+        uint32_t depth = 1;
+        uint32_t mipmaps = 1;
+        uint32_t caps2 = 0;
+        const char* fourcc = "DX10";
+
+        // Fields of the DX10 header, only written if fourcc is DX10
+        uint32_t dxgi_format = 71;
+        uint32_t dimension = DDS_DIMENSION_TEXTURE2D;
+        uint32_t misc_flag = 0;
+        uint32_t array_size = 1;
+
+        size_t data_size = 0; //!< Number of zero bytes following the headers
+    };
+
+    std::vector<uint8_t> make_dds(const DDSParams& params)
+    {
+        bool dx10 = std::strcmp(params.fourcc, "DX10") == 0;
+
+        std::vector<uint8_t> file(4 + 124 + (dx10 ? 20 : 0) + params.data_size, 0);
+        std::memcpy(file.data(), "DDS ", 4);
+
+        uint32_t flags = DDSD_DEFAULT | (params.mipmaps > 1 ? DDSD_MIPMAPCOUNT : 0) | (params.depth > 1 ? DDSD_DEPTH : 0);
+        put_u32(file, 4, 124);
+        put_u32(file, 8, flags);
+        put_u32(file, 12, params.height);
+        put_u32(file, 16, params.width);
+        put_u32(file, 24, params.depth);
+        put_u32(file, 28, params.mipmaps);
+
+        // Pixel format with a FourCC code
+        put_u32(file, 76, 32);
+        put_u32(file, 80, 0x4);
+        std::memcpy(&file[84], params.fourcc, 4);
+
+        put_u32(file, 108, 0x1000);
+        put_u32(file, 112, params.caps2);
+
+        if (dx10)
+        {
+            put_u32(file, 128, params.dxgi_format);
+            put_u32(file, 132, params.dimension);
+            put_u32(file, 136, params.misc_flag);
+            put_u32(file, 140, params.array_size);
+        }
+
+        return file;
+    }
+
+    /**
+     * @brief Calls the function with an image of the file, once mapped and once read as a stream
+     */
+    template <typename Func>
+    void for_each_source(ImgloadContext ctx, const char* path, Func func)
+    {
+        {
+            SCOPED_TRACE("mapped");
+
+            ImgloadImage img;
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(ctx, &img, path));
+            func(img);
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+        }
+        {
+            SCOPED_TRACE("stream");
+
+            auto io = util::get_std_io();
+            auto file_ptr = std::fopen(path, "rb");
+            ASSERT_NE(nullptr, file_ptr);
+
+            ImgloadImage img;
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init(ctx, &img, &io, static_cast<void*>(file_ptr)));
+            func(img);
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+
+            std::fclose(file_ptr);
+        }
+    }
+
+    uint32_t get_uint32(ImgloadImage img, size_t subimage, ImgloadProperty property)
+    {
+        uint32_t value = 0;
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_get_property(img, subimage, property, IMGLOAD_PROPERTY_TYPE_UINT32, &value));
+        return value;
+    }
+
+    /**
+     * @brief Checks that every pixel of a decoded mipmap has the color returned by expected(x, y, z)
+     */
+    template <typename Func>
+    void check_pixels(ImgloadImage img, size_t subimage, size_t mipmap, Func expected)
+    {
+        ImgloadImageData data;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, subimage, mipmap, &data));
+
+        auto pixels = static_cast<const uint8_t*>(data.data);
+        for (size_t z = 0; z < data.depth; ++z)
+        {
+            for (size_t y = 0; y < data.height; ++y)
+            {
+                for (size_t x = 0; x < data.width; ++x)
+                {
+                    auto pixel = pixels + (z * data.height + y) * data.stride + x * 4;
+                    std::array<uint8_t, 4> actual = {{ pixel[0], pixel[1], pixel[2], pixel[3] }};
+                    ASSERT_EQ(expected(x, y, z), actual) << "subimage " << subimage << ", mipmap " << mipmap
+                                                         << ", pixel " << x << ", " << y << ", " << z;
+                }
+            }
+        }
+    }
+
+    uint8_t expand5(uint32_t value)
+    {
+        return static_cast<uint8_t>((value << 3) | (value >> 2));
+    }
+
+    uint8_t expand6(uint32_t value)
+    {
+        return static_cast<uint8_t>((value << 2) | (value >> 4));
+    }
+}
 
 class DDSTests : public util::ContextFixture
 {
@@ -100,4 +252,473 @@ TEST_F(DDSTests, read_data_flip)
     ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
 
     std::fclose(file_ptr);
+}
+
+TEST_F(DDSTests, dx10_array)
+{
+    // Every block has its own color, red is 40 * subimage + 10, green is 40 * mipmap + 10 and blue is 20 * block + 10
+    for_each_source(this->ctx, TEST_DATA_PATH "ddsimg/dx10_bc7_array.dds", [](ImgloadImage img) {
+        ASSERT_EQ(3, imgload_image_num_subimages(img));
+        ASSERT_EQ(IMGLOAD_FORMAT_R8G8B8A8, imgload_image_data_format(img));
+        ASSERT_EQ(IMGLOAD_COMPRESSION_BC7, imgload_image_compression(img));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+            ASSERT_EQ(8, get_uint32(img, i, IMGLOAD_PROPERTY_WIDTH));
+            ASSERT_EQ(8, get_uint32(img, i, IMGLOAD_PROPERTY_HEIGHT));
+            ASSERT_EQ(1, get_uint32(img, i, IMGLOAD_PROPERTY_DEPTH));
+            ASSERT_EQ(4, imgload_image_num_mipmaps(img, i));
+
+            for (size_t j = 0; j < 4; ++j)
+            {
+                size_t size = 8 >> j;
+                size_t blocks_x = (size + 3) / 4;
+
+                ImgloadImageData data;
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, i, j, &data));
+                ASSERT_EQ(size, data.width);
+                ASSERT_EQ(blocks_x * blocks_x * 16, data.data_size);
+
+                check_pixels(img, i, j, [&](size_t x, size_t y, size_t) {
+                    size_t block = (y / 4) * blocks_x + x / 4;
+                    return std::array<uint8_t, 4>{{ static_cast<uint8_t>(40 * i + 10), static_cast<uint8_t>(40 * j + 10),
+                                                    static_cast<uint8_t>(20 * block + 10), 254 }};
+                });
+            }
+        }
+    });
+}
+
+TEST_F(DDSTests, dx10_cube_array)
+{
+    // Two cube maps, red is the subimage and green is 20 * mipmap + 5 before expanding them from RGB565
+    for_each_source(this->ctx, TEST_DATA_PATH "ddsimg/dx10_bc1_cube_array.dds", [](ImgloadImage img) {
+        ASSERT_EQ(12, imgload_image_num_subimages(img));
+        ASSERT_EQ(IMGLOAD_COMPRESSION_DXT1, imgload_image_compression(img));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+        for (size_t i = 0; i < 12; ++i)
+        {
+            ASSERT_EQ(3, imgload_image_num_mipmaps(img, i));
+
+            for (size_t j = 0; j < 3; ++j)
+            {
+                check_pixels(img, i, j, [&](size_t, size_t, size_t) {
+                    return std::array<uint8_t, 4>{{ expand5(static_cast<uint32_t>(i)),
+                                                    expand6(static_cast<uint32_t>(20 * j + 5)), 255, 255 }};
+                });
+            }
+        }
+    });
+}
+
+TEST_F(DDSTests, legacy_volume)
+{
+    // BC4U volume texture, red is 60 * mipmap + 10 * slice + 5
+    for_each_source(this->ctx, TEST_DATA_PATH "ddsimg/bc4u_volume.dds", [](ImgloadImage img) {
+        ASSERT_EQ(1, imgload_image_num_subimages(img));
+        ASSERT_EQ(4, get_uint32(img, 0, IMGLOAD_PROPERTY_DEPTH));
+        ASSERT_EQ(3, imgload_image_num_mipmaps(img, 0));
+        ASSERT_EQ(IMGLOAD_COMPRESSION_BC4, imgload_image_compression(img));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+        for (size_t j = 0; j < 3; ++j)
+        {
+            // Every slice of a mipmap has its own blocks
+            ImgloadImageData data;
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, 0, j, &data));
+            ASSERT_EQ(4u >> j, data.depth);
+            ASSERT_EQ(8 * data.depth, data.data_size);
+
+            check_pixels(img, 0, j, [&](size_t, size_t, size_t z) {
+                return std::array<uint8_t, 4>{{ static_cast<uint8_t>(60 * j + 10 * z + 5), 0, 0, 255 }};
+            });
+        }
+    });
+}
+
+TEST_F(DDSTests, legacy_cube)
+{
+    // ATI2 cube map with four of the six faces, red is 50 * face + 20 and green is 100 * mipmap + 10 * block + 5
+    for_each_source(this->ctx, TEST_DATA_PATH "ddsimg/ati2_cube.dds", [](ImgloadImage img) {
+        ASSERT_EQ(4, imgload_image_num_subimages(img));
+        ASSERT_EQ(IMGLOAD_COMPRESSION_BC5, imgload_image_compression(img));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+        for (size_t i = 0; i < 4; ++i)
+        {
+            ASSERT_EQ(2, imgload_image_num_mipmaps(img, i));
+
+            for (size_t j = 0; j < 2; ++j)
+            {
+                size_t blocks_x = ((8 >> j) + 3) / 4;
+                check_pixels(img, i, j, [&](size_t x, size_t y, size_t) {
+                    size_t block = (y / 4) * blocks_x + x / 4;
+                    return std::array<uint8_t, 4>{{ static_cast<uint8_t>(50 * i + 20),
+                                                    static_cast<uint8_t>(100 * j + 10 * block + 5), 0, 255 }};
+                });
+            }
+        }
+    });
+}
+
+TEST_F(DDSTests, probe_info)
+{
+    struct
+    {
+        const char* path;
+        ImgloadImageInfo info;
+    } files[] = {
+        { TEST_DATA_PATH "ddsimg/dx10_bc7_array.dds", { 8, 8, 1, 3, 4, IMGLOAD_FORMAT_R8G8B8A8, IMGLOAD_COMPRESSION_BC7 } },
+        { TEST_DATA_PATH "ddsimg/dx10_bc1_cube_array.dds", { 4, 4, 1, 12, 3, IMGLOAD_FORMAT_R8G8B8A8, IMGLOAD_COMPRESSION_DXT1 } },
+        { TEST_DATA_PATH "ddsimg/bc4u_volume.dds", { 4, 4, 4, 1, 3, IMGLOAD_FORMAT_R8G8B8A8, IMGLOAD_COMPRESSION_BC4 } },
+        { TEST_DATA_PATH "ddsimg/ati2_cube.dds", { 8, 8, 1, 4, 2, IMGLOAD_FORMAT_R8G8B8A8, IMGLOAD_COMPRESSION_BC5 } },
+    };
+
+    for (auto& file : files)
+    {
+        SCOPED_TRACE(file.path);
+
+        auto io = util::get_std_io();
+        auto file_ptr = std::fopen(file.path, "rb");
+        ASSERT_NE(nullptr, file_ptr);
+
+        ImgloadImageInfo info;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_probe_info(this->ctx, &io, static_cast<void*>(file_ptr), &info));
+
+        ASSERT_EQ(file.info.width, info.width);
+        ASSERT_EQ(file.info.height, info.height);
+        ASSERT_EQ(file.info.depth, info.depth);
+        ASSERT_EQ(file.info.subimages, info.subimages);
+        ASSERT_EQ(file.info.mipmaps, info.mipmaps);
+        ASSERT_EQ(file.info.format, info.format);
+        ASSERT_EQ(file.info.compression, info.compression);
+
+        std::fclose(file_ptr);
+    }
+}
+
+TEST_F(DDSTests, compression_formats)
+{
+    struct
+    {
+        const char* fourcc;
+        uint32_t dxgi_format;
+        ImgloadCompression compression;
+    } formats[] = {
+        { "DX10", 70, IMGLOAD_COMPRESSION_DXT1 }, { "DX10", 71, IMGLOAD_COMPRESSION_DXT1 },
+        { "DX10", 72, IMGLOAD_COMPRESSION_DXT1 }, { "DX10", 73, IMGLOAD_COMPRESSION_DXT3 },
+        { "DX10", 74, IMGLOAD_COMPRESSION_DXT3 }, { "DX10", 75, IMGLOAD_COMPRESSION_DXT3 },
+        { "DX10", 76, IMGLOAD_COMPRESSION_DXT5 }, { "DX10", 77, IMGLOAD_COMPRESSION_DXT5 },
+        { "DX10", 78, IMGLOAD_COMPRESSION_DXT5 }, { "DX10", 79, IMGLOAD_COMPRESSION_BC4 },
+        { "DX10", 80, IMGLOAD_COMPRESSION_BC4 }, { "DX10", 81, IMGLOAD_COMPRESSION_BC4_SNORM },
+        { "DX10", 82, IMGLOAD_COMPRESSION_BC5 }, { "DX10", 83, IMGLOAD_COMPRESSION_BC5 },
+        { "DX10", 84, IMGLOAD_COMPRESSION_BC5_SNORM }, { "DX10", 94, IMGLOAD_COMPRESSION_BC6H_UF16 },
+        { "DX10", 95, IMGLOAD_COMPRESSION_BC6H_UF16 }, { "DX10", 96, IMGLOAD_COMPRESSION_BC6H_SF16 },
+        { "DX10", 97, IMGLOAD_COMPRESSION_BC7 }, { "DX10", 98, IMGLOAD_COMPRESSION_BC7 },
+        { "DX10", 99, IMGLOAD_COMPRESSION_BC7 },
+        { "ATI1", 0, IMGLOAD_COMPRESSION_BC4 }, { "BC4U", 0, IMGLOAD_COMPRESSION_BC4 },
+        { "BC4S", 0, IMGLOAD_COMPRESSION_BC4_SNORM }, { "ATI2", 0, IMGLOAD_COMPRESSION_BC5 },
+        { "BC5U", 0, IMGLOAD_COMPRESSION_BC5 }, { "BC5S", 0, IMGLOAD_COMPRESSION_BC5_SNORM },
+        { "DXT1", 0, IMGLOAD_COMPRESSION_DXT1 }, { "DXT2", 0, IMGLOAD_COMPRESSION_DXT2 },
+        { "DXT3", 0, IMGLOAD_COMPRESSION_DXT3 }, { "DXT4", 0, IMGLOAD_COMPRESSION_DXT4 },
+        { "DXT5", 0, IMGLOAD_COMPRESSION_DXT5 },
+    };
+
+    for (auto& format : formats)
+    {
+        SCOPED_TRACE(format.fourcc);
+        SCOPED_TRACE(format.dxgi_format);
+
+        DDSParams params;
+        params.fourcc = format.fourcc;
+        params.dxgi_format = format.dxgi_format;
+        params.data_size = 16;
+        auto file = make_dds(params);
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, file.data(), file.size()));
+        ASSERT_EQ(format.compression, imgload_image_compression(img));
+
+        // The block directly follows the headers
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+        ImgloadImageData data;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, 0, 0, &data));
+        ASSERT_EQ(file.data() + file.size() - 16, static_cast<const uint8_t*>(data.data));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    }
+}
+
+TEST_F(DDSTests, subimage_counts)
+{
+    struct
+    {
+        DDSParams params;
+        size_t subimages;
+        uint32_t depth;
+    } layouts[4];
+
+    // Array of cube maps
+    layouts[0].params.array_size = 5;
+    layouts[0].params.misc_flag = DDS_RESOURCE_MISC_TEXTURECUBE;
+    layouts[0].subimages = 30;
+    layouts[0].depth = 1;
+
+    // DX10 volume texture, the array size is ignored
+    layouts[1].params.dimension = DDS_DIMENSION_TEXTURE3D;
+    layouts[1].params.depth = 6;
+    layouts[1].params.array_size = 3;
+    layouts[1].subimages = 1;
+    layouts[1].depth = 6;
+
+    // Legacy cube map which only stores three faces
+    layouts[2].params.fourcc = "BC4U";
+    layouts[2].params.caps2 = DDSCAPS2_CUBEMAP | 0x400 | 0x2000 | 0x8000;
+    layouts[2].subimages = 3;
+    layouts[2].depth = 1;
+
+    // Legacy volume texture
+    layouts[3].params.fourcc = "ATI2";
+    layouts[3].params.caps2 = DDSCAPS2_VOLUME;
+    layouts[3].params.depth = 5;
+    layouts[3].subimages = 1;
+    layouts[3].depth = 5;
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        SCOPED_TRACE(i);
+
+        auto file = make_dds(layouts[i].params);
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, file.data(), file.size()));
+        ASSERT_EQ(layouts[i].subimages, imgload_image_num_subimages(img));
+        ASSERT_EQ(layouts[i].depth, get_uint32(img, 0, IMGLOAD_PROPERTY_DEPTH));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    }
+}
+
+TEST_F(DDSTests, size_limits)
+{
+    struct
+    {
+        DDSParams params;
+        ImgloadErrorCode err;
+    } cases[9];
+
+    cases[0].params.width = 16384;
+    cases[0].err = IMGLOAD_ERR_NO_ERROR;
+    cases[1].params.width = 16385;
+    cases[1].err = IMGLOAD_ERR_FILE_INVALID;
+    cases[2].params.height = 0;
+    cases[2].err = IMGLOAD_ERR_FILE_INVALID;
+    cases[3].params.array_size = 2048;
+    cases[3].err = IMGLOAD_ERR_NO_ERROR;
+    cases[4].params.array_size = 2049;
+    cases[4].err = IMGLOAD_ERR_FILE_INVALID;
+    cases[5].params.array_size = 0;
+    cases[5].err = IMGLOAD_ERR_FILE_INVALID;
+    cases[6].params.mipmaps = 33;
+    cases[6].err = IMGLOAD_ERR_FILE_INVALID;
+    cases[7].params.dimension = DDS_DIMENSION_TEXTURE3D;
+    cases[7].params.depth = 16385;
+    cases[7].err = IMGLOAD_ERR_FILE_INVALID;
+    cases[8].params.fourcc = "BC4U";
+    cases[8].params.caps2 = DDSCAPS2_CUBEMAP;
+    cases[8].err = IMGLOAD_ERR_FILE_INVALID; // A cube map without any faces
+
+    for (size_t i = 0; i < 9; ++i)
+    {
+        SCOPED_TRACE(i);
+
+        auto file = make_dds(cases[i].params);
+
+        ImgloadImage img;
+        ASSERT_EQ(cases[i].err, imgload_image_init_from_memory(this->ctx, &img, file.data(), file.size()));
+        if (cases[i].err == IMGLOAD_ERR_NO_ERROR)
+        {
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+        }
+    }
+}
+
+TEST_F(DDSTests, truncated_data)
+{
+    // The size of the file has to cover the mipmap chains of all subimages
+    auto file = util::read_file(TEST_DATA_PATH "ddsimg/dx10_bc7_array.dds");
+    ASSERT_FALSE(file.empty());
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, file.data(), file.size() - 1));
+    ASSERT_EQ(IMGLOAD_ERR_FILE_INVALID, imgload_image_read_data(img));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, file.data(), file.size()));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(DDSTests, read_mipmaps)
+{
+    const char* path = TEST_DATA_PATH "ddsimg/dx10_bc7_array.dds";
+    auto contents = util::read_file(path);
+    ASSERT_FALSE(contents.empty());
+
+    ImgloadImage reference;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &reference, path));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(reference));
+
+    // Only the requested mipmaps have data and their blocks match the ones from reading the whole image
+    auto check_mipmaps = [&](ImgloadImage img) {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            for (size_t j = 0; j < 4; ++j)
+            {
+                ImgloadImageData data;
+                if (i != 2 || j < 1)
+                {
+                    ASSERT_EQ(IMGLOAD_ERR_NO_DATA, imgload_image_compressed_data(img, i, j, &data));
+                    continue;
+                }
+
+                ImgloadImageData expected;
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, i, j, &data));
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(reference, i, j, &expected));
+                ASSERT_EQ(expected.width, data.width);
+                ASSERT_EQ(expected.height, data.height);
+                ASSERT_EQ(expected.data_size, data.data_size);
+                ASSERT_EQ(0, std::memcmp(expected.data, data.data, data.data_size));
+            }
+        }
+    };
+
+    {
+        SCOPED_TRACE("mapped");
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, path));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_mipmaps(img, 2, 1, 3));
+        check_mipmaps(img);
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    }
+    {
+        SCOPED_TRACE("stream");
+
+        auto io = util::get_counting_io();
+        util::CountingFile file = {};
+        file.file = std::fopen(path, "rb");
+        ASSERT_NE(nullptr, file.file);
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init(this->ctx, &img, &io, &file));
+        size_t header_bytes = file.bytes_read;
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_mipmaps(img, 2, 1, 3));
+        check_mipmaps(img);
+
+        // The plugin seeks to the mipmaps instead of reading the subimages in front of them
+        ASSERT_EQ(16 + 16 + 16, file.bytes_read - header_bytes);
+        ASSERT_LT(0, file.seeks);
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+        std::fclose(file.file);
+    }
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(reference));
+}
+
+TEST_F(DDSTests, read_mipmaps_legacy)
+{
+    // Legacy DXT5 file with 7 mipmaps, the third one is 128x128 pixels large
+    const char* path = TEST_DATA_PATH "ddsimg/Col_Viper_Mk7e_Th11.dds";
+    const size_t MIPMAP = 2;
+    const size_t MIPMAP_SIZE = (128 / 4) * (128 / 4) * 16;
+
+    ImgloadImage reference;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &reference, path));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(reference));
+
+    ImgloadImageData expected;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(reference, 0, MIPMAP, &expected));
+    ASSERT_EQ(MIPMAP_SIZE, expected.data_size);
+
+    auto io = util::get_counting_io();
+    util::CountingFile file = {};
+    file.file = std::fopen(path, "rb");
+    ASSERT_NE(nullptr, file.file);
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init(this->ctx, &img, &io, &file));
+    size_t header_bytes = file.bytes_read;
+
+    // Only the blocks of the requested mipmap are read
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_mipmaps(img, 0, MIPMAP, 1));
+    ASSERT_EQ(MIPMAP_SIZE, file.bytes_read - header_bytes);
+
+    for (size_t j = 0; j < 7; ++j)
+    {
+        ImgloadImageData data;
+        ASSERT_EQ(j == MIPMAP ? IMGLOAD_ERR_NO_ERROR : IMGLOAD_ERR_NO_DATA, imgload_image_compressed_data(img, 0, j, &data));
+    }
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, 0, MIPMAP, &data));
+    ASSERT_EQ(expected.data_size, data.data_size);
+    ASSERT_EQ(0, std::memcmp(expected.data, data.data, data.data_size));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    std::fclose(file.file);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(reference));
+}
+
+TEST_F(DDSTests, compressed_passthrough_legacy)
+{
+    auto contents = util::read_file(TEST_DATA_PATH "ddsimg/Col_Viper_Mk7e_Th11.dds");
+    ASSERT_FALSE(contents.empty());
+
+    ImgloadImage decoded;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &decoded, contents.data(), contents.size()));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(decoded));
+
+    ImgloadContext decode_ctx = this->ctx;
+    this->ctx = nullptr;
+    this->makeContext(IMGLOAD_CONTEXT_COMPRESSED_PASSTHROUGH);
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, contents.data(), contents.size()));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    // Every mipmap is a view of its own blocks in the file, they follow the legacy header one after another
+    const uint8_t* expected_blocks = contents.data() + 128;
+    for (size_t j = 0; j < 7; ++j)
+    {
+        size_t size = 512 >> j;
+
+        ImgloadImageData compressed;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, 0, j, &compressed));
+        ASSERT_EQ(expected_blocks, static_cast<const uint8_t*>(compressed.data));
+        ASSERT_EQ(size * size, compressed.data_size);
+        expected_blocks += compressed.data_size;
+
+        ImgloadImageData expected;
+        ImgloadImageData actual;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(decoded, 0, j, &expected));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, j, &actual));
+        ASSERT_EQ(expected.data_size, actual.data_size);
+        ASSERT_EQ(0, std::memcmp(expected.data, actual.data, actual.data_size));
+    }
+    ASSERT_EQ(contents.data() + contents.size(), expected_blocks);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(decoded));
+    imgload_context_free(decode_ctx);
 }
\ No newline at end of file
@@ -0,0 +1,895 @@
+#include <imageloader.h>
+#include <imageloader_plugin.h>
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const uint8_t DXT_FILE[] = { 'D', 'X', 'T', '!' };
+
+    struct DxtPluginData
+    {
+        ImgloadCompression compression;
+        size_t width;
+        size_t height;
+        size_t subimages;
+        size_t mipmaps;
+
+        // The blocks of every mipmap, indexed by subimage * mipmaps + mipmap
+        std::vector<std::vector<uint8_t>> blocks;
+
+        // The mipmaps requested through the read_mipmaps callback
+        std::vector<std::array<size_t, 3>> mipmap_reads;
+    };
+
+    size_t block_bytes(ImgloadCompression compression)
+    {
+        switch (compression)
+        {
+        case IMGLOAD_COMPRESSION_DXT1:
+        case IMGLOAD_COMPRESSION_BC4:
+        case IMGLOAD_COMPRESSION_BC4_SNORM:
+            return 8;
+        default:
+            return 16;
+        }
+    }
+
+    size_t mip_size(size_t size, size_t mipmap)
+    {
+        size_t mip = size >> mipmap;
+        return mip > 0 ? mip : 1;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK dxt_init_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto data = static_cast<DxtPluginData*>(imgload_plugin_get_data(plugin));
+
+        imgload_plugin_image_set_data_type(img, IMGLOAD_FORMAT_R8G8B8A8, data->compression);
+        imgload_plugin_image_set_num_frames(img, data->subimages);
+
+        for (size_t i = 0; i < data->subimages; ++i)
+        {
+            imgload_plugin_image_set_num_mipmaps(img, i, data->mipmaps);
+        }
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode dxt_set_blocks(ImgloadImage img, DxtPluginData* data, size_t subimage, size_t mipmap)
+    {
+        auto& blocks = data->blocks[subimage * data->mipmaps + mipmap];
+
+        ImgloadImageData compressed;
+        compressed.width = mip_size(data->width, mipmap);
+        compressed.height = mip_size(data->height, mipmap);
+        compressed.depth = 1;
+        compressed.stride = 0;
+        compressed.data_size = blocks.size();
+        compressed.data = blocks.data();
+
+        // The blocks outlive the image so they can be referenced
+        return imgload_plugin_image_compressed_passthrough(img)
+            ? imgload_plugin_image_reference_compressed_data(img, subimage, mipmap, &compressed)
+            : imgload_plugin_image_set_compressed_data(img, subimage, mipmap, &compressed, 0);
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK dxt_read_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto data = static_cast<DxtPluginData*>(imgload_plugin_get_data(plugin));
+
+        for (size_t i = 0; i < data->subimages; ++i)
+        {
+            for (size_t j = 0; j < data->mipmaps; ++j)
+            {
+                auto err = dxt_set_blocks(img, data, i, j);
+                if (err != IMGLOAD_ERR_NO_ERROR)
+                {
+                    return err;
+                }
+            }
+        }
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK dxt_read_mipmaps(ImgloadPlugin plugin, ImgloadImage img, size_t subimage,
+                                                       size_t first_mipmap, size_t n_mipmaps)
+    {
+        auto data = static_cast<DxtPluginData*>(imgload_plugin_get_data(plugin));
+        data->mipmap_reads.push_back({{ subimage, first_mipmap, n_mipmaps }});
+
+        for (size_t j = first_mipmap; j < first_mipmap + n_mipmaps; ++j)
+        {
+            auto err = dxt_set_blocks(img, data, subimage, j);
+            if (err != IMGLOAD_ERR_NO_ERROR)
+            {
+                return err;
+            }
+        }
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK dxt_plugin_loader(ImgloadPlugin plugin, void* parameter)
+    {
+        imgload_plugin_set_info(plugin, "dxt", "DXT plugin", "Plugin providing block compressed data");
+        imgload_plugin_set_data(plugin, parameter);
+
+        auto err = imgload_plugin_register_signature(plugin, DXT_FILE, sizeof(DXT_FILE));
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        imgload_plugin_callback_init_image(plugin, dxt_init_image);
+        imgload_plugin_callback_read_data(plugin, dxt_read_image);
+        imgload_plugin_callback_read_mipmaps(plugin, dxt_read_mipmaps);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    /**
+     * @brief Creates a plugin data with a single 4x4 mipmap consisting of the given block
+     */
+    DxtPluginData single_block(ImgloadCompression compression, const std::vector<uint8_t>& block)
+    {
+        DxtPluginData data;
+        data.compression = compression;
+        data.width = 4;
+        data.height = 4;
+        data.subimages = 1;
+        data.mipmaps = 1;
+        data.blocks.push_back(block);
+
+        return data;
+    }
+
+    /**
+     * @brief Fills all mipmaps of the plugin data with random blocks
+     */
+    void random_blocks(DxtPluginData& data)
+    {
+        std::srand(42);
+        for (size_t i = 0; i < data.subimages * data.mipmaps; ++i)
+        {
+            size_t mipmap = i % data.mipmaps;
+            size_t blocks = ((mip_size(data.width, mipmap) + 3) / 4) * ((mip_size(data.height, mipmap) + 3) / 4);
+
+            std::vector<uint8_t> bytes(blocks * block_bytes(data.compression));
+            for (auto& byte : bytes)
+            {
+                byte = static_cast<uint8_t>(std::rand());
+            }
+            data.blocks.push_back(bytes);
+        }
+    }
+
+    // A color block which uses color i % 4 for pixel i
+    const uint8_t RED_BLUE_BLOCK[] = { 0x00, 0xF8, 0x1F, 0x00, 0xE4, 0xE4, 0xE4, 0xE4 };
+
+    // A color block which is white everywhere
+    const uint8_t WHITE_BLOCK[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00 };
+
+    /**
+     * @brief A block and the RGBA pixels it decodes to
+     * The pixels were computed by an independent decoder written from the specification.
+     */
+    struct KnownBlock
+    {
+        uint8_t block[16];
+        uint8_t pixels[64];
+    };
+
+    // A block of every BC7 mode and its pixels
+    const KnownBlock BC7_MODE_BLOCKS[] = {
+        // Mode 0, three subsets with a p-bit per endpoint
+        { { 0x53, 0xF2, 0x26, 0x65, 0xA6, 0x0C, 0x12, 0xD2, 0x89, 0x18, 0x5D, 0x95, 0x0E, 0xE8, 0x81, 0x36 },
+          {  82,  49,  62, 255,  65,  49,  42, 255, 116,  49, 106, 255,  65,  49,  42, 255,
+             99,  89, 187, 255,  57, 107,  74, 255, 115,  82, 231, 255, 115,  82, 231, 255,
+             99,  89, 187, 255,  65, 103,  96, 255,  91,  93, 165, 255, 115,  82, 231, 255,
+             86,  90, 147, 255,  56, 134, 186, 255,  56, 134, 186, 255, 148,   0,  66, 255 } },
+        // Mode 1, two subsets with a shared p-bit per subset
+        { { 0x0A, 0x16, 0x6F, 0x6B, 0x11, 0x3D, 0x17, 0x8D, 0x6C, 0x0F, 0xD3, 0x90, 0x1F, 0xF2, 0x39, 0xA1 },
+          {  90,  70,  54, 255, 138,  74,  72, 255, 203, 181, 190, 255, 154, 100, 100, 255,
+            178, 152, 140, 255, 106,  22,  14, 255, 171, 129, 133, 255, 219, 207, 219, 255,
+            112,  90,  75, 255, 106,  22,  14, 255, 171, 129, 133, 255, 122,  48,  43, 255,
+            112,  90,  75, 255, 203, 181, 190, 255, 154, 100, 100, 255, 187, 155, 161, 255 } },
+        // Mode 2, three subsets without p-bits
+        { { 0xA4, 0x95, 0xF2, 0x0F, 0x93, 0x95, 0x65, 0x0C, 0xF9, 0x38, 0x0B, 0x8E, 0xDB, 0x22, 0x4A, 0x6B },
+          {  82, 128,  76, 255, 144,  73,  76, 255,  33, 206, 115, 255,  87, 141,  96, 255,
+             82,  90,  57, 255, 247, 148, 181, 255, 206, 145, 122, 255, 247, 148, 181, 255,
+             82, 128,  76, 255, 206, 145, 122, 255, 164, 143,  59, 255, 164, 143,  59, 255,
+             82, 128,  76, 255, 144,  73,  76, 255,  33, 206, 115, 255, 198,   8,  57, 255 } },
+        // Mode 3, two subsets with a p-bit per endpoint
+        { { 0x28, 0x8A, 0x1E, 0x92, 0x4E, 0x8F, 0xD0, 0xAE, 0x2E, 0x1A, 0x94, 0x92, 0xA3, 0x30, 0x5F, 0x18 },
+          {  68, 122,  22, 255,  37, 219,  41, 255,  56,  85,  24, 255,  44, 203,  52, 255,
+             37, 219,  41, 255,  43,  46,  25, 255,  44, 203,  52, 255,  68, 122,  22, 255,
+             31,   9,  27, 255,  59, 171,  75, 255,  56,  85,  24, 255,  44, 203,  52, 255,
+             37, 219,  41, 255,  43,  46,  25, 255,  44, 203,  52, 255,  68, 122,  22, 255 } },
+        // Mode 4, separate alpha indices which are swapped by the index selection bit, alpha rotated into green
+        { { 0xD0, 0xB6, 0x10, 0x90, 0x0F, 0x9E, 0x34, 0x7F, 0xAE, 0x88, 0x6D, 0xC6, 0x50, 0x77, 0x95, 0xEC },
+          { 142, 164, 164,  24,  80,  99,  99,   9, 161, 164, 185,  28, 122,  99, 143,  19,
+            100,  36, 120,  14, 161,  36, 185,  28, 100,  36, 120,  14, 142, 227, 164,  24,
+             41,  36,  57,   0,  61, 164,  78,   5,  80, 164,  99,   9, 142, 164, 164,  24,
+            161, 227, 185,  28, 161, 164, 185,  28, 122, 227, 143,  19,  41,  36,  57,   0 } },
+        // Mode 5, separate alpha indices, alpha rotated into red
+        { { 0x60, 0x5C, 0x4C, 0x3F, 0xCB, 0x2E, 0xB2, 0xC7, 0x3E, 0x14, 0x93, 0x4C, 0x86, 0x7E, 0xE0, 0x57 },
+          { 217, 227, 191, 140, 217, 179, 139,  48, 236, 227, 191, 140, 196, 251, 217, 185,
+            196, 203, 165,  93, 177, 203, 165,  93, 177, 251, 217, 185, 217, 203, 165,  93,
+            236, 227, 191, 140, 236, 203, 165,  93, 196, 251, 217, 185, 177, 227, 191, 140,
+            177, 203, 165,  93, 217, 227, 191, 140, 217, 203, 165,  93, 217, 251, 217, 185 } },
+        // Mode 6, one subset with a p-bit per endpoint
+        { { 0xC0, 0x72, 0x49, 0x9B, 0xFA, 0x12, 0x1E, 0x83, 0x6B, 0x2A, 0xC1, 0x57, 0x26, 0xEE, 0x7D, 0x6B },
+          { 161, 149, 131,  23, 151, 141, 117,  21, 117, 115,  69,  15, 185, 167, 165,  28,
+            195, 175, 180,  30, 101, 103,  46,  12, 143, 135, 106,  20, 161, 149, 131,  23,
+            151, 141, 117,  21, 185, 167, 165,  28,  83,  89,  20,   9,  83,  89,  20,   9,
+             93,  97,  35,  10, 143, 135, 106,  20, 109, 109,  57,  13, 151, 141, 117,  21 } },
+        // Mode 7, two subsets with alpha
+        { { 0x80, 0xF6, 0xAB, 0x13, 0xC3, 0x8E, 0x92, 0xCA, 0xE0, 0xD1, 0x50, 0x57, 0xB1, 0x59, 0x98, 0x7F },
+          { 125, 134,  85, 166, 183,  72,  83, 117, 170,  70,  42, 146, 155, 202, 164,  60,
+            140, 167, 124, 114, 155, 202, 164,  60, 170,  70,  42, 146, 170,  70,  42, 146,
+            158,  69,   4, 174, 155, 202, 164,  60, 140, 167, 124, 114, 183,  72,  83, 117,
+            195,  73, 121,  89, 195,  73, 121,  89, 170, 235, 203,   8, 140, 167, 124, 114 } },
+    };
+
+    // A block of every BC6H mode and its pixels when decoded as unsigned
+    const KnownBlock BC6H_UF16_MODE_BLOCKS[] = {
+        // Mode 1, two regions with transformed 10 bit endpoints and partition 14
+        { { 0x5C, 0x33, 0xDF, 0x70, 0x33, 0xB1, 0xB5, 0xAE, 0xDE, 0xC9, 0x85, 0x8B, 0x84, 0xDC, 0x0A, 0xF7 },
+          {  46, 100,  84, 255,  45,  97,  85, 255,  51, 122,  79, 255,  47, 104,  83, 255,
+             44,  79,  64, 255,  44,  79,  64, 255,  60,  81,  64, 255,  52,  80,  64, 255,
+             37,  78,  64, 255,  41,  78,  64, 255,  41,  78,  64, 255,  52,  80,  64, 255,
+             60,  81,  64, 255,  33,  77,  64, 255,  37,  78,  64, 255,  49,  80,  64, 255 } },
+        // Mode 2, two regions with transformed 7 bit endpoints and partition 7
+        { { 0xC5, 0x16, 0x1B, 0x63, 0x08, 0x9A, 0x88, 0x02, 0xF4, 0xFE, 0x88, 0x40, 0x29, 0x32, 0x8B, 0xED },
+          {  81,  94,  42, 255,  76,  76,  32, 255,  79,  85,  37, 255,  76,  76,  32, 255,
+             81,  94,  42, 255,  79,  85,  37, 255,  88, 121,  59, 255,  28,  47,  32, 255,
+             79,  85,  37, 255,  83, 102,  48, 255,  44,  83,  38, 255,  31,  56,  34, 255,
+             85, 112,  54, 255,  40,  75,  37, 255,  40,  75,  37, 255,  34,  60,  35, 255 } },
+        // Mode 3, two regions with transformed 11 bit endpoints and partition 23
+        { { 0x22, 0xE5, 0x93, 0x0D, 0x47, 0xA8, 0x49, 0x60, 0xD7, 0xF0, 0x06, 0x86, 0x55, 0xD7, 0x6D, 0x5E },
+          {  40,  39, 106, 255,  45,  41, 101, 255,  42,  38, 102, 255,  45,  40, 101, 255,
+             42,  38, 106, 255,  43,  38, 106, 255,  44,  39, 101, 255,  42,  37, 102, 255,
+             42,  38, 106, 255,  43,  38, 106, 255,  43,  39, 101, 255,  43,  39, 101, 255,
+             42,  38, 106, 255,  43,  38, 106, 255,  42,  38, 106, 255,  45,  40, 101, 255 } },
+        // Mode 4, two regions with transformed 11 bit endpoints and partition 5
+        { { 0xC6, 0x71, 0xC4, 0xCB, 0x16, 0xF5, 0x61, 0xF7, 0x40, 0xB2, 0x94, 0x7D, 0xDD, 0xF1, 0x26, 0xDE },
+          { 114, 110,  74, 255, 114, 110,  74, 255, 115, 112,  77, 255, 117, 104,  72, 255,
+            114, 114,  73, 255, 116, 108,  75, 255, 115, 112,  77, 255, 117, 104,  72, 255,
+            114, 108,  74, 255, 117, 104,  72, 255, 116, 108,  75, 255, 114, 116,  80, 255,
+            114, 116,  80, 255, 117, 106,  73, 255, 115, 112,  77, 255, 115, 112,  77, 255 } },
+        // Mode 5, two regions with transformed 11 bit endpoints and partition 29
+        { { 0xEA, 0xE6, 0xBC, 0xA9, 0x57, 0x97, 0x14, 0x2B, 0xD6, 0xB5, 0xF7, 0x4A, 0x40, 0xF2, 0x06, 0x8E },
+          {  46,  94, 232, 255,  44,  97, 215, 255,  45,  96, 221, 255,  46,  94, 229, 255,
+             44,  90, 221, 255,  44,  88, 206, 255,  44,  88, 206, 255,  44,  89, 213, 255,
+             44,  89, 213, 255,  44,  94, 252, 255,  44,  91, 229, 255,  44,  91, 229, 255,
+             47,  93, 235, 255,  45,  96, 224, 255,  45,  95, 227, 255,  45,  96, 224, 255 } },
+        // Mode 6, two regions with transformed 9 bit endpoints and partition 30
+        { { 0xCE, 0xD9, 0x69, 0x88, 0xDD, 0x83, 0xCC, 0xF0, 0xC8, 0xD3, 0xC7, 0x2E, 0xC7, 0x6F, 0xE6, 0x8C },
+          {  47,  59,  30, 255,  59,  51,  26, 255,  56,  57,  23, 255,  61,  44,  29, 255,
+             45,  60,  31, 255,  40,  65,  31, 255,  47,  59,  30, 255,  61,  46,  28, 255,
+             61,  44,  29, 255,  41,  63,  31, 255,  47,  59,  30, 255,  44,  61,  31, 255,
+             61,  46,  28, 255,  56,  57,  23, 255,  58,  53,  25, 255,  42,  62,  31, 255 } },
+        // Mode 7, two regions with transformed 8 bit endpoints and partition 19
+        { { 0x32, 0x0E, 0xB8, 0xD1, 0xF0, 0x9D, 0x16, 0xC7, 0x89, 0x7F, 0x36, 0x27, 0x17, 0x42, 0x68, 0x21 },
+          { 109,  90,  60, 255, 126, 101, 120, 255, 135,  97, 133, 255, 126, 101, 120, 255,
+            107,  77,  72, 255,  98,  44, 142, 255, 114, 110, 100, 255, 157,  88, 172, 255,
+            107,  77,  72, 255, 111, 103,  53, 255, 109,  90,  60, 255, 120, 106, 110, 255,
+             98,  44, 142, 255, 107,  77,  72, 255, 111, 103,  53, 255, 109,  90,  60, 255 } },
+        // Mode 8, two regions with transformed 8 bit endpoints and partition 5
+        { { 0x36, 0xAD, 0xB1, 0xCB, 0x20, 0x1D, 0x92, 0xBE, 0x88, 0xA0, 0xE4, 0x5E, 0x14, 0x2C, 0x2C, 0x40 },
+          {  59,  42,  40, 255,  76, 109,  32, 255,  64,  99,  55, 255,  60, 157,  53, 255,
+             61,  51,  38, 255,  67,  77,  56, 255,  74,  47,  58, 255,  80,  29,  60, 255,
+             76, 109,  32, 255,  74,  47,  58, 255,  80,  29,  60, 255,  71,  58,  57, 255,
+             77,  37,  59, 255,  80,  29,  60, 255,  80,  29,  60, 255,  77,  37,  59, 255 } },
+        // Mode 9, two regions with transformed 8 bit endpoints and partition 8
+        { { 0x3A, 0xCD, 0x36, 0xCF, 0xF0, 0xD1, 0x66, 0x26, 0x74, 0x04, 0x99, 0xEE, 0x37, 0x84, 0xDF, 0xD4 },
+          {  54,  61,  62, 255,  56,  69,  55, 255,  51,  44, 101, 255,  53,  56,  73, 255,
+             49,  33, 127, 255,  49,  33, 127, 255,  50,  39, 114, 255,  57,  80,  49, 255,
+             54,  61,  62, 255,  57,  80,  49, 255,  49,  33, 127, 255, 111,  57,  73, 255,
+             50,  39, 114, 255,  52,  50,  88, 255,  49,  45, 151, 255,  56,  48, 126, 255 } },
+        // Mode 10, two regions with 6 bit endpoints and partition 7
+        { { 0x5E, 0xFB, 0x0D, 0x35, 0xC5, 0xD4, 0x73, 0xCD, 0x31, 0xED, 0x04, 0xB2, 0xB1, 0x53, 0x13, 0x0C },
+          {  54,  97,  59, 255,  59,  84,  59, 255,  41, 148,  59, 255,  41, 148,  59, 255,
+             36, 174,  59, 255,  54,  97,  59, 255,  32, 200,  59, 255,  54, 191,  97, 255,
+             54,  97,  59, 255,  36, 174,  59, 255,  54, 191,  97, 255,  45, 125, 123, 255,
+             59,  84,  59, 255,  45, 125, 123, 255,  32,  71, 200, 255,  30,  59, 226, 255 } },
+        // Mode 11, one region with 10 bit endpoints
+        { { 0x23, 0xBB, 0xD4, 0xAC, 0xC3, 0x8C, 0xB4, 0xD3, 0xAC, 0xB6, 0x0D, 0x6C, 0x12, 0xED, 0x94, 0x1F },
+          {  98,  58, 106, 255,  64,  57,  82, 255,  98,  58, 106, 255,  60,  56,  76, 255,
+             52,  56,  65, 255, 170,  60, 159, 255,  56,  56,  71, 255,  98,  58, 106, 255,
+            135,  59, 133, 255, 154,  60, 147, 255,  52,  56,  65, 255,  47,  55,  61, 255,
+            115,  59, 119, 255,  74,  57,  89, 255,  44,  55,  58, 255, 154,  60, 147, 255 } },
+        // Mode 12, one region with transformed 11 bit endpoints
+        { { 0xC7, 0x72, 0x95, 0x6B, 0x66, 0x4F, 0x09, 0x16, 0x98, 0x88, 0x7C, 0xF9, 0x3C, 0x55, 0x62, 0x7F },
+          { 116,  50,  51, 255, 110,  62,  58, 255, 111,  59,  57, 255, 111,  59,  57, 255,
+            106,  74,  63, 255, 112,  57,  56, 255, 110,  62,  58, 255, 102,  88,  70, 255,
+            106,  74,  63, 255, 117,  48,  50, 255, 115,  52,  53, 255, 115,  52,  53, 255,
+            119,  45,  49, 255, 113,  55,  54, 255, 102,  88,  70, 255, 112,  57,  56, 255 } },
+        // Mode 13, one region with transformed 12 bit endpoints
+        { { 0x6B, 0x5F, 0x5F, 0x31, 0x6F, 0x50, 0xD6, 0x5F, 0x53, 0x2A, 0x7A, 0x8B, 0x06, 0xCD, 0x6D, 0x8C },
+          {  98,  66, 215, 255,  99,  60, 198, 255, 102,  53, 177, 255,  98,  63, 210, 255,
+            102,  53, 177, 255, 100,  57, 189, 255, 102,  52, 173, 255, 101,  56, 186, 255,
+            100,  58, 193, 255,  97,  68, 219, 255, 103,  50, 165, 255, 102,  51, 169, 255,
+            103,  50, 165, 255, 100,  58, 193, 255, 102,  51, 169, 255, 101,  56, 186, 255 } },
+        // Mode 14, one region with transformed 16 bit endpoints
+        { { 0x2F, 0x03, 0xAC, 0x86, 0x76, 0x7B, 0xBD, 0x31, 0x26, 0x78, 0xCC, 0xDE, 0x09, 0x14, 0xFD, 0x0F },
+          {  69, 216,  32, 255,  69, 216,  32, 255,  69, 216,  33, 255,  69, 216,  32, 255,
+             69, 216,  33, 255,  69, 216,  33, 255,  69, 216,  33, 255,  69, 216,  33, 255,
+             69, 216,  33, 255,  69, 216,  32, 255,  69, 216,  32, 255,  69, 216,  32, 255,
+             69, 216,  33, 255,  69, 216,  33, 255,  69, 216,  33, 255,  69, 216,  32, 255 } },
+    };
+
+    // A block of every BC6H mode and its pixels when decoded as signed, negative values are clamped to 0
+    const KnownBlock BC6H_SF16_MODE_BLOCKS[] = {
+        // Mode 1, two regions with transformed 10 bit endpoints and partition 29
+        { { 0xC0, 0x98, 0x17, 0xC6, 0x31, 0x90, 0xE6, 0xE7, 0x96, 0xB2, 0x03, 0x68, 0xA0, 0x74, 0x12, 0xCE },
+          {  32,   0, 113, 255,  32,   0, 113, 255,  32,   0, 113, 255,  36,   0, 131, 255,
+             49,   0, 159, 255,  54,   0, 153, 255,  47,   0, 162, 255,  50,   0, 157, 255,
+             50,   0, 157, 255,  44,   0, 166, 255,  52,   0, 155, 255,  52,   0, 155, 255,
+             34,   0, 121, 255,  39,   0, 166, 255,  37,   0, 148, 255,  42,   0, 198, 255 } },
+        // Mode 2, two regions with transformed 7 bit endpoints and partition 15
+        { { 0x41, 0xF3, 0xFD, 0x3C, 0x17, 0x4A, 0x36, 0xBD, 0x05, 0xE0, 0xBD, 0xC1, 0x04, 0x76, 0x87, 0xB3 },
+          {  79,   0,  99, 255,  79,   0,  99, 255,  79,   0,  99, 255,  59,   0, 226, 255,
+            106,   0,  41, 255,  89,   0,  70, 255,  59,   0, 226, 255,  59,   0, 226, 255,
+             79,   0,  99, 255, 115,   0,  30, 255, 106,   0,  41, 255,  63,   0, 174, 255,
+             79,   0, 120, 255,  89,   0, 110, 255,  63,   0, 147, 255,  98,   0, 102, 255 } },
+        // Mode 3, two regions with transformed 11 bit endpoints and partition 19
+        { { 0x42, 0xB4, 0x62, 0x12, 0x53, 0xA2, 0x01, 0x42, 0xD9, 0x7B, 0xB6, 0x47, 0xE6, 0xDA, 0x0D, 0x19 },
+          {  55,   0,  31, 255,  56,   0,  28, 255,  56,   0,  28, 255,  56,   0,  28, 255,
+             59,   0,  32, 255,  59,   0,  32, 255,  62,   1,  28, 255,  45,   0,  29, 255,
+             56,   0,  31, 255,  57,   0,  31, 255,  63,   0,  33, 255,  47,   0,  28, 255,
+             53,   0,  30, 255,  56,   0,  31, 255,  61,   0,  32, 255,  53,   0,  30, 255 } },
+        // Mode 4, two regions with transformed 11 bit endpoints and partition 11
+        { { 0x06, 0xB4, 0x72, 0xA3, 0x3B, 0x67, 0x5F, 0xE2, 0xD4, 0x7D, 0x0D, 0xBA, 0xBD, 0x82, 0x30, 0x35 },
+          {  54,   0, 146, 255,  51,   0, 139, 255,  55,   0, 148, 255,  57,   0, 153, 255,
+             56,   0, 150, 255,  56,   0, 150, 255,  58,   0, 155, 255,  53,   0, 144, 255,
+             52,   0, 141, 255,  51,   0, 139, 255,  52,   0, 141, 255,  46,   0, 142, 255,
+             52,   0, 141, 255,  46,   0, 136, 255,  46,   0, 130, 255,  45,   0, 166, 255 } },
+        // Mode 5, two regions with transformed 11 bit endpoints and partition 27
+        { { 0xEA, 0xB7, 0x1F, 0xD2, 0x7B, 0x40, 0xF1, 0x42, 0xF2, 0x68, 0x13, 0xB3, 0xF8, 0xD7, 0xE4, 0x2F },
+          {  99,   0, 232, 255,  98,   0, 235, 255,  89,   0, 226, 255,  87,   0, 233, 255,
+             98,   0, 240, 255,  87,   0, 233, 255,  98,   0, 200, 255,  97,   0, 251, 255,
+             97,   0, 251, 255,  89,   0, 226, 255,  92,   0, 220, 255,  98,   0, 237, 255,
+             98,   0, 200, 255, 101,   0, 193, 255,  98,   0, 240, 255,  98,   0, 235, 255 } },
+        // Mode 6, two regions with transformed 9 bit endpoints and partition 22
+        { { 0x4E, 0x8D, 0xF7, 0xC8, 0xFC, 0x93, 0x88, 0xCC, 0xD2, 0xC7, 0x86, 0x56, 0x18, 0x19, 0xEA, 0x8A },
+          {  60,   0,  33, 255,  60,   0,  37, 255,  58,   0,  25, 255,  58,   0,  25, 255,
+             59,   0,  31, 255,  60,   0,  37, 255,  59,   0,  29, 255,  58,   0,  27, 255,
+            127,   0,  60, 255,  59,   0,  29, 255,  60,   0,  37, 255,  58,   0,  25, 255,
+            205,   0,  16, 255, 192,   0,  21, 255,  59,   0,  31, 255,  58,   0,  27, 255 } },
+        // Mode 7, two regions with transformed 8 bit endpoints and partition 17
+        { { 0x32, 0x26, 0xFA, 0x61, 0x20, 0xA6, 0xEE, 0xB2, 0x86, 0x35, 0x4E, 0x0D, 0xD6, 0x46, 0x67, 0x0F },
+          {  45,   0,  40, 255,   5,   0,  79, 255,  17,   0,  70, 255,   2,   0,  88, 255,
+             32,   0,  28, 255,  49,   0,  46, 255,  54,   0,  52, 255,   2,   0,  88, 255,
+             58,   0,  57, 255,  32,   0,  28, 255,  54,   0,  52, 255,  45,   0,  40, 255,
+             58,   0,  57, 255,  58,   0,  57, 255,  45,   0,  40, 255,  32,   0,  28, 255 } },
+        // Mode 8, two regions with transformed 8 bit endpoints and partition 0
+        { { 0xD6, 0x06, 0x77, 0x6D, 0xDC, 0xF4, 0x06, 0x20, 0x46, 0x13, 0x20, 0xA7, 0x52, 0x29, 0x25, 0x7E },
+          {  76,   0,  76, 255,  59,   0,  76, 255, 198,   0,  45, 255, 131,   0,  81, 255,
+             42,   0,  76, 255,  59,   0,  76, 255, 144,   0,  70, 255, 185,   0,  50, 255,
+             48,   0,  76, 255,  59,   0,  76, 255, 144,   0,  70, 255, 131,   0,  81, 255,
+             66,   0,  76, 255,  37,   0,  76, 255, 211,   0,  39, 255, 131,   0,  81, 255 } },
+        // Mode 9, two regions with transformed 8 bit endpoints and partition 11
+        { { 0x3A, 0xC6, 0x85, 0x72, 0x1E, 0x0C, 0x0F, 0x1E, 0xFB, 0x7F, 0x81, 0x7F, 0xBF, 0xEE, 0x44, 0xB5 },
+          {  32,   0, 123, 255,  32,   0, 123, 255,  55,   0,  62, 255,  55,   0,  62, 255,
+             41,   0,  97, 255,  55,   0,  62, 255,  55,   0,  62, 255,  38,   0, 105, 255,
+             55,   0,  62, 255,  51,   0,  70, 255,  35,   0, 114, 255,  21,   0,  37, 255,
+             38,   0, 105, 255,  26,   0,  59, 255,  27,   0,  66, 255,  22,   0,  42, 255 } },
+        // Mode 10, two regions with 6 bit endpoints and partition 8
+        { { 0x9E, 0xB9, 0x82, 0x98, 0x61, 0x7C, 0xC1, 0xC6, 0x19, 0x06, 0x91, 0x4C, 0xA7, 0x96, 0x52, 0xE5 },
+          {  35,   0,  35, 255,  35,   1,  40, 255,  35,   1,  40, 255,  35,   2,  48, 255,
+             35,   1,  44, 255,  35,  18,  69, 255,  35,   3,  53, 255,  35,   1,  44, 255,
+             35,   2,  48, 255,  35,   1,  40, 255,  35,   6,  58, 255,  35,   0, 205, 255,
+             35,   1,  44, 255,  35,   6,  58, 255,  35,   0, 205, 255,  35,   0, 186, 255 } },
+        // Mode 11, one region with 10 bit endpoints
+        { { 0x63, 0x99, 0xF4, 0xC5, 0x01, 0x27, 0xFA, 0x73, 0x78, 0xBA, 0x61, 0xC5, 0x85, 0xCA, 0x85, 0x13 },
+          {  53,   0, 114, 255,  61,   0, 118, 255,  75,   0, 122, 255,  80,   0, 123, 255,
+             45,   0, 110, 255,  59,   0, 117, 255,  55,   0, 116, 255,  85,   0, 125, 255,
+             55,   0, 116, 255,  64,   0, 119, 255,  75,   0, 122, 255,  85,   0, 125, 255,
+             55,   0, 116, 255,  64,   0, 119, 255,  50,   0, 113, 255,  45,   0, 110, 255 } },
+        // Mode 12, one region with transformed 11 bit endpoints
+        { { 0xC7, 0xBA, 0x1E, 0x7C, 0xB3, 0xAF, 0x94, 0x08, 0x82, 0xBC, 0xC8, 0x4B, 0xAB, 0xE2, 0x57, 0x91 },
+          { 156,   0,  99, 255, 138,   0, 114, 255, 128,   0, 123, 255, 130,   0, 121, 255,
+            138,   0, 114, 255, 128,   0, 123, 255, 130,   0, 121, 255, 148,   0, 105, 255,
+            130,   0, 121, 255, 133,   0, 119, 255, 153,   0, 101, 255, 125,   1, 127, 255,
+            140,   0, 112, 255, 146,   0, 107, 255, 156,   0,  99, 255, 136,   0, 116, 255 } },
+        // Mode 13, one region with transformed 12 bit endpoints
+        { { 0x6B, 0x73, 0x38, 0xAE, 0x4E, 0x40, 0x17, 0x75, 0x48, 0xB6, 0x5F, 0x04, 0x47, 0x3E, 0x42, 0xC8 },
+          { 129,   0,  59, 255, 129,   0,  59, 255, 132,   0,  58, 255, 137,   0,  54, 255,
+            142,   0,  52, 255, 130,   0,  59, 255, 129,   0,  59, 255, 126,   0,  62, 255,
+            133,   0,  57, 255, 129,   0,  59, 255, 141,   0,  52, 255, 128,   0,  60, 255,
+            127,   0,  61, 255, 129,   0,  59, 255, 134,   0,  56, 255, 139,   0,  54, 255 } },
+        // Mode 14, one region with transformed 16 bit endpoints
+        { { 0xAF, 0x1B, 0x89, 0x11, 0x13, 0x76, 0x36, 0x61, 0xFE, 0x57, 0x10, 0x01, 0x5C, 0x57, 0x31, 0x60 },
+          {  57,   0,  32, 255,  58,   0,  32, 255,  57,   0,  32, 255,  57,   0,  32, 255,
+             57,   0,  32, 255,  57,   0,  32, 255,  57,   0,  32, 255,  57,   0,  32, 255,
+             58,   0,  32, 255,  57,   0,  32, 255,  57,   0,  32, 255,  57,   0,  32, 255,
+             57,   0,  32, 255,  57,   0,  32, 255,  57,   0,  32, 255,  57,   0,  32, 255 } },
+    };
+}
+
+class DecompressTests : public util::ContextFixture
+{
+protected:
+    std::vector<uint8_t> decodeSingle(DxtPluginData& plugin_data)
+    {
+        this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+        ImgloadImage img;
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, DXT_FILE, sizeof(DXT_FILE)));
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_decompress_all(img, 1));
+
+        ImgloadImageData data;
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+        EXPECT_EQ(16u, data.stride);
+
+        auto pixels = static_cast<const uint8_t*>(data.data);
+        std::vector<uint8_t> result(pixels, pixels + 64);
+
+        imgload_image_free(img);
+
+        return result;
+    }
+
+    void checkKnownBlock(ImgloadCompression compression, const KnownBlock& known)
+    {
+        auto plugin_data = single_block(compression, std::vector<uint8_t>(std::begin(known.block), std::end(known.block)));
+        auto pixels = this->decodeSingle(plugin_data);
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                ASSERT_EQ(known.pixels[i * 4 + c], pixels[i * 4 + c]) << "pixel " << i << ", channel " << c;
+            }
+        }
+    }
+};
+
+TEST_F(DecompressTests, dxt1)
+{
+    const std::array<uint8_t, 4> palette[] = {
+        {{ 255, 0, 0, 255 }}, {{ 0, 0, 255, 255 }}, {{ 170, 0, 85, 255 }}, {{ 85, 0, 170, 255 }}
+    };
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_DXT1, std::vector<uint8_t>(std::begin(RED_BLUE_BLOCK), std::end(RED_BLUE_BLOCK)));
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(0, std::memcmp(palette[i % 4].data(), &pixels[i * 4], 4)) << "pixel " << i;
+    }
+}
+
+TEST_F(DecompressTests, dxt1_transparent)
+{
+    // Swapping the colors selects the three color mode with transparent black
+    std::vector<uint8_t> block = { 0x1F, 0x00, 0x00, 0xF8, 0xE4, 0xE4, 0xE4, 0xE4 };
+    const std::array<uint8_t, 4> palette[] = {
+        {{ 0, 0, 255, 255 }}, {{ 255, 0, 0, 255 }}, {{ 127, 0, 127, 255 }}, {{ 0, 0, 0, 0 }}
+    };
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_DXT1, block);
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(0, std::memcmp(palette[i % 4].data(), &pixels[i * 4], 4)) << "pixel " << i;
+    }
+}
+
+TEST_F(DecompressTests, dxt3)
+{
+    // Pixel i has the alpha value i
+    std::vector<uint8_t> block = { 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE };
+    block.insert(block.end(), std::begin(WHITE_BLOCK), std::end(WHITE_BLOCK));
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_DXT3, block);
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(255, pixels[i * 4]);
+        ASSERT_EQ(i * 17, pixels[i * 4 + 3]) << "pixel " << i;
+    }
+}
+
+TEST_F(DecompressTests, dxt5)
+{
+    const uint8_t alphas[] = { 255, 0, 218, 182, 145, 109, 72, 36 };
+
+    // Pixel i uses alpha index i % 8
+    uint64_t indices = 0;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        indices |= static_cast<uint64_t>(i % 8) << (3 * i);
+    }
+
+    std::vector<uint8_t> block = { 255, 0 };
+    for (size_t i = 0; i < 6; ++i)
+    {
+        block.push_back(static_cast<uint8_t>(indices >> (8 * i)));
+    }
+    block.insert(block.end(), std::begin(RED_BLUE_BLOCK), std::end(RED_BLUE_BLOCK));
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_DXT5, block);
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(alphas[i % 8], pixels[i * 4 + 3]) << "pixel " << i;
+    }
+
+    // Color blocks of DXT5 always use four colors
+    ASSERT_EQ(85, pixels[3 * 4]);
+    ASSERT_EQ(170, pixels[3 * 4 + 2]);
+}
+
+TEST_F(DecompressTests, bc4)
+{
+    const uint8_t reds[] = { 255, 0, 218, 182, 145, 109, 72, 36 };
+
+    // Pixel i uses red index i % 8
+    uint64_t indices = 0;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        indices |= static_cast<uint64_t>(i % 8) << (3 * i);
+    }
+
+    std::vector<uint8_t> block = { 255, 0 };
+    for (size_t i = 0; i < 6; ++i)
+    {
+        block.push_back(static_cast<uint8_t>(indices >> (8 * i)));
+    }
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_BC4, block);
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(reds[i % 8], pixels[i * 4]) << "pixel " << i;
+        ASSERT_EQ(0, pixels[i * 4 + 1]);
+        ASSERT_EQ(0, pixels[i * 4 + 2]);
+        ASSERT_EQ(255, pixels[i * 4 + 3]);
+    }
+}
+
+TEST_F(DecompressTests, bc5_snorm)
+{
+    // Red alternates between 127 and -127, green uses -128 which is clamped to -127
+    std::vector<uint8_t> block = { 0x7F, 0x81, 0x08, 0x82, 0x20, 0x08, 0x82, 0x20,
+                                   0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_BC5_SNORM, block);
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(i % 2 == 0 ? 255 : 0, pixels[i * 4]) << "pixel " << i;
+        ASSERT_EQ(0, pixels[i * 4 + 1]);
+        ASSERT_EQ(255, pixels[i * 4 + 3]);
+    }
+}
+
+TEST_F(DecompressTests, bc6h)
+{
+    // Mode 11 with both endpoints at (1023, 0, 480), blue is about 0.773 as half float
+    std::vector<uint8_t> block = { 0xE3, 0x7F, 0x00, 0xC0, 0xFB, 0x1F, 0x00, 0xF0,
+                                   0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_BC6H_UF16, block);
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        ASSERT_EQ(255, pixels[i * 4]) << "pixel " << i;
+        ASSERT_EQ(0, pixels[i * 4 + 1]);
+        ASSERT_EQ(197, pixels[i * 4 + 2]);
+        ASSERT_EQ(255, pixels[i * 4 + 3]);
+    }
+}
+
+TEST_F(DecompressTests, bc7)
+{
+    // Mode 6 going from transparent black to opaque white, pixel i uses index i
+    std::vector<uint8_t> block = { 0x40, 0xC0, 0x1F, 0xF0, 0x07, 0xFC, 0x01, 0x7F,
+                                   0x11, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE };
+    const uint8_t values[] = { 0, 16, 36, 52, 68, 84, 104, 120, 135, 151, 171, 187, 203, 219, 239, 255 };
+
+    auto plugin_data = single_block(IMGLOAD_COMPRESSION_BC7, block);
+    auto pixels = this->decodeSingle(plugin_data);
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        for (size_t c = 0; c < 4; ++c)
+        {
+            ASSERT_EQ(values[i], pixels[i * 4 + c]) << "pixel " << i << ", channel " << c;
+        }
+    }
+}
+
+TEST_F(DecompressTests, bc7_modes)
+{
+    for (size_t mode = 0; mode < 8; ++mode)
+    {
+        SCOPED_TRACE(mode);
+        this->checkKnownBlock(IMGLOAD_COMPRESSION_BC7, BC7_MODE_BLOCKS[mode]);
+    }
+}
+
+TEST_F(DecompressTests, bc6h_modes)
+{
+    for (size_t mode = 0; mode < 14; ++mode)
+    {
+        SCOPED_TRACE(mode + 1);
+        this->checkKnownBlock(IMGLOAD_COMPRESSION_BC6H_UF16, BC6H_UF16_MODE_BLOCKS[mode]);
+    }
+}
+
+TEST_F(DecompressTests, bc6h_signed_modes)
+{
+    for (size_t mode = 0; mode < 14; ++mode)
+    {
+        SCOPED_TRACE(mode + 1);
+        this->checkKnownBlock(IMGLOAD_COMPRESSION_BC6H_SF16, BC6H_SF16_MODE_BLOCKS[mode]);
+    }
+}
+
+TEST_F(DecompressTests, threads_match_single_thread)
+{
+    // Sizes which are not a multiple of the block size and mipmaps which are split into several tiles
+    DxtPluginData plugin_data;
+    plugin_data.compression = IMGLOAD_COMPRESSION_DXT5;
+    plugin_data.width = 150;
+    plugin_data.height = 301;
+    plugin_data.subimages = 6;
+    plugin_data.mipmaps = 5;
+
+    random_blocks(plugin_data);
+
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+    ImgloadImage single;
+    ImgloadImage parallel;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &single, DXT_FILE, sizeof(DXT_FILE)));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &parallel, DXT_FILE, sizeof(DXT_FILE)));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_decompress_all(single, 1));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_decompress_all(parallel, 8));
+
+    for (size_t i = 0; i < plugin_data.subimages; ++i)
+    {
+        for (size_t j = 0; j < plugin_data.mipmaps; ++j)
+        {
+            ImgloadImageData expected;
+            ImgloadImageData actual;
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(single, i, j, &expected));
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(parallel, i, j, &actual));
+
+            ASSERT_EQ(mip_size(plugin_data.width, j), actual.width);
+            ASSERT_EQ(mip_size(plugin_data.height, j), actual.height);
+            ASSERT_EQ(expected.data_size, actual.data_size);
+            ASSERT_EQ(0, std::memcmp(expected.data, actual.data, actual.data_size));
+        }
+    }
+
+    imgload_image_free(single);
+    imgload_image_free(parallel);
+}
+
+TEST_F(DecompressTests, compressed_passthrough)
+{
+    DxtPluginData plugin_data;
+    plugin_data.compression = IMGLOAD_COMPRESSION_BC7;
+    plugin_data.width = 40;
+    plugin_data.height = 24;
+    plugin_data.subimages = 2;
+    plugin_data.mipmaps = 3;
+    random_blocks(plugin_data);
+
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+    ImgloadImage copied;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &copied, DXT_FILE, sizeof(DXT_FILE)));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(copied));
+
+    ImgloadContext copy_ctx = this->ctx;
+    this->ctx = nullptr;
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS | IMGLOAD_CONTEXT_COMPRESSED_PASSTHROUGH);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, DXT_FILE, sizeof(DXT_FILE)));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    for (size_t i = 0; i < plugin_data.subimages; ++i)
+    {
+        for (size_t j = 0; j < plugin_data.mipmaps; ++j)
+        {
+            // The blocks are not copied but can still be decoded
+            ImgloadImageData compressed;
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, i, j, &compressed));
+            ASSERT_EQ(plugin_data.blocks[i * plugin_data.mipmaps + j].data(), compressed.data);
+
+            ImgloadImageData expected;
+            ImgloadImageData actual;
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(copied, i, j, &expected));
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, i, j, &actual));
+            ASSERT_EQ(expected.data_size, actual.data_size);
+            ASSERT_EQ(0, std::memcmp(expected.data, actual.data, actual.data_size));
+        }
+    }
+
+    imgload_image_free(img);
+    imgload_image_free(copied);
+    imgload_context_free(copy_ctx);
+}
+
+TEST_F(DecompressTests, probe_info_fallback)
+{
+    DxtPluginData plugin_data;
+    plugin_data.compression = IMGLOAD_COMPRESSION_BC5;
+    plugin_data.width = 16;
+    plugin_data.height = 16;
+    plugin_data.subimages = 3;
+    plugin_data.mipmaps = 5;
+
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+    auto file_ptr = std::tmpfile();
+    ASSERT_NE(nullptr, file_ptr);
+    ASSERT_EQ(sizeof(DXT_FILE), std::fwrite(DXT_FILE, 1, sizeof(DXT_FILE), file_ptr));
+    std::rewind(file_ptr);
+
+    // The plugin has no image info callback so the metadata comes from a complete image
+    auto io = util::get_std_io();
+    ImgloadImageInfo info;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_probe_info(this->ctx, &io, static_cast<void*>(file_ptr), &info));
+
+    ASSERT_EQ(3, info.subimages);
+    ASSERT_EQ(5, info.mipmaps);
+    ASSERT_EQ(IMGLOAD_FORMAT_R8G8B8A8, info.format);
+    ASSERT_EQ(IMGLOAD_COMPRESSION_BC5, info.compression);
+
+    std::fclose(file_ptr);
+}
+
+TEST_F(DecompressTests, read_mipmaps)
+{
+    DxtPluginData plugin_data;
+    plugin_data.compression = IMGLOAD_COMPRESSION_DXT1;
+    plugin_data.width = 64;
+    plugin_data.height = 32;
+    plugin_data.subimages = 2;
+    plugin_data.mipmaps = 6;
+    random_blocks(plugin_data);
+
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, DXT_FILE, sizeof(DXT_FILE)));
+
+    // The small mipmaps first, then the complete chain
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_mipmaps(img, 1, 3, 3));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_mipmaps(img, 1, 3, 3));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_mipmaps(img, 1, 0, 6));
+
+    ASSERT_EQ(2u, plugin_data.mipmap_reads.size());
+    ASSERT_EQ((std::array<size_t, 3>{{ 1, 3, 3 }}), plugin_data.mipmap_reads[0]);
+    ASSERT_EQ((std::array<size_t, 3>{{ 1, 0, 3 }}), plugin_data.mipmap_reads[1]);
+
+    ImgloadImageData data;
+    for (size_t j = 0; j < plugin_data.mipmaps; ++j)
+    {
+        ASSERT_EQ(IMGLOAD_ERR_NO_DATA, imgload_image_compressed_data(img, 0, j, &data));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, 1, j, &data));
+
+        auto& blocks = plugin_data.blocks[plugin_data.mipmaps + j];
+        ASSERT_EQ(blocks.size(), data.data_size);
+        ASSERT_EQ(0, std::memcmp(blocks.data(), data.data, data.data_size));
+    }
+
+    // Reading everything afterwards replaces the data read before
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_compressed_data(img, 0, 5, &data));
+
+    imgload_image_free(img);
+}
+
+TEST_F(DecompressTests, direct_layouts)
+{
+    const ImgloadCompression compressions[] = {
+        IMGLOAD_COMPRESSION_DXT1, IMGLOAD_COMPRESSION_DXT3, IMGLOAD_COMPRESSION_DXT5, IMGLOAD_COMPRESSION_BC4,
+        IMGLOAD_COMPRESSION_BC4_SNORM, IMGLOAD_COMPRESSION_BC5, IMGLOAD_COMPRESSION_BC5_SNORM,
+        IMGLOAD_COMPRESSION_BC6H_UF16, IMGLOAD_COMPRESSION_BC6H_SF16, IMGLOAD_COMPRESSION_BC7
+    };
+
+    for (auto compression : compressions)
+    {
+        SCOPED_TRACE(testing::Message() << "compression " << compression);
+
+        // An odd number of blocks per row and partial blocks at the edges
+        DxtPluginData plugin_data;
+        plugin_data.compression = compression;
+        plugin_data.width = 23;
+        plugin_data.height = 10;
+        plugin_data.subimages = 1;
+        plugin_data.mipmaps = 2;
+        random_blocks(plugin_data);
+
+        const size_t width = plugin_data.width;
+        const size_t height = plugin_data.height;
+
+        this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, DXT_FILE, sizeof(DXT_FILE)));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_decompress_all(img, 1));
+
+        ImgloadImageData data;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+        auto pixels = static_cast<const uint8_t*>(data.data);
+        std::vector<uint8_t> expected(pixels, pixels + width * height * 4);
+
+        // Decoding into memory of the caller with a larger stride
+        const size_t stride = width * 4 + 12;
+        std::vector<uint8_t> into(stride * height, 0xCD);
+
+        ImgloadImage into_img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &into_img, DXT_FILE, sizeof(DXT_FILE)));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(into_img));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data_into(into_img, 0, 0, into.data(), stride));
+
+        for (size_t y = 0; y < height; ++y)
+        {
+            ASSERT_EQ(0, std::memcmp(&expected[y * width * 4], &into[y * stride], width * 4)) << "row " << y;
+            ASSERT_EQ(0xCD, into[y * stride + width * 4]);
+        }
+
+        imgload_image_free(into_img);
+        imgload_image_free(img);
+
+        // Lazily decoded data in flipped BGRA
+        this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS | IMGLOAD_CONTEXT_FLIP_IMAGES);
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, dxt_plugin_loader, &plugin_data));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, DXT_FILE, sizeof(DXT_FILE)));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, IMGLOAD_FORMAT_B8G8R8A8, 0));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+        ASSERT_EQ(width * 4, data.stride);
+
+        pixels = static_cast<const uint8_t*>(data.data);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                const uint8_t* actual = pixels + (height - y - 1) * data.stride + x * 4;
+                const uint8_t* rgba = &expected[(y * width + x) * 4];
+
+                ASSERT_EQ(rgba[2], actual[0]) << "pixel " << x << ", " << y;
+                ASSERT_EQ(rgba[1], actual[1]) << "pixel " << x << ", " << y;
+                ASSERT_EQ(rgba[0], actual[2]) << "pixel " << x << ", " << y;
+                ASSERT_EQ(rgba[3], actual[3]) << "pixel " << x << ", " << y;
+            }
+        }
+
+        imgload_image_free(img);
+    }
+}
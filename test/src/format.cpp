@@ -0,0 +1,308 @@
+#include <imageloader.h>
+#include <imageloader_plugin.h>
+
+#include <gtest/gtest.h>
+
+#include "util.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const uint8_t FORMAT_FILE[] = { 'F', 'M', 'T', '!' };
+
+    // Odd sizes so the SIMD kernels also have to handle the end of a row
+    const size_t WIDTH = 37;
+    const size_t HEIGHT = 3;
+
+    struct FormatPluginData
+    {
+        ImgloadFormat format;
+        std::vector<uint8_t> pixels;
+        bool transfer_ownership = false;
+    };
+
+    size_t bytes_per_pixel(ImgloadFormat format)
+    {
+        switch (format)
+        {
+            case IMGLOAD_FORMAT_R8G8B8A8:
+            case IMGLOAD_FORMAT_B8G8R8A8:
+                return 4;
+            case IMGLOAD_FORMAT_R8G8B8:
+                return 3;
+            case IMGLOAD_FORMAT_GRAY8:
+                return 1;
+        }
+        return 0;
+    }
+
+    std::array<int, 4> read_pixel(ImgloadFormat format, const uint8_t* pixel, int alpha)
+    {
+        switch (format)
+        {
+            case IMGLOAD_FORMAT_R8G8B8A8:
+                return {{ pixel[0], pixel[1], pixel[2], pixel[3] }};
+            case IMGLOAD_FORMAT_B8G8R8A8:
+                return {{ pixel[2], pixel[1], pixel[0], pixel[3] }};
+            case IMGLOAD_FORMAT_R8G8B8:
+                return {{ pixel[0], pixel[1], pixel[2], alpha }};
+            case IMGLOAD_FORMAT_GRAY8:
+                return {{ pixel[0], pixel[0], pixel[0], alpha }};
+        }
+        return {{ 0, 0, 0, 0 }};
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK format_init_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto data = static_cast<FormatPluginData*>(imgload_plugin_get_data(plugin));
+
+        imgload_plugin_image_set_data_type(img, data->format, IMGLOAD_COMPRESSION_NONE);
+        imgload_plugin_image_set_num_frames(img, 1);
+        imgload_plugin_image_set_num_mipmaps(img, 0, 1);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK format_read_image(ImgloadPlugin plugin, ImgloadImage img)
+    {
+        auto data = static_cast<FormatPluginData*>(imgload_plugin_get_data(plugin));
+
+        ImgloadImageData image;
+        image.width = WIDTH;
+        image.height = HEIGHT;
+        image.depth = 1;
+        image.stride = WIDTH * bytes_per_pixel(data->format);
+        image.data_size = image.stride * HEIGHT;
+        image.data = data->pixels.data();
+
+        if (data->transfer_ownership)
+        {
+            image.data = imgload_plugin_realloc(plugin, nullptr, image.data_size);
+            std::memcpy(image.data, data->pixels.data(), image.data_size);
+        }
+
+        return imgload_plugin_image_set_image_data(img, 0, 0, &image, data->transfer_ownership ? 1 : 0);
+    }
+
+    ImgloadErrorCode IMGLOAD_CALLBACK format_plugin_loader(ImgloadPlugin plugin, void* parameter)
+    {
+        imgload_plugin_set_info(plugin, "format", "Format plugin", "Plugin providing raw pixels for conversions");
+        imgload_plugin_set_data(plugin, parameter);
+
+        auto err = imgload_plugin_register_signature(plugin, FORMAT_FILE, sizeof(FORMAT_FILE));
+        if (err != IMGLOAD_ERR_NO_ERROR)
+        {
+            return err;
+        }
+
+        imgload_plugin_callback_init_image(plugin, format_init_image);
+        imgload_plugin_callback_read_data(plugin, format_read_image);
+
+        return IMGLOAD_ERR_NO_ERROR;
+    }
+
+    const ImgloadFormat ALL_FORMATS[] = {
+        IMGLOAD_FORMAT_R8G8B8A8, IMGLOAD_FORMAT_B8G8R8A8, IMGLOAD_FORMAT_R8G8B8, IMGLOAD_FORMAT_GRAY8
+    };
+}
+
+class FormatTests : public util::ContextFixture
+{
+protected:
+    void checkConversions(bool convert_before_read, ImgloadContextFlags flags = 0, bool transfer_ownership = false)
+    {
+        const uint8_t alpha = 0x7F;
+
+        for (auto from : ALL_FORMATS)
+        {
+            for (auto to : ALL_FORMATS)
+            {
+                SCOPED_TRACE(testing::Message() << "from " << from << " to " << to);
+
+                FormatPluginData plugin_data;
+                plugin_data.format = from;
+                plugin_data.transfer_ownership = transfer_ownership;
+                plugin_data.pixels.resize(WIDTH * HEIGHT * bytes_per_pixel(from));
+
+                std::srand(static_cast<unsigned int>(from * 4 + to));
+                for (auto& byte : plugin_data.pixels)
+                {
+                    byte = static_cast<uint8_t>(std::rand());
+                }
+
+                this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS | flags);
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, format_plugin_loader, &plugin_data));
+
+                ImgloadImage img;
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR,
+                          imgload_image_init_from_memory(this->ctx, &img, FORMAT_FILE, sizeof(FORMAT_FILE)));
+
+                if (convert_before_read)
+                {
+                    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, to, imgload_transform_alpha(alpha)));
+                }
+
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+                if (!convert_before_read)
+                {
+                    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, to, imgload_transform_alpha(alpha)));
+                }
+
+                ImgloadImageData data;
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+
+                ASSERT_EQ(WIDTH * bytes_per_pixel(to), data.stride);
+                ASSERT_EQ(data.stride * HEIGHT, data.data_size);
+
+                const uint8_t* converted = static_cast<const uint8_t*>(data.data);
+                for (size_t i = 0; i < WIDTH * HEIGHT; ++i)
+                {
+                    size_t src_i = i;
+                    if (flags & IMGLOAD_CONTEXT_FLIP_IMAGES)
+                    {
+                        src_i = (HEIGHT - i / WIDTH - 1) * WIDTH + i % WIDTH;
+                    }
+
+                    auto expected = read_pixel(from, &plugin_data.pixels[src_i * bytes_per_pixel(from)], alpha);
+                    auto actual = read_pixel(to, &converted[i * bytes_per_pixel(to)], alpha);
+
+                    if (bytes_per_pixel(to) < 4)
+                    {
+                        // The alpha channel is dropped
+                        expected[3] = alpha;
+                    }
+
+                    if (to == IMGLOAD_FORMAT_GRAY8 && from != IMGLOAD_FORMAT_GRAY8)
+                    {
+                        // Fixed point luminance may be rounded differently
+                        double luminance = 0.2126 * expected[0] + 0.7152 * expected[1] + 0.0722 * expected[2];
+                        ASSERT_NEAR(luminance, actual[0], 1.0) << "Pixel " << i;
+                    }
+                    else
+                    {
+                        ASSERT_EQ(expected, actual) << "Pixel " << i;
+                    }
+                }
+
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+                ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_free(this->ctx));
+                this->ctx = nullptr;
+            }
+        }
+    }
+};
+
+TEST_F(FormatTests, convert_loaded_data)
+{
+    checkConversions(false);
+}
+
+TEST_F(FormatTests, convert_while_reading)
+{
+    checkConversions(true);
+}
+
+TEST_F(FormatTests, flip_and_convert_while_reading)
+{
+    checkConversions(true, IMGLOAD_CONTEXT_FLIP_IMAGES, false);
+}
+
+TEST_F(FormatTests, flip_and_convert_owned_data)
+{
+    checkConversions(true, IMGLOAD_CONTEXT_FLIP_IMAGES, true);
+}
+
+TEST_F(FormatTests, luminance_weights)
+{
+    FormatPluginData plugin_data;
+    plugin_data.format = IMGLOAD_FORMAT_R8G8B8;
+    plugin_data.pixels.resize(WIDTH * HEIGHT * 3);
+
+    for (size_t i = 0; i < WIDTH * HEIGHT; ++i)
+    {
+        plugin_data.pixels[i * 3 + 0] = 200;
+        plugin_data.pixels[i * 3 + 1] = 100;
+        plugin_data.pixels[i * 3 + 2] = 0;
+    }
+
+    this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, format_plugin_loader, &plugin_data));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, FORMAT_FILE, sizeof(FORMAT_FILE)));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    // Only use the red channel
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, IMGLOAD_FORMAT_GRAY8, imgload_transform_rgb(1, 0, 0)));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+
+    const uint8_t* converted = static_cast<const uint8_t*>(data.data);
+    for (size_t i = 0; i < WIDTH * HEIGHT; ++i)
+    {
+        ASSERT_EQ(200, converted[i]) << "Pixel " << i;
+    }
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(FormatTests, data_into_caller_buffer)
+{
+    const uint8_t alpha = 0x40;
+    const size_t padded_stride = WIDTH * 4 + 12;
+
+    for (bool transfer_ownership : { false, true })
+    {
+        SCOPED_TRACE(testing::Message() << "Transfer ownership " << transfer_ownership);
+
+        FormatPluginData plugin_data;
+        plugin_data.format = IMGLOAD_FORMAT_R8G8B8;
+        plugin_data.transfer_ownership = transfer_ownership;
+        plugin_data.pixels.resize(WIDTH * HEIGHT * 3);
+
+        for (size_t i = 0; i < plugin_data.pixels.size(); ++i)
+        {
+            plugin_data.pixels[i] = static_cast<uint8_t>(i * 7);
+        }
+
+        this->makeContext(IMGLOAD_CONTEXT_NO_DEFAULT_PLUGINS | IMGLOAD_CONTEXT_FLIP_IMAGES);
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_add_plugin(this->ctx, format_plugin_loader, &plugin_data));
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, FORMAT_FILE, sizeof(FORMAT_FILE)));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR,
+                  imgload_image_transform_data(img, IMGLOAD_FORMAT_B8G8R8A8, imgload_transform_alpha(alpha)));
+
+        std::vector<uint8_t> buffer(padded_stride * HEIGHT, 0xCD);
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data_into(img, 0, 0, buffer.data(), padded_stride));
+
+        for (size_t y = 0; y < HEIGHT; ++y)
+        {
+            for (size_t x = 0; x < WIDTH; ++x)
+            {
+                const uint8_t* src = &plugin_data.pixels[((HEIGHT - y - 1) * WIDTH + x) * 3];
+                const uint8_t* dst = &buffer[y * padded_stride + x * 4];
+
+                ASSERT_EQ(src[2], dst[0]);
+                ASSERT_EQ(src[1], dst[1]);
+                ASSERT_EQ(src[0], dst[2]);
+                ASSERT_EQ(alpha, dst[3]);
+            }
+
+            // The padding at the end of a row is not touched
+            ASSERT_EQ(0xCD, buffer[y * padded_stride + WIDTH * 4]);
+        }
+
+        // The data went to the caller and is not stored in the image
+        ImgloadImageData data;
+        ASSERT_EQ(IMGLOAD_ERR_NO_DATA, imgload_image_data(img, 0, 0, &data));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    }
+}
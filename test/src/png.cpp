@@ -6,6 +6,41 @@
 #include "util.h"
 
 #include <cstdio>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct TraceLog
+    {
+        std::vector<std::string> stack;
+        std::vector<std::string> stages;
+        bool mismatched = false;
+    };
+
+    void IMGLOAD_CALLBACK trace_begin(void* ud, const ImgloadTraceEvent* event)
+    {
+        auto log = static_cast<TraceLog*>(ud);
+        log->stack.push_back(event->name);
+        log->stages.push_back(event->name);
+    }
+
+    void IMGLOAD_CALLBACK trace_end(void* ud, const ImgloadTraceEvent* event)
+    {
+        auto log = static_cast<TraceLog*>(ud);
+        if (log->stack.empty() || log->stack.back() != event->name)
+        {
+            log->mismatched = true;
+            return;
+        }
+        log->stack.pop_back();
+    }
+}
 
 class PNGTests : public util::ContextFixture
 {
@@ -41,6 +76,27 @@ TEST_F(PNGTests, read_header)
     std::fclose(file_ptr);
 }
 
+TEST_F(PNGTests, probe_info)
+{
+    auto io = util::get_std_io();
+
+    auto file_ptr = std::fopen(TEST_DATA_PATH "png/test1.png", "rb");
+
+    ImgloadImageInfo info;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_probe_info(this->ctx, &io, static_cast<void*>(file_ptr), &info));
+
+    ASSERT_EQ(800, info.width);
+    ASSERT_EQ(600, info.height);
+    ASSERT_EQ(1, info.depth);
+    ASSERT_EQ(1, info.subimages);
+    ASSERT_EQ(1, info.mipmaps);
+
+    ASSERT_EQ(IMGLOAD_FORMAT_R8G8B8A8, info.format);
+    ASSERT_EQ(IMGLOAD_COMPRESSION_NONE, info.compression);
+
+    std::fclose(file_ptr);
+}
+
 TEST_F(PNGTests, read_data)
 {
     ImgloadImage img;
@@ -85,6 +141,70 @@ TEST_F(PNGTests, read_data_flip)
     std::fclose(file_ptr);
 }
 
+TEST_F(PNGTests, image_arena)
+{
+    this->makeContext(IMGLOAD_CONTEXT_FLIP_IMAGES);
+
+    ImgloadImage expected;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &expected, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(expected));
+
+    ImgloadContext expected_ctx = this->ctx;
+    this->ctx = nullptr;
+    this->makeContext(IMGLOAD_CONTEXT_FLIP_IMAGES | IMGLOAD_CONTEXT_IMAGE_ARENA);
+
+    // The metadata, the plugin state and the flip buffer come from the arena while the pixels don't
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    ImgloadImageData expected_data;
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(expected, 0, 0, &expected_data));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+
+    ASSERT_EQ(expected_data.stride, data.stride);
+    ASSERT_EQ(expected_data.data_size, data.data_size);
+    ASSERT_EQ(0, std::memcmp(expected_data.data, data.data, data.data_size));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(expected));
+    imgload_context_free(expected_ctx);
+}
+
+TEST_F(PNGTests, buffer_pool)
+{
+    this->makeContext(IMGLOAD_CONTEXT_BUFFER_POOL);
+
+    ImgloadImage first;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &first, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(first));
+
+    ImgloadImageData first_data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(first, 0, 0, &first_data));
+    const void* pixels = first_data.data;
+    std::vector<uint8_t> expected(static_cast<const uint8_t*>(pixels),
+                                  static_cast<const uint8_t*>(pixels) + first_data.data_size);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(first));
+
+    // The second image of the same size gets the buffer of the first one back
+    ImgloadImage second;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &second, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(second));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(second, 0, 0, &data));
+    ASSERT_EQ(pixels, data.data);
+    ASSERT_EQ(expected.size(), data.data_size);
+    ASSERT_EQ(0, std::memcmp(expected.data(), data.data, data.data_size));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(second));
+
+    // Lowering the limit frees the cached buffers
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_set_buffer_pool_limit(this->ctx, 0));
+}
+
 TEST_F(PNGTests, transform_data_before_read)
 {
     ImgloadImage img;
@@ -140,3 +260,483 @@ TEST_F(PNGTests, transform_data_after_read)
 
     std::fclose(file_ptr);
 }
+
+TEST_F(PNGTests, read_data_from_memory)
+{
+    auto contents = util::read_file(TEST_DATA_PATH "png/test1.png");
+    ASSERT_FALSE(contents.empty());
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, contents.data(), contents.size()));
+
+    ASSERT_EQ(IMGLOAD_FORMAT_R8G8B8A8, imgload_image_data_format(img));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+    ASSERT_EQ(800, data.width);
+    ASSERT_EQ(600, data.height);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(PNGTests, read_data_from_file)
+{
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+    ASSERT_EQ(800, data.width);
+    ASSERT_EQ(600, data.height);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(PNGTests, read_from_missing_file)
+{
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_IO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/does_not_exist.png"));
+}
+
+namespace
+{
+    std::vector<uint8_t> read_reference(ImgloadContext ctx, ImgloadFormat format)
+    {
+        ImgloadImage img;
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(ctx, &img, TEST_DATA_PATH "png/test1.png"));
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, format, imgload_transform_alpha(255)));
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+        ImgloadImageData data;
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+
+        auto begin = static_cast<const uint8_t*>(data.data);
+        std::vector<uint8_t> pixels(begin, begin + data.data_size);
+
+        EXPECT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+
+        return pixels;
+    }
+}
+
+TEST_F(PNGTests, read_rows)
+{
+    const ImgloadFormat formats[] = { IMGLOAD_FORMAT_R8G8B8A8, IMGLOAD_FORMAT_B8G8R8A8, IMGLOAD_FORMAT_R8G8B8 };
+
+    for (auto format : formats)
+    {
+        SCOPED_TRACE(testing::Message() << "Format " << format);
+
+        auto reference = read_reference(this->ctx, format);
+        size_t stride = reference.size() / 600;
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, format, imgload_transform_alpha(255)));
+
+        // Read bands of rows with gaps into a buffer with a larger stride
+        const size_t band = 50;
+        const size_t padded_stride = stride + 16;
+        std::vector<uint8_t> rows(band * padded_stride);
+
+        for (size_t first_row = 0; first_row < 600; first_row += 2 * band)
+        {
+            ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_rows(img, 0, 0, first_row, band, rows.data(), padded_stride));
+
+            for (size_t y = 0; y < band; ++y)
+            {
+                ASSERT_EQ(0, std::memcmp(&reference[(first_row + y) * stride], &rows[y * padded_stride], stride))
+                    << "Row " << first_row + y;
+            }
+        }
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    }
+}
+
+TEST_F(PNGTests, read_rows_backwards)
+{
+    auto reference = read_reference(this->ctx, IMGLOAD_FORMAT_R8G8B8A8);
+    size_t stride = reference.size() / 600;
+
+    // A stream has to be rewound to decode rows before the ones already read
+    auto io = util::get_std_io();
+    auto file_ptr = std::fopen(TEST_DATA_PATH "png/test1.png", "rb");
+    ASSERT_NE(nullptr, file_ptr);
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init(this->ctx, &img, &io, file_ptr));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, IMGLOAD_FORMAT_R8G8B8A8, imgload_transform_alpha(255)));
+
+    std::vector<uint8_t> rows(6 * stride);
+    for (size_t first_row = 594; first_row > 0; first_row -= 99)
+    {
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_rows(img, 0, 0, first_row, 6, rows.data(), stride));
+        ASSERT_EQ(0, std::memcmp(&reference[first_row * stride], rows.data(), rows.size())) << "Row " << first_row;
+    }
+
+    // Reading the whole image after streaming starts decoding from the beginning again
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+    ASSERT_EQ(reference.size(), data.data_size);
+    ASSERT_EQ(0, std::memcmp(reference.data(), data.data, data.data_size));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_rows(img, 0, 0, 0, 6, rows.data(), stride));
+    ASSERT_EQ(0, std::memcmp(reference.data(), rows.data(), rows.size()));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    std::fclose(file_ptr);
+}
+
+TEST_F(PNGTests, read_rows_flip)
+{
+    this->makeContext(IMGLOAD_CONTEXT_FLIP_IMAGES);
+
+    auto reference = read_reference(this->ctx, IMGLOAD_FORMAT_R8G8B8A8);
+    size_t stride = reference.size() / 600;
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+
+    std::vector<uint8_t> rows(10 * stride);
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_rows(img, 0, 0, 100, 10, rows.data(), stride));
+    ASSERT_EQ(0, std::memcmp(&reference[100 * stride], rows.data(), rows.size()));
+
+    ASSERT_EQ(IMGLOAD_ERR_OUT_OF_RANGE, imgload_image_read_rows(img, 0, 0, 595, 10, rows.data(), stride));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(PNGTests, data_into)
+{
+    auto reference = read_reference(this->ctx, IMGLOAD_FORMAT_R8G8B8);
+    size_t stride = reference.size() / 600;
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, IMGLOAD_FORMAT_R8G8B8, 0));
+
+    std::vector<uint8_t> pixels(reference.size());
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data_into(img, 0, 0, pixels.data(), stride));
+    ASSERT_EQ(reference, pixels);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(PNGTests, buffered_io)
+{
+    auto reference = read_reference(this->ctx, IMGLOAD_FORMAT_R8G8B8A8);
+
+    size_t unbuffered_reads = 0;
+    for (size_t buffer_size : { 0, 64 * 1024 })
+    {
+        SCOPED_TRACE(testing::Message() << "Buffer size " << buffer_size);
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_set_io_buffer_size(this->ctx, buffer_size));
+
+        util::CountingFile counting = { std::fopen(TEST_DATA_PATH "png/test1.png", "rb"), 0, 0, 0 };
+        ASSERT_NE(nullptr, counting.file);
+
+        auto io = util::get_counting_io();
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init(this->ctx, &img, &io, &counting));
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+        ImgloadImageData data;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+        ASSERT_EQ(0, std::memcmp(reference.data(), data.data, reference.size()));
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+        std::fclose(counting.file);
+
+        if (buffer_size == 0)
+        {
+            unbuffered_reads = counting.reads;
+        }
+        else
+        {
+            // libpng reads every chunk header separately, with a buffer these are collapsed into a few large reads
+            ASSERT_LT(counting.reads * 4, unbuffered_reads);
+        }
+    }
+}
+
+TEST_F(PNGTests, stats)
+{
+    ImgloadStats stats;
+    ASSERT_EQ(IMGLOAD_ERR_NO_DATA, imgload_context_get_stats(this->ctx, &stats));
+
+    this->makeContext(IMGLOAD_CONTEXT_COLLECT_STATS | IMGLOAD_CONTEXT_FLIP_IMAGES);
+
+    util::CountingFile counting = { std::fopen(TEST_DATA_PATH "png/test1.png", "rb"), 0, 0, 0 };
+    ASSERT_NE(nullptr, counting.file);
+
+    auto io = util::get_counting_io();
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init(this->ctx, &img, &io, &counting));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_transform_data(img, IMGLOAD_FORMAT_B8G8R8A8, 0));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_get_stats(img, &stats));
+    ASSERT_EQ(1u, stats.images);
+    ASSERT_EQ(counting.bytes_read, stats.bytes_read);
+    ASSERT_EQ(counting.reads, stats.read_calls);
+    ASSERT_EQ(counting.seeks, stats.seek_calls);
+    ASSERT_GT(stats.probe_ns, 0u);
+    ASSERT_GT(stats.init_ns, 0u);
+    ASSERT_GT(stats.read_ns, 0u);
+    // Flipping happens while converting
+    ASSERT_GT(stats.convert_ns, 0u);
+    ASSERT_EQ(0u, stats.flip_ns);
+    ASSERT_EQ(0u, stats.decompress_ns);
+
+    ImgloadStats image_stats = stats;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    std::fclose(counting.file);
+
+    // The context gets the numbers of the image once it is freed
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_get_stats(this->ctx, &stats));
+    ASSERT_EQ(1u, stats.images);
+    ASSERT_EQ(image_stats.bytes_read, stats.bytes_read);
+    ASSERT_EQ(image_stats.read_ns, stats.read_ns);
+    ASSERT_GE(stats.peak_bytes, data.data_size);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_get_plugin_stats(this->ctx, "png", &stats));
+    ASSERT_EQ(1u, stats.images);
+    ASSERT_EQ(image_stats.convert_ns, stats.convert_ns);
+
+    ASSERT_EQ(IMGLOAD_ERR_OUT_OF_RANGE, imgload_context_get_plugin_stats(this->ctx, "unknown", &stats));
+}
+
+TEST_F(PNGTests, trace_callbacks)
+{
+    this->makeContext(IMGLOAD_CONTEXT_FLIP_IMAGES);
+
+    TraceLog log;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_set_trace_callbacks(this->ctx, trace_begin, trace_end, &log));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+
+    ASSERT_FALSE(log.mismatched);
+    ASSERT_TRUE(log.stack.empty());
+
+    std::vector<std::string> expected = { "probe", "init_image", "read_image", "flip" };
+    ASSERT_EQ(expected, log.stages);
+
+    // Without callbacks nothing is reported anymore
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_set_trace_callbacks(this->ctx, nullptr, nullptr, nullptr));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    ASSERT_EQ(expected.size(), log.stages.size());
+}
+
+TEST_F(PNGTests, trace_writer)
+{
+    const char* path = "imgload_trace_test.json";
+
+    ImgloadTraceWriter writer;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_trace_writer_open(this->ctx, path, &writer));
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_trace_writer_close(writer));
+
+    auto contents = util::read_file(path);
+    std::remove(path);
+
+    std::string json(contents.begin(), contents.end());
+    ASSERT_EQ(0u, json.find("{\"traceEvents\":["));
+    ASSERT_NE(std::string::npos, json.find("{\"name\":\"read_image\",\"cat\":\"png\",\"ph\":\"B\""));
+    ASSERT_NE(std::string::npos, json.find("{\"name\":\"read_image\",\"cat\":\"png\",\"ph\":\"E\""));
+    ASSERT_EQ(std::string::npos, json.find(",\n]"));
+}
+
+namespace
+{
+    struct AsyncResult
+    {
+        std::mutex lock;
+        std::condition_variable done_cond;
+        bool done = false;
+
+        ImgloadImage img = nullptr;
+        ImgloadErrorCode err = IMGLOAD_ERR_NO_ERROR;
+    };
+
+    void IMGLOAD_CALLBACK async_done(void* ud, ImgloadImage img, ImgloadErrorCode err)
+    {
+        auto result = static_cast<AsyncResult*>(ud);
+
+        std::lock_guard<std::mutex> guard(result->lock);
+        result->img = img;
+        result->err = err;
+        result->done = true;
+        result->done_cond.notify_all();
+    }
+
+    void wait_for(AsyncResult& result)
+    {
+        std::unique_lock<std::mutex> guard(result.lock);
+        result.done_cond.wait(guard, [&result]() { return result.done; });
+    }
+
+    /**
+     * @brief A file in memory whose reads are completed later by another thread
+     */
+    struct DeferredFile
+    {
+        std::vector<uint8_t> data;
+        std::vector<std::thread> threads;
+
+        size_t reads = 0;
+        bool closed = false;
+        size_t fail_at = SIZE_MAX; //!< The read which fails
+    };
+
+    void IMGLOAD_CALLBACK deferred_read(void* ud, ImgloadAsyncLoad load, uint64_t offset, uint8_t* buf, size_t size)
+    {
+        auto file = static_cast<DeferredFile*>(ud);
+        bool fail = file->reads++ == file->fail_at;
+
+        file->threads.emplace_back([file, load, offset, buf, size, fail]()
+        {
+            if (fail)
+            {
+                imgload_async_complete(load, 0, IMGLOAD_ERR_IO_ERROR);
+                return;
+            }
+
+            size_t available = offset < file->data.size() ? file->data.size() - static_cast<size_t>(offset) : 0;
+            size_t read = size < available ? size : available;
+            std::memcpy(buf, file->data.data() + offset, read);
+
+            imgload_async_complete(load, read, IMGLOAD_ERR_NO_ERROR);
+        });
+    }
+
+    void IMGLOAD_CALLBACK deferred_close(void* ud)
+    {
+        static_cast<DeferredFile*>(ud)->closed = true;
+    }
+}
+
+TEST_F(PNGTests, async_file_reader)
+{
+    ImgloadImage expected;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &expected, TEST_DATA_PATH "png/test1.png"));
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(expected));
+
+    ImgloadAsyncFileReader reader;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_async_file_reader_init(this->ctx, 2, &reader));
+
+    AsyncResult results[4];
+    for (auto& result : results)
+    {
+        ImgloadAsyncOptions options;
+        std::memset(&options, 0, sizeof(options));
+        options.done = async_done;
+        options.done_ud = &result;
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_async_file_reader_load(reader, TEST_DATA_PATH "png/test1.png", &options));
+    }
+
+    ImgloadAsyncOptions options;
+    std::memset(&options, 0, sizeof(options));
+    options.done = async_done;
+    ASSERT_EQ(IMGLOAD_ERR_IO_ERROR, imgload_async_file_reader_load(reader, TEST_DATA_PATH "png/missing.png", &options));
+
+    ImgloadImageData expected_data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(expected, 0, 0, &expected_data));
+
+    for (auto& result : results)
+    {
+        wait_for(result);
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, result.err);
+
+        ImgloadImageData data;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(result.img, 0, 0, &data));
+        ASSERT_EQ(expected_data.data_size, data.data_size);
+        ASSERT_EQ(0, std::memcmp(expected_data.data, data.data, data.data_size));
+
+        imgload_image_free(result.img);
+    }
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_async_file_reader_free(reader));
+    imgload_image_free(expected);
+}
+
+TEST_F(PNGTests, async_deferred_io)
+{
+    ImgloadAsyncIO io;
+    io.read = deferred_read;
+    io.close = deferred_close;
+
+    // Without a size the file is read in chunks until a read comes up short
+    DeferredFile file;
+    file.data = util::read_file(TEST_DATA_PATH "png/test1.png");
+    ASSERT_LT(64u * 1024u, file.data.size());
+
+    AsyncResult result;
+    ImgloadAsyncOptions options;
+    std::memset(&options, 0, sizeof(options));
+    options.flags = IMGLOAD_BATCH_HEADER_ONLY;
+    options.done = async_done;
+    options.done_ud = &result;
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_async_load(this->ctx, &io, &file, &options));
+    wait_for(result);
+
+    // The threads are only added by the thread which continues the load, which is done now
+    for (auto& thread : file.threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, result.err);
+    ASSERT_TRUE(file.closed);
+    ASSERT_LT(1u, file.reads);
+
+    uint32_t width = 0;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_get_property(result.img, 0, IMGLOAD_PROPERTY_WIDTH,
+                                                               IMGLOAD_PROPERTY_TYPE_UINT32, &width));
+    ASSERT_LT(0u, width);
+    imgload_image_free(result.img);
+
+    // Failed reads fail the load
+    DeferredFile failing;
+    failing.data = file.data;
+    failing.fail_at = 1;
+
+    AsyncResult failed;
+    options.done_ud = &failed;
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_async_load(this->ctx, &io, &failing, &options));
+    wait_for(failed);
+
+    for (auto& thread : failing.threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_EQ(IMGLOAD_ERR_IO_ERROR, failed.err);
+    ASSERT_EQ(nullptr, failed.img);
+    ASSERT_TRUE(failing.closed);
+    ASSERT_EQ(2u, failing.reads);
+}
@@ -1,11 +1,67 @@
 
 #include <imageloader.h>
+#include <imageloader_plugin.h>
 
 #include <gtest/gtest.h>
 
 #include "util.h"
 
 #include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <string>
+
+namespace
+{
+    /**
+     * @brief Allocator which keeps track of every block it hands out
+     */
+    struct CountingAllocator
+    {
+        size_t allocs;
+        size_t frees;
+        std::set<void*> live;
+    };
+
+    void* IMGLOAD_CALLBACK counting_realloc(void* ud, void* mem, size_t size)
+    {
+        auto allocator = static_cast<CountingAllocator*>(ud);
+
+        void* result = std::realloc(mem, size);
+        if (result == nullptr && size > 0)
+        {
+            return nullptr;
+        }
+
+        if (mem == nullptr)
+        {
+            ++allocator->allocs;
+        }
+        else
+        {
+            allocator->live.erase(mem);
+        }
+        if (result != nullptr)
+        {
+            allocator->live.insert(result);
+        }
+
+        return result;
+    }
+
+    void IMGLOAD_CALLBACK counting_free(void* ud, void* mem)
+    {
+        auto allocator = static_cast<CountingAllocator*>(ud);
+
+        if (mem != nullptr)
+        {
+            ++allocator->frees;
+            allocator->live.erase(mem);
+        }
+
+        std::free(mem);
+    }
+}
 
 class STBITests : public util::ContextFixture
 {
@@ -41,6 +97,50 @@ TEST_F(STBITests, read_header_jpeg)
     std::fclose(file_ptr);
 }
 
+TEST_F(STBITests, probe_info_jpeg)
+{
+    auto io = util::get_std_io();
+
+    auto file_ptr = std::fopen(TEST_DATA_PATH "stb_image/jpeg420exif.jpg", "rb");
+
+    ImgloadImageInfo info;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_probe_info(this->ctx, &io, static_cast<void*>(file_ptr), &info));
+
+    ASSERT_EQ(2048, info.width);
+    ASSERT_EQ(1536, info.height);
+    ASSERT_EQ(1, info.depth);
+    ASSERT_EQ(1, info.subimages);
+    ASSERT_EQ(1, info.mipmaps);
+
+    ASSERT_EQ(IMGLOAD_FORMAT_R8G8B8, info.format);
+    ASSERT_EQ(IMGLOAD_COMPRESSION_NONE, info.compression);
+
+    std::fclose(file_ptr);
+}
+
+TEST_F(STBITests, probe_info_stream_probe)
+{
+    // The dimensions of the PPM are behind the header passed to the plugins so only the stream probe detects it
+    std::string contents = "P6" + std::string(IMGLOAD_PLUGIN_HEADER_SIZE, ' ') + "2 1\n255\n";
+    contents.append(6, '\x80');
+
+    auto file_ptr = std::tmpfile();
+    ASSERT_NE(nullptr, file_ptr);
+    ASSERT_EQ(contents.size(), std::fwrite(contents.data(), 1, contents.size(), file_ptr));
+    std::rewind(file_ptr);
+
+    auto io = util::get_std_io();
+
+    ImgloadImageInfo info;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_probe_info(this->ctx, &io, static_cast<void*>(file_ptr), &info));
+
+    ASSERT_EQ(2, info.width);
+    ASSERT_EQ(1, info.height);
+    ASSERT_EQ(IMGLOAD_FORMAT_R8G8B8, info.format);
+
+    std::fclose(file_ptr);
+}
+
 TEST_F(STBITests, read_data_jpeg)
 {
     ImgloadImage img;
@@ -158,3 +258,105 @@ TEST_F(STBITests, read_data_tga_flip)
 
     std::fclose(file_ptr);
 }
+
+TEST_F(STBITests, read_data_jpeg_from_memory)
+{
+    auto contents = util::read_file(TEST_DATA_PATH "stb_image/jpeg420exif.jpg");
+    ASSERT_FALSE(contents.empty());
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(this->ctx, &img, contents.data(), contents.size()));
+
+    ASSERT_EQ(IMGLOAD_FORMAT_R8G8B8, imgload_image_data_format(img));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+    ASSERT_EQ(2048, data.width);
+    ASSERT_EQ(1536, data.height);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(STBITests, read_data_tga_from_file)
+{
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_file(this->ctx, &img, TEST_DATA_PATH "stb_image/FLAG_B24.TGA"));
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+
+    ImgloadImageData data;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_data(img, 0, 0, &data));
+    ASSERT_EQ(124, data.width);
+    ASSERT_EQ(124, data.height);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+}
+
+TEST_F(STBITests, read_stream_once)
+{
+    const char* files[] = { TEST_DATA_PATH "stb_image/jpeg420exif.jpg", TEST_DATA_PATH "stb_image/FLAG_B24.TGA" };
+
+    // The buffer serves the rewind after probing, the plugin has to avoid reading anything twice itself
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_set_io_buffer_size(this->ctx, 4096));
+
+    for (auto path : files)
+    {
+        SCOPED_TRACE(path);
+
+        auto contents = util::read_file(path);
+        ASSERT_FALSE(contents.empty());
+
+        util::CountingFile counting = { std::fopen(path, "rb"), 0, 0, 0 };
+        ASSERT_NE(nullptr, counting.file);
+
+        auto io = util::get_counting_io();
+
+        ImgloadImage img;
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init(this->ctx, &img, &io, &counting));
+
+        // Init only reads the headers, decoding reads the rest of the file
+        size_t header_bytes = counting.bytes_read;
+        ASSERT_LT(header_bytes, contents.size() / 2);
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+        ASSERT_EQ(contents.size(), counting.bytes_read);
+
+        ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+
+        std::fclose(counting.file);
+    }
+}
+
+TEST_F(STBITests, context_allocator)
+{
+    CountingAllocator counting = { 0, 0, {} };
+
+    ImgloadMemoryAllocator allocator;
+    allocator.realloc = counting_realloc;
+    allocator.free = counting_free;
+
+    ImgloadContext ctx;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_init(&ctx, static_cast<ImgloadContextFlags>(0), &allocator, &counting));
+
+    auto contents = util::read_file(TEST_DATA_PATH "stb_image/jpeg420exif.jpg");
+    ASSERT_FALSE(contents.empty());
+
+    size_t live_before = counting.live.size();
+
+    ImgloadImage img;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_init_from_memory(ctx, &img, contents.data(), contents.size()));
+
+    // The file is in memory so the allocations while decoding are the buffers of stb_image and the decoded pixels
+    size_t allocs_before = counting.allocs;
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_read_data(img));
+    ASSERT_LT(1, counting.allocs - allocs_before);
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_image_free(img));
+    ASSERT_EQ(live_before, counting.live.size());
+
+    ASSERT_EQ(IMGLOAD_ERR_NO_ERROR, imgload_context_free(ctx));
+    ASSERT_TRUE(counting.live.empty());
+    ASSERT_EQ(counting.allocs, counting.frees);
+}
\ No newline at end of file
@@ -25,6 +25,25 @@ namespace
         return static_cast<int64_t>(std::ftell(static_cast<FILE*>(ud)));
     }
 
+    size_t IMGLOAD_CALLBACK counting_read(void* ud, uint8_t* buf, size_t size)
+    {
+        auto counting = static_cast<util::CountingFile*>(ud);
+
+        size_t read = std::fread(buf, 1, size, counting->file);
+        ++counting->reads;
+        counting->bytes_read += read;
+
+        return read;
+    }
+
+    int64_t IMGLOAD_CALLBACK counting_seek(void* ud, int64_t offset, int whence)
+    {
+        auto counting = static_cast<util::CountingFile*>(ud);
+        ++counting->seeks;
+
+        return std_seek(counting->file, offset, whence);
+    }
+
     ImgloadErrorCode IMGLOAD_CALLBACK logger(void* ud, ImgloadLogLevel level, const char* text)
     {
         switch(level)
@@ -80,6 +99,37 @@ namespace util
         return io;
     }
 
+    ImgloadIO get_counting_io()
+    {
+        ImgloadIO io;
+        io.read = counting_read;
+        io.seek = counting_seek;
+
+        return io;
+    }
+
+    std::vector<std::uint8_t> read_file(const char* path)
+    {
+        std::vector<std::uint8_t> contents;
+
+        auto file_ptr = std::fopen(path, "rb");
+        if (file_ptr == nullptr)
+        {
+            return contents;
+        }
+
+        std::uint8_t buffer[4096];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file_ptr)) > 0)
+        {
+            contents.insert(contents.end(), buffer, buffer + read);
+        }
+
+        std::fclose(file_ptr);
+
+        return contents;
+    }
+
     void ContextFixture::makeContext(ImgloadContextFlags flags)
     {
         if (ctx != nullptr)
@@ -5,6 +5,10 @@
 
 #include <imageloader.h>
 
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
 namespace util
 {
     class ContextFixture : public ::testing::Test
@@ -21,4 +25,20 @@ namespace util
     };
 
     ImgloadIO get_std_io();
+
+    /**
+     * @brief A file which counts how it is accessed, use with get_counting_io
+     */
+    struct CountingFile
+    {
+        FILE* file;
+
+        size_t reads;
+        size_t bytes_read;
+        size_t seeks;
+    };
+
+    ImgloadIO get_counting_io();
+
+    std::vector<std::uint8_t> read_file(const char* path);
 }